@@ -1,138 +1,1324 @@
+// Compilação: gcc -O2 -pthread DetectiveQuest.c -o DetectiveQuest -lm
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <math.h>
+#include "entrada.h"
+#include "log.h"
+
+// --- Definições de Constantes ---
+#define SEM_SALA UINT32_MAX     // Índice de um caminho inexistente
+#define SEM_TEXTO UINT32_MAX    // Sala sem pista, ou pista sem suspeito
+#define SEM_SUSPEITO UINT32_MAX // Nenhum suspeito (ainda) com pistas
+#define SEM_NO UINT32_MAX       // Filho vazio na árvore de pistas
+#define MAX_SALAS 0x7FFFFFFFu   // Limite de cômodos de um mapa
+#define TAM_BLOCO 32            // Posições do passeio de Euler por bloco da consulta de mínimo
+#define MAX_NOME 100            // Tamanho máximo de um nome digitado na exploração
+#define ROTEIROS_POR_LOTE 1024  // Roteiros que uma thread pega de cada vez na avaliação
 
 // --- Definição da Estrutura da Sala (Nó da Árvore) ---
-typedef struct Sala {
-    char nome[50];         // Nome do cômodo
-    struct Sala *esquerda; // Ponteiro para o cômodo à esquerda
-    struct Sala *direita;  // Ponteiro para o cômodo à direita
+/**
+ * @brief Os cômodos ficam todos num único vetor (a arena do mapa) e apontam
+ * para os filhos pelo índice nesse vetor, não por ponteiro: 12 bytes por sala,
+ * carregamento sem um malloc por cômodo e o mapa inteiro sai com um só free.
+ */
+typedef struct {
+    uint32_t nome;     // Posição do nome do cômodo em 'textos' do mapa
+    uint32_t esquerda; // Índice do cômodo à esquerda, ou SEM_SALA
+    uint32_t direita;  // Índice do cômodo à direita, ou SEM_SALA
 } Sala;
 
+/**
+ * @brief Pista de uma sala, num vetor à parte com o mesmo índice da sala: as
+ * descidas pela árvore só leem 'Sala' e continuam com 12 bytes por cômodo.
+ */
+typedef struct {
+    uint32_t pista;    // Posição da pista deixada no cômodo, ou SEM_TEXTO
+    uint32_t suspeito; // Posição do suspeito apontado pela pista, ou SEM_TEXTO
+} PistaSala;
+
+/**
+ * @brief Mapa da mansão. 'salas' e 'textos' são um único bloco de memória:
+ * primeiro as salas, depois os nomes terminados em '\0'. A sala 0 é a raiz.
+ */
+typedef struct {
+    Sala *salas;
+    uint32_t numSalas;
+    char *textos;
+    uint32_t tamanhoTextos; // Bytes usados em 'textos'
+    PistaSala *pistas;      // Pista de cada sala, ou NULL se nenhuma sala tem pista
+} Mapa;
+
+/**
+ * @brief Ordem em que as salas podem ser regravadas no vetor do mapa. Depois
+ * de carregado, o mapa fica na ordem das linhas do arquivo; numa árvore
+ * grande isso espalha cada descida pela memória toda.
+ * - LAYOUT_LARGURA: nível a nível (busca em largura). Os níveis de cima, que
+ *   toda descida atravessa, ficam juntos no começo do vetor.
+ * - LAYOUT_VEB: van Emde Boas. A árvore é cortada na metade da altura; a parte
+ *   de cima é gravada primeiro e depois cada subárvore de baixo, todas com a
+ *   mesma regra. Qualquer trecho de descida fica em poucos blocos contíguos,
+ *   seja qual for o tamanho da linha de cache ou da página.
+ */
+typedef enum {
+    LAYOUT_LARGURA,
+    LAYOUT_VEB
+} LayoutMapa;
+
+/**
+ * @brief Índice de consultas sobre um mapa, montado em tempo linear depois do
+ * carregamento. Todos os vetores ficam num único bloco (liberado com um free).
+ *
+ * - Nomes: tabela de espalhamento com endereçamento aberto (índices de sala).
+ * - Passeio de Euler: a sequência de salas de uma busca em profundidade, que
+ *   repete cada sala ao voltar de cada filho (2n - 1 posições). O ancestral
+ *   comum de A e B é a sala mais rasa do passeio entre as entradas de A e B.
+ * - Mínimo de intervalos: o passeio é dividido em blocos de TAM_BLOCO; uma
+ *   tabela esparsa guarda o mínimo de cada sequência de 2^k blocos, e as pontas
+ *   parciais são percorridas. Consulta em O(TAM_BLOCO) com memória linear.
+ */
+typedef struct {
+    uint32_t *pai;            // SEM_SALA na raiz e nas salas fora do alcance do Hall
+    uint32_t *profundidade;   // Hall = 0; UINT32_MAX fora do alcance do Hall
+    uint32_t *entrada;        // Primeira posição da sala no passeio
+    uint32_t *saida;          // Última posição da sala no passeio
+    uint32_t *passeio;        // Salas na ordem do passeio de Euler
+    uint32_t *profundidadePasseio; // Profundidade de cada posição do passeio
+    uint32_t tamanhoPasseio;
+    uint32_t *minimos;        // Tabela esparsa: nível k, bloco i -> posição mais rasa
+    uint32_t numBlocos;       // Blocos do passeio (só as salas alcançáveis entram nele)
+    uint32_t tamanhoNivel;    // Distância entre dois níveis em 'minimos', reservada para 2n - 1 posições
+    int niveis;
+    uint32_t *nomes;          // Tabela de nomes: índice da sala ou SEM_SALA
+    uint32_t mascaraNomes;    // Capacidade da tabela - 1 (potência de 2)
+} IndiceMapa;
+
+/**
+ * @brief Roteiros de exploração ("edde": esquerda, direita, direita, esquerda;
+ * 's' sai da mansão), um por linha de um arquivo lido inteiro para a memória.
+ */
+typedef struct {
+    char *texto;
+    size_t *inicios;        // Início de cada roteiro em 'texto'; inicios[total] é o fim
+    size_t total;
+} Roteiros;
+
+/**
+ * @brief Resultado da avaliação de roteiros. Cada thread tem o seu, somado no fim.
+ */
+typedef struct {
+    uint64_t *visitas;      // Entradas em cada sala (uma por exploração na sala 0)
+    uint64_t fimDaLinha;    // Explorações que terminaram num cômodo sem saída
+    uint64_t saidas;        // Explorações encerradas por 's'
+    uint64_t incompletas;   // Roteiros que acabaram antes de um fim da linha
+    uint64_t passos;        // Movimentos feitos
+    uint64_t invalidos;     // Movimentos sem caminho naquela direção (o jogador fica na sala)
+} ResultadoRoteiros;
+
+/**
+ * @brief Tabela de espalhamento de textos (endereçamento aberto) que leva cada
+ * texto a um número. Guarda só ponteiros: os textos têm de continuar vivos
+ * enquanto a tabela existir.
+ */
+typedef struct {
+    const char **chaves;    // NULL nas posições livres
+    uint32_t *valores;
+    uint32_t mascara;       // Capacidade - 1 (potência de 2)
+    uint32_t total;
+} TabelaTextos;
+
+/**
+ * @brief Nó da árvore AVL de pistas coletadas, guardado num vetor e ligado
+ * aos filhos por índice, como as salas.
+ */
+typedef struct {
+    uint64_t prefixo;       // 8 primeiros bytes do texto, para comparar sem ler o texto
+    const char *texto;
+    uint32_t esquerda;
+    uint32_t direita;
+    int altura;             // Folha = 1
+} NoPista;
+
+/**
+ * @brief Caderno do detetive: pistas coletadas numa árvore AVL (ordem
+ * alfabética, busca e inserção em O(log n)), a tabela que liga cada pista a
+ * um suspeito e quantas pistas coletadas apontam para cada suspeito. O suspeito
+ * com mais pistas é atualizado a cada coleta, sem recontar nada: as contagens
+ * só crescem, então basta comparar o suspeito da pista nova com o líder.
+ */
+typedef struct {
+    NoPista *nos;
+    uint32_t numNos;
+    uint32_t capacidadeNos;
+    uint32_t raiz;          // SEM_NO com o caderno vazio
+    TabelaTextos suspeitoDaPista;   // Pista -> índice do suspeito
+    TabelaTextos indiceSuspeito;    // Nome do suspeito -> índice do suspeito
+    const char **suspeitos;         // Nome de cada suspeito
+    uint32_t *contagem;             // Pistas coletadas que apontam para cada suspeito
+    uint32_t numSuspeitos;
+    uint32_t capacidadeSuspeitos;
+    uint32_t lider;                 // Suspeito com mais pistas coletadas, ou SEM_SUSPEITO
+} CadernoPistas;
+
+/**
+ * @brief Mapa padrão, no mesmo formato dos arquivos de mapa: uma sala por
+ * linha, "nome;esquerda;direita", com os filhos dados pelo número da sala
+ * (contando a partir de 0, sem as linhas vazias e de comentário) ou '-'.
+ * Uma sala pode ter ainda uma pista e o suspeito para o qual ela aponta:
+ * "nome;esquerda;direita;pista;suspeito".
+ */
+static const char MAPA_PADRAO[] =
+    "# Mansão Enigma Studios\n"
+    "Hall de Entrada;1;2;Pegadas de lama no tapete;Jardineira\n"     // 0
+    "Cozinha;3;4;Faca de prata desaparecida;Cozinheiro\n"            // 1
+    "Sala de Estar;5;6;Copo de licor quebrado;Mordomo\n"             // 2
+    "Despensa;-;-;Avental manchado;Cozinheiro\n"                     // 3
+    "Biblioteca;7;-;Livro de venenos fora do lugar;Mordomo\n"        // 4
+    "Jardim;-;-;Luvas de jardinagem molhadas;Jardineira\n"           // 5
+    "Escritório;8;9;Carta de demissão rasgada;Mordomo\n"             // 6
+    "Sala Secreta;-;-;Chave dourada;Governanta\n"                    // 7
+    "Porão;-;-;Lanterna ainda quente;Jardineira\n"                   // 8
+    "Quarto Principal;-;-;Perfume derramado;Governanta\n";           // 9
+
+Entrada entradaPadrao; // Comandos do jogador (teclado ou sessão redirecionada)
+
 // --- Protótipos das Funções ---
-Sala* criarSala(const char *nome);
-void montarMapa(Sala **raiz);
-void explorarSalas(Sala *atual);
-void liberarMapa(Sala *raiz);
+int carregarMapaTexto(Mapa *mapa, const char *texto, size_t tamanho);
+int carregarMapaArquivo(Mapa *mapa, const char *caminho);
+int montarMapa(Mapa *mapa);
+const char *nomeSala(const Mapa *mapa, uint32_t sala);
+void explorarSalas(const Mapa *mapa, const IndiceMapa *indice, CadernoPistas *caderno, uint32_t atual);
+void liberarMapa(Mapa *mapa);
+int indexarMapa(const Mapa *mapa, IndiceMapa *indice);
+void liberarIndice(IndiceMapa *indice);
+uint32_t buscarSala(const Mapa *mapa, const IndiceMapa *indice, const char *nome);
+uint32_t ancestralComum(const IndiceMapa *indice, uint32_t a, uint32_t b);
+uint32_t distanciaSalas(const IndiceMapa *indice, uint32_t a, uint32_t b);
+uint32_t proximoPasso(const Mapa *mapa, const IndiceMapa *indice, uint32_t origem, uint32_t destino);
+void exibirCaminho(const Mapa *mapa, const IndiceMapa *indice, uint32_t origem, uint32_t destino);
+int executarCaminho(int argc, char *argv[]);
+int executarBenchCaminhos(int argc, char *argv[]);
+int carregarRoteiros(Roteiros *roteiros, const char *caminho);
+void liberarRoteiros(Roteiros *roteiros);
+int avaliarRoteiros(const Mapa *mapa, const Roteiros *roteiros, int numThreads, ResultadoRoteiros *resultado);
+int gerarRoteiros(int argc, char *argv[]);
+int executarAvaliacaoRoteiros(int argc, char *argv[]);
+int cadernoIniciar(CadernoPistas *caderno);
+void cadernoLiberar(CadernoPistas *caderno);
+int associarPista(CadernoPistas *caderno, const char *pista, const char *suspeito);
+int associarPistasDoMapa(CadernoPistas *caderno, const Mapa *mapa);
+int coletarPista(CadernoPistas *caderno, const char *pista);
+int pistaColetada(const CadernoPistas *caderno, const char *pista);
+uint32_t buscarSuspeito(const CadernoPistas *caderno, const char *nome);
+uint32_t suspeitoDaPista(const CadernoPistas *caderno, const char *pista);
+uint32_t suspeitoPrincipal(const CadernoPistas *caderno);
+void exibirPistas(const CadernoPistas *caderno);
+int executarBenchPistas(int argc, char *argv[]);
+int gerarMansao(int argc, char *argv[]);
+int executarBenchMansao(int argc, char *argv[]);
+int reorganizarMapa(Mapa *mapa, LayoutMapa layout);
+int lerLayout(const char *nome, LayoutMapa *layout);
+uint32_t procurarSala(const Mapa *mapa, uint32_t inicio, const char *nome);
+void exibirMapa(const Mapa *mapa, uint32_t inicio, uint32_t maximoLinhas);
+int executarExibirMapa(int argc, char *argv[]);
+int executarBenchLayout(int argc, char *argv[]);
 
 // -------------------------------------------------------------------
 // ---------------------- FUNÇÕES DE LÓGICA --------------------------
 // -------------------------------------------------------------------
 
 /**
- * @brief Cria e aloca dinamicamente uma nova Sala (nó da árvore).
- * * @param nome O nome do cômodo.
- * @return Sala*: Ponteiro para a nova sala criada.
+ * @brief Lê um índice de filho ("-" = sem caminho) a partir de 'p', até 'fim'.
+ * @return const char*: Posição logo depois do número, ou NULL se não há um índice válido.
  */
-Sala* criarSala(const char *nome) {
-    // Aloca memória para a nova sala
-    Sala *novaSala = (Sala*)malloc(sizeof(Sala));
-    
-    if (novaSala == NULL) {
-        printf("[ERRO]: Falha na alocação de memória para a sala '%s'.\n", nome);
-        exit(1); // Encerra o programa em caso de falha crítica
+static const char *lerIndice(const char *p, const char *fim, uint32_t *indice) {
+    if (p < fim && *p == '-') {
+        *indice = SEM_SALA;
+        return p + 1;
     }
-    
-    // Copia o nome para o campo 'nome' da estrutura
-    strncpy(novaSala->nome, nome, 49);
-    novaSala->nome[49] = '\0'; // Garante o terminador de string
-    
-    // Inicializa os ponteiros dos filhos como NULL (sem caminhos)
-    novaSala->esquerda = NULL;
-    novaSala->direita = NULL;
-    
-    return novaSala;
+    uint64_t valor = 0;
+    const char *inicio = p;
+    while (p < fim && *p >= '0' && *p <= '9' && valor <= MAX_SALAS) {
+        valor = valor * 10 + (uint64_t)(*p++ - '0');
+    }
+    if (p == inicio || valor > MAX_SALAS) {
+        return NULL;
+    }
+    *indice = (uint32_t)valor;
+    return p;
+}
+
+/**
+ * @brief Copia um campo da linha para 'textos' (terminado em '\0').
+ * @return uint32_t: Posição do campo em 'textos'.
+ */
+static uint32_t guardarCampo(char *textos, uint32_t *usado, const char *inicio, const char *fim) {
+    uint32_t posicao = *usado;
+    memcpy(textos + posicao, inicio, (size_t)(fim - inicio));
+    textos[posicao + (uint32_t)(fim - inicio)] = '\0';
+    *usado += (uint32_t)(fim - inicio) + 1;
+    return posicao;
+}
+
+/**
+ * @brief Monta o mapa a partir do texto (formato de MAPA_PADRAO) num único
+ * bloco: as salas e uma cópia compacta dos nomes. Nada é recursivo e o texto
+ * é lido uma vez; depois, uma passada confere que os índices formam uma árvore
+ * (todo filho existe, ninguém tem dois pais e a raiz não tem pai).
+ * @param mapa Recebe o mapa; em caso de erro fica vazio.
+ * @return int: 0 em caso de sucesso, -1 em caso de erro (já informado no console).
+ */
+int carregarMapaTexto(Mapa *mapa, const char *texto, size_t tamanho) {
+    mapa->salas = NULL;
+    mapa->numSalas = 0;
+    mapa->textos = NULL;
+    mapa->pistas = NULL;
+
+    // Cada sala ocupa uma linha, então o número de linhas limita o de salas.
+    size_t linhas = 1;
+    for (const char *p = memchr(texto, '\n', tamanho); p != NULL;
+         p = memchr(p + 1, '\n', tamanho - (size_t)(p + 1 - texto))) {
+        linhas++;
+    }
+    if (linhas > MAX_SALAS || tamanho >= UINT32_MAX) {
+        printf("[ERRO]: O mapa é grande demais.\n");
+        return -1;
+    }
+    char *bloco = malloc(linhas * sizeof(Sala) + tamanho + 1);
+    if (bloco == NULL) {
+        printf("[ERRO]: Falha na alocação de memória para o mapa.\n");
+        return -1;
+    }
+    Sala *salas = (Sala *)bloco;
+    char *textos = bloco + linhas * sizeof(Sala);
+    PistaSala *pistas = NULL; // Só é criado na primeira sala com pista
+    uint32_t numSalas = 0, usado = 0;
+
+    const char *fimTexto = texto + tamanho;
+    size_t numeroLinha = 0;
+    for (const char *linha = texto; linha < fimTexto; ) {
+        const char *fim = memchr(linha, '\n', (size_t)(fimTexto - linha));
+        const char *proxima = fim != NULL ? fim + 1 : fimTexto;
+        fim = fim != NULL ? fim : fimTexto;
+        numeroLinha++;
+        if (fim > linha && fim[-1] == '\r') {
+            fim--;
+        }
+        if (fim == linha || *linha == '#') {
+            linha = proxima;
+            continue;
+        }
+
+        const char *separador = memchr(linha, ';', (size_t)(fim - linha));
+        Sala *sala = &salas[numSalas];
+        const char *p = separador != NULL ? lerIndice(separador + 1, fim, &sala->esquerda) : NULL;
+        p = p != NULL && p < fim && *p == ';' ? lerIndice(p + 1, fim, &sala->direita) : NULL;
+        // Pista e suspeito opcionais: ";pista;suspeito" depois dos filhos.
+        const char *pista = p != NULL && p < fim && *p == ';' ? p + 1 : NULL;
+        const char *fimPista = pista != NULL ? memchr(pista, ';', (size_t)(fim - pista)) : NULL;
+        if (separador == NULL || separador == linha || (p != fim && (fimPista == NULL || fimPista == pista))) {
+            printf("[ERRO]: Linha %zu do mapa inválida (esperado 'nome;esquerda;direita[;pista;suspeito]').\n",
+                   numeroLinha);
+            free(pistas);
+            free(bloco);
+            return -1;
+        }
+        sala->nome = guardarCampo(textos, &usado, linha, separador);
+        if (pista != NULL && pistas == NULL) {
+            pistas = malloc(linhas * sizeof(PistaSala));
+            if (pistas == NULL) {
+                printf("[ERRO]: Falha na alocação de memória para o mapa.\n");
+                free(bloco);
+                return -1;
+            }
+            memset(pistas, 0xFF, linhas * sizeof(PistaSala)); // Todas SEM_TEXTO
+        }
+        if (pista != NULL) {
+            pistas[numSalas].pista = guardarCampo(textos, &usado, pista, fimPista);
+            pistas[numSalas].suspeito = fimPista + 1 < fim ? guardarCampo(textos, &usado, fimPista + 1, fim)
+                                                           : SEM_TEXTO;
+        }
+        numSalas++;
+        linha = proxima;
+    }
+    if (numSalas == 0) {
+        printf("[ERRO]: O mapa não tem nenhuma sala.\n");
+        free(pistas);
+        free(bloco);
+        return -1;
+    }
+
+    // Cada sala pode ser filha de no máximo uma outra; a raiz de nenhuma.
+    unsigned char *temPai = calloc(numSalas, 1);
+    if (temPai == NULL) {
+        printf("[ERRO]: Falha na alocação de memória para o mapa.\n");
+        free(pistas);
+        free(bloco);
+        return -1;
+    }
+    temPai[0] = 1;
+    for (uint32_t i = 0; i < numSalas; i++) {
+        uint32_t filhos[2] = {salas[i].esquerda, salas[i].direita};
+        for (int k = 0; k < 2; k++) {
+            if (filhos[k] == SEM_SALA) {
+                continue;
+            }
+            if (filhos[k] >= numSalas || temPai[filhos[k]]) {
+                printf("[ERRO]: A sala %u ('%s') aponta para a sala %u, que %s.\n", i, textos + salas[i].nome,
+                       filhos[k], filhos[k] >= numSalas ? "não existe" : "já tem outro caminho até ela");
+                free(temPai);
+                free(pistas);
+                free(bloco);
+                return -1;
+            }
+            temPai[filhos[k]] = 1;
+        }
+    }
+    free(temPai);
+
+    mapa->salas = salas;
+    mapa->numSalas = numSalas;
+    mapa->textos = textos;
+    mapa->tamanhoTextos = usado;
+    mapa->pistas = pistas;
+    return 0;
+}
+
+/**
+ * @brief Carrega um arquivo de mapa (formato de MAPA_PADRAO).
+ * @return int: 0 em caso de sucesso, -1 em caso de erro (já informado no console).
+ */
+int carregarMapaArquivo(Mapa *mapa, const char *caminho) {
+    FILE *arquivo = fopen(caminho, "rb");
+    if (arquivo == NULL) {
+        printf("[ERRO]: Não foi possível abrir o mapa '%s'.\n", caminho);
+        return -1;
+    }
+    fseek(arquivo, 0, SEEK_END);
+    long tamanho = ftell(arquivo);
+    fseek(arquivo, 0, SEEK_SET);
+    char *texto = tamanho >= 0 ? malloc((size_t)tamanho + 1) : NULL;
+    if (texto == NULL || fread(texto, 1, (size_t)tamanho, arquivo) != (size_t)tamanho) {
+        printf("[ERRO]: Falha ao ler o mapa '%s'.\n", caminho);
+        free(texto);
+        fclose(arquivo);
+        return -1;
+    }
+    fclose(arquivo);
+    int resultado = carregarMapaTexto(mapa, texto, (size_t)tamanho);
+    free(texto);
+    return resultado;
+}
+
+/**
+ * @brief Monta o mapa padrão da mansão, pelo mesmo carregador dos arquivos.
+ * @return int: 0 em caso de sucesso, -1 em caso de erro.
+ */
+int montarMapa(Mapa *mapa) {
+    return carregarMapaTexto(mapa, MAPA_PADRAO, sizeof(MAPA_PADRAO) - 1);
+}
+
+/**
+ * @brief Nome do cômodo de índice 'sala'.
+ */
+const char *nomeSala(const Mapa *mapa, uint32_t sala) {
+    return mapa->textos + mapa->salas[sala].nome;
+}
+
+/**
+ * @brief Libera o mapa: salas e nomes são um só bloco; as pistas, se houver, outro.
+ * @param mapa O mapa a liberar; fica vazio.
+ */
+void liberarMapa(Mapa *mapa) {
+    free(mapa->salas);
+    free(mapa->pistas);
+    mapa->salas = NULL;
+    mapa->pistas = NULL;
+    mapa->numSalas = 0;
+    mapa->textos = NULL;
+    mapa->tamanhoTextos = 0;
+}
+
+// -------------------------------------------------------------------
+// ----------------------- ORGANIZAÇÃO DO MAPA -----------------------
+// -------------------------------------------------------------------
+
+/**
+ * @brief Salas alcançáveis a partir do Hall, nível a nível.
+ * @param ordem Recebe os índices das salas (até numSalas posições).
+ * @param altura Recebe o número de níveis da árvore.
+ * @return uint32_t: Quantas salas foram gravadas em 'ordem'.
+ */
+static uint32_t ordemLargura(const Mapa *mapa, uint32_t *ordem, uint32_t *altura) {
+    uint32_t inicio = 0, fim = 0;
+    ordem[fim++] = 0;
+    *altura = 0;
+    while (inicio < fim) {
+        uint32_t fimNivel = fim;
+        (*altura)++;
+        for (; inicio < fimNivel; inicio++) {
+            const Sala *sala = &mapa->salas[ordem[inicio]];
+            if (sala->esquerda != SEM_SALA) {
+                ordem[fim++] = sala->esquerda;
+            }
+            if (sala->direita != SEM_SALA) {
+                ordem[fim++] = sala->direita;
+            }
+        }
+    }
+    return fim;
+}
+
+typedef struct {
+    uint32_t sala;
+    uint32_t altura;        // Níveis a gravar a partir de 'sala'
+} TarefaLayout;
+
+/**
+ * @brief Salas alcançáveis a partir do Hall na ordem de van Emde Boas, com
+ * uma pilha de tarefas em vez de recursão. Uma tarefa (sala, h) com h > 1 vira
+ * a tarefa da parte de cima (sala, h - h/2), seguida das tarefas das
+ * subárvores de baixo (h/2 níveis cada), da esquerda para a direita. As
+ * subárvores pendentes nunca se sobrepõem, então a pilha cabe em numSalas.
+ * @return int64_t: Quantas salas foram gravadas em 'ordem', ou -1 se faltou memória.
+ */
+static int64_t ordemVanEmdeBoas(const Mapa *mapa, uint32_t *ordem) {
+    uint32_t altura;
+    ordemLargura(mapa, ordem, &altura); // Só para saber a altura
+    TarefaLayout *tarefas = malloc(sizeof(TarefaLayout) * mapa->numSalas);
+    TarefaLayout *descida = malloc(sizeof(TarefaLayout) * (2 * (size_t)altura + 2));
+    if (tarefas == NULL || descida == NULL) {
+        free(tarefas);
+        free(descida);
+        return -1;
+    }
+    size_t numTarefas = 0;
+    uint32_t gravadas = 0;
+    tarefas[numTarefas++] = (TarefaLayout){0, altura};
+    while (numTarefas > 0) {
+        TarefaLayout tarefa = tarefas[--numTarefas];
+        const Sala *sala = &mapa->salas[tarefa.sala];
+        if (tarefa.altura == 1 || (sala->esquerda == SEM_SALA && sala->direita == SEM_SALA)) {
+            ordem[gravadas++] = tarefa.sala;
+            continue;
+        }
+        uint32_t cima = tarefa.altura - tarefa.altura / 2, baixo = tarefa.altura / 2;
+        // Raízes de baixo: salas 'cima' níveis abaixo, achadas por uma descida
+        // em profundidade (esquerda primeiro) limitada a esses níveis.
+        size_t primeira = numTarefas;
+        size_t topo = 0;
+        descida[topo++] = (TarefaLayout){tarefa.sala, 0};
+        while (topo > 0) {
+            TarefaLayout atual = descida[--topo];
+            if (atual.altura == cima) {
+                tarefas[numTarefas++] = (TarefaLayout){atual.sala, baixo};
+                continue;
+            }
+            const Sala *s = &mapa->salas[atual.sala];
+            if (s->direita != SEM_SALA) {
+                descida[topo++] = (TarefaLayout){s->direita, atual.altura + 1};
+            }
+            if (s->esquerda != SEM_SALA) {
+                descida[topo++] = (TarefaLayout){s->esquerda, atual.altura + 1};
+            }
+        }
+        // Na pilha, a subárvore mais à esquerda tem de sair primeiro.
+        for (size_t i = primeira, j = numTarefas; i + 1 < j; i++, j--) {
+            TarefaLayout troca = tarefas[i];
+            tarefas[i] = tarefas[j - 1];
+            tarefas[j - 1] = troca;
+        }
+        tarefas[numTarefas++] = (TarefaLayout){tarefa.sala, cima};
+    }
+    free(tarefas);
+    free(descida);
+    return gravadas;
+}
+
+/**
+ * @brief Regrava as salas do mapa na ordem pedida, num bloco novo (salas e
+ * nomes, como no carregamento), e libera o antigo. O Hall continua na sala 0;
+ * salas fora do alcance do Hall vão para o fim. Os índices das salas mudam,
+ * então índices do mapa (IndiceMapa) têm de ser montados depois disto.
+ * @return int: 0 em caso de sucesso, -1 se faltou memória (o mapa não muda).
+ */
+int reorganizarMapa(Mapa *mapa, LayoutMapa layout) {
+    uint32_t n = mapa->numSalas;
+    uint32_t *ordem = malloc(sizeof(uint32_t) * n);
+    uint32_t *novo = malloc(sizeof(uint32_t) * n);
+    char *bloco = malloc((size_t)n * sizeof(Sala) + mapa->tamanhoTextos);
+    PistaSala *pistas = mapa->pistas != NULL ? malloc((size_t)n * sizeof(PistaSala)) : NULL;
+    int64_t gravadas = -1;
+    if (ordem != NULL && novo != NULL && bloco != NULL && (mapa->pistas == NULL || pistas != NULL)) {
+        uint32_t altura;
+        gravadas = layout == LAYOUT_VEB ? ordemVanEmdeBoas(mapa, ordem) : ordemLargura(mapa, ordem, &altura);
+    }
+    if (gravadas < 0) {
+        free(ordem);
+        free(novo);
+        free(bloco);
+        free(pistas);
+        return -1;
+    }
+    memset(novo, 0xFF, sizeof(uint32_t) * n);
+    for (uint32_t k = 0; k < (uint32_t)gravadas; k++) {
+        novo[ordem[k]] = k;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        if (novo[i] == SEM_SALA) {
+            ordem[gravadas] = i;
+            novo[i] = (uint32_t)gravadas++;
+        }
+    }
+    Sala *salas = (Sala *)bloco;
+    for (uint32_t k = 0; k < n; k++) {
+        Sala sala = mapa->salas[ordem[k]];
+        sala.esquerda = sala.esquerda != SEM_SALA ? novo[sala.esquerda] : SEM_SALA;
+        sala.direita = sala.direita != SEM_SALA ? novo[sala.direita] : SEM_SALA;
+        salas[k] = sala;
+        if (pistas != NULL) {
+            pistas[k] = mapa->pistas[ordem[k]];
+        }
+    }
+    char *textos = bloco + (size_t)n * sizeof(Sala);
+    memcpy(textos, mapa->textos, mapa->tamanhoTextos);
+    free(ordem);
+    free(novo);
+    free(mapa->salas);
+    free(mapa->pistas);
+    mapa->salas = salas;
+    mapa->textos = textos;
+    mapa->pistas = pistas;
+    return 0;
+}
+
+/**
+ * @brief Converte "largura" ou "veb" num LayoutMapa.
+ * @return int: 0 em caso de sucesso, -1 para um nome desconhecido.
+ */
+int lerLayout(const char *nome, LayoutMapa *layout) {
+    if (strcmp(nome, "largura") == 0) {
+        *layout = LAYOUT_LARGURA;
+    } else if (strcmp(nome, "veb") == 0) {
+        *layout = LAYOUT_VEB;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Procura, sem índice, a primeira sala com o nome dado abaixo de
+ * 'inicio' (inclusive), em pré-ordem e com pilha explícita. Em mapas muito
+ * fundos a pilha cresce no heap em vez de estourar a pilha de chamadas.
+ * @return uint32_t: Índice da sala, ou SEM_SALA se não existe (ou faltou memória).
+ */
+uint32_t procurarSala(const Mapa *mapa, uint32_t inicio, const char *nome) {
+    size_t capacidade = 64, topo = 0;
+    uint32_t *pilha = malloc(sizeof(uint32_t) * capacidade);
+    uint32_t achada = SEM_SALA;
+    if (pilha != NULL) {
+        pilha[topo++] = inicio;
+    }
+    while (topo > 0) {
+        uint32_t atual = pilha[--topo];
+        if (strcmp(nomeSala(mapa, atual), nome) == 0) {
+            achada = atual;
+            break;
+        }
+        if (topo + 2 > capacidade) {
+            uint32_t *maior = realloc(pilha, sizeof(uint32_t) * capacidade * 2);
+            if (maior == NULL) {
+                break;
+            }
+            pilha = maior;
+            capacidade *= 2;
+        }
+        const Sala *sala = &mapa->salas[atual];
+        if (sala->direita != SEM_SALA) {
+            pilha[topo++] = sala->direita;
+        }
+        if (sala->esquerda != SEM_SALA) {
+            pilha[topo++] = sala->esquerda;
+        }
+    }
+    free(pilha);
+    return achada;
+}
+
+/**
+ * @brief Mostra a árvore a partir de 'inicio', em pré-ordem, com um recuo por
+ * nível (pilha explícita com a profundidade de cada sala). Para depois de
+ * 'maximoLinhas' salas e não recua mais que 40 níveis.
+ */
+void exibirMapa(const Mapa *mapa, uint32_t inicio, uint32_t maximoLinhas) {
+    size_t capacidade = 64, topo = 0;
+    TarefaLayout *pilha = malloc(sizeof(TarefaLayout) * capacidade);
+    uint32_t linhas = 0;
+    if (pilha == NULL) {
+        printf("[ERRO]: Falha na alocação de memória.\n");
+        return;
+    }
+    printf("\n--- MAPA DA MANSÃO ---\n");
+    pilha[topo++] = (TarefaLayout){inicio, 0};
+    while (topo > 0 && linhas < maximoLinhas) {
+        TarefaLayout atual = pilha[--topo];
+        const Sala *sala = &mapa->salas[atual.sala];
+        uint32_t recuo = atual.altura < 40 ? atual.altura : 40;
+        printf("%*s%s%s\n", (int)(2 * recuo), "", atual.altura > 0 ? "└ " : "", nomeSala(mapa, atual.sala));
+        linhas++;
+        if (topo + 2 > capacidade) {
+            TarefaLayout *maior = realloc(pilha, sizeof(TarefaLayout) * capacidade * 2);
+            if (maior == NULL) {
+                break;
+            }
+            pilha = maior;
+            capacidade *= 2;
+        }
+        if (sala->direita != SEM_SALA) {
+            pilha[topo++] = (TarefaLayout){sala->direita, atual.altura + 1};
+        }
+        if (sala->esquerda != SEM_SALA) {
+            pilha[topo++] = (TarefaLayout){sala->esquerda, atual.altura + 1};
+        }
+    }
+    if (topo > 0) {
+        printf("... (mostradas as primeiras %u salas)\n", linhas);
+    }
+    free(pilha);
+}
+
+// -------------------------------------------------------------------
+// ------------------------- ÍNDICE DO MAPA --------------------------
+// -------------------------------------------------------------------
+
+static uint32_t espalharNome(const char *nome) {
+    // FNV-1a de 32 bits
+    uint32_t h = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)nome; *p != '\0'; p++) {
+        h = (h ^ *p) * 16777619u;
+    }
+    return h;
+}
+
+/**
+ * @brief Posição mais rasa do passeio entre as posições 'de' e 'ate' (inclusive),
+ * percorrendo diretamente.
+ */
+static uint32_t maisRasaDireta(const IndiceMapa *indice, uint32_t de, uint32_t ate) {
+    uint32_t melhor = de;
+    for (uint32_t i = de + 1; i <= ate; i++) {
+        if (indice->profundidadePasseio[i] < indice->profundidadePasseio[melhor]) {
+            melhor = i;
+        }
+    }
+    return melhor;
+}
+
+static uint32_t maisRasa(const IndiceMapa *indice, uint32_t a, uint32_t b) {
+    return indice->profundidadePasseio[b] < indice->profundidadePasseio[a] ? b : a;
+}
+
+/**
+ * @brief Monta o índice de nomes e de caminhos do mapa em tempo linear e sem
+ * recursão: o passeio de Euler anda pelo próprio mapa, usando o vetor de pais
+ * para saber de onde veio (volta de um filho ou chegada de cima).
+ * @return int: 0 em caso de sucesso, -1 se faltou memória.
+ */
+int indexarMapa(const Mapa *mapa, IndiceMapa *indice) {
+    uint32_t n = mapa->numSalas;
+    uint32_t capacidadeNomes = 2;
+    while (capacidadeNomes < 2 * (uint64_t)n) {
+        capacidadeNomes *= 2;
+    }
+    uint64_t tamanhoPasseio = 2 * (uint64_t)n - 1;
+    uint32_t numBlocos = (uint32_t)((tamanhoPasseio + TAM_BLOCO - 1) / TAM_BLOCO);
+    int niveis = 1;
+    while ((1u << niveis) <= numBlocos) {
+        niveis++;
+    }
+    size_t palavras = 4 * (size_t)n + 2 * (size_t)tamanhoPasseio + (size_t)niveis * numBlocos + capacidadeNomes;
+    uint32_t *bloco = malloc(palavras * sizeof(uint32_t));
+    if (bloco == NULL) {
+        return -1;
+    }
+    indice->pai = bloco;
+    indice->profundidade = indice->pai + n;
+    indice->entrada = indice->profundidade + n;
+    indice->saida = indice->entrada + n;
+    indice->passeio = indice->saida + n;
+    indice->profundidadePasseio = indice->passeio + tamanhoPasseio;
+    indice->minimos = indice->profundidadePasseio + tamanhoPasseio;
+    indice->nomes = indice->minimos + (size_t)niveis * numBlocos;
+    indice->mascaraNomes = capacidadeNomes - 1;
+    indice->tamanhoNivel = numBlocos;
+    indice->niveis = niveis;
+
+    // Nomes: sondagem linear; com nomes repetidos, a primeira sala fica na frente.
+    memset(indice->nomes, 0xFF, (size_t)capacidadeNomes * sizeof(uint32_t));
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t posicao = espalharNome(nomeSala(mapa, i)) & indice->mascaraNomes;
+        while (indice->nomes[posicao] != SEM_SALA) {
+            posicao = (posicao + 1) & indice->mascaraNomes;
+        }
+        indice->nomes[posicao] = i;
+    }
+
+    // Passeio de Euler a partir do Hall.
+    memset(indice->pai, 0xFF, (size_t)n * sizeof(uint32_t));
+    memset(indice->profundidade, 0xFF, (size_t)n * sizeof(uint32_t));
+    memset(indice->entrada, 0xFF, (size_t)n * sizeof(uint32_t));
+    memset(indice->saida, 0xFF, (size_t)n * sizeof(uint32_t));
+    uint32_t atual = 0, anterior = SEM_SALA, posicao = 0;
+    indice->profundidade[0] = 0;
+    indice->entrada[0] = 0;
+    for (;;) {
+        indice->passeio[posicao] = atual;
+        indice->profundidadePasseio[posicao] = indice->profundidade[atual];
+        indice->saida[atual] = posicao++;
+        const Sala *sala = &mapa->salas[atual];
+        uint32_t proxima;
+        if (anterior == indice->pai[atual]) {
+            // Chegou de cima: desce pela esquerda, senão pela direita, senão volta.
+            proxima = sala->esquerda != SEM_SALA ? sala->esquerda : sala->direita;
+        } else if (anterior == sala->esquerda) {
+            // Voltou da esquerda: falta a direita.
+            proxima = sala->direita;
+        } else {
+            proxima = SEM_SALA;
+        }
+        if (proxima != SEM_SALA) {
+            indice->pai[proxima] = atual;
+            indice->profundidade[proxima] = indice->profundidade[atual] + 1;
+            indice->entrada[proxima] = posicao;
+        } else if ((proxima = indice->pai[atual]) == SEM_SALA) {
+            break; // De volta ao Hall, sem mais caminhos
+        }
+        anterior = atual;
+        atual = proxima;
+    }
+    indice->tamanhoPasseio = posicao;
+
+    // Tabela esparsa sobre os blocos do passeio. Com salas fora do alcance do
+    // Hall o passeio é mais curto e usa só o começo de cada nível.
+    indice->numBlocos = (posicao + TAM_BLOCO - 1) / TAM_BLOCO;
+    for (uint32_t b = 0; b < indice->numBlocos; b++) {
+        uint32_t fim = (b + 1) * TAM_BLOCO - 1 < posicao - 1 ? (b + 1) * TAM_BLOCO - 1 : posicao - 1;
+        indice->minimos[b] = maisRasaDireta(indice, b * TAM_BLOCO, fim);
+    }
+    for (int k = 1; k < niveis; k++) {
+        const uint32_t *anteriores = indice->minimos + (size_t)(k - 1) * indice->tamanhoNivel;
+        uint32_t *nivel = indice->minimos + (size_t)k * indice->tamanhoNivel;
+        for (uint32_t b = 0; b + (1u << k) <= indice->numBlocos; b++) {
+            nivel[b] = maisRasa(indice, anteriores[b], anteriores[b + (1u << (k - 1))]);
+        }
+    }
+    return 0;
+}
+
+void liberarIndice(IndiceMapa *indice) {
+    free(indice->pai);
+    memset(indice, 0, sizeof(*indice));
+}
+
+/**
+ * @brief Procura uma sala pelo nome exato.
+ * @return uint32_t: Índice da sala, ou SEM_SALA se nenhuma tem esse nome.
+ */
+uint32_t buscarSala(const Mapa *mapa, const IndiceMapa *indice, const char *nome) {
+    uint32_t posicao = espalharNome(nome) & indice->mascaraNomes;
+    for (uint32_t sala; (sala = indice->nomes[posicao]) != SEM_SALA; posicao = (posicao + 1) & indice->mascaraNomes) {
+        if (strcmp(nomeSala(mapa, sala), nome) == 0) {
+            return sala;
+        }
+    }
+    return SEM_SALA;
+}
+
+/**
+ * @brief Sala mais profunda que está no caminho do Hall até 'a' e até 'b'.
+ * @return uint32_t: O ancestral comum, ou SEM_SALA se uma delas não é alcançável a partir do Hall.
+ */
+uint32_t ancestralComum(const IndiceMapa *indice, uint32_t a, uint32_t b) {
+    uint32_t de = indice->entrada[a], ate = indice->entrada[b];
+    if (de == SEM_SALA || ate == SEM_SALA) {
+        return SEM_SALA;
+    }
+    if (de > ate) {
+        uint32_t troca = de;
+        de = ate;
+        ate = troca;
+    }
+    uint32_t blocoDe = de / TAM_BLOCO, blocoAte = ate / TAM_BLOCO;
+    if (blocoAte - blocoDe <= 1) {
+        return indice->passeio[maisRasaDireta(indice, de, ate)];
+    }
+    // Pontas parciais percorridas; os blocos inteiros do meio vêm da tabela esparsa.
+    uint32_t melhor = maisRasa(indice, maisRasaDireta(indice, de, (blocoDe + 1) * TAM_BLOCO - 1),
+                               maisRasaDireta(indice, blocoAte * TAM_BLOCO, ate));
+    uint32_t primeiro = blocoDe + 1, quantidade = blocoAte - primeiro;
+    int k = 31 - __builtin_clz(quantidade);
+    const uint32_t *nivel = indice->minimos + (size_t)k * indice->tamanhoNivel;
+    melhor = maisRasa(indice, melhor, nivel[primeiro]);
+    melhor = maisRasa(indice, melhor, nivel[blocoAte - (1u << k)]);
+    return indice->passeio[melhor];
+}
+
+/**
+ * @brief Número de passos entre duas salas (subindo até o ancestral comum e descendo).
+ * @return uint32_t: A distância, ou UINT32_MAX se não há caminho entre elas.
+ */
+uint32_t distanciaSalas(const IndiceMapa *indice, uint32_t a, uint32_t b) {
+    uint32_t comum = ancestralComum(indice, a, b);
+    if (comum == SEM_SALA) {
+        return UINT32_MAX;
+    }
+    return indice->profundidade[a] + indice->profundidade[b] - 2 * indice->profundidade[comum];
+}
+
+/**
+ * @brief Primeira sala do caminho de 'origem' até 'destino', em O(1): se a
+ * origem está acima do destino (o passeio do destino cabe no da origem), desce
+ * pelo filho que contém o destino; senão, sobe.
+ * @return uint32_t: A próxima sala, ou SEM_SALA se já chegou ou não há caminho.
+ */
+uint32_t proximoPasso(const Mapa *mapa, const IndiceMapa *indice, uint32_t origem, uint32_t destino) {
+    if (origem == destino || indice->entrada[origem] == SEM_SALA || indice->entrada[destino] == SEM_SALA) {
+        return SEM_SALA;
+    }
+    uint32_t entradaDestino = indice->entrada[destino];
+    if (indice->entrada[origem] < entradaDestino && entradaDestino <= indice->saida[origem]) {
+        uint32_t esquerda = mapa->salas[origem].esquerda;
+        if (esquerda != SEM_SALA && indice->entrada[esquerda] <= entradaDestino &&
+            entradaDestino <= indice->saida[esquerda]) {
+            return esquerda;
+        }
+        return mapa->salas[origem].direita;
+    }
+    return indice->pai[origem];
+}
+
+/**
+ * @brief Mostra o caminho entre duas salas, passo a passo (os primeiros 20).
+ */
+void exibirCaminho(const Mapa *mapa, const IndiceMapa *indice, uint32_t origem, uint32_t destino) {
+    uint32_t distancia = distanciaSalas(indice, origem, destino);
+    if (distancia == UINT32_MAX) {
+        printf("[AVISO]: Não há caminho entre '%s' e '%s' a partir do Hall.\n",
+               nomeSala(mapa, origem), nomeSala(mapa, destino));
+        return;
+    }
+    uint32_t comum = ancestralComum(indice, origem, destino);
+    printf("Caminho de '%s' (nível %u) até '%s' (nível %u): %u passos, passando por '%s'.\n",
+           nomeSala(mapa, origem), indice->profundidade[origem], nomeSala(mapa, destino),
+           indice->profundidade[destino], distancia, nomeSala(mapa, comum));
+    uint32_t atual = origem;
+    for (uint32_t passo = 1; passo <= distancia && passo <= 20; passo++) {
+        uint32_t proxima = proximoPasso(mapa, indice, atual, destino);
+        const char *direcao = proxima == indice->pai[atual] ? "Volte"
+                              : proxima == mapa->salas[atual].esquerda ? "(E)squerda" : "(D)ireita";
+        printf("  %2u. %-10s -> %s\n", passo, direcao, nomeSala(mapa, proxima));
+        atual = proxima;
+    }
+    if (distancia > 20) {
+        printf("  ... mais %u passos.\n", distancia - 20);
+    }
+}
+
+// -------------------------------------------------------------------
+// ----------------------- PISTAS E SUSPEITOS ------------------------
+// -------------------------------------------------------------------
+
+static int tabelaIniciar(TabelaTextos *t, uint32_t capacidade) {
+    t->chaves = calloc(capacidade, sizeof(const char *));
+    t->valores = malloc(sizeof(uint32_t) * capacidade);
+    t->mascara = capacidade - 1;
+    t->total = 0;
+    if (t->chaves == NULL || t->valores == NULL) {
+        free(t->chaves);
+        free(t->valores);
+        t->chaves = NULL;
+        t->valores = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+static void tabelaLiberar(TabelaTextos *t) {
+    free(t->chaves);
+    free(t->valores);
+    t->chaves = NULL;
+    t->valores = NULL;
+}
+
+/**
+ * @brief Posição de 'chave' na tabela: onde ela está, ou a posição livre onde entraria.
+ */
+static uint32_t tabelaPosicao(const TabelaTextos *t, const char *chave) {
+    uint32_t posicao = espalharNome(chave) & t->mascara;
+    while (t->chaves[posicao] != NULL && strcmp(t->chaves[posicao], chave) != 0) {
+        posicao = (posicao + 1) & t->mascara;
+    }
+    return posicao;
+}
+
+static uint32_t tabelaBuscar(const TabelaTextos *t, const char *chave) {
+    uint32_t posicao = tabelaPosicao(t, chave);
+    return t->chaves[posicao] != NULL ? t->valores[posicao] : SEM_SUSPEITO;
+}
+
+/**
+ * @brief Insere ou troca o valor de 'chave'. A tabela dobra quando chega à
+ * metade, para que as sondagens continuem curtas.
+ * @return int: 0 em caso de sucesso, -1 se faltou memória.
+ */
+static int tabelaGuardar(TabelaTextos *t, const char *chave, uint32_t valor) {
+    if (2 * (t->total + 1) > t->mascara + 1) {
+        TabelaTextos maior;
+        if (tabelaIniciar(&maior, 2 * (t->mascara + 1)) != 0) {
+            return -1;
+        }
+        for (uint32_t i = 0; i <= t->mascara; i++) {
+            if (t->chaves[i] != NULL) {
+                uint32_t posicao = tabelaPosicao(&maior, t->chaves[i]);
+                maior.chaves[posicao] = t->chaves[i];
+                maior.valores[posicao] = t->valores[i];
+            }
+        }
+        maior.total = t->total;
+        tabelaLiberar(t);
+        *t = maior;
+    }
+    uint32_t posicao = tabelaPosicao(t, chave);
+    t->total += t->chaves[posicao] == NULL;
+    t->chaves[posicao] = chave;
+    t->valores[posicao] = valor;
+    return 0;
+}
+
+/**
+ * @brief Prepara um caderno vazio.
+ * @return int: 0 em caso de sucesso, -1 se faltou memória.
+ */
+int cadernoIniciar(CadernoPistas *caderno) {
+    memset(caderno, 0, sizeof(*caderno));
+    caderno->raiz = SEM_NO;
+    caderno->lider = SEM_SUSPEITO;
+    if (tabelaIniciar(&caderno->suspeitoDaPista, 16) != 0 || tabelaIniciar(&caderno->indiceSuspeito, 16) != 0) {
+        cadernoLiberar(caderno);
+        return -1;
+    }
+    return 0;
+}
+
+void cadernoLiberar(CadernoPistas *caderno) {
+    free(caderno->nos);
+    free(caderno->suspeitos);
+    free(caderno->contagem);
+    tabelaLiberar(&caderno->suspeitoDaPista);
+    tabelaLiberar(&caderno->indiceSuspeito);
+    memset(caderno, 0, sizeof(*caderno));
+}
+
+/**
+ * @brief Liga 'pista' a 'suspeito' (cadastrando o suspeito na primeira vez).
+ * Os textos não são copiados e têm de viver tanto quanto o caderno.
+ * @return int: 0 em caso de sucesso, -1 se faltou memória.
+ */
+int associarPista(CadernoPistas *caderno, const char *pista, const char *suspeito) {
+    uint32_t indice = tabelaBuscar(&caderno->indiceSuspeito, suspeito);
+    if (indice == SEM_SUSPEITO) {
+        if (caderno->numSuspeitos == caderno->capacidadeSuspeitos) {
+            uint32_t capacidade = caderno->capacidadeSuspeitos ? 2 * caderno->capacidadeSuspeitos : 8;
+            const char **nomes = realloc(caderno->suspeitos, sizeof(const char *) * capacidade);
+            if (nomes == NULL) {
+                return -1;
+            }
+            caderno->suspeitos = nomes;
+            uint32_t *contagem = realloc(caderno->contagem, sizeof(uint32_t) * capacidade);
+            if (contagem == NULL) {
+                return -1;
+            }
+            caderno->contagem = contagem;
+            caderno->capacidadeSuspeitos = capacidade;
+        }
+        indice = caderno->numSuspeitos;
+        if (tabelaGuardar(&caderno->indiceSuspeito, suspeito, indice) != 0) {
+            return -1;
+        }
+        caderno->suspeitos[indice] = suspeito;
+        caderno->contagem[indice] = 0;
+        caderno->numSuspeitos++;
+    }
+    return tabelaGuardar(&caderno->suspeitoDaPista, pista, indice);
+}
+
+/**
+ * @brief Liga as pistas das salas do mapa aos seus suspeitos.
+ * @return int: 0 em caso de sucesso, -1 se faltou memória.
+ */
+int associarPistasDoMapa(CadernoPistas *caderno, const Mapa *mapa) {
+    for (uint32_t i = 0; mapa->pistas != NULL && i < mapa->numSalas; i++) {
+        const PistaSala *sala = &mapa->pistas[i];
+        if (sala->pista != SEM_TEXTO && sala->suspeito != SEM_TEXTO &&
+            associarPista(caderno, mapa->textos + sala->pista, mapa->textos + sala->suspeito) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Os 8 primeiros bytes do texto (completados com zeros) como número,
+ * com o primeiro byte no topo: comparar prefixos dá a mesma ordem do strcmp().
+ */
+static uint64_t prefixoPista(const char *texto) {
+    uint64_t prefixo = 0;
+    int i = 0;
+    for (; i < 8 && texto[i] != '\0'; i++) {
+        prefixo = prefixo << 8 | (unsigned char)texto[i];
+    }
+    return prefixo << (8 * (8 - i));
+}
+
+/**
+ * @brief Compara a pista com o texto do nó; o texto só é lido se os prefixos empatam.
+ */
+static int compararPista(const NoPista *no, uint64_t prefixo, const char *pista) {
+    if (prefixo != no->prefixo) {
+        return prefixo < no->prefixo ? -1 : 1;
+    }
+    return strcmp(pista, no->texto);
+}
+
+static int alturaNo(const CadernoPistas *c, uint32_t no) {
+    return no != SEM_NO ? c->nos[no].altura : 0;
+}
+
+static void atualizarAltura(CadernoPistas *c, uint32_t no) {
+    int esquerda = alturaNo(c, c->nos[no].esquerda), direita = alturaNo(c, c->nos[no].direita);
+    c->nos[no].altura = (esquerda > direita ? esquerda : direita) + 1;
+}
+
+static uint32_t girarDireita(CadernoPistas *c, uint32_t no) {
+    uint32_t nova = c->nos[no].esquerda;
+    c->nos[no].esquerda = c->nos[nova].direita;
+    c->nos[nova].direita = no;
+    atualizarAltura(c, no);
+    atualizarAltura(c, nova);
+    return nova;
+}
+
+static uint32_t girarEsquerda(CadernoPistas *c, uint32_t no) {
+    uint32_t nova = c->nos[no].direita;
+    c->nos[no].direita = c->nos[nova].esquerda;
+    c->nos[nova].esquerda = no;
+    atualizarAltura(c, no);
+    atualizarAltura(c, nova);
+    return nova;
+}
+
+/**
+ * @brief Recalcula a altura de 'no' e, se as subárvores diferem em mais de 1,
+ * aplica a rotação simples ou dupla da AVL.
+ * @return uint32_t: A nova raiz da subárvore.
+ */
+static uint32_t rebalancear(CadernoPistas *c, uint32_t no) {
+    atualizarAltura(c, no);
+    int balanco = alturaNo(c, c->nos[no].esquerda) - alturaNo(c, c->nos[no].direita);
+    if (balanco > 1) {
+        uint32_t filho = c->nos[no].esquerda;
+        if (alturaNo(c, c->nos[filho].esquerda) < alturaNo(c, c->nos[filho].direita)) {
+            c->nos[no].esquerda = girarEsquerda(c, filho);
+        }
+        return girarDireita(c, no);
+    }
+    if (balanco < -1) {
+        uint32_t filho = c->nos[no].direita;
+        if (alturaNo(c, c->nos[filho].direita) < alturaNo(c, c->nos[filho].esquerda)) {
+            c->nos[no].direita = girarDireita(c, filho);
+        }
+        return girarEsquerda(c, no);
+    }
+    return no;
+}
+
+/**
+ * @brief Coloca a pista no caderno. A descida guarda o caminho (a altura de
+ * uma AVL não passa de 1,44 log2 n, então 64 posições bastam) e a subida
+ * religa e rebalanceia até o primeiro nó que não mudou. Se a pista é nova e
+ * aponta para um suspeito, a contagem dele sobe e o líder é atualizado.
+ * @return int: 1 se a pista é nova, 0 se já estava no caderno, -1 se faltou memória.
+ */
+int coletarPista(CadernoPistas *caderno, const char *pista) {
+    uint32_t caminho[64];
+    int foiEsquerda[64];
+    int profundidade = 0;
+    uint64_t prefixo = prefixoPista(pista);
+    for (uint32_t atual = caderno->raiz; atual != SEM_NO; profundidade++) {
+        int comparacao = compararPista(&caderno->nos[atual], prefixo, pista);
+        if (comparacao == 0) {
+            return 0;
+        }
+        caminho[profundidade] = atual;
+        foiEsquerda[profundidade] = comparacao < 0;
+        atual = comparacao < 0 ? caderno->nos[atual].esquerda : caderno->nos[atual].direita;
+    }
+    if (caderno->numNos == caderno->capacidadeNos) {
+        uint32_t capacidade = caderno->capacidadeNos ? 2 * caderno->capacidadeNos : 16;
+        NoPista *nos = realloc(caderno->nos, sizeof(NoPista) * capacidade);
+        if (nos == NULL) {
+            return -1;
+        }
+        caderno->nos = nos;
+        caderno->capacidadeNos = capacidade;
+    }
+    uint32_t subarvore = caderno->numNos++;
+    caderno->nos[subarvore] = (NoPista){prefixo, pista, SEM_NO, SEM_NO, 1};
+
+    int i = profundidade - 1;
+    for (; i >= 0; i--) {
+        uint32_t pai = caminho[i];
+        if (foiEsquerda[i]) {
+            caderno->nos[pai].esquerda = subarvore;
+        } else {
+            caderno->nos[pai].direita = subarvore;
+        }
+        int alturaAntes = caderno->nos[pai].altura;
+        subarvore = rebalancear(caderno, pai);
+        if (subarvore == pai && caderno->nos[pai].altura == alturaAntes) {
+            break; // Daqui para cima nada muda
+        }
+    }
+    if (i < 0) {
+        caderno->raiz = subarvore;
+    }
+
+    uint32_t suspeito = tabelaBuscar(&caderno->suspeitoDaPista, pista);
+    if (suspeito != SEM_SUSPEITO) {
+        caderno->contagem[suspeito]++;
+        if (caderno->lider == SEM_SUSPEITO || caderno->contagem[suspeito] > caderno->contagem[caderno->lider]) {
+            caderno->lider = suspeito;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Verifica se a pista já foi coletada, em O(log n).
+ * @return int: 1 (coletada) ou 0 (não coletada).
+ */
+int pistaColetada(const CadernoPistas *caderno, const char *pista) {
+    uint32_t atual = caderno->raiz;
+    uint64_t prefixo = prefixoPista(pista);
+    while (atual != SEM_NO) {
+        int comparacao = compararPista(&caderno->nos[atual], prefixo, pista);
+        if (comparacao == 0) {
+            return 1;
+        }
+        atual = comparacao < 0 ? caderno->nos[atual].esquerda : caderno->nos[atual].direita;
+    }
+    return 0;
+}
+
+/**
+ * @brief Índice do suspeito pelo nome, ou SEM_SUSPEITO.
+ */
+uint32_t buscarSuspeito(const CadernoPistas *caderno, const char *nome) {
+    return tabelaBuscar(&caderno->indiceSuspeito, nome);
+}
+
+/**
+ * @brief Suspeito para o qual a pista aponta, ou SEM_SUSPEITO.
+ */
+uint32_t suspeitoDaPista(const CadernoPistas *caderno, const char *pista) {
+    return tabelaBuscar(&caderno->suspeitoDaPista, pista);
 }
 
 /**
- * @brief Monta a estrutura da árvore binária (mapa) da mansão.
- * * @param raiz Ponteiro para o ponteiro da raiz da árvore.
+ * @brief Suspeito com mais pistas coletadas, em O(1); em empate, o que chegou
+ * primeiro à contagem. SEM_SUSPEITO se nenhuma pista com suspeito foi coletada.
  */
-void montarMapa(Sala **raiz) {
-    // Nível 0 (Raiz)
-    *raiz = criarSala("Hall de Entrada");
-
-    // Nível 1
-    Sala *cozinha = criarSala("Cozinha");
-    Sala *salaEstar = criarSala("Sala de Estar");
-    (*raiz)->esquerda = cozinha;
-    (*raiz)->direita = salaEstar;
-
-    // Nível 2
-    cozinha->esquerda = criarSala("Despensa"); // Nó Folha
-    
-    Sala *biblioteca = criarSala("Biblioteca");
-    cozinha->direita = biblioteca;
-    
-    Sala *jardim = criarSala("Jardim");
-    salaEstar->esquerda = jardim; // Nó Folha
-    
-    Sala *escritorio = criarSala("Escritório");
-    salaEstar->direita = escritorio;
-
-    // Nível 3 (Nós Folha)
-    biblioteca->esquerda = criarSala("Sala Secreta");
-    biblioteca->direita = NULL; // Caminho Inexistente
-    
-    escritorio->esquerda = criarSala("Porão");
-    escritorio->direita = criarSala("Quarto Principal");
+uint32_t suspeitoPrincipal(const CadernoPistas *caderno) {
+    return caderno->lider;
 }
 
 /**
- * @brief Libera a memória alocada dinamicamente para a árvore.
- * * @param raiz O nó raiz da árvore (ou subárvore).
+ * @brief Lista as pistas coletadas em ordem alfabética (percurso em ordem com
+ * pilha explícita) e o suspeito de cada uma.
  */
-void liberarMapa(Sala *raiz) {
-    if (raiz != NULL) {
-        // Post-order traversal para liberar primeiro os filhos
-        liberarMapa(raiz->esquerda);
-        liberarMapa(raiz->direita);
-        free(raiz);
+void exibirPistas(const CadernoPistas *caderno) {
+    printf("\n--- PISTAS COLETADAS (%u) ---\n", caderno->numNos);
+    uint32_t pilha[64];
+    int topo = 0;
+    uint32_t atual = caderno->raiz;
+    while (atual != SEM_NO || topo > 0) {
+        while (atual != SEM_NO) {
+            pilha[topo++] = atual;
+            atual = caderno->nos[atual].esquerda;
+        }
+        atual = pilha[--topo];
+        uint32_t suspeito = suspeitoDaPista(caderno, caderno->nos[atual].texto);
+        printf("  - %s -> %s\n", caderno->nos[atual].texto,
+               suspeito != SEM_SUSPEITO ? caderno->suspeitos[suspeito] : "(sem suspeito)");
+        atual = caderno->nos[atual].direita;
     }
 }
 
-
 // -------------------------------------------------------------------
 // -------------------- FUNÇÃO DE EXPLORAÇÃO -------------------------
 // -------------------------------------------------------------------
 
 /**
  * @brief Permite a navegação interativa do jogador pela árvore.
- * * @param atual A sala atual onde o jogador se encontra.
+ * * @param mapa O mapa da mansão.
+ * @param indice Índice do mapa, para a busca de cômodos pelo nome.
+ * @param caderno Caderno onde as pistas das salas visitadas são coletadas.
+ * @param atual Índice da sala onde o jogador se encontra.
  */
-void explorarSalas(Sala *atual) {
-    char escolha;
+void explorarSalas(const Mapa *mapa, const IndiceMapa *indice, CadernoPistas *caderno, uint32_t atual) {
+    int escolha;
     
     printf("\n--- INÍCIO DA EXPLORAÇÃO ---\n");
     
     // O loop continua enquanto o jogador não sair ou não atingir um nó-folha
-    while (atual != NULL) {
-        printf("\nVocê está em: **%s**\n", atual->nome);
+    while (atual != SEM_SALA) {
+        const Sala *sala = &mapa->salas[atual];
+        printf("\nVocê está em: **%s**\n", nomeSala(mapa, atual));
+        uint32_t pista = mapa->pistas != NULL ? mapa->pistas[atual].pista : SEM_TEXTO;
+        if (pista != SEM_TEXTO && coletarPista(caderno, mapa->textos + pista) == 1) {
+            registrarInfo("🔎 Pista encontrada: %s\n", mapa->textos + pista);
+        }
         
         // Verifica se é um nó-folha (não tem caminhos à esquerda nem à direita)
-        if (atual->esquerda == NULL && atual->direita == NULL) {
+        if (sala->esquerda == SEM_SALA && sala->direita == SEM_SALA) {
             printf("\n[FIM DA LINHA] 🛑 Esta sala não possui mais caminhos.\n");
             break; 
         }
 
         // --- Opções de Navegação ---
         printf("Caminhos disponíveis:\n");
-        if (atual->esquerda != NULL) {
-            printf("  (E)squerda: %s\n", atual->esquerda->nome);
+        if (sala->esquerda != SEM_SALA) {
+            printf("  (E)squerda: %s\n", nomeSala(mapa, sala->esquerda));
         }
-        if (atual->direita != NULL) {
-            printf("  (D)ireita: %s\n", atual->direita->nome);
+        if (sala->direita != SEM_SALA) {
+            printf("  (D)ireita: %s\n", nomeSala(mapa, sala->direita));
         }
+        printf("  (B)uscar um cômodo\n");
         printf("  (S)air da Mansão\n");
         
-        printf("Escolha o caminho (e/d/s): ");
+        printf("Escolha o caminho (e/d/b/s): ");
         
-        // Lendo a escolha do jogador
-        if (scanf(" %c", &escolha) != 1) {
-            printf("\n[AVISO]: Entrada inválida. Tente novamente.\n");
-            // Limpa o buffer de entrada
-            while (getchar() != '\n'); 
-            continue;
+        // Lendo a escolha do jogador; o fim da entrada (uma sessão
+        // redirecionada que acabou) conta como sair da mansão.
+        escolha = entradaCaractere(&entradaPadrao);
+        if (escolha < 0) {
+            escolha = 's';
         }
         
         // Converte para minúsculo para facilitar a validação
@@ -142,49 +1328,1051 @@ void explorarSalas(Sala *atual) {
 
         // --- Processa a Escolha ---
         if (escolha == 'e') {
-            if (atual->esquerda != NULL) {
-                printf(">> Você seguiu para a Esquerda.\n");
-                atual = atual->esquerda; // Move para a esquerda
+            if (sala->esquerda != SEM_SALA) {
+                registrarInfo(">> Você seguiu para a Esquerda.\n");
+                atual = sala->esquerda; // Move para a esquerda
             } else {
-                printf("[AVISO]: Não há caminho para a Esquerda nesta sala.\n");
+                registrarAviso("[AVISO]: Não há caminho para a Esquerda nesta sala.\n");
             }
         } else if (escolha == 'd') {
-            if (atual->direita != NULL) {
-                printf(">> Você seguiu para a Direita.\n");
-                atual = atual->direita; // Move para a direita
+            if (sala->direita != SEM_SALA) {
+                registrarInfo(">> Você seguiu para a Direita.\n");
+                atual = sala->direita; // Move para a direita
+            } else {
+                registrarAviso("[AVISO]: Não há caminho para a Direita nesta sala.\n");
+            }
+        } else if (escolha == 'b') {
+            char nome[MAX_NOME];
+            printf("Nome do cômodo: ");
+            if (entradaPular(&entradaPadrao) < 0) {
+                continue;
+            }
+            entradaLinha(&entradaPadrao, nome, sizeof(nome));
+            uint32_t alvo = buscarSala(mapa, indice, nome);
+            uint32_t proxima = alvo != SEM_SALA ? proximoPasso(mapa, indice, atual, alvo) : SEM_SALA;
+            if (alvo == SEM_SALA) {
+                printf("[AVISO]: Nenhum cômodo se chama '%s'.\n", nome);
+            } else if (alvo == atual) {
+                printf("[PISTA]: Você já está em '%s'.\n", nome);
+            } else if (proxima == SEM_SALA) {
+                printf("[PISTA]: '%s' não tem ligação com o Hall de Entrada.\n", nome);
+            } else if (proxima == indice->pai[atual]) {
+                printf("[PISTA]: '%s' (nível %u) não fica adiante daqui; o caminho passa por '%s'.\n", nome,
+                       indice->profundidade[alvo], nomeSala(mapa, ancestralComum(indice, atual, alvo)));
             } else {
-                printf("[AVISO]: Não há caminho para a Direita nesta sala.\n");
+                printf("[PISTA]: '%s' fica %u cômodos adiante: siga pela %s.\n", nome,
+                       distanciaSalas(indice, atual, alvo), proxima == sala->esquerda ? "(E)squerda" : "(D)ireita");
             }
         } else if (escolha == 's') {
             printf("\n>> 🚪 Você decidiu sair da mansão. Exploração encerrada.\n");
             break;
         } else {
-            printf("[AVISO]: Opção inválida. Use 'e' (esquerda), 'd' (direita) ou 's' (sair).\n");
+            registrarAviso("[AVISO]: Opção inválida. Use 'e' (esquerda), 'd' (direita), 'b' (buscar) ou 's' (sair).\n");
+        }
+    }
+}
+
+// -------------------------------------------------------------------
+// ----------------------- MAPAS GERADOS -----------------------------
+// -------------------------------------------------------------------
+
+static uint64_t sortearProximo(uint64_t *estado) {
+    // xorshift64*: basta para sortear o formato das mansões geradas
+    *estado ^= *estado >> 12;
+    *estado ^= *estado << 25;
+    *estado ^= *estado >> 27;
+    return *estado * 2685821657736338717ULL;
+}
+
+/**
+ * @brief Sorteia o formato de uma mansão com 'n' salas. Na forma "aleatoria"
+ * cada sala nova ocupa um caminho livre sorteado entre todas as salas já
+ * criadas (árvore baixa); no "corredor" as salas formam uma fila de um lado só,
+ * com alguns cômodos sem saída do outro (árvore com a altura do número de salas).
+ * @return uint32_t*: Vetor com 2 * n filhos (esquerda e direita de cada sala,
+ * SEM_SALA se não há), ou NULL se faltou memória.
+ */
+static uint32_t *sortearArvore(uint32_t n, int corredor, uint64_t *estado) {
+    uint32_t *filhos = malloc(sizeof(uint32_t) * 2 * (size_t)n);
+    uint32_t *livres = corredor ? NULL : malloc(sizeof(uint32_t) * (2 * (size_t)n + 1));
+    if (filhos == NULL || (!corredor && livres == NULL)) {
+        free(filhos);
+        free(livres);
+        return NULL;
+    }
+    memset(filhos, 0xFF, sizeof(uint32_t) * 2 * (size_t)n);
+    if (corredor) {
+        // O corredor segue por um lado sorteado; às vezes o outro lado é um cômodo sem saída.
+        uint32_t atual = 0, proxima = 1;
+        while (proxima < n) {
+            uint32_t lado = (uint32_t)(sortearProximo(estado) & 1);
+            if (proxima + 1 < n && sortearProximo(estado) % 4 == 0) {
+                filhos[2 * atual + 1 - lado] = proxima++;
+            }
+            filhos[2 * atual + lado] = proxima;
+            atual = proxima++;
+        }
+    } else {
+        // 'livres' guarda os caminhos ainda sem sala (2 * sala + lado).
+        size_t numLivres = 0;
+        livres[numLivres++] = 0;
+        livres[numLivres++] = 1;
+        for (uint32_t i = 1; i < n; i++) {
+            size_t escolhido = (size_t)(sortearProximo(estado) % numLivres);
+            filhos[livres[escolhido]] = i;
+            livres[escolhido] = livres[--numLivres];
+            livres[numLivres++] = 2 * i;
+            livres[numLivres++] = 2 * i + 1;
+        }
+    }
+    free(livres);
+    return filhos;
+}
+
+/**
+ * @brief "./DetectiveQuest --gerar-mansao arquivo [salas] [forma] [semente]":
+ * grava um mapa sorteado por sortearArvore() com 'salas' cômodos. A forma
+ * "desconexa" é a aleatória com 1 de cada 8 passagens fechadas: as salas depois
+ * delas ficam fora do alcance do Hall (os índices precisam ignorá-las).
+ */
+int gerarMansao(int argc, char *argv[]) {
+    static const char *nomesBase[] = {"Hall", "Cozinha", "Sala de Estar", "Despensa", "Biblioteca",
+                                      "Jardim", "Escritório", "Sala Secreta", "Porão", "Quarto"};
+    long long total = argc > 3 ? atoll(argv[3]) : 1000000;
+    const char *forma = argc > 4 ? argv[4] : "aleatoria";
+    uint64_t estado = argc > 5 ? strtoull(argv[5], NULL, 10) : 2024;
+    int corredor = strcmp(forma, "corredor") == 0, desconexa = strcmp(forma, "desconexa") == 0;
+    if (argc < 3 || total <= 0 || total > (long long)MAX_SALAS ||
+        (!corredor && !desconexa && strcmp(forma, "aleatoria") != 0)) {
+        printf("[ERRO]: Uso: ./DetectiveQuest --gerar-mansao arquivo [salas] [aleatoria|corredor|desconexa] "
+               "[semente]\n");
+        return 1;
+    }
+    estado = estado != 0 ? estado : 1;
+    uint32_t n = (uint32_t)total;
+    uint32_t *filhos = sortearArvore(n, corredor, &estado);
+    if (filhos == NULL) {
+        printf("[ERRO]: Falha na alocação de memória.\n");
+        return 1;
+    }
+    for (size_t i = 0; desconexa && i < 2 * (size_t)n; i++) {
+        if (filhos[i] != SEM_SALA && sortearProximo(&estado) % 8 == 0) {
+            filhos[i] = SEM_SALA;
+        }
+    }
+
+    FILE *arquivo = fopen(argv[2], "w");
+    if (arquivo == NULL) {
+        printf("[ERRO]: Não foi possível criar '%s'.\n", argv[2]);
+        free(filhos);
+        return 1;
+    }
+    fprintf(arquivo, "# Mansão gerada: %u salas, forma %s\n", n, forma);
+    for (uint32_t i = 0; i < n; i++) {
+        fprintf(arquivo, "%s %u;", nomesBase[i % 10], i);
+        for (int lado = 0; lado < 2; lado++) {
+            uint32_t filho = filhos[2 * i + lado];
+            if (filho == SEM_SALA) {
+                fprintf(arquivo, lado == 0 ? "-;" : "-\n");
+            } else {
+                fprintf(arquivo, lado == 0 ? "%u;" : "%u\n", filho);
+            }
+        }
+    }
+    int erro = fclose(arquivo) != 0;
+    free(filhos);
+    if (erro) {
+        printf("[ERRO]: Falha ao gravar '%s'.\n", argv[2]);
+        return 1;
+    }
+    printf(">> 🏗️ Mansão com %u salas (%s) gravada em '%s'.\n", n, forma, argv[2]);
+    return 0;
+}
+
+static double segundosAgora() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec + (double)t.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief "./DetectiveQuest --bench-mansao arquivo": mede o carregamento e a
+ * liberação de um mapa e mostra sua altura, calculada sem recursão.
+ */
+int executarBenchMansao(int argc, char *argv[]) {
+    if (argc < 3) {
+        printf("[ERRO]: Uso: ./DetectiveQuest --bench-mansao arquivo\n");
+        return 1;
+    }
+    Mapa mapa;
+    double inicio = segundosAgora();
+    if (carregarMapaArquivo(&mapa, argv[2]) != 0) {
+        return 1;
+    }
+    double tempoCarga = segundosAgora() - inicio;
+
+    // Altura por largura: uma fila com os índices de um nível de cada vez.
+    uint32_t *fila = malloc(sizeof(uint32_t) * mapa.numSalas);
+    if (fila == NULL) {
+        printf("[ERRO]: Falha na alocação de memória.\n");
+        liberarMapa(&mapa);
+        return 1;
+    }
+    uint32_t inicioFila = 0, fimFila = 0, altura = 0, alcancaveis = 0;
+    fila[fimFila++] = 0;
+    while (inicioFila < fimFila) {
+        uint32_t fimNivel = fimFila;
+        altura++;
+        for (; inicioFila < fimNivel; inicioFila++) {
+            const Sala *sala = &mapa.salas[fila[inicioFila]];
+            if (sala->esquerda != SEM_SALA) {
+                fila[fimFila++] = sala->esquerda;
+            }
+            if (sala->direita != SEM_SALA) {
+                fila[fimFila++] = sala->direita;
+            }
+        }
+    }
+    alcancaveis = fimFila;
+    free(fila);
+
+    uint32_t numSalas = mapa.numSalas;
+    inicio = segundosAgora();
+    liberarMapa(&mapa);
+    double tempoLiberar = segundosAgora() - inicio;
+
+    printf("--- BENCHMARK DO MAPA DA MANSÃO ---\n");
+    printf("Arquivo: %s | Salas: %u (%u alcançáveis a partir do Hall) | Altura: %u\n",
+           argv[2], numSalas, alcancaveis, altura);
+    printf("Carregamento: %.1f ms (%.0f salas/s) | Liberação: %.3f ms\n",
+           tempoCarga * 1e3, numSalas / tempoCarga, tempoLiberar * 1e3);
+    return 0;
+}
+
+/**
+ * @brief Monta direto na memória (sem passar por arquivo) um mapa sorteado por
+ * sortearArvore(), com os cômodos chamados "Sala 0", "Sala 1", ...
+ * @return int: 0 em caso de sucesso, -1 se faltou memória.
+ */
+static int sortearMapa(Mapa *mapa, uint32_t n, int corredor, uint64_t *estado) {
+    uint32_t *filhos = sortearArvore(n, corredor, estado);
+    size_t tamanhoTextos = (size_t)n * 16;
+    char *bloco = malloc((size_t)n * sizeof(Sala) + tamanhoTextos);
+    if (filhos == NULL || bloco == NULL) {
+        free(filhos);
+        free(bloco);
+        return -1;
+    }
+    mapa->salas = (Sala *)bloco;
+    mapa->numSalas = n;
+    mapa->textos = bloco + (size_t)n * sizeof(Sala);
+    mapa->pistas = NULL;
+    uint32_t usado = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        mapa->salas[i] = (Sala){usado, filhos[2 * i], filhos[2 * i + 1]};
+        usado += (uint32_t)sprintf(mapa->textos + usado, "Sala %u", i) + 1;
+    }
+    mapa->tamanhoTextos = usado;
+    free(filhos);
+    return 0;
+}
+
+/**
+ * @brief "./DetectiveQuest --exibir-mapa [arquivo|-] [sala] [linhas]": mostra a
+ * árvore do mapa padrão ("-") ou do arquivo a partir de um cômodo, achado por
+ * procurarSala() e listado por exibirMapa(), ambos sem recursão.
+ */
+int executarExibirMapa(int argc, char *argv[]) {
+    Mapa mapa;
+    int padrao = argc < 3 || strcmp(argv[2], "-") == 0;
+    long long linhas = argc > 4 ? atoll(argv[4]) : 200;
+    if (linhas <= 0) {
+        printf("[ERRO]: Uso: ./DetectiveQuest --exibir-mapa [arquivo|-] [sala] [linhas]\n");
+        return 1;
+    }
+    if ((padrao ? montarMapa(&mapa) : carregarMapaArquivo(&mapa, argv[2])) != 0) {
+        return 1;
+    }
+    uint32_t inicio = 0;
+    if (argc > 3) {
+        inicio = procurarSala(&mapa, 0, argv[3]);
+        if (inicio == SEM_SALA) {
+            printf("[AVISO]: Não existe um cômodo chamado '%s' abaixo do Hall.\n", argv[3]);
+            liberarMapa(&mapa);
+            return 1;
+        }
+    }
+    exibirMapa(&mapa, inicio, linhas > UINT32_MAX ? UINT32_MAX : (uint32_t)linhas);
+    liberarMapa(&mapa);
+    return 0;
+}
+
+/**
+ * @brief Faz 'descidas' descidas do Hall até um cômodo sem saída. O lado de
+ * cada passo sai dos bits do sorteio (se não há cômodo desse lado, vai pelo
+ * outro), então as descidas são as mesmas em qualquer organização do mapa.
+ * @param finais Recebe a posição do nome do cômodo final das primeiras 'numFinais' descidas.
+ * @return uint64_t: Total de passos dados.
+ */
+static uint64_t descerMapa(const Mapa *mapa, uint32_t descidas, uint64_t semente, uint32_t *finais,
+                           uint32_t numFinais) {
+    uint64_t estado = semente, passos = 0;
+    for (uint32_t d = 0; d < descidas; d++) {
+        uint32_t atual = 0;
+        uint64_t bits = sortearProximo(&estado);
+        int restantes = 64;
+        for (;;) {
+            const Sala *sala = &mapa->salas[atual];
+            if (sala->esquerda == SEM_SALA && sala->direita == SEM_SALA) {
+                break;
+            }
+            if (restantes == 0) {
+                bits = sortearProximo(&estado);
+                restantes = 64;
+            }
+            uint32_t lado = (uint32_t)(bits & 1);
+            bits >>= 1;
+            restantes--;
+            uint32_t proxima = lado ? sala->direita : sala->esquerda;
+            atual = proxima != SEM_SALA ? proxima : (lado ? sala->esquerda : sala->direita);
+            passos++;
+        }
+        if (d < numFinais) {
+            finais[d] = mapa->salas[atual].nome;
+        }
+    }
+    return passos;
+}
+
+/**
+ * @brief "./DetectiveQuest --bench-layout [salas] [descidas] [forma] [semente]":
+ * sorteia uma mansão na memória e mede as mesmas descidas aleatórias do Hall
+ * até as folhas com as salas na ordem de criação, nível a nível e em van Emde
+ * Boas. Confere que as descidas terminam nos mesmos cômodos em todas.
+ */
+int executarBenchLayout(int argc, char *argv[]) {
+    static const char *nomesLayout[] = {"Ordem de criação", "Largura", "van Emde Boas"};
+    long long total = argc > 2 ? atoll(argv[2]) : 16000000;
+    long long descidas = argc > 3 ? atoll(argv[3]) : 1000000;
+    const char *forma = argc > 4 ? argv[4] : "aleatoria";
+    uint64_t semente = argc > 5 ? strtoull(argv[5], NULL, 10) : 2024;
+    int corredor = strcmp(forma, "corredor") == 0;
+    if (total <= 0 || total > (long long)MAX_SALAS || descidas <= 0 || descidas > UINT32_MAX ||
+        (!corredor && strcmp(forma, "aleatoria") != 0)) {
+        printf("[ERRO]: Uso: ./DetectiveQuest --bench-layout [salas] [descidas] [aleatoria|corredor] [semente]\n");
+        return 1;
+    }
+    semente = semente != 0 ? semente : 1;
+    uint32_t numFinais = descidas < 1024 ? (uint32_t)descidas : 1024;
+    uint32_t finaisReferencia[1024], finais[1024];
+
+    printf("--- BENCHMARK DA ORGANIZAÇÃO DO MAPA ---\n");
+    printf("Salas: %lld (%s) | Descidas: %lld\n", total, forma, descidas);
+    double tempoReferencia = 0;
+    for (int layout = 0; layout < 3; layout++) {
+        // Cada organização parte do mesmo sorteio, para não manter três mapas na memória.
+        Mapa mapa;
+        uint64_t estado = semente;
+        if (sortearMapa(&mapa, (uint32_t)total, corredor, &estado) != 0) {
+            printf("[ERRO]: Falha na alocação de memória.\n");
+            return 1;
+        }
+        double tempoReorganizar = 0;
+        if (layout > 0) {
+            double inicio = segundosAgora();
+            if (reorganizarMapa(&mapa, layout == 1 ? LAYOUT_LARGURA : LAYOUT_VEB) != 0) {
+                printf("[ERRO]: Falha na alocação de memória.\n");
+                liberarMapa(&mapa);
+                return 1;
+            }
+            tempoReorganizar = segundosAgora() - inicio;
+        }
+        double inicio = segundosAgora();
+        uint64_t passos = descerMapa(&mapa, (uint32_t)descidas, semente, layout == 0 ? finaisReferencia : finais,
+                                     numFinais);
+        double tempo = segundosAgora() - inicio;
+        int iguais = layout == 0 || memcmp(finais, finaisReferencia, sizeof(uint32_t) * numFinais) == 0;
+        liberarMapa(&mapa);
+
+        if (layout == 0) {
+            tempoReferencia = tempo;
+        }
+        printf("%-17s: %7.1f ns/descida | %5.2f ns/passo | %.1f passos em média", nomesLayout[layout],
+               tempo * 1e9 / (double)descidas, tempo * 1e9 / (double)passos, (double)passos / (double)descidas);
+        if (layout > 0) {
+            printf(" | reorganização %.0f ms | %.2fx", tempoReorganizar * 1e3, tempoReferencia / tempo);
+        }
+        printf("\n");
+        if (!iguais) {
+            printf("[ERRO]: As descidas terminaram em cômodos diferentes.\n");
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief "./DetectiveQuest --caminho origem destino [arquivo]": mostra o
+ * caminho entre dois cômodos do mapa padrão ou do arquivo.
+ */
+int executarCaminho(int argc, char *argv[]) {
+    if (argc < 4) {
+        printf("[ERRO]: Uso: ./DetectiveQuest --caminho origem destino [arquivo]\n");
+        return 1;
+    }
+    Mapa mapa;
+    IndiceMapa indice;
+    if ((argc > 4 ? carregarMapaArquivo(&mapa, argv[4]) : montarMapa(&mapa)) != 0) {
+        return 1;
+    }
+    if (indexarMapa(&mapa, &indice) != 0) {
+        printf("[ERRO]: Falha na alocação de memória para o índice do mapa.\n");
+        liberarMapa(&mapa);
+        return 1;
+    }
+    uint32_t origem = buscarSala(&mapa, &indice, argv[2]);
+    uint32_t destino = buscarSala(&mapa, &indice, argv[3]);
+    int resultado = 0;
+    if (origem == SEM_SALA || destino == SEM_SALA) {
+        printf("[ERRO]: Nenhum cômodo se chama '%s'.\n", origem == SEM_SALA ? argv[2] : argv[3]);
+        resultado = 1;
+    } else {
+        exibirCaminho(&mapa, &indice, origem, destino);
+    }
+    liberarIndice(&indice);
+    liberarMapa(&mapa);
+    return resultado;
+}
+
+/**
+ * @brief "./DetectiveQuest --bench-caminhos arquivo [consultas]": mede a
+ * montagem do índice, a busca por nome e o ancestral comum de pares sorteados.
+ * Uma parte das consultas é conferida subindo pelos pais, sala a sala.
+ */
+int executarBenchCaminhos(int argc, char *argv[]) {
+    long consultas = argc > 3 ? atol(argv[3]) : 1000000;
+    if (argc < 3 || consultas <= 0) {
+        printf("[ERRO]: Uso: ./DetectiveQuest --bench-caminhos arquivo [consultas]\n");
+        return 1;
+    }
+    Mapa mapa;
+    IndiceMapa indice;
+    if (carregarMapaArquivo(&mapa, argv[2]) != 0) {
+        return 1;
+    }
+    double inicio = segundosAgora();
+    if (indexarMapa(&mapa, &indice) != 0) {
+        printf("[ERRO]: Falha na alocação de memória para o índice do mapa.\n");
+        liberarMapa(&mapa);
+        return 1;
+    }
+    double tempoIndice = segundosAgora() - inicio;
+
+    uint32_t *pares = malloc(sizeof(uint32_t) * 2 * (size_t)consultas);
+    if (pares == NULL) {
+        printf("[ERRO]: Falha na alocação de memória.\n");
+        liberarIndice(&indice);
+        liberarMapa(&mapa);
+        return 1;
+    }
+    uint64_t estado = 2024;
+    for (long i = 0; i < 2 * consultas; i++) {
+        pares[i] = (uint32_t)(sortearProximo(&estado) % mapa.numSalas);
+    }
+
+    inicio = segundosAgora();
+    long achadas = 0;
+    for (long i = 0; i < consultas; i++) {
+        achadas += buscarSala(&mapa, &indice, nomeSala(&mapa, pares[i])) == pares[i];
+    }
+    double tempoNomes = segundosAgora() - inicio;
+
+    inicio = segundosAgora();
+    uint64_t somaDistancias = 0;
+    for (long i = 0; i < consultas; i++) {
+        uint32_t distancia = distanciaSalas(&indice, pares[2 * i], pares[2 * i + 1]);
+        somaDistancias += distancia != UINT32_MAX ? distancia : 0;
+    }
+    double tempoComum = segundosAgora() - inicio;
+
+    // Referência: iguala as profundidades e sobe as duas salas até se encontrarem.
+    long conferidas = consultas < 2000 ? consultas : 2000, erradas = 0;
+    inicio = segundosAgora();
+    for (long i = 0; i < conferidas; i++) {
+        uint32_t a = pares[2 * i], b = pares[2 * i + 1];
+        if (indice.entrada[a] == SEM_SALA || indice.entrada[b] == SEM_SALA) {
+            erradas += ancestralComum(&indice, a, b) != SEM_SALA;
+            continue;
+        }
+        uint32_t esperado = ancestralComum(&indice, a, b);
+        while (indice.profundidade[a] > indice.profundidade[b]) {
+            a = indice.pai[a];
+        }
+        while (indice.profundidade[b] > indice.profundidade[a]) {
+            b = indice.pai[b];
+        }
+        while (a != b) {
+            a = indice.pai[a];
+            b = indice.pai[b];
+        }
+        erradas += a != esperado;
+    }
+    double tempoSubindo = segundosAgora() - inicio;
+
+    printf("--- BENCHMARK DE CAMINHOS NA MANSÃO ---\n");
+    printf("Arquivo: %s | Salas: %u | Consultas: %ld\n", argv[2], mapa.numSalas, consultas);
+    printf("Montagem do índice (nomes + passeio de Euler + tabela esparsa): %.1f ms\n", tempoIndice * 1e3);
+    printf("%-34s %12.0f consultas/s (%ld de %ld achadas)\n", "Busca por nome:", consultas / tempoNomes, achadas,
+           consultas);
+    printf("%-34s %12.0f consultas/s (distância média %.1f)\n", "Ancestral comum + distância:",
+           consultas / tempoComum, (double)somaDistancias / (double)consultas);
+    printf("%-34s %12.0f consultas/s\n", "Subindo pelos pais (referência):", conferidas / tempoSubindo);
+    printf("Ancestrais conferidos: %ld | Divergências: %ld\n", conferidas, erradas);
+    free(pares);
+    liberarIndice(&indice);
+    liberarMapa(&mapa);
+    return erradas == 0 && achadas == consultas ? 0 : 1;
+}
+
+// -------------------------------------------------------------------
+// --------------------- AVALIAÇÃO DE ROTEIROS -----------------------
+// -------------------------------------------------------------------
+
+/**
+ * @brief Lê um arquivo de roteiros, um por linha (linhas vazias contam como
+ * roteiros vazios, que terminam no Hall).
+ * @return int: 0 em caso de sucesso, -1 em caso de erro (já informado no console).
+ */
+int carregarRoteiros(Roteiros *roteiros, const char *caminho) {
+    memset(roteiros, 0, sizeof(*roteiros));
+    FILE *arquivo = fopen(caminho, "rb");
+    if (arquivo == NULL) {
+        printf("[ERRO]: Não foi possível abrir os roteiros '%s'.\n", caminho);
+        return -1;
+    }
+    fseek(arquivo, 0, SEEK_END);
+    long tamanho = ftell(arquivo);
+    fseek(arquivo, 0, SEEK_SET);
+    roteiros->texto = tamanho >= 0 ? malloc((size_t)tamanho + 1) : NULL;
+    int ok = roteiros->texto != NULL && fread(roteiros->texto, 1, (size_t)tamanho, arquivo) == (size_t)tamanho;
+    fclose(arquivo);
+    size_t linhas = 0;
+    for (long i = 0; ok && i < tamanho; i++) {
+        linhas += roteiros->texto[i] == '\n';
+    }
+    // A última linha pode não ter '\n'.
+    linhas += ok && tamanho > 0 && roteiros->texto[tamanho - 1] != '\n';
+    roteiros->inicios = ok ? malloc(sizeof(size_t) * (linhas + 1)) : NULL;
+    if (roteiros->inicios == NULL) {
+        printf("[ERRO]: Falha ao ler os roteiros '%s'.\n", caminho);
+        liberarRoteiros(roteiros);
+        return -1;
+    }
+    size_t inicio = 0;
+    for (long i = 0; i < tamanho; i++) {
+        if (roteiros->texto[i] == '\n') {
+            roteiros->inicios[roteiros->total++] = inicio;
+            inicio = (size_t)i + 1;
+        }
+    }
+    if (inicio < (size_t)tamanho) {
+        roteiros->inicios[roteiros->total++] = inicio;
+    }
+    // Cada roteiro vai do seu início até o '\n' antes do próximo.
+    roteiros->inicios[roteiros->total] = (size_t)tamanho + (inicio < (size_t)tamanho);
+    roteiros->texto[tamanho] = '\n';
+    return 0;
+}
+
+void liberarRoteiros(Roteiros *roteiros) {
+    free(roteiros->texto);
+    free(roteiros->inicios);
+    memset(roteiros, 0, sizeof(*roteiros));
+}
+
+/**
+ * @brief Executa um roteiro como explorarSalas() faria, sem nenhuma saída no
+ * console: 'e'/'d' andam (maiúsculas também), 's' sai, um passo sem caminho ou
+ * uma letra desconhecida deixa o jogador na mesma sala, e chegar a um cômodo
+ * sem saída encerra a exploração.
+ */
+static void executarRoteiro(const Mapa *mapa, const char *passo, const char *fim, ResultadoRoteiros *r) {
+    uint32_t atual = 0;
+    r->visitas[0]++;
+    for (;;) {
+        const Sala *sala = &mapa->salas[atual];
+        if (sala->esquerda == SEM_SALA && sala->direita == SEM_SALA) {
+            r->fimDaLinha++;
+            return;
+        }
+        if (passo == fim) {
+            r->incompletas++;
+            return;
+        }
+        char escolha = (char)(*passo++ | 0x20); // Minúscula
+        uint32_t proxima = escolha == 'e' ? sala->esquerda : escolha == 'd' ? sala->direita : SEM_SALA;
+        if (proxima != SEM_SALA) {
+            atual = proxima;
+            r->visitas[atual]++;
+            r->passos++;
+        } else if (escolha == 's') {
+            r->saidas++;
+            return;
+        } else {
+            r->invalidos++;
+        }
+    }
+}
+
+typedef struct {
+    const Mapa *mapa;
+    const Roteiros *roteiros;
+    atomic_size_t proximo;  // Próximo lote de roteiros a avaliar
+} TrabalhoRoteiros;
+
+typedef struct {
+    TrabalhoRoteiros *trabalho;
+    ResultadoRoteiros resultado;
+    pthread_t thread;
+} AvaliadorRoteiros;
+
+static void *threadAvaliadora(void *arg) {
+    AvaliadorRoteiros *a = arg;
+    const Roteiros *roteiros = a->trabalho->roteiros;
+    size_t inicio;
+    while ((inicio = atomic_fetch_add(&a->trabalho->proximo, ROTEIROS_POR_LOTE)) < roteiros->total) {
+        size_t fim = inicio + ROTEIROS_POR_LOTE < roteiros->total ? inicio + ROTEIROS_POR_LOTE : roteiros->total;
+        for (size_t i = inicio; i < fim; i++) {
+            const char *passo = roteiros->texto + roteiros->inicios[i];
+            const char *fimRoteiro = roteiros->texto + roteiros->inicios[i + 1] - 1; // Sem o '\n'
+            if (fimRoteiro > passo && fimRoteiro[-1] == '\r') {
+                fimRoteiro--;
+            }
+            executarRoteiro(a->trabalho->mapa, passo, fimRoteiro, &a->resultado);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Avalia todos os roteiros em 'numThreads' threads. Cada thread conta
+ * as visitas no seu próprio vetor (sem disputa por contadores compartilhados) e
+ * os vetores são somados no fim; o resultado não depende do número de threads.
+ * @param resultado Recebe as somas; 'resultado->visitas' é alocado aqui.
+ * @return int: 0 em caso de sucesso, -1 se faltou memória ou thread.
+ */
+int avaliarRoteiros(const Mapa *mapa, const Roteiros *roteiros, int numThreads, ResultadoRoteiros *resultado) {
+    TrabalhoRoteiros trabalho = {mapa, roteiros, 0};
+    AvaliadorRoteiros *avaliadores = calloc((size_t)numThreads, sizeof(AvaliadorRoteiros));
+    int criadas = 0, erro = avaliadores == NULL;
+    for (int t = 0; !erro && t < numThreads; t++) {
+        avaliadores[t].trabalho = &trabalho;
+        avaliadores[t].resultado.visitas = calloc(mapa->numSalas, sizeof(uint64_t));
+        erro = avaliadores[t].resultado.visitas == NULL ||
+               pthread_create(&avaliadores[t].thread, NULL, threadAvaliadora, &avaliadores[t]) != 0;
+        criadas += !erro;
+    }
+    for (int t = 0; t < criadas; t++) {
+        pthread_join(avaliadores[t].thread, NULL);
+    }
+
+    memset(resultado, 0, sizeof(*resultado));
+    if (!erro) {
+        // O vetor da primeira thread vira o resultado; os demais são somados nele.
+        *resultado = avaliadores[0].resultado;
+        for (int t = 1; t < numThreads; t++) {
+            const ResultadoRoteiros *r = &avaliadores[t].resultado;
+            for (uint32_t i = 0; i < mapa->numSalas; i++) {
+                resultado->visitas[i] += r->visitas[i];
+            }
+            resultado->fimDaLinha += r->fimDaLinha;
+            resultado->saidas += r->saidas;
+            resultado->incompletas += r->incompletas;
+            resultado->passos += r->passos;
+            resultado->invalidos += r->invalidos;
+        }
+    }
+    for (int t = erro ? 0 : 1; avaliadores != NULL && t < numThreads; t++) {
+        free(avaliadores[t].resultado.visitas);
+    }
+    free(avaliadores);
+    return erro ? -1 : 0;
+}
+
+/**
+ * @brief "./DetectiveQuest --gerar-roteiros arquivo [roteiros] [passos] [semente]":
+ * grava roteiros sorteados com 'e' e 'd' e, raramente, um 's' para sair.
+ */
+int gerarRoteiros(int argc, char *argv[]) {
+    long total = argc > 3 ? atol(argv[3]) : 1000000;
+    long passos = argc > 4 ? atol(argv[4]) : 64;
+    uint64_t estado = argc > 5 ? strtoull(argv[5], NULL, 10) : 2024;
+    if (argc < 3 || total <= 0 || passos <= 0) {
+        printf("[ERRO]: Uso: ./DetectiveQuest --gerar-roteiros arquivo [roteiros] [passos] [semente]\n");
+        return 1;
+    }
+    estado = estado != 0 ? estado : 1;
+    FILE *arquivo = fopen(argv[2], "w");
+    char *linha = malloc((size_t)passos + 2);
+    if (arquivo == NULL || linha == NULL) {
+        printf("[ERRO]: Não foi possível criar '%s'.\n", argv[2]);
+        if (arquivo != NULL) {
+            fclose(arquivo);
+        }
+        free(linha);
+        return 1;
+    }
+    for (long i = 0; i < total; i++) {
+        for (long k = 0; k < passos; k++) {
+            uint64_t sorteio = sortearProximo(&estado);
+            linha[k] = sorteio % 200 == 0 ? 's' : (sorteio >> 32 & 1) ? 'e' : 'd';
+        }
+        linha[passos] = '\n';
+        fwrite(linha, 1, (size_t)passos + 1, arquivo);
+    }
+    free(linha);
+    if (fclose(arquivo) != 0) {
+        printf("[ERRO]: Falha ao gravar '%s'.\n", argv[2]);
+        return 1;
+    }
+    printf(">> 📝 %ld roteiros de %ld passos gravados em '%s'.\n", total, passos, argv[2]);
+    return 0;
+}
+
+/**
+ * @brief "./DetectiveQuest --avaliar-roteiros roteiros [mapa] [threads] [largura|veb]":
+ * executa todos os roteiros no mapa padrão ou no do arquivo, sem saída por
+ * passo, e mostra visitas por sala, taxas de término e explorações por segundo.
+ * Com mais de uma thread, repete com uma só para mostrar o ganho e conferir
+ * que as contagens são as mesmas. Com um layout, as salas são reorganizadas
+ * (reorganizarMapa) antes da avaliação.
+ */
+int executarAvaliacaoRoteiros(int argc, char *argv[]) {
+    int numThreads = argc > 4 ? atoi(argv[4]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    LayoutMapa layout = LAYOUT_VEB;
+    if (argc < 3 || numThreads < 1 || numThreads > 256 || (argc > 5 && lerLayout(argv[5], &layout) != 0)) {
+        printf("[ERRO]: Uso: ./DetectiveQuest --avaliar-roteiros roteiros [mapa] [threads] [largura|veb]\n");
+        return 1;
+    }
+    Mapa mapa;
+    Roteiros roteiros;
+    if ((argc > 3 ? carregarMapaArquivo(&mapa, argv[3]) : montarMapa(&mapa)) != 0) {
+        return 1;
+    }
+    if (argc > 5 && reorganizarMapa(&mapa, layout) != 0) {
+        printf("[ERRO]: Falha na alocação de memória para reorganizar o mapa.\n");
+        liberarMapa(&mapa);
+        return 1;
+    }
+    if (carregarRoteiros(&roteiros, argv[2]) != 0) {
+        liberarMapa(&mapa);
+        return 1;
+    }
+    ResultadoRoteiros r, sequencial = {0};
+    double inicio = segundosAgora();
+    int erro = avaliarRoteiros(&mapa, &roteiros, numThreads, &r);
+    double tempo = segundosAgora() - inicio;
+    double tempoSequencial = 0;
+    if (!erro && numThreads > 1) {
+        inicio = segundosAgora();
+        erro = avaliarRoteiros(&mapa, &roteiros, 1, &sequencial);
+        tempoSequencial = segundosAgora() - inicio;
+    }
+    if (erro) {
+        printf("[ERRO]: Falha na alocação de memória ou ao criar as threads.\n");
+        free(r.visitas);
+        liberarRoteiros(&roteiros);
+        liberarMapa(&mapa);
+        return 1;
+    }
+
+    double total = roteiros.total > 0 ? (double)roteiros.total : 1;
+    printf("--- AVALIAÇÃO DE ROTEIROS DE EXPLORAÇÃO ---\n");
+    printf("Roteiros: %zu | Salas: %u | Threads: %d\n", roteiros.total, mapa.numSalas, numThreads);
+    printf("Tempo: %.3f s -> %.0f explorações/s (%.0f passos/s)\n", tempo, roteiros.total / tempo,
+           r.passos / tempo);
+    printf("Fim da linha: %.1f%% | Saíram: %.1f%% | Roteiro acabou antes: %.1f%% | Passos sem caminho: %llu\n",
+           100.0 * r.fimDaLinha / total, 100.0 * r.saidas / total, 100.0 * r.incompletas / total,
+           (unsigned long long)r.invalidos);
+
+    // As 10 salas mais visitadas; nos cômodos sem saída, toda visita é um fim da linha.
+    uint32_t maisVisitadas[10];
+    int numMais = 0;
+    uint32_t nuncaVisitadas = 0;
+    for (uint32_t i = 0; i < mapa.numSalas; i++) {
+        nuncaVisitadas += r.visitas[i] == 0;
+        int pos = numMais < 10 ? numMais++ : 10;
+        while (pos > 0 && r.visitas[maisVisitadas[pos - 1]] < r.visitas[i]) {
+            if (pos < 10) {
+                maisVisitadas[pos] = maisVisitadas[pos - 1];
+            }
+            pos--;
+        }
+        if (pos < 10) {
+            maisVisitadas[pos] = i;
+        }
+    }
+    printf("Salas nunca visitadas: %u\n", nuncaVisitadas);
+    printf("\n--- SALAS MAIS VISITADAS ---\n");
+    for (int k = 0; k < numMais; k++) {
+        const Sala *sala = &mapa.salas[maisVisitadas[k]];
+        int semSaida = sala->esquerda == SEM_SALA && sala->direita == SEM_SALA;
+        printf("%-24s %12llu visitas (%5.1f%% das explorações)%s\n", nomeSala(&mapa, maisVisitadas[k]),
+               (unsigned long long)r.visitas[maisVisitadas[k]], 100.0 * r.visitas[maisVisitadas[k]] / total,
+               semSaida ? " - fim da linha" : "");
+    }
+
+    int iguais = 1;
+    if (numThreads > 1) {
+        iguais = r.fimDaLinha == sequencial.fimDaLinha && r.saidas == sequencial.saidas &&
+                 r.passos == sequencial.passos && r.invalidos == sequencial.invalidos &&
+                 memcmp(r.visitas, sequencial.visitas, sizeof(uint64_t) * mapa.numSalas) == 0;
+        printf("\nCom 1 thread: %.0f explorações/s | Ganho: %.2fx | Mesmas contagens: %s\n",
+               roteiros.total / tempoSequencial, tempoSequencial / tempo, iguais ? "sim" : "NAO");
+    }
+    free(r.visitas);
+    free(sequencial.visitas);
+    liberarRoteiros(&roteiros);
+    liberarMapa(&mapa);
+    return iguais ? 0 : 1;
+}
+
+/**
+ * @brief "./DetectiveQuest --bench-pistas [pistas] [suspeitos]": liga pistas
+ * sorteadas a suspeitos, coleta todas no caderno e mede inserção, busca (pistas
+ * coletadas e ausentes) e acusações (pistas de um suspeito e suspeito com mais
+ * pistas). Confere a árvore (ordem e altura) e o líder contra uma recontagem.
+ */
+int executarBenchPistas(int argc, char *argv[]) {
+    long total = argc > 2 ? atol(argv[2]) : 500000;
+    long numSuspeitos = argc > 3 ? atol(argv[3]) : 1000;
+    if (total <= 0 || total > 50000000 || numSuspeitos <= 0 || numSuspeitos > total) {
+        printf("[ERRO]: Uso: ./DetectiveQuest --bench-pistas [pistas] [suspeitos (até o número de pistas)]\n");
+        return 1;
+    }
+    // Textos: "pista-xxxxxxxx" (coletadas), "falsa-xxxxxxxx" (nunca coletadas) e os suspeitos.
+    enum { TAM_TEXTO = 24 };
+    char *textos = malloc((size_t)(2 * total + numSuspeitos) * TAM_TEXTO);
+    CadernoPistas caderno;
+    if (textos == NULL || cadernoIniciar(&caderno) != 0) {
+        printf("[ERRO]: Falha na alocação de memória.\n");
+        free(textos);
+        return 1;
+    }
+    char *pistas = textos, *falsas = textos + (size_t)total * TAM_TEXTO;
+    char *suspeitos = falsas + (size_t)total * TAM_TEXTO;
+    for (long i = 0; i < total; i++) {
+        // Multiplicar por um número ímpar embaralha sem repetir.
+        uint32_t codigo = (uint32_t)i * 2654435761u;
+        snprintf(pistas + (size_t)i * TAM_TEXTO, TAM_TEXTO, "pista-%08x", codigo);
+        snprintf(falsas + (size_t)i * TAM_TEXTO, TAM_TEXTO, "falsa-%08x", codigo);
+    }
+    for (long i = 0; i < numSuspeitos; i++) {
+        snprintf(suspeitos + (size_t)i * TAM_TEXTO, TAM_TEXTO, "Suspeito %ld", i);
+    }
+
+    uint64_t estado = 2024;
+    int erro = 0;
+    double inicio = segundosAgora();
+    for (long i = 0; i < total && !erro; i++) {
+        long suspeito = (long)(sortearProximo(&estado) % (uint64_t)numSuspeitos);
+        erro = associarPista(&caderno, pistas + (size_t)i * TAM_TEXTO, suspeitos + (size_t)suspeito * TAM_TEXTO);
+    }
+    double tempoAssociar = segundosAgora() - inicio;
+
+    // A cada coleta também se pergunta quem é o suspeito principal, como faria o jogo.
+    inicio = segundosAgora();
+    uint64_t somaLideres = 0;
+    for (long i = 0; i < total && !erro; i++) {
+        erro = coletarPista(&caderno, pistas + (size_t)i * TAM_TEXTO) != 1;
+        somaLideres += suspeitoPrincipal(&caderno);
+    }
+    double tempoColetar = segundosAgora() - inicio;
+    if (erro) {
+        printf("[ERRO]: Falha na alocação de memória.\n");
+        cadernoLiberar(&caderno);
+        free(textos);
+        return 1;
+    }
+
+    inicio = segundosAgora();
+    long achadas = 0;
+    for (long i = 0; i < total; i++) {
+        long k = (long)(sortearProximo(&estado) % (uint64_t)total);
+        achadas += pistaColetada(&caderno, pistas + (size_t)k * TAM_TEXTO);
+        achadas -= pistaColetada(&caderno, falsas + (size_t)k * TAM_TEXTO);
+    }
+    double tempoBuscar = segundosAgora() - inicio;
+
+    inicio = segundosAgora();
+    uint64_t somaAcusacoes = 0;
+    for (long i = 0; i < total; i++) {
+        long k = (long)(sortearProximo(&estado) % (uint64_t)numSuspeitos);
+        uint32_t suspeito = buscarSuspeito(&caderno, suspeitos + (size_t)k * TAM_TEXTO);
+        somaAcusacoes += caderno.contagem[suspeito] >= 2; // Acusação sustentada por 2 pistas
+        somaAcusacoes += suspeitoPrincipal(&caderno);
+    }
+    double tempoAcusar = segundosAgora() - inicio;
+    (void)somaLideres;
+    (void)somaAcusacoes;
+
+    // Referência: recontar as pistas de todos os suspeitos a cada pergunta.
+    int consultasRecontagem = 20;
+    uint32_t *recontagem = calloc((size_t)numSuspeitos, sizeof(uint32_t));
+    uint32_t maiorRecontado = 0;
+    inicio = segundosAgora();
+    for (int rodada = 0; recontagem != NULL && rodada < consultasRecontagem; rodada++) {
+        memset(recontagem, 0, sizeof(uint32_t) * (size_t)numSuspeitos);
+        maiorRecontado = 0;
+        for (uint32_t no = 0; no < caderno.numNos; no++) {
+            uint32_t s = suspeitoDaPista(&caderno, caderno.nos[no].texto);
+            if (++recontagem[s] > maiorRecontado) {
+                maiorRecontado = recontagem[s];
+            }
         }
     }
+    double tempoRecontar = segundosAgora() - inicio;
+    int contagensIguais = recontagem != NULL &&
+                          memcmp(recontagem, caderno.contagem, sizeof(uint32_t) * (size_t)numSuspeitos) == 0;
+    free(recontagem);
+
+    // Árvore: em ordem e com altura de AVL (no máximo 1,44 log2(n + 2)).
+    uint32_t pilha[64], atual = caderno.raiz, visitados = 0;
+    int topo = 0, emOrdem = 1;
+    const char *anterior = NULL;
+    while (atual != SEM_NO || topo > 0) {
+        while (atual != SEM_NO) {
+            pilha[topo++] = atual;
+            atual = caderno.nos[atual].esquerda;
+        }
+        atual = pilha[--topo];
+        emOrdem &= anterior == NULL || strcmp(anterior, caderno.nos[atual].texto) < 0;
+        anterior = caderno.nos[atual].texto;
+        visitados++;
+        atual = caderno.nos[atual].direita;
+    }
+    int altura = caderno.nos[caderno.raiz].altura;
+    double limite = 1.4405 * log2((double)total + 2);
+    uint32_t lider = suspeitoPrincipal(&caderno);
+    int ok = achadas == total && emOrdem && visitados == (uint32_t)total && altura <= limite &&
+             contagensIguais && caderno.contagem[lider] == maiorRecontado;
+
+    printf("--- BENCHMARK DE PISTAS E SUSPEITOS ---\n");
+    printf("Pistas: %ld | Suspeitos: %ld | Altura da árvore: %d (limite da AVL: %.1f)\n", total, numSuspeitos,
+           altura, limite);
+    printf("%-40s %12.0f op/s\n", "Ligar pista a suspeito (tabela):", total / tempoAssociar);
+    printf("%-40s %12.0f op/s\n", "Coletar pista (AVL + líder):", total / tempoColetar);
+    printf("%-40s %12.0f op/s\n", "Buscar pista (coletada e ausente):", 2 * total / tempoBuscar);
+    printf("%-40s %12.0f op/s\n", "Acusar (contagem + suspeito principal):", total / tempoAcusar);
+    printf("%-40s %12.0f op/s\n", "Suspeito principal por recontagem:", consultasRecontagem / tempoRecontar);
+    printf("Suspeito principal: %s (%u pistas) | Conferência: %s\n", caderno.suspeitos[lider],
+           caderno.contagem[lider], ok ? "ok" : "FALHOU");
+    cadernoLiberar(&caderno);
+    free(textos);
+    return ok ? 0 : 1;
 }
 
 // -------------------------------------------------------------------
 // ------------------------- FUNÇÃO PRINCIPAL ------------------------
 // -------------------------------------------------------------------
 
-int main() {
-    Sala *mapaRaiz = NULL; // Ponteiro inicial para o mapa (Hall de Entrada)
+/**
+ * @brief "./DetectiveQuest [arquivo] [--log registro]" explora o mapa padrão
+ * ou o do arquivo; com "--log", as mensagens de cada passo vão para 'registro'.
+ * "--gerar-mansao arquivo [salas] [forma] [semente]" grava um mapa gerado e
+ * "--bench-mansao arquivo" mede o carregamento de um mapa. "--caminho origem
+ * destino [arquivo]" mostra o caminho entre dois cômodos e "--bench-caminhos
+ * arquivo [consultas]" mede as consultas do índice do mapa. "--gerar-roteiros
+ * arquivo ..." grava roteiros de exploração e "--avaliar-roteiros roteiros
+ * [mapa] [threads] [layout]" executa todos eles em paralelo, sem interface.
+ * "--bench-pistas [pistas] [suspeitos]" mede o caderno de pistas.
+ * "--exibir-mapa [arquivo|-] [sala]" mostra a árvore a partir de um cômodo e
+ * "--bench-layout [salas] [descidas]" compara as organizações do mapa.
+ */
+int main(int argc, char *argv[]) {
+    if (argc > 1 && strcmp(argv[1], "--gerar-mansao") == 0) {
+        return gerarMansao(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-mansao") == 0) {
+        return executarBenchMansao(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--exibir-mapa") == 0) {
+        return executarExibirMapa(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-layout") == 0) {
+        return executarBenchLayout(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--caminho") == 0) {
+        return executarCaminho(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-caminhos") == 0) {
+        return executarBenchCaminhos(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--gerar-roteiros") == 0) {
+        return gerarRoteiros(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--avaliar-roteiros") == 0) {
+        return executarAvaliacaoRoteiros(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-pistas") == 0) {
+        return executarBenchPistas(argc, argv);
+    }
+
+    Mapa mapa; // Salas e nomes num só bloco; a sala 0 é o Hall de Entrada
+    IndiceMapa indice; // Busca de cômodos pelo nome e caminhos entre eles
+    CadernoPistas caderno; // Pistas coletadas e seus suspeitos
+
+    // "--log arquivo" manda as mensagens de cada passo para o arquivo; o outro
+    // argumento, se houver, é o mapa.
+    const char *arquivoMapa = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--log") == 0 && i + 1 < argc) {
+            if (logIniciarArquivo(argv[++i]) != 0) {
+                printf("[ERRO]: Não foi possível criar o arquivo de log '%s'.\n", argv[i]);
+                return 1;
+            }
+        } else {
+            arquivoMapa = argv[i];
+        }
+    }
 
     // 1. Monta o Mapa (Árvore Binária)
     printf(">> 🗺️ Montando o mapa da Mansão Enigma Studios...\n");
-    montarMapa(&mapaRaiz);
-    printf(">> ✅ Mapa montado com sucesso. O Hall de Entrada está pronto.\n");
+    int resultado = arquivoMapa != NULL ? carregarMapaArquivo(&mapa, arquivoMapa) : montarMapa(&mapa);
+    if (resultado != 0) {
+        printf("[ERRO CRÍTICO]: A raiz do mapa não foi criada. Exploracão impossível.\n");
+        return 1;
+    }
+    if (indexarMapa(&mapa, &indice) != 0) {
+        printf("[ERRO CRÍTICO]: Falha na alocação de memória para o índice do mapa.\n");
+        liberarMapa(&mapa);
+        return 1;
+    }
+    if (cadernoIniciar(&caderno) != 0 || associarPistasDoMapa(&caderno, &mapa) != 0) {
+        printf("[ERRO CRÍTICO]: Falha na alocação de memória para as pistas.\n");
+        cadernoLiberar(&caderno);
+        liberarIndice(&indice);
+        liberarMapa(&mapa);
+        return 1;
+    }
+    printf(">> ✅ Mapa montado com sucesso (%u cômodos). O %s está pronto.\n", mapa.numSalas, nomeSala(&mapa, 0));
 
     // 2. Inicia a Exploração
-    if (mapaRaiz != NULL) {
-        explorarSalas(mapaRaiz);
-    } else {
-        printf("[ERRO CRÍTICO]: A raiz do mapa não foi criada. Exploracão impossível.\n");
+    explorarSalas(&mapa, &indice, &caderno, 0);
+
+    // 3. Revisa as pistas coletadas
+    exibirPistas(&caderno);
+    uint32_t principal = suspeitoPrincipal(&caderno);
+    if (principal != SEM_SUSPEITO) {
+        printf(">> 🕵️ Suspeito com mais pistas: %s (%u pista(s)).\n", caderno.suspeitos[principal],
+               caderno.contagem[principal]);
     }
 
-    // 3. Libera a memória alocada
-    liberarMapa(mapaRaiz);
+    // 4. Libera a memória alocada
+    cadernoLiberar(&caderno);
+    liberarIndice(&indice);
+    liberarMapa(&mapa);
+    logEncerrar();
     printf("\n>> 🧹 Memória da mansão liberada.\n");
 
     return 0;
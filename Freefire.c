@@ -1,6 +1,22 @@
+// Compilação: gcc -O2 -pthread Freefire.c -o Freefire
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <pthread.h>
+#include <signal.h>
+#include "entrada.h"
+#include "log.h"
 
 // --- Definição da Struct ---
 /**
@@ -13,23 +29,2630 @@ typedef struct {
     int quantidade;     // Quantidade do item
 } Item;
 
+// --- Representação Compacta ---
+/**
+ * @brief Item como fica guardado no inventário: 12 bytes em vez dos 56 de Item.
+ * O nome fica uma única vez na arena de nomes e o tipo, que se repete em quase
+ * todos os itens, vira o índice de uma tabela de tipos. Varreduras por
+ * quantidade ou tipo percorrem assim um vetor quase 5 vezes menor.
+ */
+typedef struct {
+    uint32_t nome;      // Deslocamento do nome em ArenaNomes.texto
+    uint16_t tipo;      // Índice em TabelaTipos.nomes
+    int quantidade;
+} ItemCompacto;
+
+/**
+ * @brief Textos dos nomes, um atrás do outro e terminados em '\0'. Remover um
+ * item só soma o nome a 'lixo'; quando o lixo passa da metade, a arena é
+ * reescrita só com os nomes vivos.
+ */
+typedef struct {
+    char *texto;
+    uint32_t usado;
+    uint32_t capacidade;
+    uint32_t lixo;      // Bytes de nomes já removidos
+} ArenaNomes;
+
+/**
+ * @brief Tipos distintos já vistos pelo inventário. São poucos (Arma,
+ * Municao, Cura...), então a busca é sequencial e um tipo nunca sai da tabela.
+ */
+typedef struct {
+    char (*nomes)[20];
+    int total;
+    int capacidade;
+} TabelaTipos;
+
+// --- Índice Hash de Nomes ---
+/**
+ * @brief Posição da tabela hash (endereçamento aberto com sondagem linear).
+ * Guarda o hash completo do nome para evitar comparar strings em colisões
+ * e para redistribuir a tabela sem recalcular os hashes.
+ */
+typedef struct {
+    uint32_t hash;      // Hash do nome do item
+    int slot;           // Slot do handle do item (-1 = posição livre)
+} EntradaIndice;
+
+/**
+ * @brief Índice hash sobre os nomes dos itens. A tabela tem tamanho potência de 2 e
+ * dobra quando passa de 70% de ocupação. Remoções usam deslocamento para trás
+ * (sem marcadores de "apagado"), então buscas nunca ficam mais lentas com o uso.
+ */
+typedef struct {
+    EntradaIndice *entradas;
+    int capacidade;     // Número de posições (potência de 2)
+    int ocupadas;
+    int ignorarCaixa;   // 1 = "pistola" encontra "Pistola"
+} IndiceNomes;
+
+// --- Handles e Visões Ordenadas ---
+/**
+ * @brief Referência estável a um item. A remoção troca itens de posição no
+ * vetor, mas o slot do handle continua apontando para o mesmo item; a geração
+ * muda quando o slot é liberado, então um handle antigo nunca encontra o item
+ * que reaproveitou o slot.
+ */
+typedef struct {
+    int slot;
+    uint32_t geracao;
+} HandleItem;
+
+typedef enum {
+    VISAO_TIPO,         // Ordem por tipo e, dentro do tipo, por nome
+    VISAO_QUANTIDADE,   // Ordem por quantidade
+    NUM_VISOES
+} VisaoInventario;
+
+/**
+ * @brief Nó de uma visão. 'chave' resume a ordem do item (a quantidade, ou os 4
+ * primeiros bytes do tipo) para que a maioria das comparações na descida da
+ * árvore não precise buscar o item no vetor.
+ */
+typedef struct {
+    int esquerda;       // Slot do filho (-1 = sem filho)
+    int direita;
+    uint32_t chave;
+} NoVisao;
+
+/**
+ * @brief Treap (árvore de busca com prioridades aleatórias) sobre os slots dos
+ * itens. Os nós ficam num vetor indexado pelo slot, então inserir e remover
+ * não alocam memória. Cada alteração custa O(log n) esperado e as listagens
+ * ordenadas só percorrem a árvore, sem reordenar nada.
+ */
+typedef struct {
+    int raiz;
+    NoVisao *nos;       // Por slot
+} VisaoOrdenada;
+
+#define TOPK_NOMES 8 // Sugestões guardadas em cada nó da trie
+
+/**
+ * @brief Item sugerido por um nó da trie. A quantidade é copiada para que
+ * refazer as listas não precise buscar cada item no vetor; ela continua válida
+ * porque toda mudança de quantidade refaz os nós do caminho do nome.
+ */
+typedef struct {
+    int slot;
+    int quantidade;
+} Sugestao;
+
+/**
+ * @brief Nó da trie de nomes. Os filhos formam uma lista ligada (primeiro filho
+ * e próximo irmão), o que mantém todos os nós do mesmo tamanho e pequenos: a
+ * busca aproximada percorre muitos nós e só precisa destes campos.
+ */
+typedef struct {
+    int pai;
+    int filho;          // Primeiro filho (-1 = folha)
+    int irmao;          // Próximo irmão; num nó livre, o próximo nó livre
+    int slot;           // Primeiro item cujo nome termina aqui (-1 = nenhum)
+    unsigned char letra;
+    unsigned char numMelhores; // Sugestões do nó em 'melhores'
+} NoTrie;
+
+/**
+ * @brief Trie dos nomes com as letras ASCII em minúsculas, para buscas por
+ * prefixo e buscas aproximadas. Nomes que só diferem na caixa terminam no
+ * mesmo nó e ficam encadeados por 'proximoMesmoNo'.
+ *
+ * Cada nó tem em 'melhores' os TOPK_NOMES itens de maior quantidade da sua
+ * subárvore, então a busca por prefixo termina assim que chega ao nó do prefixo.
+ */
+typedef struct {
+    NoTrie *nos;        // nos[0] é a raiz
+    Sugestao *melhores; // TOPK_NOMES por nó, da maior para a menor quantidade
+    int numNos;
+    int capacidadeNos;
+    int noLivre;        // Início da lista de nós liberados (-1 = vazia)
+    int *noDoSlot;      // Por slot: nó onde o nome do item termina
+    int *proximoMesmoNo; // Por slot: próximo item do mesmo nó (-1 = fim)
+    int capacidadeSlots;
+} TrieNomes;
+
+/**
+ * @brief Inventário que cresce conforme a necessidade, com índice por nome,
+ * handles estáveis e visões ordenadas. 'limite' é a capacidade da mochila no
+ * jogo (0 = sem limite, usado nos benchmarks com catálogos grandes). Os itens
+ * ficam na forma compacta; quem está fora do inventário os lê com
+ * inventarioNome(), inventarioTipo(), inventarioQuantidade() ou inventarioItem().
+ *
+ * Cada item vivo ocupa exatamente um slot, então os vetores por slot têm a mesma
+ * capacidade do vetor de itens. Num slot livre, 'posicaoDoSlot' guarda
+ * -2 - (próximo slot livre), formando a lista de slots livres.
+ */
+typedef struct {
+    ItemCompacto *itens;
+    ArenaNomes textos;
+    TabelaTipos tipos;
+    int total;
+    int capacidade;     // Espaço alocado em 'itens' e nos vetores por slot
+    int limite;
+    IndiceNomes indice;
+    int *slotDoItem;    // Por posição em 'itens'
+    int *posicaoDoSlot; // Por slot: posição do item em 'itens'
+    uint32_t *geracao;  // Por slot: incrementada quando o slot é liberado
+    int numSlots;       // Slots já usados alguma vez
+    int slotLivre;      // Início da lista de slots livres (-1 = vazia)
+    VisaoOrdenada visoes[NUM_VISOES];
+    int visoesSuspensas; // 1 = visões desatualizadas até inventarioReconstruirVisoes()
+    TrieNomes *nomes;   // NULL = sem busca por prefixo (ver inventarioAtivarBuscaNomes)
+} Inventario;
+
+// --- Persistência: Diário e Checkpoint ---
+/**
+ * @brief Tipos de registro do diário. Quantidades são gravadas como valor final
+ * (não como incremento), exceto na inserção, que repete inventarioAdicionar().
+ */
+typedef enum {
+    REGISTRO_INSERIR = 1,   // nome, tipo, quantidade
+    REGISTRO_REMOVER = 2,   // nome
+    REGISTRO_QUANTIDADE = 3 // nome, nova quantidade
+} TipoRegistro;
+
+#define DIARIO_MAGICO "FFDIARIO"
+#define CHECKPOINT_MAGICO "FFCHKPT1"
+#define DIARIO_VERSAO 1u
+#define TAM_CABECALHO_DIARIO 16     // magico[8] + versao + geracao
+#define TAM_CABECALHO_REGISTRO 7    // crc32 + tamanho (2 bytes) + tipo
+#define TAM_BUFFER_DIARIO (64 * 1024)
+
+/**
+ * @brief Diário só de acréscimo das alterações do inventário.
+ *
+ * Cada registro é [crc32][tamanho][tipo][dados]; o CRC cobre tudo depois dele,
+ * então um registro cortado no meio por uma queda é detectado e descartado na
+ * recuperação. Os registros se acumulam no buffer e são gravados juntos, com um
+ * único fdatasync (group commit), quando o buffer enche, quando o primeiro
+ * registro pendente passa de 'intervaloGrupo' segundos ou em diarioConfirmar().
+ *
+ * O checkpoint é uma cópia compacta do inventário inteiro. Ele e o diário
+ * carregam uma geração: compactar grava o checkpoint com a geração seguinte e
+ * só depois recria o diário vazio, então se o processo cair entre os dois
+ * passos o diário antigo (geração menor) é reconhecido como já incluído.
+ */
+typedef struct {
+    int fd;                         // Diário aberto para acréscimo (-1 = fechado)
+    char caminhoDiario[256];
+    char caminhoCheckpoint[256];
+    uint32_t geracao;
+    unsigned char buffer[TAM_BUFFER_DIARIO];
+    size_t pendentes;               // Bytes no buffer ainda não gravados
+    double inicioPendente;          // Instante do primeiro registro pendente
+    double intervaloGrupo;          // Atraso máximo de um registro, em segundos
+    uint64_t registrosDiario;       // Registros no diário desde o último checkpoint
+    uint64_t limiteCompactacao;     // Compacta ao passar disso (0 = só manualmente)
+    uint64_t sincronizacoes;        // Quantos fdatasync() já foram feitos
+    uint64_t recuperados;           // Registros reaplicados na abertura
+    const Inventario *inventario;   // Inventário copiado nas compactações
+} Diario;
+
+// --- Serviço Multijogador ---
+/**
+ * @brief Mochilas de muitos jogadores num único processo. Os jogadores são
+ * distribuídos em NUM_FRAGMENTOS fragmentos pelo hash do id; cada fragmento tem
+ * sua própria trava e sua própria tabela de jogadores, então threads que
+ * atendem jogadores de fragmentos diferentes nunca disputam a mesma trava.
+ * Cada fragmento ocupa linhas de cache próprias para que as travas vizinhas
+ * não fiquem invalidando a mesma linha (false sharing).
+ */
+#define NUM_FRAGMENTOS 64
+
+typedef struct {
+    uint32_t jogador;
+    Inventario *mochila;        // NULL = posição livre
+} EntradaJogador;
+
+typedef struct {
+    pthread_mutex_t trava;
+    EntradaJogador *jogadores;  // Tabela hash com sondagem linear
+    int capacidade;             // Potência de 2
+    int ocupadas;
+} __attribute__((aligned(64))) FragmentoServico;
+
+typedef struct {
+    FragmentoServico fragmentos[NUM_FRAGMENTOS];
+    int limiteMochila;          // Capacidade da mochila de cada jogador
+} ServicoMochilas;
+
 // --- Variáveis Globais para o Inventário ---
 #define CAPACIDADE_MAXIMA 10 // Capacidade máxima de itens na mochila
-Item inventario[CAPACIDADE_MAXIMA]; // Vetor de structs para armazenar os itens
-int totalItens = 0; // Contador para o número atual de itens no inventário
+Inventario mochila; // Mochila do jogador, com índice hash por nome
+Diario diario;      // Diário em disco das alterações da mochila
+int persistenciaAtiva = 0;
+Entrada entradaPadrao; // Comandos do jogador (teclado ou sessão redirecionada)
+
+// --- Protótipos das Funções ---
+void menu();
+void inserirItem();
+void removerItem();
+void listarItens();
+static void escreverListagem(void (*escrever)(const char *formato, ...));
+void listarItensPorTipo();
+void listarItensPorQuantidade();
+int buscarItem(char nomeBusca[30]); // Retorna o índice do item ou -1 se não encontrado
+void sugerirItens(const char *nome);
+
+int inventarioIniciar(Inventario *inv, int limite, int ignorarCaixa);
+void inventarioLiberar(Inventario *inv);
+int inventarioAdicionar(Inventario *inv, const Item *item);
+int inventarioBuscar(const Inventario *inv, const char *nome);
+int inventarioBuscarSequencial(const Inventario *inv, const char *nome);
+int inventarioRemover(Inventario *inv, const char *nome);
+int inventarioRemoverHandle(Inventario *inv, HandleItem h);
+HandleItem inventarioHandle(const Inventario *inv, int posicao);
+const char *inventarioNome(const Inventario *inv, int posicao);
+const char *inventarioTipo(const Inventario *inv, int posicao);
+int inventarioQuantidade(const Inventario *inv, int posicao);
+void inventarioItem(const Inventario *inv, int posicao, Item *saida);
+int inventarioResolver(const Inventario *inv, HandleItem h);
+void inventarioDefinirQuantidade(Inventario *inv, int posicao, int quantidade);
+void inventarioReconstruirVisoes(Inventario *inv);
+int inventarioListarOrdenado(const Inventario *inv, VisaoInventario v, int *saida, int maximo);
+int inventarioBuscarTipo(const Inventario *inv, const char *tipo, int *saida, int maximo);
+int inventarioFaixaQuantidade(const Inventario *inv, int minimo, int maximoQuantidade, int *saida, int maximo);
+int inventarioAtivarBuscaNomes(Inventario *inv);
+int inventarioBuscarPrefixo(const Inventario *inv, const char *prefixo, int *saida, int maximo);
+int inventarioBuscarAproximado(const Inventario *inv, const char *nome, int distanciaMaxima, int *saida, int maximo);
+int diarioAbrir(Diario *d, const char *base, Inventario *inv);
+int diarioRegistrarInsercao(Diario *d, const Item *item);
+int diarioRegistrarRemocao(Diario *d, const char *nome);
+int diarioRegistrarQuantidade(Diario *d, const char *nome, int quantidade);
+int diarioConfirmar(Diario *d);
+int diarioCompactar(Diario *d);
+int diarioFechar(Diario *d);
+int executarBenchBusca(int argc, char *argv[]);
+int executarBenchVisoes(int argc, char *argv[]);
+int executarBenchDiario(int argc, char *argv[]);
+int executarBenchNomes(int argc, char *argv[]);
+int executarBenchMemoria(int argc, char *argv[]);
+int executarServidor(int argc, char *argv[]);
+int executarCarga(int argc, char *argv[]);
+
+// --- Função Principal (main) ---
+/**
+ * @brief "./Freefire [--ignorar-caixa] [--arquivo base]" abre o jogo. Com
+ * --arquivo, a mochila é salva em base.ckpt/base.diario e recuperada na próxima
+ * execução com a mesma base; sem ele, nada é gravado em disco. --ignorar-caixa
+ * faz as buscas por nome ignorarem maiúsculas/minúsculas. Modos de benchmark: "--bench-busca [itens] [buscas]",
+ * "--bench-visoes [itens] [operacoes]", "--bench-diario [registros] [base]",
+ * "--bench-nomes [itens] [consultas]" e "--bench-memoria [itens] [varreduras]".
+ * "--servidor caminho [limite]" atende mochilas de muitos jogadores por um
+ * socket Unix e "--carga caminho|local [threads] [segundos] [jogadores]" mede
+ * esse serviço. "--log arquivo" manda as mensagens de cada operação para o
+ * arquivo (veja log.h).
+ */
+int main(int argc, char *argv[]) {
+    if (argc > 1 && strcmp(argv[1], "--bench-busca") == 0) {
+        return executarBenchBusca(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-visoes") == 0) {
+        return executarBenchVisoes(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-diario") == 0) {
+        return executarBenchDiario(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-nomes") == 0) {
+        return executarBenchNomes(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-memoria") == 0) {
+        return executarBenchMemoria(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--servidor") == 0) {
+        return executarServidor(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--carga") == 0) {
+        return executarCarga(argc, argv);
+    }
+    int ignorarCaixa = 0;
+    const char *base = NULL; // Sem --arquivo a mochila só existe nesta partida
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--ignorar-caixa") == 0) {
+            ignorarCaixa = 1;
+        } else if (strcmp(argv[i], "--arquivo") == 0 && i + 1 < argc) {
+            base = argv[++i];
+        } else if (strcmp(argv[i], "--log") == 0 && i + 1 < argc) {
+            // As mensagens de cada operação e a listagem automática vão para o
+            // arquivo, gravado em segundo plano; a tela fica com menus, buscas
+            // e os erros (que também vão para o arquivo).
+            if (logIniciarArquivo(argv[++i]) != 0) {
+                printf("\n[ERRO] Nao foi possivel criar o arquivo de log '%s'.\n", argv[i]);
+                return 1;
+            }
+        }
+    }
+    if (inventarioIniciar(&mochila, CAPACIDADE_MAXIMA, ignorarCaixa) != 0 ||
+        inventarioAtivarBuscaNomes(&mochila) != 0) {
+        printf("\n[ERRO] Falha na alocacao de memoria para a mochila.\n");
+        return 1;
+    }
+    // Com --arquivo, recupera a mochila salva (checkpoint + diário); sem disco,
+    // o jogo segue sem salvar.
+    if (base != NULL) {
+        if (diarioAbrir(&diario, base, &mochila) == 0) {
+            persistenciaAtiva = 1;
+            diario.limiteCompactacao = 1000;
+            if (mochila.total > 0) {
+                printf("\n[INFO] Mochila recuperada: %d itens (%llu registros do diario).\n",
+                       mochila.total, (unsigned long long)diario.recuperados);
+            }
+        } else {
+            printf("[ALERTA] A mochila nao sera salva nesta partida.\n");
+        }
+    }
+    // Inicializa o sistema e exibe o menu principal
+    menu();
+    if (persistenciaAtiva) {
+        diarioFechar(&diario);
+    }
+    inventarioLiberar(&mochila);
+    logEncerrar();
+    return 0;
+}
+
+// --- Funções do Índice Hash ---
+
+/**
+ * @brief Hash FNV-1a do nome. Com 'ignorarCaixa', letras ASCII são convertidas
+ * para minúsculas antes do hash, para combinar com strcasecmp().
+ */
+static uint32_t hashNome(const char *nome, int ignorarCaixa) {
+    uint32_t h = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)nome; *p; p++) {
+        unsigned char c = ignorarCaixa ? (unsigned char)tolower(*p) : *p;
+        h = (h ^ c) * 16777619u;
+    }
+    return h;
+}
+
+static int nomesIguais(const char *a, const char *b, int ignorarCaixa) {
+    return ignorarCaixa ? strcasecmp(a, b) == 0 : strcmp(a, b) == 0;
+}
+
+static const ItemCompacto *itemDoSlot(const Inventario *inv, int slot) {
+    return &inv->itens[inv->posicaoDoSlot[slot]];
+}
+
+static const char *nomeCompacto(const Inventario *inv, const ItemCompacto *item) {
+    return inv->textos.texto + item->nome;
+}
+
+static const char *tipoCompacto(const Inventario *inv, const ItemCompacto *item) {
+    return inv->tipos.nomes[item->tipo];
+}
+
+/**
+ * @brief Aloca a tabela com 'capacidade' posições livres.
+ * @return 0 em sucesso ou -1 se faltar memória.
+ */
+static int indiceAlocar(IndiceNomes *ind, int capacidade) {
+    EntradaIndice *entradas = malloc((size_t)capacidade * sizeof(EntradaIndice));
+    if (entradas == NULL) {
+        return -1;
+    }
+    for (int i = 0; i < capacidade; i++) {
+        entradas[i].slot = -1;
+    }
+    ind->entradas = entradas;
+    ind->capacidade = capacidade;
+    ind->ocupadas = 0;
+    return 0;
+}
+
+/**
+ * @brief Coloca uma entrada na primeira posição livre a partir do seu hash.
+ * Não verifica duplicatas: quem chama já sabe que o nome não está na tabela.
+ */
+static void indiceColocar(IndiceNomes *ind, uint32_t hash, int slot) {
+    int mascara = ind->capacidade - 1;
+    int i = (int)(hash & (uint32_t)mascara);
+    while (ind->entradas[i].slot != -1) {
+        i = (i + 1) & mascara;
+    }
+    ind->entradas[i].hash = hash;
+    ind->entradas[i].slot = slot;
+    ind->ocupadas++;
+}
+
+/**
+ * @brief Dobra a tabela e redistribui as entradas usando os hashes guardados.
+ */
+static int indiceCrescer(IndiceNomes *ind) {
+    IndiceNomes antigo = *ind;
+    if (indiceAlocar(ind, antigo.capacidade * 2) != 0) {
+        *ind = antigo;
+        return -1;
+    }
+    for (int i = 0; i < antigo.capacidade; i++) {
+        if (antigo.entradas[i].slot != -1) {
+            indiceColocar(ind, antigo.entradas[i].hash, antigo.entradas[i].slot);
+        }
+    }
+    free(antigo.entradas);
+    return 0;
+}
+
+/**
+ * @brief Procura a posição da tabela que aponta para o item com esse nome.
+ * @return A posição na tabela ou -1 se o nome não estiver indexado.
+ */
+static int indiceProcurar(const Inventario *inv, const char *nome, uint32_t hash) {
+    const IndiceNomes *ind = &inv->indice;
+    int mascara = ind->capacidade - 1;
+    for (int i = (int)(hash & (uint32_t)mascara); ind->entradas[i].slot != -1; i = (i + 1) & mascara) {
+        if (ind->entradas[i].hash == hash &&
+            nomesIguais(nomeCompacto(inv, itemDoSlot(inv, ind->entradas[i].slot)), nome, ind->ignorarCaixa)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Libera a posição 'i' e puxa para trás as entradas seguintes do mesmo
+ * agrupamento que ficariam inalcançáveis, mantendo as sondagens contíguas.
+ */
+static void indiceApagar(IndiceNomes *ind, int i) {
+    int mascara = ind->capacidade - 1;
+    int j = i;
+    for (;;) {
+        j = (j + 1) & mascara;
+        if (ind->entradas[j].slot == -1) {
+            break;
+        }
+        int ideal = (int)(ind->entradas[j].hash & (uint32_t)mascara);
+        // A entrada em 'j' pode ir para 'i' se sua posição ideal não está em (i, j].
+        int distanciaIdeal = (j - ideal) & mascara;
+        int distanciaBuraco = (j - i) & mascara;
+        if (distanciaIdeal >= distanciaBuraco) {
+            ind->entradas[i] = ind->entradas[j];
+            i = j;
+        }
+    }
+    ind->entradas[i].slot = -1;
+    ind->ocupadas--;
+}
+
+// --- Funções das Visões Ordenadas ---
+
+/**
+ * @brief Prioridade do treap derivada do número do slot (mistura de bits do
+ * MurmurHash3), o que dispensa guardar um vetor de prioridades.
+ */
+static uint32_t prioridadeSlot(int slot) {
+    uint32_t x = (uint32_t)slot * 0x9E3779B9u;
+    x ^= x >> 16;
+    x *= 0x85EBCA6Bu;
+    x ^= x >> 13;
+    x *= 0xC2B2AE35u;
+    return x ^ (x >> 16);
+}
+
+/**
+ * @brief Chave resumida do item na visão, comparável como inteiro sem sinal:
+ * a quantidade com o bit de sinal invertido, ou os 4 primeiros bytes do tipo em
+ * big-endian (mesma ordem de strcmp).
+ */
+static uint32_t chaveVisao(const Inventario *inv, const ItemCompacto *item, VisaoInventario v) {
+    if (v == VISAO_QUANTIDADE) {
+        return (uint32_t)item->quantidade ^ 0x80000000u;
+    }
+    const char *tipo = tipoCompacto(inv, item);
+    uint32_t chave = 0;
+    int fim = 0;
+    for (int i = 0; i < 4; i++) {
+        unsigned char c = fim ? 0 : (unsigned char)tipo[i];
+        fim = fim || c == 0;
+        chave = (chave << 8) | c;
+    }
+    return chave;
+}
+
+/**
+ * @brief Compara dois itens na ordem da visão: pela chave resumida e, só em
+ * empate, pelo tipo e nome completos. O slot desempata, tornando a ordem total
+ * mesmo com quantidades iguais.
+ */
+static int compararSlots(const Inventario *inv, VisaoInventario v, int a, int b) {
+    const NoVisao *nos = inv->visoes[v].nos;
+    if (nos[a].chave != nos[b].chave) {
+        return nos[a].chave < nos[b].chave ? -1 : 1;
+    }
+    if (v == VISAO_TIPO) {
+        const ItemCompacto *x = itemDoSlot(inv, a);
+        const ItemCompacto *y = itemDoSlot(inv, b);
+        // Tipos internados: o mesmo índice já garante o mesmo texto.
+        int c = x->tipo == y->tipo ? 0 : strcmp(tipoCompacto(inv, x), tipoCompacto(inv, y));
+        if (c == 0) {
+            c = strcmp(nomeCompacto(inv, x), nomeCompacto(inv, y));
+        }
+        if (c != 0) {
+            return c;
+        }
+    }
+    return (a > b) - (a < b);
+}
+
+/**
+ * @brief Une duas árvores em que todos os slots de 'a' vêm antes dos de 'b'.
+ */
+static int treapUnir(VisaoOrdenada *vis, int a, int b) {
+    if (a < 0) {
+        return b;
+    }
+    if (b < 0) {
+        return a;
+    }
+    if (prioridadeSlot(a) > prioridadeSlot(b)) {
+        vis->nos[a].direita = treapUnir(vis, vis->nos[a].direita, b);
+        return a;
+    }
+    vis->nos[b].esquerda = treapUnir(vis, a, vis->nos[b].esquerda);
+    return b;
+}
+
+/**
+ * @brief Divide a árvore 't' entre os slots antes e depois de 'slot'.
+ */
+static void treapDividir(const Inventario *inv, VisaoInventario v, int t, int slot, int *antes, int *depois) {
+    VisaoOrdenada *vis = (VisaoOrdenada *)&inv->visoes[v];
+    if (t < 0) {
+        *antes = *depois = -1;
+    } else if (compararSlots(inv, v, t, slot) < 0) {
+        *antes = t;
+        treapDividir(inv, v, vis->nos[t].direita, slot, &vis->nos[t].direita, depois);
+    } else {
+        *depois = t;
+        treapDividir(inv, v, vis->nos[t].esquerda, slot, antes, &vis->nos[t].esquerda);
+    }
+}
+
+static int treapInserir(Inventario *inv, VisaoInventario v, int t, int slot) {
+    VisaoOrdenada *vis = &inv->visoes[v];
+    if (t < 0) {
+        vis->nos[slot].esquerda = vis->nos[slot].direita = -1;
+        return slot;
+    }
+    if (prioridadeSlot(slot) > prioridadeSlot(t)) {
+        treapDividir(inv, v, t, slot, &vis->nos[slot].esquerda, &vis->nos[slot].direita);
+        return slot;
+    }
+    if (compararSlots(inv, v, slot, t) < 0) {
+        vis->nos[t].esquerda = treapInserir(inv, v, vis->nos[t].esquerda, slot);
+    } else {
+        vis->nos[t].direita = treapInserir(inv, v, vis->nos[t].direita, slot);
+    }
+    return t;
+}
+
+/**
+ * @brief Tira 'slot' da árvore. A chave do item precisa ser a mesma usada na
+ * inserção: quem altera a quantidade remove o item da visão antes.
+ */
+static int treapRemover(Inventario *inv, VisaoInventario v, int t, int slot) {
+    VisaoOrdenada *vis = &inv->visoes[v];
+    if (t == slot) {
+        return treapUnir(vis, vis->nos[t].esquerda, vis->nos[t].direita);
+    }
+    if (compararSlots(inv, v, slot, t) < 0) {
+        vis->nos[t].esquerda = treapRemover(inv, v, vis->nos[t].esquerda, slot);
+    } else {
+        vis->nos[t].direita = treapRemover(inv, v, vis->nos[t].direita, slot);
+    }
+    return t;
+}
+
+static void visoesInserir(Inventario *inv, int slot) {
+    if (inv->visoesSuspensas) {
+        return;
+    }
+    for (int v = 0; v < NUM_VISOES; v++) {
+        inv->visoes[v].nos[slot].chave = chaveVisao(inv, itemDoSlot(inv, slot), (VisaoInventario)v);
+        inv->visoes[v].raiz = treapInserir(inv, (VisaoInventario)v, inv->visoes[v].raiz, slot);
+    }
+}
+
+static void visoesRemover(Inventario *inv, int slot) {
+    if (inv->visoesSuspensas) {
+        return;
+    }
+    for (int v = 0; v < NUM_VISOES; v++) {
+        inv->visoes[v].raiz = treapRemover(inv, (VisaoInventario)v, inv->visoes[v].raiz, slot);
+    }
+}
+
+/**
+ * @brief Diz onde um item fica em relação a uma faixa da visão:
+ * negativo = antes da faixa, 0 = dentro, positivo = depois.
+ */
+typedef int (*FaixaVisao)(const Inventario *inv, const ItemCompacto *item, const void *faixa);
+
+/**
+ * @brief Percurso em ordem que só desce nas subárvores que podem ter itens da
+ * faixa: O(log n + k) para k itens encontrados.
+ */
+static int visaoColetar(const Inventario *inv, VisaoInventario v, int t, FaixaVisao faixa,
+                        const void *argumento, int *saida, int maximo, int encontrados) {
+    const VisaoOrdenada *vis = &inv->visoes[v];
+    while (t >= 0 && encontrados < maximo) {
+        int relacao = faixa != NULL ? faixa(inv, itemDoSlot(inv, t), argumento) : 0;
+        if (relacao >= 0) {
+            encontrados = visaoColetar(inv, v, vis->nos[t].esquerda, faixa, argumento, saida, maximo, encontrados);
+        }
+        if (relacao == 0 && encontrados < maximo) {
+            saida[encontrados++] = inv->posicaoDoSlot[t];
+        }
+        if (relacao > 0) {
+            break;
+        }
+        t = vis->nos[t].direita;
+    }
+    return encontrados;
+}
+
+static int faixaTipo(const Inventario *inv, const ItemCompacto *item, const void *faixa) {
+    return strcmp(tipoCompacto(inv, item), (const char *)faixa);
+}
+
+static int faixaQuantidade(const Inventario *inv, const ItemCompacto *item, const void *faixa) {
+    (void)inv;
+    const int *limites = faixa;
+    return item->quantidade < limites[0] ? -1 : item->quantidade > limites[1] ? 1 : 0;
+}
+
+// --- Funções da Trie de Nomes ---
+
+static unsigned char letraTrie(char c) {
+    return (unsigned char)tolower((unsigned char)c);
+}
+
+/**
+ * @brief Ordem das sugestões: maior quantidade primeiro; o slot desempata.
+ */
+static int sugestaoAntes(Sugestao a, Sugestao b) {
+    return a.quantidade != b.quantidade ? a.quantidade > b.quantidade : a.slot < b.slot;
+}
+
+static Sugestao sugestaoDoSlot(const Inventario *inv, int slot) {
+    Sugestao s = {slot, itemDoSlot(inv, slot)->quantidade};
+    return s;
+}
+
+/**
+ * @brief Coloca 's' na lista ordenada 'melhores' (no máximo TOPK_NOMES).
+ * @return 1 se entrou na lista ou 0 se ela já estava cheia de sugestões melhores.
+ */
+static int melhoresColocar(Sugestao *melhores, int *total, Sugestao s) {
+    int i = *total;
+    if (i == TOPK_NOMES) {
+        if (!sugestaoAntes(s, melhores[i - 1])) {
+            return 0;
+        }
+        i--;
+    } else {
+        (*total)++;
+    }
+    while (i > 0 && sugestaoAntes(s, melhores[i - 1])) {
+        melhores[i] = melhores[i - 1];
+        i--;
+    }
+    melhores[i] = s;
+    return 1;
+}
+
+/**
+ * @brief Garante espaço para 'nosNovos' nós e para slots até 'slots' - 1, para
+ * que a inserção seguinte não precise alocar.
+ * @return 0 em sucesso ou -1 se faltar memória.
+ */
+static int trieReservar(TrieNomes *t, int nosNovos, int slots) {
+    if (t->numNos + nosNovos > t->capacidadeNos) {
+        int nova = t->capacidadeNos * 2 > t->numNos + nosNovos ? t->capacidadeNos * 2 : t->numNos + nosNovos;
+        NoTrie *nos = realloc(t->nos, (size_t)nova * sizeof(NoTrie));
+        if (nos == NULL) {
+            return -1;
+        }
+        t->nos = nos;
+        Sugestao *melhores = realloc(t->melhores, (size_t)nova * TOPK_NOMES * sizeof(Sugestao));
+        if (melhores == NULL) {
+            return -1;
+        }
+        t->melhores = melhores;
+        t->capacidadeNos = nova;
+    }
+    if (slots > t->capacidadeSlots) {
+        int *noDoSlot = realloc(t->noDoSlot, (size_t)slots * sizeof(int));
+        if (noDoSlot == NULL) {
+            return -1;
+        }
+        t->noDoSlot = noDoSlot;
+        int *proximo = realloc(t->proximoMesmoNo, (size_t)slots * sizeof(int));
+        if (proximo == NULL) {
+            return -1;
+        }
+        t->proximoMesmoNo = proximo;
+        t->capacidadeSlots = slots;
+    }
+    return 0;
+}
+
+static void trieLiberar(TrieNomes *t) {
+    if (t != NULL) {
+        free(t->nos);
+        free(t->melhores);
+        free(t->noDoSlot);
+        free(t->proximoMesmoNo);
+        free(t);
+    }
+}
+
+/**
+ * @brief Deixa a trie só com a raiz, sem liberar a memória dos nós.
+ */
+static void trieEsvaziar(TrieNomes *t) {
+    t->numNos = 1;
+    t->noLivre = -1;
+    t->nos[0].pai = -1;
+    t->nos[0].filho = -1;
+    t->nos[0].irmao = -1;
+    t->nos[0].slot = -1;
+    t->nos[0].letra = 0;
+    t->nos[0].numMelhores = 0;
+}
+
+static int trieFilho(const TrieNomes *t, int no, unsigned char letra) {
+    int f = t->nos[no].filho;
+    while (f != -1 && t->nos[f].letra != letra) {
+        f = t->nos[f].irmao;
+    }
+    return f;
+}
+
+static int trieNovoFilho(TrieNomes *t, int pai, unsigned char letra) {
+    int no = t->noLivre;
+    if (no != -1) {
+        t->noLivre = t->nos[no].irmao;
+    } else {
+        no = t->numNos++;
+    }
+    NoTrie *n = &t->nos[no];
+    n->pai = pai;
+    n->filho = -1;
+    n->slot = -1;
+    n->letra = letra;
+    n->numMelhores = 0;
+    n->irmao = t->nos[pai].filho;
+    t->nos[pai].filho = no;
+    return no;
+}
+
+/**
+ * @brief Refaz as sugestões de um nó a partir dos itens que terminam nele e
+ * das listas dos filhos. Como as listas dos filhos já estão ordenadas, cada uma
+ * é lida só até a primeira sugestão que não entra.
+ * @return 1 se a lista do nó mudou ou 0 se ficou igual.
+ */
+static int trieRecalcular(const Inventario *inv, int no) {
+    TrieNomes *t = inv->nomes;
+    NoTrie *n = &t->nos[no];
+    Sugestao melhores[TOPK_NOMES];
+    int total = 0;
+    for (int s = n->slot; s != -1; s = t->proximoMesmoNo[s]) {
+        melhoresColocar(melhores, &total, sugestaoDoSlot(inv, s));
+    }
+    for (int f = n->filho; f != -1; f = t->nos[f].irmao) {
+        const Sugestao *doFilho = &t->melhores[(size_t)f * TOPK_NOMES];
+        for (int i = 0; i < t->nos[f].numMelhores && melhoresColocar(melhores, &total, doFilho[i]); i++) {
+        }
+    }
+    Sugestao *doNo = &t->melhores[(size_t)no * TOPK_NOMES];
+    if (total == n->numMelhores && memcmp(doNo, melhores, (size_t)total * sizeof(Sugestao)) == 0) {
+        return 0;
+    }
+    memcpy(doNo, melhores, (size_t)total * sizeof(Sugestao));
+    n->numMelhores = (unsigned char)total;
+    return 1;
+}
+
+/**
+ * @brief Atualiza as sugestões do nó em direção à raiz: O(tamanho do nome) nós
+ * no pior caso. A lista de um nó só depende das listas dos filhos, então a
+ * subida para no primeiro nó cuja lista não mudou, o que é o comum para itens
+ * de quantidade baixa.
+ */
+static void trieRecalcularCaminho(const Inventario *inv, int no) {
+    for (; no != -1 && trieRecalcular(inv, no); no = inv->nomes->nos[no].pai) {
+    }
+}
+
+/**
+ * @brief Põe o nome do item na trie. O espaço precisa ter sido reservado com
+ * trieReservar().
+ */
+static void trieInserir(const Inventario *inv, int slot) {
+    TrieNomes *t = inv->nomes;
+    int no = 0;
+    for (const char *p = nomeCompacto(inv, itemDoSlot(inv, slot)); *p; p++) {
+        unsigned char letra = letraTrie(*p);
+        int filho = trieFilho(t, no, letra);
+        no = filho != -1 ? filho : trieNovoFilho(t, no, letra);
+    }
+    t->proximoMesmoNo[slot] = t->nos[no].slot;
+    t->nos[no].slot = slot;
+    t->noDoSlot[slot] = no;
+    trieRecalcularCaminho(inv, no);
+}
+
+/**
+ * @brief Tira o item da trie antes de o slot ser liberado. Os nós que ficam sem
+ * itens e sem filhos voltam para a lista de nós livres.
+ */
+static void trieRemover(const Inventario *inv, int slot) {
+    TrieNomes *t = inv->nomes;
+    int no = t->noDoSlot[slot];
+    int *elo = &t->nos[no].slot;
+    while (*elo != slot) {
+        elo = &t->proximoMesmoNo[*elo];
+    }
+    *elo = t->proximoMesmoNo[slot];
+    while (no != 0 && t->nos[no].filho == -1 && t->nos[no].slot == -1) {
+        int pai = t->nos[no].pai;
+        int *irmao = &t->nos[pai].filho;
+        while (*irmao != no) {
+            irmao = &t->nos[*irmao].irmao;
+        }
+        *irmao = t->nos[no].irmao;
+        t->nos[no].irmao = t->noLivre;
+        t->noLivre = no;
+        no = pai;
+    }
+    trieRecalcularCaminho(inv, no);
+}
+
+/**
+ * @brief Estado da busca aproximada: as linhas da distância de edição são
+ * calculadas uma por nível da trie, então prefixos em comum com o nome buscado
+ * são processados uma única vez.
+ */
+typedef struct {
+    const Inventario *inv;
+    unsigned char alvo[30];
+    int tamanho;
+    int distanciaMaxima;
+    Sugestao sugestoes[TOPK_NOMES];
+    int distancias[TOPK_NOMES];
+    int encontrados;
+    int maximo;
+} BuscaAproximada;
+
+/**
+ * @brief Guarda um resultado em ordem de distância e, na mesma distância, de
+ * quantidade, mantendo só os 'maximo' primeiros.
+ */
+static void aproximadoColocar(BuscaAproximada *b, Sugestao s, int distancia) {
+    int i = b->encontrados;
+    if (i == b->maximo) {
+        int d = b->distancias[i - 1];
+        if (distancia > d || (distancia == d && !sugestaoAntes(s, b->sugestoes[i - 1]))) {
+            return;
+        }
+        i--;
+    } else {
+        b->encontrados++;
+    }
+    while (i > 0 && (distancia < b->distancias[i - 1] ||
+                     (distancia == b->distancias[i - 1] && sugestaoAntes(s, b->sugestoes[i - 1])))) {
+        b->sugestoes[i] = b->sugestoes[i - 1];
+        b->distancias[i] = b->distancias[i - 1];
+        i--;
+    }
+    b->sugestoes[i] = s;
+    b->distancias[i] = distancia;
+}
+
+/**
+ * @brief Desce pelos filhos de 'no' (que está na profundidade 'nivel')
+ * calculando a linha seguinte da distância de Levenshtein. Só a faixa de
+ * colunas a até 'distanciaMaxima' da diagonal pode ficar dentro do limite; o
+ * resto vale distanciaMaxima + 1. Uma subárvore é abandonada quando a linha
+ * inteira passa do limite.
+ */
+static void aproximadoVisitar(BuscaAproximada *b, int no, int nivel, const int *anterior) {
+    const TrieNomes *t = b->inv->nomes;
+    int limite = b->distanciaMaxima;
+    int linha[31];
+    int linhaNova = nivel + 1;
+    int de = linhaNova - limite > 1 ? linhaNova - limite : 1;
+    int ate = linhaNova + limite < b->tamanho ? linhaNova + limite : b->tamanho;
+    for (int f = t->nos[no].filho; f != -1; f = t->nos[f].irmao) {
+        unsigned char letra = t->nos[f].letra;
+        linha[0] = linhaNova <= limite ? linhaNova : limite + 1;
+        int menor = linha[0];
+        if (de > 1) {
+            linha[de - 1] = limite + 1;
+        }
+        for (int j = de; j <= ate; j++) {
+            int valor = anterior[j - 1] + (b->alvo[j - 1] != letra);
+            if (anterior[j] + 1 < valor) {
+                valor = anterior[j] + 1;
+            }
+            if (linha[j - 1] + 1 < valor) {
+                valor = linha[j - 1] + 1;
+            }
+            linha[j] = valor <= limite ? valor : limite + 1;
+            if (linha[j] < menor) {
+                menor = linha[j];
+            }
+        }
+        if (ate < b->tamanho) {
+            linha[ate + 1] = limite + 1;
+        }
+        if (ate == b->tamanho && linha[b->tamanho] <= limite) {
+            for (int s = t->nos[f].slot; s != -1; s = t->proximoMesmoNo[s]) {
+                aproximadoColocar(b, sugestaoDoSlot(b->inv, s), linha[b->tamanho]);
+            }
+        }
+        if (menor <= limite) {
+            aproximadoVisitar(b, f, linhaNova, linha);
+        }
+    }
+}
+
+// --- Funções da Representação Compacta ---
+
+/**
+ * @brief Índice do tipo na tabela.
+ * @return O índice ou -1 se o inventário ainda não tem esse tipo.
+ */
+static int tipoProcurar(const TabelaTipos *tipos, const char *tipo) {
+    for (int i = 0; i < tipos->total; i++) {
+        if (strncmp(tipos->nomes[i], tipo, sizeof(tipos->nomes[i]) - 1) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Índice do tipo, acrescentando-o à tabela na primeira vez.
+ * @return O índice ou -1 se faltar memória (ou houver tipos demais).
+ */
+static int tipoInternar(TabelaTipos *tipos, const char *tipo) {
+    int i = tipoProcurar(tipos, tipo);
+    if (i != -1) {
+        return i;
+    }
+    if (tipos->total > UINT16_MAX) {
+        return -1;
+    }
+    if (tipos->total == tipos->capacidade) {
+        int nova = tipos->capacidade ? tipos->capacidade * 2 : 8;
+        char (*nomes)[20] = realloc(tipos->nomes, (size_t)nova * sizeof(*nomes));
+        if (nomes == NULL) {
+            return -1;
+        }
+        tipos->nomes = nomes;
+        tipos->capacidade = nova;
+    }
+    snprintf(tipos->nomes[tipos->total], sizeof(tipos->nomes[0]), "%.19s", tipo);
+    return tipos->total++;
+}
+
+/**
+ * @brief Copia 'tamanho' bytes do nome para o fim da arena, terminando em '\0'.
+ * @return O deslocamento do nome ou UINT32_MAX se faltar memória.
+ */
+static uint32_t arenaGuardar(ArenaNomes *arena, const char *nome, size_t tamanho) {
+    size_t necessario = (size_t)arena->usado + tamanho + 1;
+    if (necessario > arena->capacidade) {
+        size_t nova = arena->capacidade ? (size_t)arena->capacidade * 2 : 256;
+        while (nova < necessario) {
+            nova *= 2;
+        }
+        if (nova > UINT32_MAX) {
+            nova = UINT32_MAX;
+        }
+        char *texto = nova >= necessario ? realloc(arena->texto, nova) : NULL;
+        if (texto == NULL) {
+            return UINT32_MAX;
+        }
+        arena->texto = texto;
+        arena->capacidade = (uint32_t)nova;
+    }
+    uint32_t deslocamento = arena->usado;
+    memcpy(arena->texto + deslocamento, nome, tamanho);
+    arena->texto[deslocamento + tamanho] = '\0';
+    arena->usado = (uint32_t)necessario;
+    return deslocamento;
+}
+
+/**
+ * @brief Reescreve a arena só com os nomes dos itens vivos, na ordem do vetor.
+ * Sem memória para a cópia, o lixo fica para a próxima tentativa.
+ */
+static void arenaCompactar(Inventario *inv) {
+    ArenaNomes *arena = &inv->textos;
+    uint32_t vivos = arena->usado - arena->lixo;
+    char *texto = malloc(vivos ? vivos : 1);
+    if (texto == NULL) {
+        return;
+    }
+    uint32_t usado = 0;
+    for (int i = 0; i < inv->total; i++) {
+        const char *nome = arena->texto + inv->itens[i].nome;
+        size_t tamanho = strlen(nome) + 1;
+        memcpy(texto + usado, nome, tamanho);
+        inv->itens[i].nome = usado;
+        usado += (uint32_t)tamanho;
+    }
+    free(arena->texto);
+    arena->texto = texto;
+    arena->capacidade = vivos;
+    arena->usado = usado;
+    arena->lixo = 0;
+}
+
+// --- Funções do Inventário ---
+
+/**
+ * @brief Prepara um inventário vazio.
+ * @param limite Número máximo de itens (0 = sem limite).
+ * @param ignorarCaixa 1 para que as buscas por nome ignorem maiúsculas/minúsculas.
+ * @return 0 em sucesso ou -1 se faltar memória.
+ */
+int inventarioIniciar(Inventario *inv, int limite, int ignorarCaixa) {
+    memset(inv, 0, sizeof(*inv));
+    inv->limite = limite;
+    inv->slotLivre = -1;
+    for (int v = 0; v < NUM_VISOES; v++) {
+        inv->visoes[v].raiz = -1;
+    }
+    inv->indice.ignorarCaixa = ignorarCaixa;
+    return indiceAlocar(&inv->indice, 16);
+}
+
+void inventarioLiberar(Inventario *inv) {
+    free(inv->itens);
+    free(inv->textos.texto);
+    free(inv->tipos.nomes);
+    free(inv->indice.entradas);
+    free(inv->slotDoItem);
+    free(inv->posicaoDoSlot);
+    free(inv->geracao);
+    for (int v = 0; v < NUM_VISOES; v++) {
+        free(inv->visoes[v].nos);
+    }
+    trieLiberar(inv->nomes);
+    memset(inv, 0, sizeof(*inv));
+}
+
+/**
+ * @brief Redimensiona um vetor do inventário, mantendo o antigo se faltar memória.
+ */
+static int crescerVetor(void **vetor, int capacidade, size_t tamanhoElemento) {
+    void *novo = realloc(*vetor, (size_t)capacidade * tamanhoElemento);
+    if (novo == NULL) {
+        return -1;
+    }
+    *vetor = novo;
+    return 0;
+}
+
+/**
+ * @brief Dobra o vetor de itens e os vetores por slot.
+ * @return 0 em sucesso ou -1 se faltar memória.
+ */
+static int inventarioCrescer(Inventario *inv) {
+    int nova = inv->capacidade ? inv->capacidade * 2 : 16;
+    if (crescerVetor((void **)&inv->itens, nova, sizeof(ItemCompacto)) != 0 ||
+        crescerVetor((void **)&inv->slotDoItem, nova, sizeof(int)) != 0 ||
+        crescerVetor((void **)&inv->posicaoDoSlot, nova, sizeof(int)) != 0 ||
+        crescerVetor((void **)&inv->geracao, nova, sizeof(uint32_t)) != 0) {
+        return -1;
+    }
+    for (int v = 0; v < NUM_VISOES; v++) {
+        if (crescerVetor((void **)&inv->visoes[v].nos, nova, sizeof(NoVisao)) != 0) {
+            return -1;
+        }
+    }
+    inv->capacidade = nova;
+    return 0;
+}
+
+/**
+ * @brief Busca pelo índice hash: O(1) em média.
+ * @return O índice do item no vetor ou -1 se não for encontrado.
+ */
+int inventarioBuscar(const Inventario *inv, const char *nome) {
+    int i = indiceProcurar(inv, nome, hashNome(nome, inv->indice.ignorarCaixa));
+    return i == -1 ? -1 : inv->posicaoDoSlot[inv->indice.entradas[i].slot];
+}
+
+/**
+ * @brief Busca sequencial original, mantida como referência para o benchmark.
+ * @return O índice do item no vetor ou -1 se não for encontrado.
+ */
+int inventarioBuscarSequencial(const Inventario *inv, const char *nome) {
+    for (int i = 0; i < inv->total; i++) {
+        if (nomesIguais(nomeCompacto(inv, &inv->itens[i]), nome, inv->indice.ignorarCaixa)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Handle estável do item que está hoje na posição 'posicao'.
+ */
+HandleItem inventarioHandle(const Inventario *inv, int posicao) {
+    HandleItem h;
+    h.slot = inv->slotDoItem[posicao];
+    h.geracao = inv->geracao[h.slot];
+    return h;
+}
+
+/**
+ * @brief Posição atual do item do handle.
+ * @return A posição no vetor de itens ou -1 se o item já foi removido.
+ */
+int inventarioResolver(const Inventario *inv, HandleItem h) {
+    if (h.slot < 0 || h.slot >= inv->numSlots || inv->geracao[h.slot] != h.geracao) {
+        return -1;
+    }
+    return inv->posicaoDoSlot[h.slot];
+}
+
+/**
+ * @brief Nome do item da posição. O ponteiro vale até a próxima alteração do
+ * inventário, que pode realocar ou compactar a arena.
+ */
+const char *inventarioNome(const Inventario *inv, int posicao) {
+    return nomeCompacto(inv, &inv->itens[posicao]);
+}
+
+const char *inventarioTipo(const Inventario *inv, int posicao) {
+    return tipoCompacto(inv, &inv->itens[posicao]);
+}
+
+int inventarioQuantidade(const Inventario *inv, int posicao) {
+    return inv->itens[posicao].quantidade;
+}
+
+/**
+ * @brief Copia o item da posição para um Item completo, com os bytes depois
+ * dos textos zerados.
+ */
+void inventarioItem(const Inventario *inv, int posicao, Item *saida) {
+    memset(saida, 0, sizeof(*saida));
+    strcpy(saida->nome, inventarioNome(inv, posicao));
+    strcpy(saida->tipo, inventarioTipo(inv, posicao));
+    saida->quantidade = inv->itens[posicao].quantidade;
+}
+
+/**
+ * @brief Adiciona um item. Se já existe um item com o mesmo nome, as
+ * quantidades são somadas (o nome é a chave do índice).
+ * @return O índice do item, -1 se o inventário está cheio ou -2 se faltar memória.
+ */
+int inventarioAdicionar(Inventario *inv, const Item *item) {
+    int existente = inventarioBuscar(inv, item->nome);
+    if (existente != -1) {
+        inventarioDefinirQuantidade(inv, existente, inv->itens[existente].quantidade + item->quantidade);
+        return existente;
+    }
+    if (inv->limite > 0 && inv->total >= inv->limite) {
+        return -1;
+    }
+    if (inv->total == inv->capacidade && inventarioCrescer(inv) != 0) {
+        return -2;
+    }
+    // Mantém a ocupação da tabela abaixo de 70%.
+    if ((inv->indice.ocupadas + 1) * 10 > inv->indice.capacidade * 7 && indiceCrescer(&inv->indice) != 0) {
+        return -2;
+    }
+    // No pior caso o nome cria um nó da trie por letra.
+    if (inv->nomes != NULL && trieReservar(inv->nomes, (int)strlen(item->nome), inv->capacidade) != 0) {
+        return -2;
+    }
+    int tipo = tipoInternar(&inv->tipos, item->tipo);
+    if (tipo < 0) {
+        return -2;
+    }
+    uint32_t nome = arenaGuardar(&inv->textos, item->nome, strnlen(item->nome, sizeof(item->nome) - 1));
+    if (nome == UINT32_MAX) {
+        return -2;
+    }
+    int slot = inv->slotLivre;
+    if (slot != -1) {
+        inv->slotLivre = -2 - inv->posicaoDoSlot[slot];
+    } else {
+        slot = inv->numSlots++;
+        inv->geracao[slot] = 0;
+    }
+    int posicao = inv->total++;
+    inv->itens[posicao].nome = nome;
+    inv->itens[posicao].tipo = (uint16_t)tipo;
+    inv->itens[posicao].quantidade = item->quantidade;
+    inv->slotDoItem[posicao] = slot;
+    inv->posicaoDoSlot[slot] = posicao;
+    indiceColocar(&inv->indice, hashNome(item->nome, inv->indice.ignorarCaixa), slot);
+    visoesInserir(inv, slot);
+    if (inv->nomes != NULL && !inv->visoesSuspensas) {
+        trieInserir(inv, slot);
+    }
+    return posicao;
+}
+
+/**
+ * @brief Altera a quantidade de um item, reposicionando-o na visão por quantidade
+ * e refazendo as sugestões da trie no caminho do nome.
+ */
+void inventarioDefinirQuantidade(Inventario *inv, int posicao, int quantidade) {
+    if (inv->visoesSuspensas) {
+        inv->itens[posicao].quantidade = quantidade;
+        return;
+    }
+    int slot = inv->slotDoItem[posicao];
+    VisaoOrdenada *vis = &inv->visoes[VISAO_QUANTIDADE];
+    vis->raiz = treapRemover(inv, VISAO_QUANTIDADE, vis->raiz, slot);
+    inv->itens[posicao].quantidade = quantidade;
+    vis->nos[slot].chave = chaveVisao(inv, &inv->itens[posicao], VISAO_QUANTIDADE);
+    vis->raiz = treapInserir(inv, VISAO_QUANTIDADE, vis->raiz, slot);
+    if (inv->nomes != NULL) {
+        trieRecalcularCaminho(inv, inv->nomes->noDoSlot[slot]);
+    }
+}
+
+/**
+ * @brief Remove o item do handle em O(1) no vetor: o último item ocupa o lugar
+ * do removido e só o slot dele é atualizado. As visões custam O(log n) e a
+ * compactação ocasional da arena de nomes é amortizada pelas remoções.
+ * @return 1 se o item foi removido ou 0 se o handle não é mais válido.
+ */
+int inventarioRemoverHandle(Inventario *inv, HandleItem h) {
+    int posicao = inventarioResolver(inv, h);
+    if (posicao == -1) {
+        return 0;
+    }
+    const char *nome = inventarioNome(inv, posicao);
+    indiceApagar(&inv->indice, indiceProcurar(inv, nome, hashNome(nome, inv->indice.ignorarCaixa)));
+    inv->textos.lixo += (uint32_t)strlen(nome) + 1;
+    visoesRemover(inv, h.slot);
+    if (inv->nomes != NULL && !inv->visoesSuspensas) {
+        trieRemover(inv, h.slot);
+    }
+
+    int ultimo = --inv->total;
+    if (posicao != ultimo) {
+        inv->itens[posicao] = inv->itens[ultimo];
+        inv->slotDoItem[posicao] = inv->slotDoItem[ultimo];
+        inv->posicaoDoSlot[inv->slotDoItem[posicao]] = posicao;
+    }
+    inv->geracao[h.slot]++;
+    inv->posicaoDoSlot[h.slot] = -2 - inv->slotLivre;
+    inv->slotLivre = h.slot;
+    // Compacta os nomes quando mais da metade da arena é de itens removidos.
+    if (inv->textos.lixo > 4096 && inv->textos.lixo * 2 > inv->textos.usado) {
+        arenaCompactar(inv);
+    }
+    return 1;
+}
+
+/**
+ * @brief Remove o item com esse nome.
+ * @return 1 se o item foi removido ou 0 se não foi encontrado.
+ */
+int inventarioRemover(Inventario *inv, const char *nome) {
+    int posicao = inventarioBuscar(inv, nome);
+    return posicao != -1 && inventarioRemoverHandle(inv, inventarioHandle(inv, posicao));
+}
+
+/**
+ * @brief Monta as visões (e a trie, se ativa) do zero com os itens atuais.
+ * Usada depois de uma carga em massa feita com 'visoesSuspensas', que evita
+ * manter as árvores a cada alteração de um histórico que só interessa pelo
+ * estado final. Se faltar memória para a trie, a busca por prefixo é desligada.
+ */
+void inventarioReconstruirVisoes(Inventario *inv) {
+    inv->visoesSuspensas = 0;
+    for (int v = 0; v < NUM_VISOES; v++) {
+        inv->visoes[v].raiz = -1;
+    }
+    if (inv->nomes != NULL) {
+        trieEsvaziar(inv->nomes);
+    }
+    for (int i = 0; i < inv->total; i++) {
+        int slot = inv->slotDoItem[i];
+        visoesInserir(inv, slot);
+        if (inv->nomes == NULL) {
+            continue;
+        }
+        if (trieReservar(inv->nomes, (int)strlen(inventarioNome(inv, i)), inv->capacidade) != 0) {
+            trieLiberar(inv->nomes);
+            inv->nomes = NULL;
+            continue;
+        }
+        trieInserir(inv, slot);
+    }
+}
+
+/**
+ * @brief Posições de todos os itens na ordem da visão (até 'maximo').
+ * @return Quantas posições foram escritas em 'saida'.
+ */
+int inventarioListarOrdenado(const Inventario *inv, VisaoInventario v, int *saida, int maximo) {
+    return visaoColetar(inv, v, inv->visoes[v].raiz, NULL, NULL, saida, maximo, 0);
+}
+
+/**
+ * @brief Itens de um tipo, em ordem de nome.
+ * @return Quantas posições foram escritas em 'saida' (no máximo 'maximo').
+ */
+int inventarioBuscarTipo(const Inventario *inv, const char *tipo, int *saida, int maximo) {
+    return visaoColetar(inv, VISAO_TIPO, inv->visoes[VISAO_TIPO].raiz, faixaTipo, tipo, saida, maximo, 0);
+}
+
+/**
+ * @brief Itens com quantidade entre 'minimo' e 'maximoQuantidade', em ordem crescente.
+ * @return Quantas posições foram escritas em 'saida' (no máximo 'maximo').
+ */
+int inventarioFaixaQuantidade(const Inventario *inv, int minimo, int maximoQuantidade, int *saida, int maximo) {
+    int limites[2] = {minimo, maximoQuantidade};
+    return visaoColetar(inv, VISAO_QUANTIDADE, inv->visoes[VISAO_QUANTIDADE].raiz,
+                        faixaQuantidade, limites, saida, maximo, 0);
+}
+
+/**
+ * @brief Liga a trie de nomes usada por inventarioBuscarPrefixo() e
+ * inventarioBuscarAproximado(), indexando os itens que já existem. Cada
+ * alteração passa a custar também O(tamanho do nome) na trie.
+ * @return 0 em sucesso ou -1 se faltar memória.
+ */
+int inventarioAtivarBuscaNomes(Inventario *inv) {
+    if (inv->nomes != NULL) {
+        return 0;
+    }
+    TrieNomes *t = calloc(1, sizeof(TrieNomes));
+    if (t == NULL || trieReservar(t, 1, inv->capacidade) != 0) {
+        trieLiberar(t);
+        return -1;
+    }
+    trieEsvaziar(t);
+    inv->nomes = t;
+    for (int i = 0; i < inv->total; i++) {
+        if (trieReservar(t, (int)strlen(inventarioNome(inv, i)), inv->capacidade) != 0) {
+            trieLiberar(t);
+            inv->nomes = NULL;
+            return -1;
+        }
+        trieInserir(inv, inv->slotDoItem[i]);
+    }
+    return 0;
+}
+
+/**
+ * @brief Itens cujo nome começa com 'prefixo' (sem diferenciar maiúsculas de
+ * minúsculas), da maior para a menor quantidade. A resposta já está guardada no
+ * nó do prefixo: custa O(tamanho do prefixo), qualquer que seja o catálogo.
+ * @param maximo No máximo TOPK_NOMES resultados são devolvidos.
+ * @return Quantas posições foram escritas em 'saida'.
+ */
+int inventarioBuscarPrefixo(const Inventario *inv, const char *prefixo, int *saida, int maximo) {
+    const TrieNomes *t = inv->nomes;
+    if (t == NULL) {
+        return 0;
+    }
+    int no = 0;
+    for (const char *p = prefixo; *p && no != -1; p++) {
+        no = trieFilho(t, no, letraTrie(*p));
+    }
+    if (no == -1) {
+        return 0;
+    }
+    int encontrados = t->nos[no].numMelhores < maximo ? t->nos[no].numMelhores : maximo;
+    for (int i = 0; i < encontrados; i++) {
+        saida[i] = inv->posicaoDoSlot[t->melhores[(size_t)no * TOPK_NOMES + i].slot];
+    }
+    return encontrados;
+}
+
+/**
+ * @brief Itens cujo nome fica a no máximo 'distanciaMaxima' edições (inserção,
+ * remoção ou troca de uma letra) de 'nome', sem diferenciar maiúsculas de
+ * minúsculas. Os mais próximos vêm primeiro e, na mesma distância, os de maior
+ * quantidade.
+ * @param maximo No máximo TOPK_NOMES resultados são devolvidos.
+ * @return Quantas posições foram escritas em 'saida'.
+ */
+int inventarioBuscarAproximado(const Inventario *inv, const char *nome, int distanciaMaxima, int *saida, int maximo) {
+    BuscaAproximada b;
+    b.tamanho = (int)strlen(nome);
+    if (inv->nomes == NULL || b.tamanho == 0 || b.tamanho >= (int)sizeof(b.alvo) || maximo <= 0) {
+        return 0;
+    }
+    b.inv = inv;
+    b.distanciaMaxima = distanciaMaxima;
+    b.encontrados = 0;
+    b.maximo = maximo < TOPK_NOMES ? maximo : TOPK_NOMES;
+    int linha[31];
+    for (int j = 0; j <= b.tamanho; j++) {
+        b.alvo[j] = (unsigned char)(j < b.tamanho ? letraTrie(nome[j]) : 0);
+        linha[j] = j <= distanciaMaxima ? j : distanciaMaxima + 1;
+    }
+    aproximadoVisitar(&b, 0, 0, linha);
+    for (int i = 0; i < b.encontrados; i++) {
+        saida[i] = inv->posicaoDoSlot[b.sugestoes[i].slot];
+    }
+    return b.encontrados;
+}
+
+// --- Funções de Persistência ---
+
+static double segundosAgora() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief CRC-32 (polinômio refletido 0xEDB88320), com tabela montada no primeiro uso.
+ */
+static uint32_t crc32Atualizar(uint32_t crc, const unsigned char *dados, size_t tamanho) {
+    static uint32_t tabela[256];
+    if (tabela[1] == 0) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            tabela[i] = c;
+        }
+    }
+    crc = ~crc;
+    for (size_t i = 0; i < tamanho; i++) {
+        crc = tabela[(crc ^ dados[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static void gravarU32(unsigned char *p, uint32_t v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static uint32_t lerU32(const unsigned char *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/**
+ * @brief Grava o buffer inteiro, repetindo write() em escritas parciais.
+ * @return 0 em sucesso ou -1 em erro.
+ */
+static int gravarTudo(int fd, const void *dados, size_t tamanho) {
+    const unsigned char *p = dados;
+    while (tamanho > 0) {
+        ssize_t n = write(fd, p, tamanho);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        p += n;
+        tamanho -= (size_t)n;
+    }
+    return 0;
+}
+
+/**
+ * @brief fsync do diretório que contém 'caminho', para que um rename() sobreviva a quedas.
+ */
+static void sincronizarDiretorio(const char *caminho) {
+    char diretorio[256];
+    snprintf(diretorio, sizeof(diretorio), "%s", caminho);
+    char *barra = strrchr(diretorio, '/');
+    if (barra == NULL) {
+        strcpy(diretorio, ".");
+    } else {
+        *(barra == diretorio ? barra + 1 : barra) = 0;
+    }
+    int fd = open(diretorio, O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+/**
+ * @brief Grava os itens do inventário no formato do checkpoint (um Item
+ * completo por item), expandindo a forma compacta em lotes.
+ */
+static int gravarItens(int fd, const Inventario *inv) {
+    Item lote[256];
+    for (int inicio = 0; inicio < inv->total; inicio += 256) {
+        int n = inv->total - inicio < 256 ? inv->total - inicio : 256;
+        for (int i = 0; i < n; i++) {
+            inventarioItem(inv, inicio + i, &lote[i]);
+        }
+        if (gravarTudo(fd, lote, (size_t)n * sizeof(Item)) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Cria um arquivo novo em 'caminho' de forma atômica: grava o cabeçalho
+ * e os itens de 'inv' (se não for NULL) em 'caminho.tmp', sincroniza e renomeia
+ * por cima do antigo.
+ * @return O descritor aberto (posicionado no fim) ou -1 em erro.
+ */
+static int substituirArquivo(const char *caminho, const void *cabecalho, size_t tamanho, const Inventario *inv) {
+    char temporario[300];
+    snprintf(temporario, sizeof(temporario), "%s.tmp", caminho);
+    int fd = open(temporario, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    int ok = gravarTudo(fd, cabecalho, tamanho) == 0 && (inv == NULL || gravarItens(fd, inv) == 0);
+    if (!ok || fsync(fd) != 0 || rename(temporario, caminho) != 0) {
+        close(fd);
+        unlink(temporario);
+        return -1;
+    }
+    sincronizarDiretorio(caminho);
+    return fd;
+}
+
+/**
+ * @brief Cria um diário vazio da geração atual no lugar do que existir.
+ * @return O descritor aberto ou -1 em erro.
+ */
+static int diarioRecomecar(Diario *d) {
+    unsigned char cabecalho[TAM_CABECALHO_DIARIO];
+    memcpy(cabecalho, DIARIO_MAGICO, 8);
+    gravarU32(cabecalho + 8, DIARIO_VERSAO);
+    gravarU32(cabecalho + 12, d->geracao);
+    return substituirArquivo(d->caminhoDiario, cabecalho, sizeof(cabecalho), NULL);
+}
+
+/**
+ * @brief Grava os registros pendentes e sincroniza o diário (um fdatasync para
+ * todo o grupo). Se uma compactação não conseguiu recriar o diário, tenta de
+ * novo aqui antes de gravar.
+ * @return 0 em sucesso ou -1 em erro de escrita.
+ */
+int diarioConfirmar(Diario *d) {
+    if (d->pendentes == 0) {
+        return 0;
+    }
+    if (d->fd < 0 && (d->fd = diarioRecomecar(d)) < 0) {
+        return -1;
+    }
+    if (gravarTudo(d->fd, d->buffer, d->pendentes) != 0 || fdatasync(d->fd) != 0) {
+        return -1;
+    }
+    d->pendentes = 0;
+    d->sincronizacoes++;
+    return 0;
+}
+
+/**
+ * @brief Grava um checkpoint com o inventário atual e recomeça o diário vazio.
+ * @return 0 em sucesso ou -1 em erro. Se só a troca do diário falhou, o
+ * checkpoint novo já vale e o diário é recriado no próximo diarioConfirmar().
+ */
+int diarioCompactar(Diario *d) {
+    if (diarioConfirmar(d) != 0) {
+        return -1;
+    }
+    const Inventario *inv = d->inventario;
+    uint32_t crc = 0;
+    for (int i = 0; i < inv->total; i++) {
+        Item item;
+        inventarioItem(inv, i, &item);
+        crc = crc32Atualizar(crc, (const unsigned char *)&item, sizeof(Item));
+    }
+    unsigned char cabecalho[24];
+    memcpy(cabecalho, CHECKPOINT_MAGICO, 8);
+    gravarU32(cabecalho + 8, DIARIO_VERSAO);
+    gravarU32(cabecalho + 12, d->geracao + 1);
+    gravarU32(cabecalho + 16, (uint32_t)inv->total);
+    gravarU32(cabecalho + 20, crc);
+    int fd = substituirArquivo(d->caminhoCheckpoint, cabecalho, sizeof(cabecalho), inv);
+    if (fd < 0) {
+        return -1;
+    }
+    close(fd);
+
+    // O checkpoint novo já vale: o diário antigo passa a ser ignorado, então os
+    // próximos registros só podem ir para um diário da geração nova.
+    d->geracao++;
+    d->registrosDiario = 0;
+    close(d->fd);
+    d->fd = diarioRecomecar(d);
+    return d->fd >= 0 ? 0 : -1;
+}
+
+/**
+ * @brief Acrescenta um registro ao buffer, gravando o grupo quando necessário.
+ * @return 0 em sucesso ou -1 em erro de escrita.
+ */
+static int diarioAcrescentar(Diario *d, TipoRegistro tipo, const char *nome, const char *tipoItem,
+                             int quantidade) {
+    unsigned char registro[TAM_CABECALHO_REGISTRO + 64];
+    size_t n = TAM_CABECALHO_REGISTRO;
+    size_t tamanhoNome = strlen(nome);
+    registro[n++] = (unsigned char)tamanhoNome;
+    memcpy(registro + n, nome, tamanhoNome);
+    n += tamanhoNome;
+    if (tipo == REGISTRO_INSERIR) {
+        size_t tamanhoTipo = strlen(tipoItem);
+        registro[n++] = (unsigned char)tamanhoTipo;
+        memcpy(registro + n, tipoItem, tamanhoTipo);
+        n += tamanhoTipo;
+    }
+    if (tipo != REGISTRO_REMOVER) {
+        gravarU32(registro + n, (uint32_t)quantidade);
+        n += 4;
+    }
+    size_t dados = n - TAM_CABECALHO_REGISTRO;
+    registro[4] = (unsigned char)dados;
+    registro[5] = (unsigned char)(dados >> 8);
+    registro[6] = (unsigned char)tipo;
+    gravarU32(registro, crc32Atualizar(0, registro + 4, n - 4));
+
+    if (d->pendentes + n > sizeof(d->buffer) && diarioConfirmar(d) != 0) {
+        return -1;
+    }
+    if (d->pendentes == 0) {
+        d->inicioPendente = segundosAgora();
+    }
+    memcpy(d->buffer + d->pendentes, registro, n);
+    d->pendentes += n;
+    d->registrosDiario++;
+
+    if (segundosAgora() - d->inicioPendente >= d->intervaloGrupo && diarioConfirmar(d) != 0) {
+        return -1;
+    }
+    if (d->limiteCompactacao > 0 && d->registrosDiario >= d->limiteCompactacao) {
+        return diarioCompactar(d);
+    }
+    return 0;
+}
+
+int diarioRegistrarInsercao(Diario *d, const Item *item) {
+    return diarioAcrescentar(d, REGISTRO_INSERIR, item->nome, item->tipo, item->quantidade);
+}
+
+int diarioRegistrarRemocao(Diario *d, const char *nome) {
+    return diarioAcrescentar(d, REGISTRO_REMOVER, nome, NULL, 0);
+}
+
+int diarioRegistrarQuantidade(Diario *d, const char *nome, int quantidade) {
+    return diarioAcrescentar(d, REGISTRO_QUANTIDADE, nome, NULL, quantidade);
+}
+
+/**
+ * @brief Lê o checkpoint para o inventário (vazio se o arquivo não existe).
+ * @return 0 em sucesso ou -1 se o checkpoint existe mas está corrompido.
+ */
+static int carregarCheckpoint(Diario *d, Inventario *inv) {
+    int fd = open(d->caminhoCheckpoint, O_RDONLY);
+    if (fd < 0) {
+        d->geracao = 0;
+        return errno == ENOENT ? 0 : -1;
+    }
+    struct stat info;
+    unsigned char *dados = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size >= 24) {
+        dados = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (dados == MAP_FAILED) {
+        return -1;
+    }
+    uint32_t total = lerU32(dados + 16);
+    int ok = memcmp(dados, CHECKPOINT_MAGICO, 8) == 0 && lerU32(dados + 8) == DIARIO_VERSAO &&
+             (uint64_t)info.st_size == 24 + (uint64_t)total * sizeof(Item) &&
+             crc32Atualizar(0, dados + 24, (size_t)total * sizeof(Item)) == lerU32(dados + 20);
+    if (ok) {
+        d->geracao = lerU32(dados + 12);
+        const Item *itens = (const Item *)(dados + 24);
+        for (uint32_t i = 0; i < total && ok; i++) {
+            ok = inventarioAdicionar(inv, &itens[i]) >= 0;
+        }
+    }
+    munmap(dados, (size_t)info.st_size);
+    return ok ? 0 : -1;
+}
+
+/**
+ * @brief Reaplica um registro do diário no inventário.
+ * @return 0 em sucesso, -1 se o registro está malformado ou tem tipo desconhecido,
+ * ou -2 se o inventário não aceitou o item (falta de memória ou limite de itens).
+ */
+static int aplicarRegistro(Inventario *inv, int tipo, const unsigned char *dados, size_t tamanho) {
+    Item item;
+    memset(&item, 0, sizeof(item));
+    size_t n = 0;
+    size_t tamanhoNome = dados[n++];
+    if (tamanhoNome >= sizeof(item.nome) || n + tamanhoNome > tamanho) {
+        return -1;
+    }
+    memcpy(item.nome, dados + n, tamanhoNome);
+    n += tamanhoNome;
+    if (tipo == REGISTRO_INSERIR) {
+        size_t tamanhoTipo = n < tamanho ? dados[n++] : sizeof(item.tipo);
+        if (tamanhoTipo >= sizeof(item.tipo) || n + tamanhoTipo > tamanho) {
+            return -1;
+        }
+        memcpy(item.tipo, dados + n, tamanhoTipo);
+        n += tamanhoTipo;
+    }
+    if (tipo != REGISTRO_REMOVER) {
+        if (n + 4 > tamanho) {
+            return -1;
+        }
+        item.quantidade = (int)lerU32(dados + n);
+    }
+
+    if (tipo == REGISTRO_INSERIR) {
+        return inventarioAdicionar(inv, &item) >= 0 ? 0 : -2;
+    }
+    if (tipo == REGISTRO_REMOVER) {
+        inventarioRemover(inv, item.nome);
+        return 0;
+    }
+    if (tipo == REGISTRO_QUANTIDADE) {
+        int posicao = inventarioBuscar(inv, item.nome);
+        if (posicao != -1) {
+            inventarioDefinirQuantidade(inv, posicao, item.quantidade);
+        }
+        return 0;
+    }
+    return -1;
+}
+
+/**
+ * @brief Abre a persistência em 'base' (arquivos base.ckpt e base.diario):
+ * carrega o checkpoint, reaplica o diário da mesma geração e descarta um
+ * registro final incompleto deixado por uma queda. Só um registro cortado ou
+ * com CRC errado é descartado: se um registro íntegro não pode ser reaplicado,
+ * a abertura falha e o diário fica como está.
+ * @return 0 em sucesso ou -1 em erro (mensagem já impressa).
+ */
+int diarioAbrir(Diario *d, const char *base, Inventario *inv) {
+    memset(d, 0, sizeof(*d));
+    d->fd = -1;
+    d->intervaloGrupo = 0.005;
+    d->inventario = inv;
+    snprintf(d->caminhoDiario, sizeof(d->caminhoDiario), "%s.diario", base);
+    snprintf(d->caminhoCheckpoint, sizeof(d->caminhoCheckpoint), "%s.ckpt", base);
+    // A recuperação só precisa do estado final: as visões são montadas uma vez no fim.
+    inv->visoesSuspensas = 1;
+    if (carregarCheckpoint(d, inv) != 0) {
+        inventarioReconstruirVisoes(inv);
+        printf("\n[ERRO] Checkpoint '%s' corrompido.\n", d->caminhoCheckpoint);
+        return -1;
+    }
+
+    int fd = open(d->caminhoDiario, O_RDWR);
+    struct stat info;
+    off_t valido = 0;
+    if (fd >= 0 && fstat(fd, &info) == 0 && info.st_size >= TAM_CABECALHO_DIARIO) {
+        unsigned char *dados = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        int cabecalhoValido = dados != MAP_FAILED && memcmp(dados, DIARIO_MAGICO, 8) == 0 &&
+                               lerU32(dados + 8) == DIARIO_VERSAO;
+        if (cabecalhoValido && lerU32(dados + 12) > d->geracao) {
+            printf("\n[ALERTA] Diario '%s' e mais novo que o checkpoint e sera descartado.\n",
+                   d->caminhoDiario);
+        }
+        if (cabecalhoValido && lerU32(dados + 12) == d->geracao) {
+            size_t pos = TAM_CABECALHO_DIARIO;
+            size_t fim = (size_t)info.st_size;
+            int aplicado = 0;
+            while (pos + TAM_CABECALHO_REGISTRO <= fim) {
+                size_t tamanho = (size_t)dados[pos + 4] | (size_t)dados[pos + 5] << 8;
+                if (tamanho == 0 || pos + TAM_CABECALHO_REGISTRO + tamanho > fim ||
+                    crc32Atualizar(0, dados + pos + 4, 3 + tamanho) != lerU32(dados + pos)) {
+                    break; // Registro incompleto ou corrompido: fim da parte válida
+                }
+                aplicado = aplicarRegistro(inv, dados[pos + 6], dados + pos + TAM_CABECALHO_REGISTRO, tamanho);
+                if (aplicado != 0) {
+                    break;
+                }
+                pos += TAM_CABECALHO_REGISTRO + tamanho;
+                d->recuperados++;
+            }
+            valido = (off_t)pos;
+            if (aplicado != 0) {
+                munmap(dados, (size_t)info.st_size);
+                close(fd);
+                inventarioReconstruirVisoes(inv);
+                printf("\n[ERRO] Nao foi possivel reaplicar o registro %llu do diario '%s' (%s); o arquivo foi mantido.\n",
+                       (unsigned long long)d->recuperados + 1, d->caminhoDiario,
+                       aplicado == -2 ? "sem memoria ou mochila cheia" : "registro invalido");
+                return -1;
+            }
+        }
+        if (dados != MAP_FAILED) {
+            munmap(dados, (size_t)info.st_size);
+        }
+    }
+
+    inventarioReconstruirVisoes(inv);
+
+    if (fd >= 0 && valido > 0) {
+        // Corta o que sobrou depois do último registro válido e continua dali.
+        if (ftruncate(fd, valido) != 0 || lseek(fd, valido, SEEK_SET) < 0) {
+            close(fd);
+            fd = -1;
+        }
+    } else {
+        // Diário ausente, de outra geração ou sem cabeçalho: recomeça vazio.
+        if (fd >= 0) {
+            close(fd);
+        }
+        fd = diarioRecomecar(d);
+    }
+    if (fd < 0) {
+        printf("\n[ERRO] Nao foi possivel abrir o diario '%s'.\n", d->caminhoDiario);
+        return -1;
+    }
+    d->fd = fd;
+    d->registrosDiario = d->recuperados;
+    return 0;
+}
+
+/**
+ * @brief Confirma os registros pendentes e fecha o diário.
+ * @return 0 em sucesso ou -1 se a última gravação falhou.
+ */
+int diarioFechar(Diario *d) {
+    int resultado = diarioConfirmar(d);
+    if (d->fd >= 0) {
+        close(d->fd);
+        d->fd = -1;
+    }
+    return resultado;
+}
+
+// --- Funções do Serviço Multijogador ---
+
+/**
+ * @brief Mistura os bits do id do jogador (finalizador do MurmurHash3), para que
+ * ids sequenciais se espalhem pelos fragmentos e pela tabela.
+ */
+static uint32_t misturarId(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x85EBCA6Bu;
+    x ^= x >> 13;
+    x *= 0xC2B2AE35u;
+    return x ^ (x >> 16);
+}
+
+/**
+ * @brief Prepara o serviço vazio.
+ * @param limiteMochila Capacidade de cada mochila (0 = sem limite).
+ */
+void servicoIniciar(ServicoMochilas *serv, int limiteMochila) {
+    memset(serv, 0, sizeof(*serv));
+    serv->limiteMochila = limiteMochila;
+    for (int f = 0; f < NUM_FRAGMENTOS; f++) {
+        pthread_mutex_init(&serv->fragmentos[f].trava, NULL);
+    }
+}
+
+void servicoLiberar(ServicoMochilas *serv) {
+    for (int f = 0; f < NUM_FRAGMENTOS; f++) {
+        FragmentoServico *frag = &serv->fragmentos[f];
+        for (int i = 0; i < frag->capacidade; i++) {
+            if (frag->jogadores[i].mochila != NULL) {
+                inventarioLiberar(frag->jogadores[i].mochila);
+                free(frag->jogadores[i].mochila);
+            }
+        }
+        free(frag->jogadores);
+        pthread_mutex_destroy(&frag->trava);
+    }
+}
+
+static FragmentoServico *fragmentoDoJogador(ServicoMochilas *serv, uint32_t jogador) {
+    return &serv->fragmentos[misturarId(jogador) & (NUM_FRAGMENTOS - 1)];
+}
+
+/**
+ * @brief Dobra a tabela de jogadores do fragmento. Chamada com a trava tomada.
+ */
+static int fragmentoCrescer(FragmentoServico *frag) {
+    int nova = frag->capacidade ? frag->capacidade * 2 : 64;
+    EntradaJogador *jogadores = calloc((size_t)nova, sizeof(EntradaJogador));
+    if (jogadores == NULL) {
+        return -1;
+    }
+    for (int i = 0; i < frag->capacidade; i++) {
+        if (frag->jogadores[i].mochila != NULL) {
+            // Os bits altos do hash escolhem a posição; os baixos já escolheram o fragmento.
+            int j = (int)((misturarId(frag->jogadores[i].jogador) >> 8) & (uint32_t)(nova - 1));
+            while (jogadores[j].mochila != NULL) {
+                j = (j + 1) & (nova - 1);
+            }
+            jogadores[j] = frag->jogadores[i];
+        }
+    }
+    free(frag->jogadores);
+    frag->jogadores = jogadores;
+    frag->capacidade = nova;
+    return 0;
+}
+
+/**
+ * @brief Mochila do jogador, criada vazia no primeiro acesso se 'criar' for 1.
+ * Chamada com a trava do fragmento tomada.
+ * @return A mochila, ou NULL se o jogador não existe (ou faltou memória).
+ */
+static Inventario *fragmentoMochila(ServicoMochilas *serv, FragmentoServico *frag, uint32_t jogador, int criar) {
+    if (frag->capacidade > 0) {
+        int mascara = frag->capacidade - 1;
+        for (int i = (int)((misturarId(jogador) >> 8) & (uint32_t)mascara); frag->jogadores[i].mochila != NULL;
+             i = (i + 1) & mascara) {
+            if (frag->jogadores[i].jogador == jogador) {
+                return frag->jogadores[i].mochila;
+            }
+        }
+    }
+    if (!criar) {
+        return NULL;
+    }
+    if ((frag->ocupadas + 1) * 10 > frag->capacidade * 7 && fragmentoCrescer(frag) != 0) {
+        return NULL;
+    }
+    Inventario *mochilaNova = malloc(sizeof(Inventario));
+    if (mochilaNova == NULL || inventarioIniciar(mochilaNova, serv->limiteMochila, 0) != 0) {
+        free(mochilaNova);
+        return NULL;
+    }
+    int mascara = frag->capacidade - 1;
+    int i = (int)((misturarId(jogador) >> 8) & (uint32_t)mascara);
+    while (frag->jogadores[i].mochila != NULL) {
+        i = (i + 1) & mascara;
+    }
+    frag->jogadores[i].jogador = jogador;
+    frag->jogadores[i].mochila = mochilaNova;
+    frag->ocupadas++;
+    return mochilaNova;
+}
+
+/**
+ * @brief Adiciona um item à mochila do jogador (somando se o nome já existe).
+ * @return A quantidade resultante, -1 se a mochila está cheia ou -2 se faltar memória.
+ */
+int servicoInserir(ServicoMochilas *serv, uint32_t jogador, const Item *item) {
+    FragmentoServico *frag = fragmentoDoJogador(serv, jogador);
+    pthread_mutex_lock(&frag->trava);
+    Inventario *inv = fragmentoMochila(serv, frag, jogador, 1);
+    int resultado = inv == NULL ? -2 : inventarioAdicionar(inv, item);
+    if (resultado >= 0) {
+        resultado = inventarioQuantidade(inv, resultado);
+    }
+    pthread_mutex_unlock(&frag->trava);
+    return resultado;
+}
+
+/**
+ * @return 1 se o item foi removido ou 0 se não estava na mochila.
+ */
+int servicoRemover(ServicoMochilas *serv, uint32_t jogador, const char *nome) {
+    FragmentoServico *frag = fragmentoDoJogador(serv, jogador);
+    pthread_mutex_lock(&frag->trava);
+    Inventario *inv = fragmentoMochila(serv, frag, jogador, 0);
+    int removido = inv != NULL && inventarioRemover(inv, nome);
+    pthread_mutex_unlock(&frag->trava);
+    return removido;
+}
+
+/**
+ * @brief Copia o item para 'saida' (a cópia continua válida depois que a trava é solta).
+ * @return 1 se o item foi encontrado ou 0 caso contrário.
+ */
+int servicoBuscar(ServicoMochilas *serv, uint32_t jogador, const char *nome, Item *saida) {
+    FragmentoServico *frag = fragmentoDoJogador(serv, jogador);
+    pthread_mutex_lock(&frag->trava);
+    Inventario *inv = fragmentoMochila(serv, frag, jogador, 0);
+    int posicao = inv != NULL ? inventarioBuscar(inv, nome) : -1;
+    if (posicao != -1) {
+        inventarioItem(inv, posicao, saida);
+    }
+    pthread_mutex_unlock(&frag->trava);
+    return posicao != -1;
+}
+
+/**
+ * @brief Copia até 'maximo' itens da mochila do jogador para 'saida'.
+ * @return Quantos itens foram copiados.
+ */
+int servicoListar(ServicoMochilas *serv, uint32_t jogador, Item *saida, int maximo) {
+    FragmentoServico *frag = fragmentoDoJogador(serv, jogador);
+    pthread_mutex_lock(&frag->trava);
+    Inventario *inv = fragmentoMochila(serv, frag, jogador, 0);
+    int n = 0;
+    for (; inv != NULL && n < inv->total && n < maximo; n++) {
+        inventarioItem(inv, n, &saida[n]);
+    }
+    pthread_mutex_unlock(&frag->trava);
+    return n;
+}
+
+// --- Servidor por Socket Unix ---
+/*
+ * Protocolo de texto, uma linha por pedido (o nome é o resto da linha e pode
+ * ter espaços; o tipo é uma palavra só):
+ *   INSERIR <jogador> <quantidade> <tipo> <nome>  -> OK <quantidade> | CHEIA | ERRO
+ *   REMOVER <jogador> <nome>                      -> OK | AUSENTE
+ *   BUSCAR <jogador> <nome>                       -> OK <quantidade> <tipo> <nome> | AUSENTE
+ *   LISTAR <jogador>                              -> OK <n>, seguido de n linhas "<quantidade> <tipo> <nome>"
+ *   DESLIGAR                                      -> OK (encerra o servidor)
+ */
+
+typedef struct Conexao Conexao;
+
+typedef struct {
+    ServicoMochilas *servico;
+    int socketEscuta;
+    int desligando;
+    int conexoesAtivas;
+    Conexao *conexoes;          // Conexões abertas, para o DESLIGAR encerrar as paradas
+    pthread_mutex_t trava;
+    pthread_cond_t semConexoes;
+} Servidor;
+
+struct Conexao {
+    Servidor *servidor;
+    int fd;
+    Conexao *anterior;
+    Conexao *proxima;
+};
+
+/**
+ * @brief Põe a conexão na lista do servidor (com a trava do servidor). Se o
+ * servidor já está desligando, a leitura dela é encerrada na hora.
+ */
+static void servidorRegistrar(Servidor *servidor, Conexao *conexao) {
+    conexao->anterior = NULL;
+    conexao->proxima = servidor->conexoes;
+    if (servidor->conexoes != NULL) {
+        servidor->conexoes->anterior = conexao;
+    }
+    servidor->conexoes = conexao;
+    servidor->conexoesAtivas++;
+    if (servidor->desligando) {
+        shutdown(conexao->fd, SHUT_RD);
+    }
+}
+
+/**
+ * @brief Tira a conexão da lista do servidor (com a trava do servidor).
+ */
+static void servidorDescadastrar(Servidor *servidor, Conexao *conexao) {
+    if (conexao->anterior != NULL) {
+        conexao->anterior->proxima = conexao->proxima;
+    } else {
+        servidor->conexoes = conexao->proxima;
+    }
+    if (conexao->proxima != NULL) {
+        conexao->proxima->anterior = conexao->anterior;
+    }
+    if (--servidor->conexoesAtivas == 0) {
+        pthread_cond_signal(&servidor->semConexoes);
+    }
+}
+
+/**
+ * @brief Começa o desligamento: para de aceitar conexões e encerra a leitura
+ * de todas as abertas. Cada conexão ainda responde aos pedidos que já recebeu
+ * e termina, inclusive as de clientes parados que não mandam mais nada.
+ */
+static void servidorDesligar(Servidor *servidor) {
+    pthread_mutex_lock(&servidor->trava);
+    servidor->desligando = 1;
+    for (Conexao *c = servidor->conexoes; c != NULL; c = c->proxima) {
+        shutdown(c->fd, SHUT_RD);
+    }
+    pthread_mutex_unlock(&servidor->trava);
+    shutdown(servidor->socketEscuta, SHUT_RDWR);
+}
+
+/**
+ * @brief Leitura de linhas sobre read(), sabendo se ainda há bytes recebidos e
+ * não consumidos (o que stdio não expõe).
+ */
+typedef struct {
+    int fd;
+    char buffer[4096];
+    size_t inicio;
+    size_t fim;
+} LeitorLinhas;
+
+/**
+ * @brief Lê uma linha (sem o '\n') para 'linha'; linhas maiores que a
+ * capacidade são cortadas.
+ * @return 1 se leu uma linha ou 0 no fim da conexão.
+ */
+static int lerLinha(LeitorLinhas *leitor, char *linha, size_t capacidade) {
+    size_t n = 0;
+    for (;;) {
+        if (leitor->inicio == leitor->fim) {
+            ssize_t lidos = read(leitor->fd, leitor->buffer, sizeof(leitor->buffer));
+            if (lidos < 0 && errno == EINTR) {
+                continue;
+            }
+            if (lidos <= 0) {
+                return 0;
+            }
+            leitor->inicio = 0;
+            leitor->fim = (size_t)lidos;
+        }
+        char c = leitor->buffer[leitor->inicio++];
+        if (c == '\n') {
+            linha[n] = 0;
+            return 1;
+        }
+        if (n + 1 < capacidade) {
+            linha[n++] = c;
+        }
+    }
+}
+
+static int leitorTemPendentes(const LeitorLinhas *leitor) {
+    return leitor->inicio < leitor->fim;
+}
+
+/**
+ * @brief Copia 'origem' para 'destino' (tamanho 'capacidade'), cortando o excesso.
+ */
+static void copiarCampo(char *destino, size_t capacidade, const char *origem) {
+    size_t n = strlen(origem);
+    if (n >= capacidade) {
+        n = capacidade - 1;
+    }
+    memcpy(destino, origem, n);
+    destino[n] = 0;
+}
+
+/**
+ * @brief Interpreta um pedido e escreve a resposta.
+ * @return 1 se o pedido foi DESLIGAR, 0 caso contrário.
+ */
+static int responderPedido(ServicoMochilas *serv, char *linha, FILE *saida) {
+    linha[strcspn(linha, "\r")] = 0;
+    char comando[16];
+    unsigned jogador = 0;
+    int lidos = 0;
+    if (sscanf(linha, "%15s %u %n", comando, &jogador, &lidos) < 1) {
+        fputs("ERRO pedido vazio\n", saida);
+        return 0;
+    }
+    const char *resto = lidos > 0 ? linha + lidos : "";
+
+    if (strcmp(comando, "INSERIR") == 0) {
+        Item item;
+        char tipo[64];
+        int quantidade, usados = 0;
+        if (lidos == 0 || sscanf(resto, "%d %63s %n", &quantidade, tipo, &usados) < 2 || resto[usados] == 0) {
+            fputs("ERRO uso: INSERIR <jogador> <quantidade> <tipo> <nome>\n", saida);
+            return 0;
+        }
+        copiarCampo(item.nome, sizeof(item.nome), resto + usados);
+        copiarCampo(item.tipo, sizeof(item.tipo), tipo);
+        item.quantidade = quantidade;
+        int resultado = servicoInserir(serv, jogador, &item);
+        if (resultado >= 0) {
+            fprintf(saida, "OK %d\n", resultado);
+        } else {
+            fputs(resultado == -1 ? "CHEIA\n" : "ERRO memoria\n", saida);
+        }
+    } else if (strcmp(comando, "REMOVER") == 0 && lidos > 0) {
+        fputs(servicoRemover(serv, jogador, resto) ? "OK\n" : "AUSENTE\n", saida);
+    } else if (strcmp(comando, "BUSCAR") == 0 && lidos > 0) {
+        Item item;
+        if (servicoBuscar(serv, jogador, resto, &item)) {
+            fprintf(saida, "OK %d %s %s\n", item.quantidade, item.tipo, item.nome);
+        } else {
+            fputs("AUSENTE\n", saida);
+        }
+    } else if (strcmp(comando, "LISTAR") == 0 && lidos > 0) {
+        Item itens[64];
+        int n = servicoListar(serv, jogador, itens, 64);
+        fprintf(saida, "OK %d\n", n);
+        for (int i = 0; i < n; i++) {
+            fprintf(saida, "%d %s %s\n", itens[i].quantidade, itens[i].tipo, itens[i].nome);
+        }
+    } else if (strcmp(comando, "DESLIGAR") == 0) {
+        fputs("OK\n", saida);
+        return 1;
+    } else {
+        fputs("ERRO comando desconhecido\n", saida);
+    }
+    return 0;
+}
+
+/**
+ * @brief Thread de uma conexão: lê pedidos até o cliente fechar. A resposta só
+ * é enviada quando não há mais pedidos já recebidos, então clientes que mandam
+ * vários pedidos de uma vez recebem as respostas numa única escrita.
+ */
+static void *atenderConexao(void *arg) {
+    Conexao *conexao = arg;
+    Servidor *servidor = conexao->servidor;
+    LeitorLinhas entrada;
+    entrada.fd = conexao->fd;
+    entrada.inicio = entrada.fim = 0;
+    FILE *saida = fdopen(conexao->fd, "w");
+    char linha[256];
+    while (saida != NULL && lerLinha(&entrada, linha, sizeof(linha))) {
+        if (responderPedido(servidor->servico, linha, saida)) {
+            servidorDesligar(servidor);
+        }
+        // Só envia quando o cliente não deixou mais pedidos no buffer.
+        if (!leitorTemPendentes(&entrada) && fflush(saida) != 0) {
+            break;
+        }
+    }
+    // Sai da lista antes de fechar, para o DESLIGAR não usar um descritor já fechado.
+    pthread_mutex_lock(&servidor->trava);
+    servidorDescadastrar(servidor, conexao);
+    pthread_mutex_unlock(&servidor->trava);
+    if (saida != NULL) {
+        fclose(saida);
+    } else {
+        close(conexao->fd);
+    }
+    free(conexao);
+    return NULL;
+}
+
+/**
+ * @brief Abre um socket Unix em 'caminho' para escuta ou para conexão.
+ * @return O descritor ou -1 em erro.
+ */
+static int abrirSocketUnix(const char *caminho, int escutar) {
+    struct sockaddr_un endereco;
+    memset(&endereco, 0, sizeof(endereco));
+    endereco.sun_family = AF_UNIX;
+    if (strlen(caminho) >= sizeof(endereco.sun_path)) {
+        return -1;
+    }
+    strcpy(endereco.sun_path, caminho);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    int ok;
+    if (escutar) {
+        unlink(caminho);
+        ok = bind(fd, (struct sockaddr *)&endereco, sizeof(endereco)) == 0 && listen(fd, 128) == 0;
+    } else {
+        ok = connect(fd, (struct sockaddr *)&endereco, sizeof(endereco)) == 0;
+    }
+    if (!ok) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief "./Freefire --servidor caminho [limite]": atende o protocolo acima
+ * num socket Unix, com uma thread por conexão, até receber DESLIGAR.
+ */
+int executarServidor(int argc, char *argv[]) {
+    if (argc < 3) {
+        printf("[ERRO] Uso: ./Freefire --servidor caminho [limite_mochila]\n");
+        return 1;
+    }
+    int limite = argc > 3 ? atoi(argv[3]) : CAPACIDADE_MAXIMA;
+    signal(SIGPIPE, SIG_IGN); // Cliente que fecha no meio de uma resposta não derruba o servidor
+
+    static ServicoMochilas servico;
+    servicoIniciar(&servico, limite);
+    Servidor servidor;
+    memset(&servidor, 0, sizeof(servidor));
+    servidor.servico = &servico;
+    pthread_mutex_init(&servidor.trava, NULL);
+    pthread_cond_init(&servidor.semConexoes, NULL);
+    servidor.socketEscuta = abrirSocketUnix(argv[2], 1);
+    if (servidor.socketEscuta < 0) {
+        printf("[ERRO] Nao foi possivel escutar em '%s'.\n", argv[2]);
+        servicoLiberar(&servico);
+        return 1;
+    }
+    printf("[INFO] Servidor de mochilas em '%s' (%d fragmentos, limite %d itens).\n",
+           argv[2], NUM_FRAGMENTOS, limite);
+    fflush(stdout);
+
+    for (;;) {
+        int fd = accept(servidor.socketEscuta, NULL, NULL);
+        pthread_mutex_lock(&servidor.trava);
+        int desligando = servidor.desligando;
+        pthread_mutex_unlock(&servidor.trava);
+        if (fd < 0) {
+            if (desligando) {
+                break;
+            }
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            printf("[ERRO] Falha ao aceitar conexao.\n");
+            break;
+        }
+        Conexao *conexao = malloc(sizeof(Conexao));
+        pthread_t thread;
+        pthread_attr_t atributos;
+        pthread_attr_init(&atributos);
+        pthread_attr_setdetachstate(&atributos, PTHREAD_CREATE_DETACHED);
+        if (conexao == NULL) {
+            close(fd);
+            pthread_attr_destroy(&atributos);
+            continue;
+        }
+        conexao->servidor = &servidor;
+        conexao->fd = fd;
+        pthread_mutex_lock(&servidor.trava);
+        servidorRegistrar(&servidor, conexao);
+        pthread_mutex_unlock(&servidor.trava);
+        if (pthread_create(&thread, &atributos, atenderConexao, conexao) != 0) {
+            pthread_mutex_lock(&servidor.trava);
+            servidorDescadastrar(&servidor, conexao);
+            pthread_mutex_unlock(&servidor.trava);
+            close(fd);
+            free(conexao);
+        }
+        pthread_attr_destroy(&atributos);
+    }
+
+    // Espera as conexões abertas terminarem antes de liberar as mochilas.
+    pthread_mutex_lock(&servidor.trava);
+    while (servidor.conexoesAtivas > 0) {
+        pthread_cond_wait(&servidor.semConexoes, &servidor.trava);
+    }
+    pthread_mutex_unlock(&servidor.trava);
+    close(servidor.socketEscuta);
+    unlink(argv[2]);
+    servicoLiberar(&servico);
+    printf("[INFO] Servidor encerrado.\n");
+    return 0;
+}
+
+// --- Gerador de Carga ---
+
+#define BALDES_LATENCIA 1024
+
+/**
+ * @brief Balde do histograma de latência: exato abaixo de 16 ns e, acima disso,
+ * 16 baldes por potência de 2 (erro relativo de no máximo 1/16).
+ */
+static int baldeLatencia(uint64_t ns) {
+    if (ns < 16) {
+        return (int)ns;
+    }
+    int expoente = 63 - __builtin_clzll(ns);
+    return (expoente - 3) * 16 + (int)((ns >> (expoente - 4)) & 15);
+}
+
+static uint64_t valorDoBalde(int balde) {
+    if (balde < 16) {
+        return (uint64_t)balde;
+    }
+    int expoente = balde / 16 + 3;
+    return (uint64_t)(16 + balde % 16) << (expoente - 4);
+}
+
+static uint64_t percentilLatencia(const uint64_t *histograma, uint64_t total, double fracao) {
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t alvo = (uint64_t)((double)total * fracao);
+    uint64_t acumulado = 0;
+    for (int b = 0; b < BALDES_LATENCIA; b++) {
+        acumulado += histograma[b];
+        if (acumulado > alvo) {
+            return valorDoBalde(b);
+        }
+    }
+    return valorDoBalde(BALDES_LATENCIA - 1);
+}
+
+typedef struct {
+    const char *caminho;        // Socket do servidor (NULL = serviço local, sem socket)
+    ServicoMochilas *servico;
+    uint32_t jogadores;
+    uint32_t semente;
+    double fim;                 // Instante de parar
+    uint64_t operacoes;
+    uint64_t falhas;
+    uint64_t histograma[BALDES_LATENCIA];
+} TrabalhadorCarga;
+
+/**
+ * @brief Thread do gerador: pedidos aleatórios (60% BUSCAR, 25% INSERIR,
+ * 15% REMOVER) de jogadores aleatórios, um de cada vez, medindo a latência de
+ * cada pedido até a resposta.
+ */
+static void *executarTrabalhadorCarga(void *arg) {
+    TrabalhadorCarga *t = arg;
+    const char *tipos[] = {"Arma", "Municao", "Cura", "Ferramenta"};
+    LeitorLinhas entrada;
+    FILE *saida = NULL;
+    if (t->caminho != NULL) {
+        entrada.fd = abrirSocketUnix(t->caminho, 0);
+        entrada.inicio = entrada.fim = 0;
+        saida = entrada.fd >= 0 ? fdopen(entrada.fd, "w") : NULL;
+        if (saida == NULL) {
+            t->falhas++;
+            return NULL;
+        }
+    }
+    uint32_t x = t->semente;
+    char pedido[128], resposta[256];
+    while (segundosAgora() < t->fim) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        uint32_t jogador = x % t->jogadores;
+        int sorteio = (int)((x >> 20) % 100);
+        Item item;
+        snprintf(item.nome, sizeof(item.nome), "Item %02u", (x >> 8) % 16);
+        strcpy(item.tipo, tipos[(x >> 12) % 4]);
+        item.quantidade = 1 + (int)((x >> 14) % 9);
+
+        double inicio = segundosAgora();
+        int ok = 1;
+        if (t->caminho == NULL) {
+            Item encontrado;
+            if (sorteio < 60) {
+                servicoBuscar(t->servico, jogador, item.nome, &encontrado);
+            } else if (sorteio < 85) {
+                ok = servicoInserir(t->servico, jogador, &item) != -2;
+            } else {
+                servicoRemover(t->servico, jogador, item.nome);
+            }
+        } else {
+            if (sorteio < 60) {
+                snprintf(pedido, sizeof(pedido), "BUSCAR %u %s\n", jogador, item.nome);
+            } else if (sorteio < 85) {
+                snprintf(pedido, sizeof(pedido), "INSERIR %u %d %s %s\n", jogador, item.quantidade,
+                         item.tipo, item.nome);
+            } else {
+                snprintf(pedido, sizeof(pedido), "REMOVER %u %s\n", jogador, item.nome);
+            }
+            if (fputs(pedido, saida) < 0 || fflush(saida) != 0 || !lerLinha(&entrada, resposta, sizeof(resposta))) {
+                t->falhas++;
+                break; // Conexão perdida
+            }
+            ok = strncmp(resposta, "ERRO", 4) != 0;
+        }
+        double duracao = segundosAgora() - inicio;
+        t->histograma[baldeLatencia((uint64_t)(duracao * 1e9))]++;
+        t->operacoes++;
+        t->falhas += !ok;
+    }
+    if (saida != NULL) {
+        fclose(saida);
+    }
+    return NULL;
+}
 
-// --- Protótipos das Funções ---
-void menu();
-void inserirItem();
-void removerItem();
-void listarItens();
-int buscarItem(char nomeBusca[30]); // Retorna o índice do item ou -1 se não encontrado
+/**
+ * @brief "./Freefire --carga caminho|local [threads_max] [segundos] [jogadores]":
+ * roda rodadas com 1, 2, 4, ... threads até 'threads_max', cada uma por
+ * 'segundos', e imprime operações por segundo e latências p50/p99 por rodada.
+ * Com "local" as threads chamam o serviço direto, sem socket, o que isola o
+ * custo das travas por fragmento.
+ */
+int executarCarga(int argc, char *argv[]) {
+    if (argc < 3) {
+        printf("[ERRO] Uso: ./Freefire --carga caminho|local [threads_max] [segundos] [jogadores]\n");
+        return 1;
+    }
+    const char *caminho = strcmp(argv[2], "local") == 0 ? NULL : argv[2];
+    int maxThreads = argc > 3 ? atoi(argv[3]) : 8;
+    double segundos = argc > 4 ? atof(argv[4]) : 2.0;
+    uint32_t jogadores = argc > 5 ? (uint32_t)strtoul(argv[5], NULL, 10) : 10000;
+    if (maxThreads <= 0 || maxThreads > 1024 || segundos <= 0 || jogadores == 0) {
+        printf("[ERRO] Parametros invalidos.\n");
+        return 1;
+    }
 
-// --- Função Principal (main) ---
-int main() {
-    // Inicializa o sistema e exibe o menu principal
-    menu();
-    return 0;
+    static ServicoMochilas servico;
+    if (caminho == NULL) {
+        servicoIniciar(&servico, CAPACIDADE_MAXIMA);
+    }
+    TrabalhadorCarga *trabalhadores = calloc((size_t)maxThreads, sizeof(TrabalhadorCarga));
+    pthread_t *threads = malloc((size_t)maxThreads * sizeof(pthread_t));
+    if (trabalhadores == NULL || threads == NULL) {
+        printf("[ERRO] Falha na alocacao de memoria para a carga.\n");
+        free(trabalhadores);
+        free(threads);
+        if (caminho == NULL) {
+            servicoLiberar(&servico);
+        }
+        return 1;
+    }
+
+    printf("--- CARGA NO SERVICO DE MOCHILAS (%s, %u jogadores) ---\n",
+           caminho ? caminho : "local", jogadores);
+    printf("%8s | %12s | %10s | %10s | %7s\n", "threads", "ops/s", "p50 (us)", "p99 (us)", "falhas");
+    int falhasTotais = 0;
+    for (int n = 1; n <= maxThreads; n = n * 2 > maxThreads && n != maxThreads ? maxThreads : n * 2) {
+        double fim = segundosAgora() + segundos;
+        // Para na primeira thread que não pôde ser criada: as 'criadas' primeiras são as que existem.
+        int criadas = 0;
+        for (int i = 0; i < n; i++) {
+            memset(&trabalhadores[i], 0, sizeof(TrabalhadorCarga));
+            trabalhadores[i].caminho = caminho;
+            trabalhadores[i].servico = &servico;
+            trabalhadores[i].jogadores = jogadores;
+            trabalhadores[i].semente = 0x9E3779B9u * (uint32_t)(i + 1) + (uint32_t)n;
+            trabalhadores[i].fim = fim;
+            if (pthread_create(&threads[i], NULL, executarTrabalhadorCarga, &trabalhadores[i]) != 0) {
+                printf("[ALERTA] Apenas %d de %d threads puderam ser criadas.\n", criadas, n);
+                break;
+            }
+            criadas++;
+        }
+        double inicio = segundosAgora();
+        uint64_t operacoes = 0, falhas = 0;
+        static uint64_t histograma[BALDES_LATENCIA];
+        memset(histograma, 0, sizeof(histograma));
+        for (int i = 0; i < criadas; i++) {
+            pthread_join(threads[i], NULL);
+            operacoes += trabalhadores[i].operacoes;
+            falhas += trabalhadores[i].falhas;
+            for (int b = 0; b < BALDES_LATENCIA; b++) {
+                histograma[b] += trabalhadores[i].histograma[b];
+            }
+        }
+        double duracao = segundosAgora() - inicio;
+        printf("%8d | %12.0f | %10.2f | %10.2f | %7llu\n", n, (double)operacoes / duracao,
+               (double)percentilLatencia(histograma, operacoes, 0.50) / 1e3,
+               (double)percentilLatencia(histograma, operacoes, 0.99) / 1e3, (unsigned long long)falhas);
+        falhasTotais += falhas > 0 || criadas < n;
+        if (n == maxThreads) {
+            break;
+        }
+    }
+
+    free(trabalhadores);
+    free(threads);
+    if (caminho == NULL) {
+        servicoLiberar(&servico);
+    }
+    return falhasTotais == 0 ? 0 : 1;
 }
 
 // --- Funções de Operação do Inventário ---
@@ -47,14 +2670,18 @@ void menu() {
         printf("2. Remover Item pelo Nome\n");
         printf("3. Buscar Item pelo Nome\n");
         printf("4. Listar Todos os Itens\n");
+        printf("5. Listar Itens por Tipo\n");
+        printf("6. Listar Itens por Faixa de Quantidade\n");
         printf("0. Sair do Jogo\n");
         printf("-------------------------------\n");
         printf("Escolha uma opcao: ");
-        // Leitura segura da opção
-        if (scanf("%d", &opcao) != 1) {
-            // Limpa o buffer de entrada em caso de falha na leitura (caractere não numérico)
-            int c;
-            while ((c = getchar()) != '\n' && c != EOF);
+        // Leitura da opção: a linha inteira é consumida, então as leituras de
+        // nomes seguintes começam na linha certa. O fim da entrada (uma sessão
+        // redirecionada que acabou) sai do jogo como a opção 0.
+        int lido = entradaInteiroLinha(&entradaPadrao, &opcao);
+        if (lido < 0) {
+            opcao = 0;
+        } else if (lido == 0) {
             opcao = -1; // Define uma opção inválida para repetir o loop
         }
 
@@ -70,22 +2697,18 @@ void menu() {
                 {
                     char nomeBusca[30];
                     printf("\nInforme o nome do item a buscar: ");
-                    // Limpa o buffer antes de ler a string
-                    int c;
-                    while ((c = getchar()) != '\n' && c != EOF);
-                    // Leitura da string (usando fgets para maior segurança)
-                    if (fgets(nomeBusca, sizeof(nomeBusca), stdin) != NULL) {
-                        // Remove o newline (\n) capturado pelo fgets
-                        nomeBusca[strcspn(nomeBusca, "\n")] = 0;
+                    // Leitura da linha (sem o '\n', cortada no tamanho do nome)
+                    if (entradaLinha(&entradaPadrao, nomeBusca, sizeof(nomeBusca)) >= 0) {
                         int indice = buscarItem(nomeBusca);
                         if (indice != -1) {
                             printf("\n--- Item Encontrado ---\n");
-                            printf("Nome: %s\n", inventario[indice].nome);
-                            printf("Tipo: %s\n", inventario[indice].tipo);
-                            printf("Quantidade: %d\n", inventario[indice].quantidade);
+                            printf("Nome: %s\n", inventarioNome(&mochila, indice));
+                            printf("Tipo: %s\n", inventarioTipo(&mochila, indice));
+                            printf("Quantidade: %d\n", inventarioQuantidade(&mochila, indice));
                             printf("----------------------\n");
                         } else {
                             printf("\n[ALERTA] Item \"%s\" nao foi encontrado na mochila.\n", nomeBusca);
+                            sugerirItens(nomeBusca);
                         }
                     }
                 }
@@ -93,17 +2716,34 @@ void menu() {
             case 4:
                 listarItens();
                 break;
+            case 5:
+                listarItensPorTipo();
+                break;
+            case 6:
+                listarItensPorQuantidade();
+                break;
             case 0:
                 printf("\n[SAIDA] Salvando o inventario e saindo do jogo. Boa sorte!\n");
+                // Compacta o diário num checkpoint para a próxima partida abrir rápido.
+                if (persistenciaAtiva && diarioCompactar(&diario) != 0) {
+                    registrarErro("\n[ERRO] Falha ao salvar o checkpoint da mochila.\n");
+                }
                 break;
             default:
-                printf("\n[ERRO] Opcao invalida. Por favor, tente novamente.\n");
+                registrarAviso("\n[ERRO] Opcao invalida. Por favor, tente novamente.\n");
                 break;
         }
 
-        // Listagem dos itens após cada operação (requisito funcional)
-        if (opcao != 0 && opcao != 3) {
-            listarItens();
+        // Cada operação confirmada vai para o disco num único grupo do diário.
+        if (persistenciaAtiva && diarioConfirmar(&diario) != 0) {
+            registrarErro("\n[ERRO] Falha ao gravar o diario da mochila.\n");
+        }
+
+        // Listagem dos itens após cada operação (requisito funcional). Ela é uma
+        // mensagem informativa: vai para o log com "--log" e some da compilação
+        // com NIVEL_LOG abaixo de LOG_INFO.
+        if (LOG_HABILITADO(LOG_INFO) && opcao != 0 && opcao != 3 && opcao != 5 && opcao != 6) {
+            escreverListagem(logEscrever);
         }
 
     } while (opcao != 0);
@@ -111,76 +2751,70 @@ void menu() {
 
 /**
  * @brief Cadastra um novo item na mochila, respeitando o limite de capacidade.
+ * Um item com nome já cadastrado tem a quantidade somada ao existente.
  */
 void inserirItem() {
-    if (totalItens >= CAPACIDADE_MAXIMA) {
-        printf("\n[ERRO] A mochila esta cheia! Capacidade maxima (%d) atingida.\n", CAPACIDADE_MAXIMA);
-        return;
-    }
-
     Item novoItem;
 
     printf("\n--- Cadastro de Novo Item ---\n");
 
-    // Limpa o buffer antes de ler strings
-    int c;
-    while ((c = getchar()) != '\n' && c != EOF);
-
     printf("Informe o Nome do Item (max 29 caracteres): ");
-    if (fgets(novoItem.nome, sizeof(novoItem.nome), stdin) != NULL) {
-        // Remove o newline (\n)
-        novoItem.nome[strcspn(novoItem.nome, "\n")] = 0;
-    } else {
+    if (entradaLinha(&entradaPadrao, novoItem.nome, sizeof(novoItem.nome)) < 0) {
         return; // Falha na leitura
     }
 
+    // Com a mochila cheia, só um item que já está nela pode ter a quantidade somada.
+    if (mochila.total >= CAPACIDADE_MAXIMA && inventarioBuscar(&mochila, novoItem.nome) == -1) {
+        registrarAviso("\n[ERRO] A mochila esta cheia! Capacidade maxima (%d) atingida.\n", CAPACIDADE_MAXIMA);
+        return;
+    }
+
     printf("Informe o Tipo do Item (ex: Arma, Municao, Cura): ");
-    if (fgets(novoItem.tipo, sizeof(novoItem.tipo), stdin) != NULL) {
-        // Remove o newline (\n)
-        novoItem.tipo[strcspn(novoItem.tipo, "\n")] = 0;
-    } else {
+    if (entradaLinha(&entradaPadrao, novoItem.tipo, sizeof(novoItem.tipo)) < 0) {
         return; // Falha na leitura
     }
 
     printf("Informe a Quantidade: ");
-    if (scanf("%d", &novoItem.quantidade) != 1) {
-        printf("\n[ERRO] Leitura de quantidade invalida. Cadastro cancelado.\n");
-        // Limpa o buffer após a falha
-        while ((c = getchar()) != '\n' && c != EOF);
+    if (entradaInteiro(&entradaPadrao, &novoItem.quantidade) != 1) {
+        // Uma quantidade inválida já teve o resto da linha descartado
+        registrarAviso("\n[ERRO] Leitura de quantidade invalida. Cadastro cancelado.\n");
         return;
     }
 
-    // Adiciona o novo item ao final do vetor (inventario)
-    inventario[totalItens] = novoItem;
-    totalItens++;
-
-    printf("\n[SUCESSO] Item '%s' cadastrado com sucesso! (%d/%d)\n", novoItem.nome, totalItens, CAPACIDADE_MAXIMA);
+    // Adiciona o novo item ao inventário (e ao índice por nome)
+    int totalAntes = mochila.total;
+    int indice = inventarioAdicionar(&mochila, &novoItem);
+    if (indice < 0) {
+        registrarErro("\n[ERRO] Falha na alocacao de memoria. Cadastro cancelado.\n");
+        return;
+    }
+    if (persistenciaAtiva) {
+        diarioRegistrarInsercao(&diario, &novoItem);
+    }
+    if (mochila.total == totalAntes) {
+        registrarInfo("\n[SUCESSO] Item '%s' ja estava na mochila: quantidade atualizada para %d.\n",
+                      inventarioNome(&mochila, indice), inventarioQuantidade(&mochila, indice));
+    } else {
+        registrarInfo("\n[SUCESSO] Item '%s' cadastrado com sucesso! (%d/%d)\n", novoItem.nome, mochila.total, CAPACIDADE_MAXIMA);
+    }
 }
 
 /**
- * @brief Implementa a busca sequencial.
+ * @brief Busca o item pelo nome usando o índice hash da mochila.
  * @param nomeBusca O nome do item a ser procurado.
  * @return O índice do item encontrado no vetor ou -1 se não for encontrado.
  */
 int buscarItem(char nomeBusca[30]) {
-    // Percorre o vetor de structs do início (0) até o último item cadastrado (totalItens - 1)
-    for (int i = 0; i < totalItens; i++) {
-        // Comparação de strings ignorando a caixa (strcasecmp é mais robusto, mas stricmp é mais comum em C padrão,
-        // vamos usar strcmp por ser padrão, mas alertar sobre a sensibilidade à caixa)
-        if (strcmp(inventario[i].nome, nomeBusca) == 0) {
-            return i; // Item encontrado no índice 'i'
-        }
-    }
-    return -1; // Item não encontrado
+    return inventarioBuscar(&mochila, nomeBusca);
 }
 
 /**
  * @brief Remove um item da mochila com base no nome.
- * Utiliza a busca sequencial e, se encontrado, remove e reorganiza o vetor.
+ * O índice hash localiza o item e o último item ocupa o lugar do removido.
  */
 void removerItem() {
-    if (totalItens == 0) {
-        printf("\n[ALERTA] A mochila esta vazia. Nao ha itens para remover.\n");
+    if (mochila.total == 0) {
+        registrarAviso("\n[ALERTA] A mochila esta vazia. Nao ha itens para remover.\n");
         return;
     }
 
@@ -188,57 +2822,921 @@ void removerItem() {
     printf("\n--- Remocao de Item ---\n");
     printf("Informe o nome do item a ser removido: ");
 
-    // Limpa o buffer antes de ler a string
-    int c;
-    while ((c = getchar()) != '\n' && c != EOF);
-    
-    // Leitura da string (usando fgets)
-    if (fgets(nomeRemover, sizeof(nomeRemover), stdin) != NULL) {
-        // Remove o newline (\n)
-        nomeRemover[strcspn(nomeRemover, "\n")] = 0;
-    } else {
+    // Leitura da linha (sem o '\n', cortada no tamanho do nome)
+    if (entradaLinha(&entradaPadrao, nomeRemover, sizeof(nomeRemover)) < 0) {
         return; // Falha na leitura
     }
 
-    // Busca o item no inventário
-    int indice = buscarItem(nomeRemover);
-
-    if (indice != -1) {
-        // Item encontrado. Remove o item e reorganiza o vetor.
-        // Move todos os elementos a partir do índice removido uma posição para trás
-        for (int i = indice; i < totalItens - 1; i++) {
-            inventario[i] = inventario[i + 1];
+    if (inventarioRemover(&mochila, nomeRemover)) {
+        if (persistenciaAtiva) {
+            diarioRegistrarRemocao(&diario, nomeRemover);
         }
-
-        totalItens--; // Decrementa o contador de itens
-        printf("\n[SUCESSO] Item '%s' removido da mochila.\n", nomeRemover);
+        registrarInfo("\n[SUCESSO] Item '%s' removido da mochila.\n", nomeRemover);
     } else {
-        printf("\n[ALERTA] Item \"%s\" nao foi encontrado na mochila. Remocao cancelada.\n", nomeRemover);
+        registrarAviso("\n[ALERTA] Item \"%s\" nao foi encontrado na mochila. Remocao cancelada.\n", nomeRemover);
+    }
+}
+
+/**
+ * @brief Escreve na tela; mesmo formato de logEscrever, para escreverListagem().
+ */
+static void escreverTela(const char *formato, ...) {
+    va_list args;
+    va_start(args, formato);
+    vprintf(formato, args);
+    va_end(args);
+}
+
+/**
+ * @brief Monta a listagem da mochila com a função de escrita dada: a tela
+ * (opção 4) ou o log (listagem automática depois de cada operação).
+ */
+static void escreverListagem(void (*escrever)(const char *formato, ...)) {
+    escrever("\n======================================================\n");
+    escrever("             LISTAGEM ATUAL DA MOCHILA (%d/%d)             \n", mochila.total, CAPACIDADE_MAXIMA);
+    escrever("======================================================\n");
+    escrever("| %-25s | %-15s | %-10s |\n", "NOME", "TIPO", "QUANTIDADE");
+    escrever("------------------------------------------------------\n");
+
+    if (mochila.total == 0) {
+        escrever("| %-54s |\n", "Mochila vazia! Coletar recursos URGENTE!");
+        escrever("======================================================\n");
+        return;
+    }
+
+    // Percorre o vetor e exibe os dados de cada item
+    for (int i = 0; i < mochila.total; i++) {
+        escrever("| %-25s | %-15s | %-10d |\n",
+                 inventarioNome(&mochila, i),
+                 inventarioTipo(&mochila, i),
+                 inventarioQuantidade(&mochila, i));
     }
+    escrever("======================================================\n");
 }
 
 /**
  * @brief Lista todos os itens atualmente registrados na mochila.
  */
 void listarItens() {
+    escreverListagem(escreverTela);
+}
+
+/**
+ * @brief Imprime os itens das posições indicadas, na ordem recebida.
+ */
+static void imprimirItensSelecionados(const char *titulo, const int *posicoes, int quantidade) {
     printf("\n======================================================\n");
-    printf("             LISTAGEM ATUAL DA MOCHILA (%d/%d)             \n", totalItens, CAPACIDADE_MAXIMA);
+    printf("   %-50s \n", titulo);
     printf("======================================================\n");
     printf("| %-25s | %-15s | %-10s |\n", "NOME", "TIPO", "QUANTIDADE");
     printf("------------------------------------------------------\n");
+    if (quantidade == 0) {
+        printf("| %-54s |\n", "Nenhum item encontrado.");
+    }
+    for (int i = 0; i < quantidade; i++) {
+        printf("| %-25s | %-15s | %-10d |\n", inventarioNome(&mochila, posicoes[i]),
+               inventarioTipo(&mochila, posicoes[i]), inventarioQuantidade(&mochila, posicoes[i]));
+    }
+    printf("======================================================\n");
+}
+
+/**
+ * @brief Lista a mochila ordenada por tipo (e por nome dentro do tipo), lida
+ * direto da visão ordenada, sem ordenar a cada chamada.
+ */
+void listarItensPorTipo() {
+    int posicoes[CAPACIDADE_MAXIMA];
+    int quantidade = inventarioListarOrdenado(&mochila, VISAO_TIPO, posicoes, CAPACIDADE_MAXIMA);
+    imprimirItensSelecionados("MOCHILA ORDENADA POR TIPO", posicoes, quantidade);
+}
 
-    if (totalItens == 0) {
-        printf("| %-54s |\n", "Mochila vazia! Coletar recursos URGENTE!");
-        printf("======================================================\n");
+/**
+ * @brief Lê uma faixa de quantidades e lista os itens dentro dela, em ordem
+ * crescente de quantidade.
+ */
+void listarItensPorQuantidade() {
+    int minimo, maximo;
+    printf("\nInforme a quantidade minima e a maxima (ex: 1 50): ");
+    if (entradaInteiro(&entradaPadrao, &minimo) != 1 || entradaInteiro(&entradaPadrao, &maximo) != 1) {
+        printf("\n[ERRO] Faixa invalida.\n");
         return;
     }
+    int posicoes[CAPACIDADE_MAXIMA];
+    int quantidade = inventarioFaixaQuantidade(&mochila, minimo, maximo, posicoes, CAPACIDADE_MAXIMA);
+    char titulo[64];
+    snprintf(titulo, sizeof(titulo), "ITENS COM QUANTIDADE ENTRE %d E %d", minimo, maximo);
+    imprimirItensSelecionados(titulo, posicoes, quantidade);
+}
+
+/**
+ * @brief Quando a busca exata falha, mostra os itens que começam com o texto
+ * digitado ("Muni" acha "Municao 9mm") ou, se não houver nenhum, os de nome
+ * parecido, tolerando um erro de digitação em nomes curtos e dois nos demais.
+ */
+void sugerirItens(const char *nome) {
+    int posicoes[TOPK_NOMES];
+    int quantidade = inventarioBuscarPrefixo(&mochila, nome, posicoes, TOPK_NOMES);
+    if (quantidade == 0) {
+        int distancia = strlen(nome) <= 4 ? 1 : 2;
+        quantidade = inventarioBuscarAproximado(&mochila, nome, distancia, posicoes, TOPK_NOMES);
+    }
+    if (quantidade > 0) {
+        imprimirItensSelecionados("VOCE QUIS DIZER:", posicoes, quantidade);
+    }
+}
 
-    // Percorre o vetor e exibe os dados de cada item
-    for (int i = 0; i < totalItens; i++) {
-        printf("| %-25s | %-15s | %-10d |\n",
-               inventario[i].nome,
-               inventario[i].tipo,
-               inventario[i].quantidade);
+// --- Benchmark de Busca ---
+
+/**
+ * @brief "./Freefire --bench-busca [itens] [buscas]": monta um catálogo sem
+ * limite de capacidade e mede buscas (metade encontradas, metade não) pela
+ * busca sequencial e pelo índice hash, conferindo que as duas concordam.
+ * Também mede remoções e reinserções pelo índice.
+ */
+int executarBenchBusca(int argc, char *argv[]) {
+    int numItens = argc > 2 ? atoi(argv[2]) : 50000;
+    int numBuscas = argc > 3 ? atoi(argv[3]) : 1000000;
+    if (numItens <= 0 || numBuscas <= 0) {
+        printf("[ERRO] Uso: ./Freefire --bench-busca [itens] [buscas]\n");
+        return 1;
     }
-    printf("======================================================\n");
-}
\ No newline at end of file
+    const char *tipos[] = {"Arma", "Municao", "Cura", "Ferramenta"};
+
+    Inventario catalogo;
+    if (inventarioIniciar(&catalogo, 0, 1) != 0) {
+        printf("[ERRO] Falha na alocacao de memoria para o catalogo.\n");
+        return 1;
+    }
+    double inicio = segundosAgora();
+    for (int i = 0; i < numItens; i++) {
+        Item item;
+        snprintf(item.nome, sizeof(item.nome), "Item %07d", i);
+        strcpy(item.tipo, tipos[i % 4]);
+        item.quantidade = 1 + i % 100;
+        if (inventarioAdicionar(&catalogo, &item) < 0) {
+            printf("[ERRO] Falha na alocacao de memoria para o catalogo.\n");
+            inventarioLiberar(&catalogo);
+            return 1;
+        }
+    }
+    double tempoCadastro = segundosAgora() - inicio;
+
+    // Nomes buscados: índices pares existem, ímpares passam do fim do catálogo.
+    // Letras minúsculas exercitam a busca sem diferenciar maiúsculas.
+    uint32_t semente = 12345;
+    char (*nomes)[30] = malloc((size_t)numBuscas * sizeof(*nomes));
+    if (nomes == NULL) {
+        printf("[ERRO] Falha na alocacao de memoria para as buscas.\n");
+        inventarioLiberar(&catalogo);
+        return 1;
+    }
+    for (int i = 0; i < numBuscas; i++) {
+        semente = semente * 1664525u + 1013904223u;
+        int alvo = (int)((semente >> 8) % (uint32_t)numItens);
+        snprintf(nomes[i], sizeof(nomes[i]), "item %07d", (i & 1) ? numItens + alvo : alvo);
+    }
+
+    // A busca sequencial é lenta demais para todas as buscas: mede uma amostra,
+    // guardando cada posição para conferir com a do índice.
+    int sequenciais[2000];
+    int amostra = numBuscas < 2000 ? numBuscas : 2000;
+    inicio = segundosAgora();
+    for (int i = 0; i < amostra; i++) {
+        sequenciais[i] = inventarioBuscarSequencial(&catalogo, nomes[i]);
+    }
+    double tempoSequencial = (segundosAgora() - inicio) / amostra;
+
+    int iguais = 1;
+    for (int i = 0; i < amostra && iguais; i++) {
+        iguais = inventarioBuscar(&catalogo, nomes[i]) == sequenciais[i];
+    }
+
+    inicio = segundosAgora();
+    long long encontrados = 0;
+    for (int i = 0; i < numBuscas; i++) {
+        encontrados += inventarioBuscar(&catalogo, nomes[i]) != -1;
+    }
+    double tempoHash = (segundosAgora() - inicio) / numBuscas;
+
+    // Remove e recoloca metade do catálogo pelo índice.
+    inicio = segundosAgora();
+    int removidos = 0;
+    for (int i = 0; i < numItens; i += 2) {
+        char nome[30];
+        snprintf(nome, sizeof(nome), "Item %07d", i);
+        removidos += inventarioRemover(&catalogo, nome);
+    }
+    for (int i = 0; i < numItens; i += 2) {
+        Item item;
+        snprintf(item.nome, sizeof(item.nome), "Item %07d", i);
+        strcpy(item.tipo, tipos[i % 4]);
+        item.quantidade = 1;
+        inventarioAdicionar(&catalogo, &item);
+    }
+    double tempoRemocao = (segundosAgora() - inicio) / (2.0 * removidos);
+    for (int i = 0; i < amostra && iguais; i++) {
+        int a = inventarioBuscar(&catalogo, nomes[i]);
+        int b = inventarioBuscarSequencial(&catalogo, nomes[i]);
+        iguais = a == b;
+    }
+
+    printf("--- BENCHMARK DE BUSCA NA MOCHILA ---\n");
+    printf("Itens: %d | Cadastro: %.1f ms | Ocupacao do indice: %d/%d\n",
+           numItens, tempoCadastro * 1e3, catalogo.indice.ocupadas, catalogo.indice.capacidade);
+    printf("Busca sequencial: %10.1f ns/busca (amostra de %d)\n", tempoSequencial * 1e9, amostra);
+    printf("Indice hash:      %10.1f ns/busca (%d buscas, %lld encontradas)\n",
+           tempoHash * 1e9, numBuscas, encontrados);
+    printf("Remocao + reinsercao pelo indice: %.1f ns/operacao\n", tempoRemocao * 1e9);
+    printf("Aceleracao: %.0fx | Resultados %s\n", tempoSequencial / tempoHash,
+           iguais ? "conferem" : "DIVERGEM");
+
+    free(nomes);
+    inventarioLiberar(&catalogo);
+    return iguais ? 0 : 1;
+}
+
+// --- Benchmark das Visões Ordenadas ---
+
+static const Inventario *inventarioComparado; // Usado por qsort nas conferências
+
+static int compararPorQuantidade(const void *a, const void *b) {
+    int x = inventarioQuantidade(inventarioComparado, *(const int *)a);
+    int y = inventarioQuantidade(inventarioComparado, *(const int *)b);
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief "./Freefire --bench-visoes [itens] [operacoes]": aplica remoções,
+ * inserções e mudanças de quantidade aleatórias num catálogo grande, mede o
+ * custo por operação com as visões mantidas e compara a consulta de faixa pela
+ * visão com filtrar e ordenar o vetor a cada chamada. Confere as duas respostas
+ * e que handles de itens removidos não resolvem mais.
+ */
+int executarBenchVisoes(int argc, char *argv[]) {
+    int numItens = argc > 2 ? atoi(argv[2]) : 100000;
+    int numOperacoes = argc > 3 ? atoi(argv[3]) : 1000000;
+    if (numItens <= 0 || numOperacoes < 0) {
+        printf("[ERRO] Uso: ./Freefire --bench-visoes [itens] [operacoes]\n");
+        return 1;
+    }
+    const char *tipos[] = {"Arma", "Municao", "Cura", "Ferramenta"};
+
+    Inventario catalogo;
+    HandleItem *handles = malloc((size_t)numItens * sizeof(HandleItem));
+    int *faixa = malloc((size_t)numItens * sizeof(int));
+    int *conferencia = malloc((size_t)numItens * sizeof(int));
+    if (inventarioIniciar(&catalogo, 0, 0) != 0 || handles == NULL || faixa == NULL || conferencia == NULL) {
+        printf("[ERRO] Falha na alocacao de memoria para o catalogo.\n");
+        free(handles);
+        free(faixa);
+        free(conferencia);
+        inventarioLiberar(&catalogo);
+        return 1;
+    }
+    uint32_t semente = 2024;
+    int proximoNome = 0, adicionado = 0;
+    for (int i = 0; i < numItens && adicionado >= 0; i++) {
+        Item item;
+        semente = semente * 1664525u + 1013904223u;
+        snprintf(item.nome, sizeof(item.nome), "Item %07d", proximoNome++);
+        strcpy(item.tipo, tipos[(semente >> 8) % 4]);
+        item.quantidade = (int)((semente >> 12) % 1000);
+        if ((adicionado = inventarioAdicionar(&catalogo, &item)) >= 0) {
+            handles[i] = inventarioHandle(&catalogo, adicionado);
+        }
+    }
+
+    // Cada operação escolhe um handle: remove o item e coloca outro no lugar, ou
+    // muda a quantidade. Handles removidos precisam deixar de resolver.
+    int handlesInvalidos = 0, remocoes = 0, iguais = 1;
+    double inicio = segundosAgora();
+    for (int op = 0; op < numOperacoes && adicionado >= 0; op++) {
+        semente = semente * 1664525u + 1013904223u;
+        int escolhido = (int)((semente >> 8) % (uint32_t)numItens);
+        int posicao = inventarioResolver(&catalogo, handles[escolhido]);
+        if (semente & 1) {
+            HandleItem antigo = handles[escolhido];
+            remocoes += inventarioRemoverHandle(&catalogo, antigo);
+            Item item;
+            snprintf(item.nome, sizeof(item.nome), "Item %07d", proximoNome++);
+            strcpy(item.tipo, tipos[(semente >> 4) % 4]);
+            item.quantidade = (int)((semente >> 12) % 1000);
+            if ((adicionado = inventarioAdicionar(&catalogo, &item)) < 0) {
+                break;
+            }
+            handles[escolhido] = inventarioHandle(&catalogo, adicionado);
+            handlesInvalidos += inventarioResolver(&catalogo, antigo) == -1;
+        } else {
+            inventarioDefinirQuantidade(&catalogo, posicao, (int)((semente >> 12) % 1000));
+        }
+    }
+    double tempoOperacoes = segundosAgora() - inicio;
+    if (adicionado < 0) {
+        printf("[ERRO] Falha na alocacao de memoria para o catalogo.\n");
+        free(handles);
+        free(faixa);
+        free(conferencia);
+        inventarioLiberar(&catalogo);
+        return 1;
+    }
+
+    const int repeticoes = 100;
+    int encontrados = 0;
+    inicio = segundosAgora();
+    for (int r = 0; r < repeticoes; r++) {
+        encontrados = inventarioFaixaQuantidade(&catalogo, 400, 409, faixa, numItens);
+    }
+    double tempoVisao = (segundosAgora() - inicio) / repeticoes;
+
+    // Referência: filtrar o vetor e ordenar a cada consulta.
+    int esperados = 0;
+    inicio = segundosAgora();
+    for (int r = 0; r < repeticoes; r++) {
+        esperados = 0;
+        for (int i = 0; i < catalogo.total; i++) {
+            if (inventarioQuantidade(&catalogo, i) >= 400 && inventarioQuantidade(&catalogo, i) <= 409) {
+                conferencia[esperados++] = i;
+            }
+        }
+        inventarioComparado = &catalogo;
+        qsort(conferencia, (size_t)esperados, sizeof(int), compararPorQuantidade);
+    }
+    double tempoOrdenando = (segundosAgora() - inicio) / repeticoes;
+    iguais = encontrados == esperados;
+    for (int i = 1; i < encontrados && iguais; i++) {
+        iguais = inventarioQuantidade(&catalogo, faixa[i - 1]) <= inventarioQuantidade(&catalogo, faixa[i]);
+    }
+    for (int i = 0; i < encontrados && iguais; i++) {
+        iguais = inventarioQuantidade(&catalogo, faixa[i]) == inventarioQuantidade(&catalogo, conferencia[i]);
+    }
+
+    int porTipo = 0;
+    for (int t = 0; t < 4; t++) {
+        int n = inventarioBuscarTipo(&catalogo, tipos[t], faixa, numItens);
+        for (int i = 0; i < n && iguais; i++) {
+            iguais = strcmp(inventarioTipo(&catalogo, faixa[i]), tipos[t]) == 0 &&
+                     (i == 0 ||
+                      strcmp(inventarioNome(&catalogo, faixa[i - 1]), inventarioNome(&catalogo, faixa[i])) < 0);
+        }
+        porTipo += n;
+    }
+    iguais = iguais && porTipo == catalogo.total && handlesInvalidos == remocoes &&
+             inventarioListarOrdenado(&catalogo, VISAO_QUANTIDADE, faixa, numItens) == catalogo.total;
+
+    printf("--- BENCHMARK DAS VISOES ORDENADAS ---\n");
+    printf("Itens: %d | Operacoes: %d | %.0f ns/operacao (indice + visoes)\n",
+           catalogo.total, numOperacoes, tempoOperacoes / (numOperacoes ? numOperacoes : 1) * 1e9);
+    printf("Faixa de quantidade 400..409: %d itens\n", encontrados);
+    printf("Pela visao: %.1f us | Filtrando e ordenando: %.1f us\n", tempoVisao * 1e6, tempoOrdenando * 1e6);
+    printf("Handles de itens removidos invalidados: %d | Resultados %s\n", handlesInvalidos,
+           iguais ? "conferem" : "DIVERGEM");
+
+    free(handles);
+    free(faixa);
+    free(conferencia);
+    inventarioLiberar(&catalogo);
+    return iguais ? 0 : 1;
+}
+
+// --- Benchmark do Diário ---
+
+/**
+ * @brief Confere se dois inventários têm os mesmos itens (nome, tipo e quantidade).
+ */
+static int inventariosIguais(const Inventario *a, const Inventario *b) {
+    if (a->total != b->total) {
+        return 0;
+    }
+    for (int i = 0; i < a->total; i++) {
+        int j = inventarioBuscar(b, inventarioNome(a, i));
+        if (j == -1 || strcmp(inventarioTipo(a, i), inventarioTipo(b, j)) != 0 ||
+            inventarioQuantidade(a, i) != inventarioQuantidade(b, j)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief "./Freefire --bench-diario [registros] [base]": aplica alterações
+ * aleatórias num catálogo grande gravando tudo no diário com group commit,
+ * compara com uma sincronização por alteração e mede a recuperação: primeiro
+ * reaplicando o diário inteiro, depois a partir de um checkpoint compactado.
+ * Também acrescenta meio registro ao fim do diário, como numa queda durante a
+ * gravação, e confere que a recuperação o descarta.
+ */
+int executarBenchDiario(int argc, char *argv[]) {
+    long numRegistros = argc > 2 ? atol(argv[2]) : 2000000;
+    const char *base = argc > 3 ? argv[3] : "bench-mochila";
+    if (numRegistros <= 0) {
+        printf("[ERRO] Uso: ./Freefire --bench-diario [registros] [base]\n");
+        return 1;
+    }
+    const char *tipos[] = {"Arma", "Municao", "Cura", "Ferramenta"};
+    const int numNomes = 50000;
+
+    Diario d;
+    Inventario vivo, recuperado;
+    char caminho[300];
+    snprintf(caminho, sizeof(caminho), "%s.diario", base);
+    unlink(caminho);
+    snprintf(caminho, sizeof(caminho), "%s.ckpt", base);
+    unlink(caminho);
+    if (inventarioIniciar(&vivo, 0, 0) != 0 || diarioAbrir(&d, base, &vivo) != 0) {
+        printf("[ERRO] Nao foi possivel preparar o diario em '%s'.\n", base);
+        return 1;
+    }
+
+    // Mistura de alterações: 40% inserções, 40% mudanças de quantidade, 20% remoções.
+    uint32_t semente = 77;
+    int falhas = 0;
+    double inicio = segundosAgora();
+    for (long r = 0; r < numRegistros; r++) {
+        semente = semente * 1664525u + 1013904223u;
+        Item item;
+        snprintf(item.nome, sizeof(item.nome), "Item %05u", (semente >> 8) % (uint32_t)numNomes);
+        int sorteio = (int)((semente >> 4) % 10);
+        int posicao = inventarioBuscar(&vivo, item.nome);
+        if (sorteio < 4 || posicao == -1) {
+            strcpy(item.tipo, tipos[semente % 4]);
+            item.quantidade = 1 + (int)(semente % 50);
+            inventarioAdicionar(&vivo, &item);
+            falhas += diarioRegistrarInsercao(&d, &item) != 0;
+        } else if (sorteio < 8) {
+            int quantidade = (int)(semente % 1000);
+            inventarioDefinirQuantidade(&vivo, posicao, quantidade);
+            falhas += diarioRegistrarQuantidade(&d, item.nome, quantidade) != 0;
+        } else {
+            inventarioRemover(&vivo, item.nome);
+            falhas += diarioRegistrarRemocao(&d, item.nome) != 0;
+        }
+    }
+    falhas += diarioConfirmar(&d) != 0;
+    double tempoGravacao = segundosAgora() - inicio;
+    uint64_t gruposGravados = d.sincronizacoes;
+    off_t tamanhoDiario = lseek(d.fd, 0, SEEK_END);
+
+    // Referência: uma sincronização por alteração, numa amostra pequena.
+    const int amostra = 200;
+    inicio = segundosAgora();
+    for (int r = 0; r < amostra; r++) {
+        int posicao = r % vivo.total;
+        falhas += diarioRegistrarQuantidade(&d, inventarioNome(&vivo, posicao),
+                                            inventarioQuantidade(&vivo, posicao)) != 0;
+        falhas += diarioConfirmar(&d) != 0;
+    }
+    double tempoSincrono = (segundosAgora() - inicio) / amostra;
+
+    // Queda simulada: meio registro no fim do diário.
+    const unsigned char lixo[] = {0x12, 0x34, 0x56, 0x78, 40, 0, REGISTRO_INSERIR, 5, 'I', 't'};
+    falhas += gravarTudo(d.fd, lixo, sizeof(lixo)) != 0;
+    close(d.fd);
+    d.fd = -1;
+
+    Diario r = {.fd = -1};
+    inicio = segundosAgora();
+    int ok = inventarioIniciar(&recuperado, 0, 0) == 0 && diarioAbrir(&r, base, &recuperado) == 0;
+    double tempoReplay = segundosAgora() - inicio;
+    uint64_t reaplicados = r.recuperados;
+    int iguais = ok && inventariosIguais(&vivo, &recuperado);
+
+    // Compacta num checkpoint e recupera de novo.
+    inicio = segundosAgora();
+    ok = ok && diarioCompactar(&r) == 0;
+    double tempoCompactacao = segundosAgora() - inicio;
+    diarioFechar(&r);
+    inventarioLiberar(&recuperado);
+    inicio = segundosAgora();
+    ok = ok && inventarioIniciar(&recuperado, 0, 0) == 0 && diarioAbrir(&r, base, &recuperado) == 0;
+    double tempoCheckpoint = segundosAgora() - inicio;
+    iguais = iguais && ok && inventariosIguais(&vivo, &recuperado);
+    diarioFechar(&r);
+
+    printf("--- BENCHMARK DO DIARIO ---\n");
+    printf("Registros: %ld | Diario: %.1f MB | Itens vivos: %d\n", numRegistros,
+           (double)tamanhoDiario / (1024.0 * 1024.0), vivo.total);
+    printf("Group commit: %.0f registros/s em %llu sincronizacoes (%.1f registros/grupo)\n",
+           (double)numRegistros / tempoGravacao, (unsigned long long)gruposGravados,
+           (double)numRegistros / (double)(gruposGravados ? gruposGravados : 1));
+    printf("Uma sincronizacao por registro: %.0f registros/s\n", 1.0 / tempoSincrono);
+    printf("Recuperacao pelo diario: %.1f ms (%llu registros reaplicados, registro cortado descartado)\n",
+           tempoReplay * 1e3, (unsigned long long)reaplicados);
+    printf("Compactacao: %.1f ms | Recuperacao pelo checkpoint: %.1f ms\n",
+           tempoCompactacao * 1e3, tempoCheckpoint * 1e3);
+    printf("Estado recuperado %s | Falhas de escrita: %d\n", iguais ? "confere" : "DIVERGE", falhas);
+
+    inventarioLiberar(&recuperado);
+    inventarioLiberar(&vivo);
+    snprintf(caminho, sizeof(caminho), "%s.diario", base);
+    unlink(caminho);
+    snprintf(caminho, sizeof(caminho), "%s.ckpt", base);
+    unlink(caminho);
+    return iguais && falhas == 0 ? 0 : 1;
+}
+
+// --- Benchmark da Busca por Nomes ---
+
+/**
+ * @brief Distância de Levenshtein completa, sem diferenciar maiúsculas de
+ * minúsculas. Referência para conferir a busca aproximada.
+ */
+static int distanciaEdicao(const char *a, const char *b) {
+    int linha[31];
+    int tamanhoB = (int)strlen(b);
+    for (int j = 0; j <= tamanhoB; j++) {
+        linha[j] = j;
+    }
+    for (int i = 1; a[i - 1]; i++) {
+        int diagonal = linha[0];
+        linha[0] = i;
+        for (int j = 1; j <= tamanhoB; j++) {
+            int acima = linha[j];
+            int valor = diagonal + (letraTrie(a[i - 1]) != letraTrie(b[j - 1]));
+            if (acima + 1 < valor) {
+                valor = acima + 1;
+            }
+            if (linha[j - 1] + 1 < valor) {
+                valor = linha[j - 1] + 1;
+            }
+            linha[j] = valor;
+            diagonal = acima;
+        }
+    }
+    return linha[tamanhoB];
+}
+
+static int compararTempos(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Sorteia um nome de catálogo no estilo "Pistola Tatica 48213".
+ */
+static void gerarNomeCatalogo(char *nome, size_t tamanho, uint32_t sorteio, int numero) {
+    static const char *bases[] = {"Municao 9mm", "Municao 5.56", "Pistola", "Fuzil", "Espingarda",
+                                  "Granada", "Colete", "Capacete", "Kit Medico", "Bandagem",
+                                  "Faca", "Mira", "Silenciador", "Carregador", "Lanterna", "Radio"};
+    static const char *variantes[] = {"Tatica", "Leve", "Pesada", "Dourada", "Camuflada",
+                                      "Antiga", "Rapida", "Rara", "Lendaria", "Comum"};
+    snprintf(nome, tamanho, "%s %s %d", bases[sorteio % 16], variantes[(sorteio >> 4) % 10], numero);
+}
+
+/**
+ * @brief Faz de uma a duas edições aleatórias no nome (troca, remoção ou
+ * inserção de letra), simulando erros de digitação.
+ */
+static void errarDigitacao(char *nome, uint32_t *semente) {
+    int edicoes = 1 + (int)(*semente & 1);
+    for (int e = 0; e < edicoes; e++) {
+        *semente = *semente * 1664525u + 1013904223u;
+        int tamanho = (int)strlen(nome);
+        int i = (int)((*semente >> 8) % (uint32_t)tamanho);
+        char letra = (char)('a' + (*semente >> 20) % 26);
+        switch ((*semente >> 4) % 3) {
+            case 0:
+                nome[i] = letra;
+                break;
+            case 1:
+                if (tamanho > 1) {
+                    memmove(&nome[i], &nome[i + 1], (size_t)(tamanho - i));
+                }
+                break;
+            default:
+                if (tamanho < 29) {
+                    memmove(&nome[i + 1], &nome[i], (size_t)(tamanho - i + 1));
+                    nome[i] = letra;
+                }
+                break;
+        }
+    }
+}
+
+/**
+ * @brief "./Freefire --bench-nomes [itens] [consultas]": monta um catálogo com
+ * a trie de nomes ativa, aplica remoções e mudanças de quantidade, e mede buscas
+ * por prefixo e aproximadas (até 2 edições). Uma amostra das respostas é
+ * conferida com uma varredura linear do catálogo.
+ */
+int executarBenchNomes(int argc, char *argv[]) {
+    int numItens = argc > 2 ? atoi(argv[2]) : 200000;
+    int numConsultas = argc > 3 ? atoi(argv[3]) : 100000;
+    if (numItens <= 0 || numConsultas <= 0) {
+        printf("[ERRO] Uso: ./Freefire --bench-nomes [itens] [consultas]\n");
+        return 1;
+    }
+    Inventario catalogo;
+    int *varredura = malloc((size_t)numItens * sizeof(int));
+    if (inventarioIniciar(&catalogo, 0, 1) != 0 || inventarioAtivarBuscaNomes(&catalogo) != 0 || varredura == NULL) {
+        printf("[ERRO] Falha na alocacao de memoria para o catalogo.\n");
+        free(varredura);
+        inventarioLiberar(&catalogo);
+        return 1;
+    }
+    uint32_t semente = 2024;
+    int proximoNumero = 0;
+    double inicio = segundosAgora();
+    for (int i = 0; i < numItens; i++) {
+        Item item;
+        semente = semente * 1664525u + 1013904223u;
+        gerarNomeCatalogo(item.nome, sizeof(item.nome), semente >> 8, proximoNumero++);
+        strcpy(item.tipo, "Loot");
+        item.quantidade = 1 + (int)((semente >> 12) % 999);
+        if (inventarioAdicionar(&catalogo, &item) < 0) {
+            printf("[ERRO] Falha na alocacao de memoria para o catalogo.\n");
+            free(varredura);
+            inventarioLiberar(&catalogo);
+            return 1;
+        }
+    }
+    double tempoCarga = segundosAgora() - inicio;
+
+    // Alterações depois da carga: as sugestões guardadas nos nós precisam acompanhar.
+    int numAlteracoes = numItens / 2;
+    inicio = segundosAgora();
+    for (int op = 0; op < numAlteracoes; op++) {
+        semente = semente * 1664525u + 1013904223u;
+        int posicao = (int)((semente >> 8) % (uint32_t)catalogo.total);
+        if (semente & 1) {
+            inventarioRemoverHandle(&catalogo, inventarioHandle(&catalogo, posicao));
+            Item item;
+            gerarNomeCatalogo(item.nome, sizeof(item.nome), semente >> 4, proximoNumero++);
+            strcpy(item.tipo, "Loot");
+            item.quantidade = 1 + (int)((semente >> 12) % 999);
+            inventarioAdicionar(&catalogo, &item);
+        } else {
+            inventarioDefinirQuantidade(&catalogo, posicao, 1 + (int)((semente >> 12) % 999));
+        }
+    }
+    double tempoAlteracoes = segundosAgora() - inicio;
+
+    int resultado[TOPK_NOMES];
+    int conferencia[TOPK_NOMES];
+    char consulta[30];
+    int iguais = 1;
+
+    // Prefixos de 1 a 12 letras de nomes do catálogo.
+    long long totalPrefixo = 0;
+    inicio = segundosAgora();
+    for (int c = 0; c < numConsultas; c++) {
+        semente = semente * 1664525u + 1013904223u;
+        const char *nome = inventarioNome(&catalogo, (semente >> 8) % (uint32_t)catalogo.total);
+        int tamanho = 1 + (int)((semente >> 4) % 12);
+        snprintf(consulta, sizeof(consulta), "%.*s", tamanho, nome);
+        totalPrefixo += inventarioBuscarPrefixo(&catalogo, consulta, resultado, TOPK_NOMES);
+    }
+    double tempoPrefixo = (segundosAgora() - inicio) / numConsultas;
+
+    // Referência para prefixos: varre o catálogo e ordena os que casam.
+    const int amostraPrefixo = 200;
+    inicio = segundosAgora();
+    for (int c = 0; c < amostraPrefixo && iguais; c++) {
+        semente = semente * 1664525u + 1013904223u;
+        const char *nome = inventarioNome(&catalogo, (semente >> 8) % (uint32_t)catalogo.total);
+        int tamanho = 1 + (int)((semente >> 4) % 12);
+        snprintf(consulta, sizeof(consulta), "%.*s", tamanho, nome);
+        int esperados = 0;
+        for (int i = 0; i < catalogo.total; i++) {
+            if (strncasecmp(inventarioNome(&catalogo, i), consulta, (size_t)tamanho) == 0) {
+                varredura[esperados++] = i;
+            }
+        }
+        inventarioComparado = &catalogo;
+        qsort(varredura, (size_t)esperados, sizeof(int), compararPorQuantidade);
+        int n = inventarioBuscarPrefixo(&catalogo, consulta, resultado, TOPK_NOMES);
+        iguais = n == (esperados < TOPK_NOMES ? esperados : TOPK_NOMES);
+        for (int i = 0; i < n && iguais; i++) {
+            iguais = inventarioQuantidade(&catalogo, resultado[i]) ==
+                     inventarioQuantidade(&catalogo, varredura[esperados - 1 - i]);
+        }
+    }
+    double tempoVarredura = (segundosAgora() - inicio) / amostraPrefixo;
+
+    // Nomes do catálogo com uma ou duas letras erradas, buscados com até 2 edições.
+    int numAproximadas = numConsultas / 10 > 0 ? numConsultas / 10 : 1;
+    long long totalAproximado = 0;
+    double *tempos = malloc((size_t)numAproximadas * sizeof(double));
+    if (tempos == NULL) {
+        printf("[ERRO] Falha na alocacao de memoria para as medidas.\n");
+        free(varredura);
+        inventarioLiberar(&catalogo);
+        return 1;
+    }
+    inicio = segundosAgora();
+    for (int c = 0; c < numAproximadas; c++) {
+        semente = semente * 1664525u + 1013904223u;
+        strcpy(consulta, inventarioNome(&catalogo, (semente >> 8) % (uint32_t)catalogo.total));
+        errarDigitacao(consulta, &semente);
+        double antes = segundosAgora();
+        totalAproximado += inventarioBuscarAproximado(&catalogo, consulta, 2, resultado, TOPK_NOMES);
+        tempos[c] = segundosAgora() - antes;
+    }
+    double tempoAproximado = (segundosAgora() - inicio) / numAproximadas;
+    qsort(tempos, (size_t)numAproximadas, sizeof(double), compararTempos);
+    double p99Aproximada = tempos[(int)(numAproximadas * 0.99)];
+    free(tempos);
+
+    // Referência para a busca aproximada: distância de edição contra cada nome.
+    for (int c = 0; c < 5 && iguais; c++) {
+        semente = semente * 1664525u + 1013904223u;
+        strcpy(consulta, inventarioNome(&catalogo, (semente >> 8) % (uint32_t)catalogo.total));
+        errarDigitacao(consulta, &semente);
+        int n = inventarioBuscarAproximado(&catalogo, consulta, 2, resultado, TOPK_NOMES);
+        int esperados = 0;
+        for (int i = 0; i < catalogo.total; i++) {
+            int d = distanciaEdicao(inventarioNome(&catalogo, i), consulta);
+            if (d > 2) {
+                continue;
+            }
+            // Insere em ordem de distância e quantidade, mantendo os TOPK_NOMES primeiros.
+            int j = esperados < TOPK_NOMES ? esperados++ : TOPK_NOMES;
+            while (j > 0) {
+                int outro = conferencia[j - 1];
+                int dOutro = distanciaEdicao(inventarioNome(&catalogo, outro), consulta);
+                int qOutro = inventarioQuantidade(&catalogo, outro);
+                if (dOutro < d || (dOutro == d && qOutro >= inventarioQuantidade(&catalogo, i))) {
+                    break;
+                }
+                if (j < TOPK_NOMES) {
+                    conferencia[j] = conferencia[j - 1];
+                }
+                j--;
+            }
+            if (j < TOPK_NOMES) {
+                conferencia[j] = i;
+            }
+        }
+        iguais = n == esperados;
+        for (int i = 0; i < n && iguais; i++) {
+            int a = resultado[i], b = conferencia[i];
+            iguais = distanciaEdicao(inventarioNome(&catalogo, a), consulta) ==
+                         distanciaEdicao(inventarioNome(&catalogo, b), consulta) &&
+                     inventarioQuantidade(&catalogo, a) == inventarioQuantidade(&catalogo, b);
+        }
+    }
+
+    printf("--- BENCHMARK DA BUSCA POR NOMES ---\n");
+    printf("Itens: %d | Nos da trie: %d (%.1f MB)\n", catalogo.total, catalogo.nomes->numNos,
+           (double)catalogo.nomes->capacidadeNos * (sizeof(NoTrie) + TOPK_NOMES * sizeof(Sugestao)) /
+               (1024.0 * 1024.0));
+    printf("Carga: %.2f us/item | Alteracoes: %.2f us/operacao\n", tempoCarga / numItens * 1e6,
+           tempoAlteracoes / (numAlteracoes ? numAlteracoes : 1) * 1e6);
+    printf("Prefixo (top %d por quantidade): %.3f us/consulta, %.1f resultados em media\n", TOPK_NOMES,
+           tempoPrefixo * 1e6, (double)totalPrefixo / numConsultas);
+    printf("Varredura linear do mesmo prefixo: %.1f us/consulta\n", tempoVarredura * 1e6);
+    printf("Aproximada (ate 2 edicoes): %.1f us/consulta, p99 %.1f us, %.1f resultados em media\n",
+           tempoAproximado * 1e6, p99Aproximada * 1e6, (double)totalAproximado / numAproximadas);
+    printf("Resultados %s\n", iguais ? "conferem" : "DIVERGEM");
+
+    free(varredura);
+    inventarioLiberar(&catalogo);
+    return iguais ? 0 : 1;
+}
+
+// --- Benchmark da Representação Compacta ---
+
+/**
+ * @brief "./Freefire --bench-memoria [itens] [varreduras]": monta o mesmo
+ * catálogo no vetor de Item (o formato antigo, 56 bytes por item) e no
+ * inventário compacto, compara a memória ocupada pelos itens e mede varreduras
+ * completas: total de um tipo, itens acima de uma quantidade e nomes com um
+ * prefixo. Confere que os dois formatos dão as mesmas respostas.
+ */
+int executarBenchMemoria(int argc, char *argv[]) {
+    int numItens = argc > 2 ? atoi(argv[2]) : 1000000;
+    int numVarreduras = argc > 3 ? atoi(argv[3]) : 20;
+    if (numItens <= 0 || numVarreduras <= 0) {
+        printf("[ERRO] Uso: ./Freefire --bench-memoria [itens] [varreduras]\n");
+        return 1;
+    }
+    const char *tipos[] = {"Arma", "Municao", "Cura", "Ferramenta"};
+    Inventario catalogo;
+    if (inventarioIniciar(&catalogo, 0, 0) != 0) {
+        printf("[ERRO] Falha na alocacao de memoria para o catalogo.\n");
+        inventarioLiberar(&catalogo);
+        return 1;
+    }
+    uint32_t semente = 2024;
+    for (int i = 0; i < numItens; i++) {
+        Item item;
+        semente = semente * 1664525u + 1013904223u;
+        gerarNomeCatalogo(item.nome, sizeof(item.nome), semente >> 8, i);
+        strcpy(item.tipo, tipos[(semente >> 4) % 4]);
+        item.quantidade = (int)((semente >> 12) % 1000);
+        if (inventarioAdicionar(&catalogo, &item) < 0) {
+            printf("[ERRO] Falha na alocacao de memoria para o catalogo.\n");
+            inventarioLiberar(&catalogo);
+            return 1;
+        }
+    }
+    int total = catalogo.total;
+    Item *vetor = malloc((size_t)total * sizeof(Item));
+    if (vetor == NULL) {
+        printf("[ERRO] Falha na alocacao de memoria para o vetor de referencia.\n");
+        inventarioLiberar(&catalogo);
+        return 1;
+    }
+    for (int i = 0; i < total; i++) {
+        inventarioItem(&catalogo, i, &vetor[i]);
+    }
+    size_t bytesVetor = (size_t)total * sizeof(Item);
+    size_t bytesCompacto = (size_t)total * sizeof(ItemCompacto) + catalogo.textos.usado +
+                           (size_t)catalogo.tipos.total * sizeof(catalogo.tipos.nomes[0]);
+
+    // Cada varredura é feita 'numVarreduras' vezes em cada formato; 'volatile'
+    // impede que o compilador descarte os laços.
+    volatile long long resultadoVetor[3] = {0, 0, 0}, resultadoCompacto[3] = {0, 0, 0};
+    double tempoVetor[3], tempoCompacto[3];
+    const char *prefixo = "Pistola";
+    size_t tamanhoPrefixo = strlen(prefixo);
+
+    double inicio = segundosAgora();
+    for (int r = 0; r < numVarreduras; r++) {
+        long long soma = 0;
+        for (int i = 0; i < total; i++) {
+            if (strcmp(vetor[i].tipo, "Municao") == 0) {
+                soma += vetor[i].quantidade;
+            }
+        }
+        resultadoVetor[0] = soma;
+    }
+    tempoVetor[0] = (segundosAgora() - inicio) / numVarreduras;
+    inicio = segundosAgora();
+    for (int r = 0; r < numVarreduras; r++) {
+        // O tipo é internado: basta comparar o índice, sem strcmp por item.
+        int tipo = tipoProcurar(&catalogo.tipos, "Municao");
+        long long soma = 0;
+        for (int i = 0; i < total; i++) {
+            if (catalogo.itens[i].tipo == tipo) {
+                soma += catalogo.itens[i].quantidade;
+            }
+        }
+        resultadoCompacto[0] = soma;
+    }
+    tempoCompacto[0] = (segundosAgora() - inicio) / numVarreduras;
+
+    inicio = segundosAgora();
+    for (int r = 0; r < numVarreduras; r++) {
+        long long contagem = 0;
+        for (int i = 0; i < total; i++) {
+            contagem += vetor[i].quantidade >= 500;
+        }
+        resultadoVetor[1] = contagem;
+    }
+    tempoVetor[1] = (segundosAgora() - inicio) / numVarreduras;
+    inicio = segundosAgora();
+    for (int r = 0; r < numVarreduras; r++) {
+        long long contagem = 0;
+        for (int i = 0; i < total; i++) {
+            contagem += catalogo.itens[i].quantidade >= 500;
+        }
+        resultadoCompacto[1] = contagem;
+    }
+    tempoCompacto[1] = (segundosAgora() - inicio) / numVarreduras;
+
+    inicio = segundosAgora();
+    for (int r = 0; r < numVarreduras; r++) {
+        long long contagem = 0;
+        for (int i = 0; i < total; i++) {
+            contagem += strncmp(vetor[i].nome, prefixo, tamanhoPrefixo) == 0;
+        }
+        resultadoVetor[2] = contagem;
+    }
+    tempoVetor[2] = (segundosAgora() - inicio) / numVarreduras;
+    inicio = segundosAgora();
+    for (int r = 0; r < numVarreduras; r++) {
+        long long contagem = 0;
+        for (int i = 0; i < total; i++) {
+            contagem += strncmp(catalogo.textos.texto + catalogo.itens[i].nome, prefixo, tamanhoPrefixo) == 0;
+        }
+        resultadoCompacto[2] = contagem;
+    }
+    tempoCompacto[2] = (segundosAgora() - inicio) / numVarreduras;
+
+    int iguais = 1;
+    for (int v = 0; v < 3; v++) {
+        iguais = iguais && resultadoVetor[v] == resultadoCompacto[v];
+    }
+    for (int i = 0; i < total && iguais; i++) {
+        Item item;
+        inventarioItem(&catalogo, i, &item);
+        iguais = memcmp(&item, &vetor[i], sizeof(Item)) == 0;
+    }
+
+    const char *varreduras[] = {"Total do tipo Municao", "Quantidade >= 500", "Nomes com prefixo"};
+    printf("--- BENCHMARK DA REPRESENTACAO COMPACTA ---\n");
+    printf("Itens: %d | Tipos distintos: %d\n", total, catalogo.tipos.total);
+    printf("Vetor de Item: %.1f MB (%zu bytes/item)\n", bytesVetor / (1024.0 * 1024.0), sizeof(Item));
+    printf("Compacto: %.1f MB (%zu bytes/item + %.1f bytes/item de nomes) | %.1fx menor\n",
+           bytesCompacto / (1024.0 * 1024.0), sizeof(ItemCompacto), (double)catalogo.textos.usado / total,
+           (double)bytesVetor / bytesCompacto);
+    for (int v = 0; v < 3; v++) {
+        printf("%-22s: vetor %.2f ms | compacto %.2f ms | %.1fx\n", varreduras[v], tempoVetor[v] * 1e3,
+               tempoCompacto[v] * 1e3, tempoVetor[v] / tempoCompacto[v]);
+    }
+    printf("Resultados %s\n", iguais ? "conferem" : "DIVERGEM");
+
+    free(vetor);
+    inventarioLiberar(&catalogo);
+    return iguais ? 0 : 1;
+}
@@ -1,10 +1,28 @@
+// Compilação: gcc -O2 -pthread TetrisStack.c -o TetrisStack
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
 #include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include "entrada.h"
+#include "log.h"
 
 // --- Definições de Constantes ---
 #define CAPACIDADE_MAXIMA 5 // Tamanho fixo da fila de peças futuras
-#define TIPOS_PECAS 4       // Número de tipos de peças ('I', 'O', 'T', 'L')
+#define RESERVA_PECAS 64    // Peças que a thread geradora deixa prontas para o jogo
+#define TIPOS_PECAS 7       // Número de tipos de peças ('I', 'O', 'T', 'S', 'Z', 'J', 'L')
+#define LINHA_CACHE 64      // Tamanho de uma linha de cache, em bytes
+#define LARGURA_TABULEIRO 10
+#define ALTURA_TABULEIRO 20
+#define LINHA_CHEIA ((uint16_t)((1u << LARGURA_TABULEIRO) - 1))
+#define MAX_CANDIDATAS (4 * LARGURA_TABULEIRO) // Rotações x colunas de uma peça
+#define VERSAO_REPLAY 1
+#define PALAVRAS_BUFFER_REPLAY 8192            // 64 KiB de bits gravados por escrita no arquivo
 
 // --- Estrutura da Peça (Struct) ---
 typedef struct {
@@ -12,12 +30,170 @@ typedef struct {
     int id;    // Identificador único da peça
 } Peca;
 
+// --- Gerador de Peças (PCG32 + saco de 7) ---
+/**
+ * @brief Gerador PCG32: 64 bits de estado e saída de 32 bits, bem mais rápido
+ * e de melhor qualidade que rand(), e reproduzível a partir da semente.
+ */
+typedef struct {
+    uint64_t estado;
+    uint64_t incremento;    // Sempre ímpar: escolhe uma das sequências do gerador
+} GeradorPCG;
+
+/**
+ * @brief Randomizador "7-bag": as 7 peças são embaralhadas num saco e saem em
+ * ordem; só então um novo saco é sorteado. Cada grupo de 7 peças tem uma de
+ * cada tipo, o que evita longas sequências sem uma peça. A mesma semente
+ * sempre dá a mesma sequência de peças (benchmarks e replays).
+ */
+typedef struct {
+    GeradorPCG aleatorio;
+    char saco[TIPOS_PECAS];
+    int restantes;          // Peças do saco atual ainda não entregues
+    int proximoId;          // ID único sequencial para novas peças
+    uint64_t semente;
+} GeradorPecas;
+
+// --- Anel SPSC (um produtor, um consumidor) ---
+/**
+ * @brief Fila circular sem travas para exatamente uma thread produtora e uma
+ * consumidora. A capacidade do vetor é potência de 2, então a posição de um
+ * índice é só 'indice & mascara'. 'cabeca' e 'cauda' crescem sem voltar a zero
+ * (o tamanho é sempre cauda - cabeca) e cada uma é escrita por um único lado.
+ *
+ * Cada lado fica numa linha de cache própria, junto com a última posição que
+ * ele viu do outro lado: o produtor só relê 'cabeca' quando a fila parece cheia
+ * e o consumidor só relê 'cauda' quando ela parece vazia, o que evita que a
+ * linha do outro lado fique indo e voltando entre os núcleos a cada peça.
+ */
+typedef struct {
+    // Lado do consumidor
+    _Alignas(LINHA_CACHE) _Atomic size_t cabeca; // Próximo índice a ler
+    size_t caudaVista;                           // Última 'cauda' lida pelo consumidor
+    // Lado do produtor
+    _Alignas(LINHA_CACHE) _Atomic size_t cauda;  // Próximo índice a escrever
+    size_t cabecaVista;                          // Última 'cabeca' lida pelo produtor
+    // Só leitura depois de anelIniciar()
+    _Alignas(LINHA_CACHE) Peca *pecas;
+    size_t mascara;                              // Capacidade do vetor - 1
+    size_t limite;                               // Máximo de peças na fila (<= mascara + 1)
+} AnelSPSC;
+
+// --- Tabuleiro em bits ---
+/**
+ * @brief Cada linha do tabuleiro é uma máscara de 10 bits (bit x = coluna x),
+ * então colisão, linha completa e buracos saem de poucas operações com bits em
+ * vez de percorrer células. A linha 0 é o fundo.
+ */
+typedef struct {
+    uint16_t linhas[ALTURA_TABULEIRO];
+    int topo;               // Da linha 'topo' para cima está tudo vazio
+} Tabuleiro;
+
+/**
+ * @brief Uma rotação de uma peça, como máscaras por linha (de baixo para cima)
+ * encostadas na coluna 0. Na coluna x, a linha k ocupa 'linhas[k] << x'.
+ */
+typedef struct {
+    uint16_t linhas[4];
+    int largura;
+    int altura;
+} FormaPeca;
+
+typedef struct {
+    int rotacao;
+    int coluna;
+} Jogada;
+
+/**
+ * @brief Busca de jogadas em paralelo. Cada candidata da peça da frente (uma
+ * rotação numa coluna) é avaliada inteira por uma thread, olhando as peças
+ * seguintes da fila; as threads pegam a próxima candidata por um contador
+ * atômico. As threads auxiliares ficam paradas em 'inicio' entre as jogadas.
+ */
+typedef struct {
+    // Jogada atual: escrita pela thread principal antes de liberar as auxiliares
+    Tabuleiro tabuleiro;
+    int tipos[CAPACIDADE_MAXIMA];       // Peça da frente e as seguintes, como índices
+    int profundidade;                   // Quantas peças de 'tipos' são consideradas
+    Jogada candidatas[MAX_CANDIDATAS];
+    double notas[MAX_CANDIDATAS];       // Cada posição é escrita por uma única thread
+    int numCandidatas;
+    atomic_int proximaCandidata;
+    atomic_llong avaliadas;             // Posicionamentos testados desde o início
+    // Threads auxiliares (a principal também trabalha)
+    pthread_t *threads;
+    int numThreads;
+    sem_t inicio;
+    sem_t fim;
+    atomic_int encerrar;
+} BuscaParalela;
+
+// --- Replay binário da fila ---
+/**
+ * @brief Cabeçalho do arquivo de replay, seguido dos eventos como um fluxo de
+ * bits (palavras de 64 bits, do bit menos significativo para o mais).
+ *
+ * Cada evento começa com 1 bit: 0 = enfileirar, 1 = desenfileirar.
+ * - Enfileirar: 3 bits com o tipo da peça (índice em 'tiposPecas') e o ID.
+ * - Desenfileirar: 1 bit que vale 1 se a fila estava vazia; senão, o ID removido.
+ * Os IDs são gravados como diferença para o esperado (último ID do mesmo tipo
+ * de evento + 1) em código de Elias-gamma; no caso comum a diferença é 0 e
+ * custa 1 bit, então uma inserção ocupa 5 bits e uma remoção 3.
+ */
+typedef struct {
+    char magica[4];         // "TSRP"
+    uint32_t versao;
+    uint64_t semente;       // Semente do gerador na sessão gravada
+    uint32_t capacidade;    // Limite da fila na sessão gravada
+    uint32_t reservado;
+    uint64_t eventos;
+    uint64_t bits;          // Bits de eventos depois do cabeçalho
+} CabecalhoReplay;
+
+typedef struct {
+    FILE *arquivo;
+    uint64_t *palavras;     // Palavras completas ainda não escritas no arquivo
+    size_t numPalavras;
+    uint64_t acumulador;    // Bits da palavra em formação
+    int bitsPendentes;
+    int erro;
+    int ultimoInserido;     // Último ID enfileirado
+    int ultimoRemovido;     // Último ID desenfileirado com sucesso
+    CabecalhoReplay cabecalho;
+} GravadorReplay;
+
+typedef struct {
+    uint64_t *palavras;     // Arquivo inteiro na memória, com uma palavra extra zerada
+    uint64_t posicao;       // Próximo bit a ler
+    int ultimoInserido;
+    int ultimoRemovido;
+    CabecalhoReplay cabecalho;
+} LeitorReplay;
+
+enum { EVENTO_ENFILEIRAR = 0, EVENTO_DESENFILEIRAR = 1 };
+
 // --- Variáveis Globais de Controle da Fila ---
-Peca filaPecas[CAPACIDADE_MAXIMA]; // Array que armazena as peças
-int frente = 0;                    // Índice do primeiro elemento (dequeue)
-int fim = 0;                       // Índice da próxima posição livre (enqueue)
-int contadorPecas = 0;             // Contador para rastrear o número de elementos na fila
-int proximoId = 0;                 // ID único sequencial para novas peças
+AnelSPSC filaPecas;     // Fila de peças futuras, usada só pela thread do jogo
+AnelSPSC reservaPecas;  // Peças já geradas: a thread geradora produz, o jogo consome
+GeradorPecas geradorPecas; // Só a thread geradora usa depois de iniciada
+
+// Comunicação entre o jogo e a thread geradora de peças
+sem_t pedidosGeracao;   // Acorda a thread geradora para completar a reserva
+atomic_int reabastecimentoPedido = 0; // 1 enquanto um pedido ainda não foi atendido
+atomic_int encerrarGeracao = 0;
+
+// Tipos de peça na ordem dos índices usados pelo tabuleiro e pelo gerador
+const char tiposPecas[TIPOS_PECAS + 1] = "IOTSZJL";
+FormaPeca formas[TIPOS_PECAS][4]; // Preenchida por prepararFormas()
+int numRotacoes[TIPOS_PECAS];     // Rotações distintas de cada tipo (O: 1, I/S/Z: 2, demais: 4)
+
+// Gravação da sessão ("--gravar"). Enfileirar e desenfileirar rodam na thread
+// do jogo; a thread geradora só mexe na reserva.
+GravadorReplay gravadorSessao;
+int gravandoSessao = 0;
+
+Entrada entradaPadrao; // Comandos do jogador (teclado ou sessão redirecionada)
 
 // --- Protótipos das Funções ---
 Peca gerarPeca();
@@ -28,43 +204,889 @@ void enfileirar(Peca novaPeca);
 Peca desenfileirar();
 void exibirFila();
 void exibirMenu();
+void exibirTabuleiro(const Tabuleiro *t);
+void *threadGeradora(void *arg);
+void solicitarPecas(int quantidade);
+
+int anelIniciar(AnelSPSC *anel, size_t limite);
+void anelLiberar(AnelSPSC *anel);
+int anelEnfileirar(AnelSPSC *anel, Peca peca);
+int anelDesenfileirar(AnelSPSC *anel, Peca *peca);
+size_t anelEnfileirarLote(AnelSPSC *anel, const Peca *pecas, size_t quantidade);
+size_t anelDesenfileirarLote(AnelSPSC *anel, Peca *saida, size_t maximo);
+size_t anelTamanho(AnelSPSC *anel);
+int anelEspiar(AnelSPSC *anel, size_t posicao, Peca *peca);
+void geradorIniciar(GeradorPecas *g, uint64_t semente);
+Peca geradorProxima(GeradorPecas *g);
+void geradorPreencher(GeradorPecas *g, Peca *saida, size_t quantidade);
+size_t geradorEncherFila(GeradorPecas *g, AnelSPSC *anel);
+int executarBenchFila(int argc, char *argv[]);
+int executarBenchGerador(int argc, char *argv[]);
+
+void prepararFormas();
+int indiceTipo(char nome);
+int tabuleiroSoltar(const Tabuleiro *t, const FormaPeca *forma, int coluna);
+int tabuleiroFixar(Tabuleiro *t, const FormaPeca *forma, int coluna, int y);
+double tabuleiroAvaliar(const Tabuleiro *t);
+int buscaIniciar(BuscaParalela *b, int numThreads);
+void buscaEncerrar(BuscaParalela *b);
+int buscaEscolher(BuscaParalela *b, const Tabuleiro *t, const int *tipos, int profundidade, Jogada *escolhida);
+int executarSimulacao(int argc, char *argv[]);
+
+int replayAbrir(GravadorReplay *g, const char *caminho, uint64_t semente, uint32_t capacidade);
+void replayGravarInsercao(GravadorReplay *g, Peca peca);
+void replayGravarRemocao(GravadorReplay *g, int id);
+int replayFechar(GravadorReplay *g);
+int replayCarregar(LeitorReplay *l, const char *caminho);
+void replayLiberar(LeitorReplay *l);
+int executarGerarReplay(int argc, char *argv[]);
+int executarReplay(int argc, char *argv[]);
+
+// -------------------------------------------------------------------
+// ----------------------- FUNÇÕES DO ANEL SPSC ----------------------
+// -------------------------------------------------------------------
+
+/**
+ * @brief Prepara um anel vazio para até 'limite' peças. O vetor é alocado com
+ * a menor potência de 2 que comporta o limite.
+ * @return int: 0 em sucesso ou -1 se faltar memória.
+ */
+int anelIniciar(AnelSPSC *anel, size_t limite) {
+    size_t capacidade = 1;
+    while (capacidade < limite) {
+        capacidade <<= 1;
+    }
+    anel->pecas = malloc(capacidade * sizeof(Peca));
+    if (anel->pecas == NULL) {
+        return -1;
+    }
+    anel->mascara = capacidade - 1;
+    anel->limite = limite;
+    anel->caudaVista = 0;
+    anel->cabecaVista = 0;
+    atomic_init(&anel->cabeca, 0);
+    atomic_init(&anel->cauda, 0);
+    return 0;
+}
+
+void anelLiberar(AnelSPSC *anel) {
+    free(anel->pecas);
+    anel->pecas = NULL;
+}
+
+/**
+ * @brief Espaço livre visto pelo produtor; só relê 'cabeca' se o valor guardado
+ * não bastar para 'desejado' peças.
+ */
+static size_t anelLivres(AnelSPSC *anel, size_t cauda, size_t desejado) {
+    size_t livres = anel->limite - (cauda - anel->cabecaVista);
+    if (livres < desejado) {
+        anel->cabecaVista = atomic_load_explicit(&anel->cabeca, memory_order_acquire);
+        livres = anel->limite - (cauda - anel->cabecaVista);
+    }
+    return livres;
+}
+
+/**
+ * @brief Peças disponíveis vistas pelo consumidor; só relê 'cauda' se o valor
+ * guardado não bastar para 'desejado' peças.
+ */
+static size_t anelDisponiveis(AnelSPSC *anel, size_t cabeca, size_t desejado) {
+    size_t disponiveis = anel->caudaVista - cabeca;
+    if (disponiveis < desejado) {
+        anel->caudaVista = atomic_load_explicit(&anel->cauda, memory_order_acquire);
+        disponiveis = anel->caudaVista - cabeca;
+    }
+    return disponiveis;
+}
+
+/**
+ * @brief Só para a thread produtora: coloca uma peça no fim do anel.
+ * @return int: 1 se a peça entrou ou 0 se o anel está cheio.
+ */
+int anelEnfileirar(AnelSPSC *anel, Peca peca) {
+    size_t cauda = atomic_load_explicit(&anel->cauda, memory_order_relaxed);
+    if (anelLivres(anel, cauda, 1) == 0) {
+        return 0;
+    }
+    anel->pecas[cauda & anel->mascara] = peca;
+    // 'release' publica a peça antes do novo fim.
+    atomic_store_explicit(&anel->cauda, cauda + 1, memory_order_release);
+    return 1;
+}
+
+/**
+ * @brief Só para a thread consumidora: tira a peça da frente do anel.
+ * @return int: 1 se havia peça ou 0 se o anel está vazio.
+ */
+int anelDesenfileirar(AnelSPSC *anel, Peca *peca) {
+    size_t cabeca = atomic_load_explicit(&anel->cabeca, memory_order_relaxed);
+    if (anelDisponiveis(anel, cabeca, 1) == 0) {
+        return 0;
+    }
+    *peca = anel->pecas[cabeca & anel->mascara];
+    // 'release' garante que a posição já foi lida antes de o produtor reusá-la.
+    atomic_store_explicit(&anel->cabeca, cabeca + 1, memory_order_release);
+    return 1;
+}
+
+/**
+ * @brief Enfileira até 'quantidade' peças com uma única publicação do fim; as
+ * cópias são no máximo dois memcpy (antes e depois da volta do vetor).
+ * @return size_t: Quantas peças couberam.
+ */
+size_t anelEnfileirarLote(AnelSPSC *anel, const Peca *pecas, size_t quantidade) {
+    size_t cauda = atomic_load_explicit(&anel->cauda, memory_order_relaxed);
+    size_t livres = anelLivres(anel, cauda, quantidade);
+    size_t n = quantidade < livres ? quantidade : livres;
+    size_t inicio = cauda & anel->mascara;
+    size_t ateOFim = anel->mascara + 1 - inicio;
+    size_t primeiro = n < ateOFim ? n : ateOFim;
+    memcpy(&anel->pecas[inicio], pecas, primeiro * sizeof(Peca));
+    memcpy(anel->pecas, pecas + primeiro, (n - primeiro) * sizeof(Peca));
+    atomic_store_explicit(&anel->cauda, cauda + n, memory_order_release);
+    return n;
+}
+
+/**
+ * @brief Desenfileira até 'maximo' peças com uma única publicação da frente.
+ * @return size_t: Quantas peças foram copiadas para 'saida'.
+ */
+size_t anelDesenfileirarLote(AnelSPSC *anel, Peca *saida, size_t maximo) {
+    size_t cabeca = atomic_load_explicit(&anel->cabeca, memory_order_relaxed);
+    size_t disponiveis = anelDisponiveis(anel, cabeca, maximo);
+    size_t n = maximo < disponiveis ? maximo : disponiveis;
+    size_t inicio = cabeca & anel->mascara;
+    size_t ateOFim = anel->mascara + 1 - inicio;
+    size_t primeiro = n < ateOFim ? n : ateOFim;
+    memcpy(saida, &anel->pecas[inicio], primeiro * sizeof(Peca));
+    memcpy(saida + primeiro, anel->pecas, (n - primeiro) * sizeof(Peca));
+    atomic_store_explicit(&anel->cabeca, cabeca + n, memory_order_release);
+    return n;
+}
+
+/**
+ * @brief Número de peças no anel. Com as duas threads ativas é só uma
+ * fotografia: o valor pode mudar logo depois da leitura.
+ */
+size_t anelTamanho(AnelSPSC *anel) {
+    size_t cabeca = atomic_load_explicit(&anel->cabeca, memory_order_acquire);
+    return atomic_load_explicit(&anel->cauda, memory_order_acquire) - cabeca;
+}
+
+/**
+ * @brief Só para a thread consumidora: copia a peça 'posicao' (0 = frente) sem
+ * tirá-la do anel.
+ * @return int: 1 se a posição existe ou 0 caso contrário.
+ */
+int anelEspiar(AnelSPSC *anel, size_t posicao, Peca *peca) {
+    size_t cabeca = atomic_load_explicit(&anel->cabeca, memory_order_relaxed);
+    if (anelDisponiveis(anel, cabeca, posicao + 1) <= posicao) {
+        return 0;
+    }
+    *peca = anel->pecas[(cabeca + posicao) & anel->mascara];
+    return 1;
+}
+
+// -------------------------------------------------------------------
+// ---------------------- FUNÇÕES DO GERADOR -------------------------
+// -------------------------------------------------------------------
+
+static uint32_t pcgProximo(GeradorPCG *g) {
+    uint64_t anterior = g->estado;
+    g->estado = anterior * 6364136223846793005ULL + g->incremento;
+    uint32_t misturado = (uint32_t)(((anterior >> 18u) ^ anterior) >> 27u);
+    uint32_t rotacao = (uint32_t)(anterior >> 59u);
+    return (misturado >> rotacao) | (misturado << ((-rotacao) & 31u));
+}
+
+static void pcgIniciar(GeradorPCG *g, uint64_t semente, uint64_t sequencia) {
+    g->estado = 0;
+    g->incremento = (sequencia << 1u) | 1u;
+    pcgProximo(g);
+    g->estado += semente;
+    pcgProximo(g);
+}
+
+/**
+ * @brief Número em [0, limite) por multiplicação em vez de '%': sem divisão, e
+ * o viés para limites pequenos como 7 é da ordem de 1 em 10^9.
+ */
+static uint32_t pcgAbaixoDe(GeradorPCG *g, uint32_t limite) {
+    return (uint32_t)(((uint64_t)pcgProximo(g) * limite) >> 32);
+}
+
+/**
+ * @brief Sorteia um saco novo: as 7 peças embaralhadas por Fisher-Yates.
+ */
+static void sortearSaco(GeradorPecas *g) {
+    memcpy(g->saco, tiposPecas, TIPOS_PECAS);
+    for (int i = TIPOS_PECAS - 1; i > 0; i--) {
+        int j = (int)pcgAbaixoDe(&g->aleatorio, (uint32_t)i + 1);
+        char troca = g->saco[i];
+        g->saco[i] = g->saco[j];
+        g->saco[j] = troca;
+    }
+    g->restantes = TIPOS_PECAS;
+}
+
+/**
+ * @brief Prepara o gerador; a mesma semente reproduz a mesma sequência de peças.
+ */
+void geradorIniciar(GeradorPecas *g, uint64_t semente) {
+    pcgIniciar(&g->aleatorio, semente, 0x7E7215u);
+    g->restantes = 0;
+    g->proximoId = 0;
+    g->semente = semente;
+}
+
+/**
+ * @brief Próxima peça da sequência, sem nenhuma saída no console.
+ * @return Peca: A nova peça, com o próximo ID.
+ */
+Peca geradorProxima(GeradorPecas *g) {
+    if (g->restantes == 0) {
+        sortearSaco(g);
+    }
+    Peca nova;
+    nova.nome = g->saco[TIPOS_PECAS - g->restantes--];
+    nova.id = g->proximoId++;
+    return nova;
+}
+
+/**
+ * @brief Gera 'quantidade' peças de uma vez em 'saida'. A sequência é a mesma
+ * de chamar geradorProxima() o mesmo número de vezes.
+ */
+void geradorPreencher(GeradorPecas *g, Peca *saida, size_t quantidade) {
+    size_t i = 0;
+    while (i < quantidade) {
+        if (g->restantes == 0) {
+            sortearSaco(g);
+        }
+        size_t n = (size_t)g->restantes < quantidade - i ? (size_t)g->restantes : quantidade - i;
+        const char *tipos = &g->saco[TIPOS_PECAS - g->restantes];
+        for (size_t k = 0; k < n; k++) {
+            saida[i + k].nome = tipos[k];
+            saida[i + k].id = g->proximoId++;
+        }
+        g->restantes -= (int)n;
+        i += n;
+    }
+}
+
+/**
+ * @brief Só para a thread produtora do anel: completa a fila com peças novas,
+ * em lotes. Como só o produtor acrescenta peças, todo o espaço livre visto aqui
+ * continua livre até o enfileiramento (o consumidor só libera mais).
+ * @return size_t: Quantas peças foram enfileiradas.
+ */
+size_t geradorEncherFila(GeradorPecas *g, AnelSPSC *anel) {
+    Peca lote[64];
+    size_t total = 0;
+    size_t livres = anel->limite - anelTamanho(anel);
+    while (livres > 0) {
+        size_t n = livres < 64 ? livres : 64;
+        geradorPreencher(g, lote, n);
+        anelEnfileirarLote(anel, lote, n);
+        livres -= n;
+        total += n;
+    }
+    return total;
+}
+
+// -------------------------------------------------------------------
+// ---------------------- FUNÇÕES DO TABULEIRO -----------------------
+// -------------------------------------------------------------------
+
+/**
+ * @brief Monta a tabela de formas: cada tipo é descrito por suas 4 células na
+ * rotação inicial (x, y com y para cima) e as demais rotações saem girando 90
+ * graus. Rotações que repetem uma forma já vista (O, I, S, Z) são descartadas.
+ */
+void prepararFormas() {
+    static const int celulas[TIPOS_PECAS][4][2] = {
+        {{0, 0}, {1, 0}, {2, 0}, {3, 0}}, // I
+        {{0, 0}, {1, 0}, {0, 1}, {1, 1}}, // O
+        {{0, 0}, {1, 0}, {2, 0}, {1, 1}}, // T
+        {{0, 0}, {1, 0}, {1, 1}, {2, 1}}, // S
+        {{1, 0}, {2, 0}, {0, 1}, {1, 1}}, // Z
+        {{0, 0}, {1, 0}, {2, 0}, {0, 1}}, // J
+        {{0, 0}, {1, 0}, {2, 0}, {2, 1}}, // L
+    };
+    for (int tipo = 0; tipo < TIPOS_PECAS; tipo++) {
+        int x[4], y[4];
+        for (int k = 0; k < 4; k++) {
+            x[k] = celulas[tipo][k][0];
+            y[k] = celulas[tipo][k][1];
+        }
+        numRotacoes[tipo] = 0;
+        for (int rotacao = 0; rotacao < 4; rotacao++) {
+            // Encosta a forma na coluna 0 e na linha 0
+            int minX = 4, minY = 4;
+            for (int k = 0; k < 4; k++) {
+                minX = x[k] < minX ? x[k] : minX;
+                minY = y[k] < minY ? y[k] : minY;
+            }
+            FormaPeca forma = {{0, 0, 0, 0}, 0, 0};
+            for (int k = 0; k < 4; k++) {
+                int cx = x[k] - minX, cy = y[k] - minY;
+                forma.linhas[cy] |= (uint16_t)(1u << cx);
+                forma.largura = cx + 1 > forma.largura ? cx + 1 : forma.largura;
+                forma.altura = cy + 1 > forma.altura ? cy + 1 : forma.altura;
+            }
+            int repetida = 0;
+            for (int r = 0; r < numRotacoes[tipo]; r++) {
+                repetida |= memcmp(formas[tipo][r].linhas, forma.linhas, sizeof(forma.linhas)) == 0;
+            }
+            if (!repetida) {
+                formas[tipo][numRotacoes[tipo]++] = forma;
+            }
+            // Gira 90 graus no sentido horário: (x, y) -> (y, -x)
+            for (int k = 0; k < 4; k++) {
+                int antigoX = x[k];
+                x[k] = y[k];
+                y[k] = -antigoX;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Índice do tipo na tabela de formas ('I' = 0 ... 'L' = 6).
+ * @return int: O índice, ou -1 para um nome desconhecido.
+ */
+int indiceTipo(char nome) {
+    // Índice + 1, para que as posições não listadas valham 0 (tipo desconhecido)
+    static const signed char indices[128] = {['I'] = 1, ['O'] = 2, ['T'] = 3, ['S'] = 4,
+                                             ['Z'] = 5, ['J'] = 6, ['L'] = 7};
+    return (unsigned char)nome < 128 ? indices[(unsigned char)nome] - 1 : -1;
+}
+
+static int tabuleiroColide(const Tabuleiro *t, const FormaPeca *forma, int coluna, int y) {
+    for (int k = 0; k < forma->altura; k++) {
+        if (t->linhas[y + k] & (uint16_t)(forma->linhas[k] << coluna)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Queda direta da peça na coluna dada. Acima de 'topo' não há nada, então
+ * a queda começa ali e desce linha a linha enquanto não houver colisão. Com a
+ * pilha alta, a peça entra já na linha mais alta em que ainda cabe inteira no
+ * tabuleiro; se ali ela colide, não há onde colocá-la.
+ * @return int: Linha em que a base da peça para, ou -1 se ela não cabe no tabuleiro.
+ */
+int tabuleiroSoltar(const Tabuleiro *t, const FormaPeca *forma, int coluna) {
+    int y = t->topo < ALTURA_TABULEIRO - forma->altura ? t->topo : ALTURA_TABULEIRO - forma->altura;
+    if (tabuleiroColide(t, forma, coluna, y)) {
+        return -1;
+    }
+    while (y > 0 && !tabuleiroColide(t, forma, coluna, y - 1)) {
+        y--;
+    }
+    return y;
+}
+
+/**
+ * @brief Fixa a peça e remove as linhas completas. Só as linhas tocadas pela
+ * peça podem ter ficado completas; as de cima descem no lugar das removidas.
+ * @return int: Quantas linhas foram removidas.
+ */
+int tabuleiroFixar(Tabuleiro *t, const FormaPeca *forma, int coluna, int y) {
+    int completas = 0;
+    for (int k = 0; k < forma->altura; k++) {
+        t->linhas[y + k] |= (uint16_t)(forma->linhas[k] << coluna);
+        completas += t->linhas[y + k] == LINHA_CHEIA;
+    }
+    if (y + forma->altura > t->topo) {
+        t->topo = y + forma->altura;
+    }
+    if (completas == 0) {
+        return 0;
+    }
+    int destino = y;
+    for (int r = y; r < t->topo; r++) {
+        if (t->linhas[r] != LINHA_CHEIA) {
+            t->linhas[destino++] = t->linhas[r];
+        }
+    }
+    for (int r = destino; r < t->topo; r++) {
+        t->linhas[r] = 0;
+    }
+    t->topo = destino;
+    return completas;
+}
+
+/**
+ * @brief Nota do tabuleiro (maior é melhor): penaliza altura somada das colunas,
+ * buracos e irregularidade entre colunas vizinhas. Varre as linhas de cima para
+ * baixo acumulando em 'coberto' as colunas que já têm bloco acima: buraco é
+ * célula vazia coberta, e a primeira linha onde uma coluna aparece dá sua altura.
+ */
+double tabuleiroAvaliar(const Tabuleiro *t) {
+    int alturas[LARGURA_TABULEIRO] = {0};
+    int buracos = 0;
+    uint16_t coberto = 0;
+    for (int r = t->topo - 1; r >= 0; r--) {
+        uint16_t linha = t->linhas[r];
+        buracos += __builtin_popcount(coberto & (uint16_t)~linha);
+        uint16_t novas = linha & (uint16_t)~coberto;
+        while (novas != 0) {
+            alturas[__builtin_ctz(novas)] = r + 1;
+            novas &= (uint16_t)(novas - 1);
+        }
+        coberto |= linha;
+    }
+    int somaAlturas = alturas[0], irregularidade = 0;
+    for (int c = 1; c < LARGURA_TABULEIRO; c++) {
+        somaAlturas += alturas[c];
+        irregularidade += abs(alturas[c] - alturas[c - 1]);
+    }
+    return -0.510066 * somaAlturas - 0.35663 * buracos - 0.184483 * irregularidade;
+}
+
+// -------------------------------------------------------------------
+// ------------------------ BUSCA DE JOGADAS -------------------------
+// -------------------------------------------------------------------
+
+#define PESO_LINHAS 0.760666
+#define NOTA_PERDIDA (-1e18) // Nenhuma posição cabe: fim de jogo nesse ramo
+
+/**
+ * @brief Melhor nota alcançável colocando as 'restantes' peças de 'tipos' em
+ * sequência, testando toda rotação e coluna de cada uma (sem deslizes nem giros
+ * depois da queda). Cada posicionamento testado soma 1 em 'avaliadas'.
+ */
+static double buscarMelhor(const Tabuleiro *t, const int *tipos, int restantes, long long *avaliadas) {
+    if (restantes == 0) {
+        return tabuleiroAvaliar(t);
+    }
+    double melhor = NOTA_PERDIDA;
+    int tipo = tipos[0];
+    for (int rotacao = 0; rotacao < numRotacoes[tipo]; rotacao++) {
+        const FormaPeca *forma = &formas[tipo][rotacao];
+        for (int coluna = 0; coluna + forma->largura <= LARGURA_TABULEIRO; coluna++) {
+            int y = tabuleiroSoltar(t, forma, coluna);
+            if (y < 0) {
+                continue;
+            }
+            Tabuleiro copia = *t;
+            int linhas = tabuleiroFixar(&copia, forma, coluna, y);
+            (*avaliadas)++;
+            double nota = PESO_LINHAS * linhas + buscarMelhor(&copia, tipos + 1, restantes - 1, avaliadas);
+            if (nota > melhor) {
+                melhor = nota;
+            }
+        }
+    }
+    return melhor;
+}
+
+/**
+ * @brief Avalia candidatas da jogada atual até acabarem. Roda na thread
+ * principal e em cada auxiliar ao mesmo tempo.
+ */
+static void trabalharBusca(BuscaParalela *b) {
+    long long avaliadas = 0;
+    int i;
+    while ((i = atomic_fetch_add(&b->proximaCandidata, 1)) < b->numCandidatas) {
+        const FormaPeca *forma = &formas[b->tipos[0]][b->candidatas[i].rotacao];
+        int coluna = b->candidatas[i].coluna;
+        Tabuleiro copia = b->tabuleiro;
+        int linhas = tabuleiroFixar(&copia, forma, coluna, tabuleiroSoltar(&copia, forma, coluna));
+        avaliadas++;
+        b->notas[i] = PESO_LINHAS * linhas + buscarMelhor(&copia, b->tipos + 1, b->profundidade - 1, &avaliadas);
+    }
+    atomic_fetch_add(&b->avaliadas, avaliadas);
+}
+
+static void *threadBusca(void *arg) {
+    BuscaParalela *b = arg;
+    for (;;) {
+        sem_wait(&b->inicio);
+        if (atomic_load(&b->encerrar)) {
+            break;
+        }
+        trabalharBusca(b);
+        sem_post(&b->fim);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Prepara a busca com 'numThreads' threads ao todo (a chamadora conta
+ * como uma; as outras são criadas aqui e ficam esperando jogadas).
+ * @return int: 0 em caso de sucesso, -1 se não foi possível criar as threads.
+ */
+int buscaIniciar(BuscaParalela *b, int numThreads) {
+    memset(b, 0, sizeof(*b));
+    b->threads = malloc(sizeof(pthread_t) * (size_t)(numThreads > 1 ? numThreads - 1 : 1));
+    if (b->threads == NULL || sem_init(&b->inicio, 0, 0) != 0 || sem_init(&b->fim, 0, 0) != 0) {
+        free(b->threads);
+        return -1;
+    }
+    b->numThreads = 1; // A thread chamadora
+    for (int i = 0; i < numThreads - 1; i++) {
+        if (pthread_create(&b->threads[i], NULL, threadBusca, b) != 0) {
+            buscaEncerrar(b);
+            return -1;
+        }
+        b->numThreads++;
+    }
+    return 0;
+}
+
+/**
+ * @brief Acorda as threads auxiliares para que saiam, espera por elas e libera a busca.
+ */
+void buscaEncerrar(BuscaParalela *b) {
+    atomic_store(&b->encerrar, 1);
+    for (int i = 0; i < b->numThreads - 1; i++) {
+        sem_post(&b->inicio);
+    }
+    for (int i = 0; i < b->numThreads - 1; i++) {
+        pthread_join(b->threads[i], NULL);
+    }
+    sem_destroy(&b->inicio);
+    sem_destroy(&b->fim);
+    free(b->threads);
+    b->threads = NULL;
+}
+
+/**
+ * @brief Escolhe onde colocar a peça tipos[0] olhando as 'profundidade' - 1
+ * peças seguintes. Empates ficam com a candidata de menor índice, então a
+ * escolha não depende de quantas threads participaram.
+ * @return int: 1 com 'escolhida' preenchida, ou 0 se a peça não cabe em lugar nenhum.
+ */
+int buscaEscolher(BuscaParalela *b, const Tabuleiro *t, const int *tipos, int profundidade, Jogada *escolhida) {
+    b->tabuleiro = *t;
+    memcpy(b->tipos, tipos, sizeof(int) * (size_t)profundidade);
+    b->profundidade = profundidade;
+    b->numCandidatas = 0;
+    for (int rotacao = 0; rotacao < numRotacoes[tipos[0]]; rotacao++) {
+        const FormaPeca *forma = &formas[tipos[0]][rotacao];
+        for (int coluna = 0; coluna + forma->largura <= LARGURA_TABULEIRO; coluna++) {
+            if (tabuleiroSoltar(t, forma, coluna) >= 0) {
+                b->candidatas[b->numCandidatas++] = (Jogada){rotacao, coluna};
+            }
+        }
+    }
+    if (b->numCandidatas == 0) {
+        return 0;
+    }
+    atomic_store(&b->proximaCandidata, 0);
+    for (int i = 0; i < b->numThreads - 1; i++) {
+        sem_post(&b->inicio);
+    }
+    trabalharBusca(b);
+    for (int i = 0; i < b->numThreads - 1; i++) {
+        sem_wait(&b->fim);
+    }
+    int melhor = 0;
+    for (int i = 1; i < b->numCandidatas; i++) {
+        if (b->notas[i] > b->notas[melhor]) {
+            melhor = i;
+        }
+    }
+    *escolhida = b->candidatas[melhor];
+    return 1;
+}
+
+// -------------------------------------------------------------------
+// ----------------------- GRAVAÇÃO DE REPLAY ------------------------
+// -------------------------------------------------------------------
+
+/**
+ * @brief Abre 'caminho' para gravar uma sessão. O cabeçalho é reescrito em
+ * replayFechar(), com o total de eventos e de bits.
+ * @return int: 0 em caso de sucesso, -1 se não foi possível criar o arquivo.
+ */
+int replayAbrir(GravadorReplay *g, const char *caminho, uint64_t semente, uint32_t capacidade) {
+    memset(g, 0, sizeof(*g));
+    g->palavras = malloc(PALAVRAS_BUFFER_REPLAY * sizeof(uint64_t));
+    g->arquivo = g->palavras != NULL ? fopen(caminho, "wb") : NULL;
+    if (g->arquivo == NULL) {
+        free(g->palavras);
+        return -1;
+    }
+    memcpy(g->cabecalho.magica, "TSRP", 4);
+    g->cabecalho.versao = VERSAO_REPLAY;
+    g->cabecalho.semente = semente;
+    g->cabecalho.capacidade = capacidade;
+    g->ultimoInserido = -1;
+    g->ultimoRemovido = -1;
+    if (fwrite(&g->cabecalho, sizeof(g->cabecalho), 1, g->arquivo) != 1) {
+        g->erro = 1;
+    }
+    return 0;
+}
+
+static void descarregarReplay(GravadorReplay *g) {
+    if (g->numPalavras > 0 && fwrite(g->palavras, sizeof(uint64_t), g->numPalavras, g->arquivo) != g->numPalavras) {
+        g->erro = 1;
+    }
+    g->numPalavras = 0;
+}
+
+/**
+ * @brief Acrescenta os 'n' bits menos significativos de 'valor' (n < 64). Quando
+ * a palavra completa, o que sobrou de 'valor' começa a próxima.
+ */
+static inline void gravarBits(GravadorReplay *g, uint64_t valor, int n) {
+    g->acumulador |= valor << g->bitsPendentes;
+    if (g->bitsPendentes + n < 64) {
+        g->bitsPendentes += n;
+        return;
+    }
+    g->palavras[g->numPalavras++] = g->acumulador;
+    if (g->numPalavras == PALAVRAS_BUFFER_REPLAY) {
+        descarregarReplay(g);
+    }
+    g->acumulador = valor >> (64 - g->bitsPendentes);
+    g->bitsPendentes += n - 64;
+}
+
+/**
+ * @brief Grava os 'n' bits de 'inicio' seguidos da diferença em Elias-gamma: o
+ * valor em zigue-zague (0, -1, 1, -2... viram 0, 1, 2, 3...) mais 1 tem k bits;
+ * saem k - 1 zeros, um 1 e os k - 1 bits de baixo. A diferença 0 custa um único
+ * bit, e diferenças pequenas saem junto com 'inicio' numa só escrita.
+ */
+static inline void gravarComDiferenca(GravadorReplay *g, uint64_t inicio, int n, int64_t diferenca) {
+    uint64_t valor = ((uint64_t)diferenca << 1 ^ (uint64_t)(diferenca >> 63)) + 1;
+    int bits = 64 - __builtin_clzll(valor);
+    uint64_t codigo = 1ULL << (bits - 1) | (valor & ((1ULL << (bits - 1)) - 1)) << bits;
+    if (n + 2 * bits - 1 < 64) {
+        gravarBits(g, inicio | codigo << n, n + 2 * bits - 1);
+        return;
+    }
+    gravarBits(g, inicio, n);
+    gravarBits(g, 1ULL << (bits - 1), bits);
+    gravarBits(g, valor & ((1ULL << (bits - 1)) - 1), bits - 1);
+}
+
+/**
+ * @brief Registra uma peça gerada e enfileirada (mesmo que a fila estivesse cheia).
+ */
+void replayGravarInsercao(GravadorReplay *g, Peca peca) {
+    gravarComDiferenca(g, (uint64_t)EVENTO_ENFILEIRAR | (uint64_t)indiceTipo(peca.nome) << 1, 4,
+                       (int64_t)peca.id - ((int64_t)g->ultimoInserido + 1));
+    g->ultimoInserido = peca.id;
+    g->cabecalho.eventos++;
+}
+
+/**
+ * @brief Registra um desenfileiramento; 'id' é -1 quando a fila estava vazia.
+ */
+void replayGravarRemocao(GravadorReplay *g, int id) {
+    if (id < 0) {
+        gravarBits(g, EVENTO_DESENFILEIRAR | 1u << 1, 2);
+    } else {
+        gravarComDiferenca(g, EVENTO_DESENFILEIRAR, 2, (int64_t)id - ((int64_t)g->ultimoRemovido + 1));
+        g->ultimoRemovido = id;
+    }
+    g->cabecalho.eventos++;
+}
+
+/**
+ * @brief Escreve os bits pendentes, completa o cabeçalho e fecha o arquivo.
+ * @return int: 0 se tudo foi gravado, -1 em caso de erro de escrita.
+ */
+int replayFechar(GravadorReplay *g) {
+    g->cabecalho.bits = (uint64_t)(ftell(g->arquivo) - (long)sizeof(CabecalhoReplay)) * 8 +
+                        (uint64_t)g->numPalavras * 64 + (uint64_t)g->bitsPendentes;
+    if (g->bitsPendentes > 0) {
+        g->palavras[g->numPalavras++] = g->acumulador;
+    }
+    descarregarReplay(g);
+    if (fseek(g->arquivo, 0, SEEK_SET) != 0 || fwrite(&g->cabecalho, sizeof(g->cabecalho), 1, g->arquivo) != 1) {
+        g->erro = 1;
+    }
+    if (fclose(g->arquivo) != 0) {
+        g->erro = 1;
+    }
+    free(g->palavras);
+    g->arquivo = NULL;
+    g->palavras = NULL;
+    return g->erro ? -1 : 0;
+}
+
+/**
+ * @brief Lê o arquivo de replay inteiro para a memória e confere o cabeçalho.
+ * @return int: 0 em caso de sucesso, -1 se o arquivo não existe, não é um
+ * replay desta versão ou está truncado.
+ */
+int replayCarregar(LeitorReplay *l, const char *caminho) {
+    memset(l, 0, sizeof(*l));
+    FILE *arquivo = fopen(caminho, "rb");
+    if (arquivo == NULL) {
+        return -1;
+    }
+    int ok = fread(&l->cabecalho, sizeof(l->cabecalho), 1, arquivo) == 1 &&
+             memcmp(l->cabecalho.magica, "TSRP", 4) == 0 && l->cabecalho.versao == VERSAO_REPLAY &&
+             l->cabecalho.capacidade > 0 && l->cabecalho.bits < (1ULL << 40);
+    size_t numPalavras = ok ? (size_t)((l->cabecalho.bits + 63) / 64) : 0;
+    // Duas palavras zeradas no fim: a leitura de bits sempre olha a palavra seguinte.
+    l->palavras = ok ? calloc(numPalavras + 2, sizeof(uint64_t)) : NULL;
+    ok = l->palavras != NULL && fread(l->palavras, sizeof(uint64_t), numPalavras, arquivo) == numPalavras;
+    fclose(arquivo);
+    if (!ok) {
+        replayLiberar(l);
+        return -1;
+    }
+    l->ultimoInserido = -1;
+    l->ultimoRemovido = -1;
+    return 0;
+}
+
+void replayLiberar(LeitorReplay *l) {
+    free(l->palavras);
+    l->palavras = NULL;
+}
+
+static inline uint64_t espiarBits(const LeitorReplay *l) {
+    uint64_t palavra = l->posicao >> 6;
+    unsigned deslocamento = (unsigned)(l->posicao & 63);
+    uint64_t bits = l->palavras[palavra] >> deslocamento;
+    return deslocamento == 0 ? bits : bits | l->palavras[palavra + 1] << (64 - deslocamento);
+}
+
+static inline uint64_t lerBits(LeitorReplay *l, int n) {
+    uint64_t bits = espiarBits(l) & ((1ULL << n) - 1);
+    l->posicao += (uint64_t)n;
+    return bits;
+}
+
+/**
+ * @brief Inverso de gravarDiferenca().
+ * @return int: 1 em caso de sucesso, 0 se os bits não formam um código válido.
+ */
+static inline int lerDiferenca(LeitorReplay *l, int64_t *diferenca) {
+    uint64_t prefixo = espiarBits(l);
+    if (prefixo == 0) {
+        return 0;
+    }
+    int zeros = __builtin_ctzll(prefixo);
+    l->posicao += (uint64_t)zeros + 1;
+    uint64_t valor = (1ULL << zeros | lerBits(l, zeros)) - 1;
+    *diferenca = (int64_t)(valor >> 1) ^ -(int64_t)(valor & 1);
+    return 1;
+}
+
+/**
+ * @brief Lê o próximo evento: 'tipo' é EVENTO_ENFILEIRAR ou EVENTO_DESENFILEIRAR
+ * e 'peca' traz a peça enfileirada ou o ID removido (nome 'X' na remoção).
+ * @return int: 1 em caso de sucesso, 0 se o arquivo está corrompido.
+ */
+static inline int replayProximoEvento(LeitorReplay *l, int *tipo, Peca *peca) {
+    int64_t diferenca;
+    *tipo = (int)lerBits(l, 1);
+    if (*tipo == EVENTO_ENFILEIRAR) {
+        int indice = (int)lerBits(l, 3);
+        if (indice >= TIPOS_PECAS || !lerDiferenca(l, &diferenca)) {
+            return 0;
+        }
+        peca->nome = tiposPecas[indice];
+        peca->id = (int)((int64_t)l->ultimoInserido + 1 + diferenca);
+        l->ultimoInserido = peca->id;
+    } else {
+        peca->nome = 'X';
+        if (lerBits(l, 1)) {
+            peca->id = -1;
+        } else if (lerDiferenca(l, &diferenca)) {
+            peca->id = (int)((int64_t)l->ultimoRemovido + 1 + diferenca);
+            l->ultimoRemovido = peca->id;
+        } else {
+            return 0;
+        }
+    }
+    return l->posicao <= l->cabecalho.bits;
+}
 
 // -------------------------------------------------------------------
 // ---------------------- FUNÇÕES DE LÓGICA --------------------------
 // -------------------------------------------------------------------
 
 /**
- * @brief Gera uma nova peça com tipo aleatório e ID único.
+ * @brief Acorda a thread geradora, a menos que um pedido anterior ainda esteja
+ * pendente: enquanto ela não o atende, um novo seria só uma volta a mais.
+ */
+static void pedirReabastecimento(void) {
+    if (!atomic_exchange(&reabastecimentoPedido, 1)) {
+        sem_post(&pedidosGeracao);
+    }
+}
+
+/**
+ * @brief Retira a próxima peça da reserva da thread geradora. A mensagem sai
+ * daqui, na thread do jogo, para ficar na ordem das demais.
  * @return Peca: A nova peça gerada.
  */
 Peca gerarPeca() {
     Peca nova;
-    // Tipos de peças disponíveis
-    char tipos[] = {'I', 'O', 'T', 'L'};
-    
-    // Sorteia um tipo de peça aleatoriamente
-    int indiceTipo = rand() % TIPOS_PECAS;
-    nova.nome = tipos[indiceTipo];
-    
-    // Atribui o ID único e incrementa o contador global de IDs
-    nova.id = proximoId;
-    proximoId++;
+    // Só esvazia se a geradora ficar sem CPU por meia reserva inteira
+    while (!anelDesenfileirar(&reservaPecas, &nova)) {
+        pedirReabastecimento();
+        sched_yield();
+    }
+    if (anelTamanho(&reservaPecas) <= reservaPecas.limite / 2) {
+        pedirReabastecimento();
+    }
     
-    printf("\n[GERADO]: Nova peça '%c' com ID %d.\n", nova.nome, nova.id);
+    registrarInfo("\n[GERADO]: Nova peça '%c' com ID %d.\n", nova.nome, nova.id);
     return nova;
 }
 
 /**
- * @brief Inicializa a fila preenchendo-a com peças iniciais.
+ * @brief Laço da thread geradora, a única produtora de 'reservaPecas': deixa a
+ * reserva cheia e dorme até o jogo avisar que ela baixou da metade.
+ */
+void *threadGeradora(void *arg) {
+    (void)arg;
+    for (;;) {
+        geradorEncherFila(&geradorPecas, &reservaPecas);
+        sem_wait(&pedidosGeracao);
+        if (atomic_load(&encerrarGeracao)) {
+            break;
+        }
+        atomic_store(&reabastecimentoPedido, 0);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Coloca 'quantidade' peças novas na fila, tiradas da reserva sem
+ * esperar pela thread geradora.
+ */
+void solicitarPecas(int quantidade) {
+    for (int i = 0; i < quantidade; i++) {
+        enfileirar(gerarPeca());
+    }
+}
+
+/**
+ * @brief Inicializa a fila preenchendo-a com peças iniciais, geradas em lote.
+ * Chamada antes de a thread geradora existir, que depois continua a mesma
+ * sequência na reserva.
  */
 void inicializarFila() {
     printf(">> 🚀 Inicializando a Fila de Peças Futures (Capacidade: %d)...\n", CAPACIDADE_MAXIMA);
+    printf(">> 🎲 Semente das peças: %llu\n", (unsigned long long)geradorPecas.semente);
     
     // Preenche a fila até a capacidade máxima
-    for (int i = 0; i < CAPACIDADE_MAXIMA; i++) {
-        Peca p = gerarPeca();
-        enfileirar(p);
+    size_t geradas = geradorEncherFila(&geradorPecas, &filaPecas);
+    if (gravandoSessao) {
+        for (size_t i = 0; i < geradas; i++) {
+            Peca peca;
+            anelEspiar(&filaPecas, i, &peca);
+            replayGravarInsercao(&gravadorSessao, peca);
+        }
     }
+    printf("\n[GERADO]: %zu peças geradas em lote.\n", geradas);
     printf(">> ✅ Fila inicializada e preenchida.\n");
 }
 
@@ -73,7 +1095,7 @@ void inicializarFila() {
  * @return int: 1 (cheia) ou 0 (não cheia).
  */
 int filaCheia() {
-    return contadorPecas == CAPACIDADE_MAXIMA;
+    return anelTamanho(&filaPecas) == filaPecas.limite;
 }
 
 /**
@@ -81,7 +1103,7 @@ int filaCheia() {
  * @return int: 1 (vazia) ou 0 (não vazia).
  */
 int filaVazia() {
-    return contadorPecas == 0;
+    return anelTamanho(&filaPecas) == 0;
 }
 
 /**
@@ -89,45 +1111,36 @@ int filaVazia() {
  * @param novaPeca A peça a ser inserida.
  */
 void enfileirar(Peca novaPeca) {
-    if (filaCheia()) {
-        printf("\n[ERRO]: A fila de peças está cheia! Não é possível inserir.\n");
+    if (gravandoSessao) {
+        replayGravarInsercao(&gravadorSessao, novaPeca);
+    }
+    if (!anelEnfileirar(&filaPecas, novaPeca)) {
+        registrarAviso("\n[ERRO]: A fila de peças está cheia! Não é possível inserir.\n");
         return;
     }
     
-    // Insere a peça na posição 'fim'
-    filaPecas[fim] = novaPeca;
-    
-    // Atualiza o índice 'fim' (avança e garante a circularidade com o operador módulo)
-    fim = (fim + 1) % CAPACIDADE_MAXIMA;
-    
-    // Incrementa o contador de peças na fila
-    contadorPecas++;
-    
-    printf("\n[INSERIDO]: Peça [%c %d] adicionada ao final da fila.\n", novaPeca.nome, novaPeca.id);
+    registrarInfo("\n[INSERIDO]: Peça [%c %d] adicionada ao final da fila.\n", novaPeca.nome, novaPeca.id);
 }
 
 /**
- * @brief Remove a peça da frente da fila (Dequeue) e a retorna.
+ * @brief Remove a peça da frente da fila (Dequeue) e a retorna. Chamada pelo
+ * laço do jogo, o único consumidor da fila.
  * @return Peca: A peça removida.
  */
 Peca desenfileirar() {
-    if (filaVazia()) {
-        printf("\n[ERRO]: A fila de peças está vazia! Não há peça para jogar.\n");
+    Peca pecaRemovida;
+    int removida = anelDesenfileirar(&filaPecas, &pecaRemovida);
+    if (gravandoSessao) {
+        replayGravarRemocao(&gravadorSessao, removida ? pecaRemovida.id : -1);
+    }
+    if (!removida) {
+        registrarAviso("\n[ERRO]: A fila de peças está vazia! Não há peça para jogar.\n");
         // Retorna uma peça nula/vazia para sinalizar erro
         Peca vazia = {'X', -1}; 
         return vazia; 
     }
     
-    // Pega a peça da posição 'frente'
-    Peca pecaRemovida = filaPecas[frente];
-    
-    // Atualiza o índice 'frente' (avança e garante a circularidade)
-    frente = (frente + 1) % CAPACIDADE_MAXIMA;
-    
-    // Decrementa o contador de peças
-    contadorPecas--;
-    
-    printf("\n[JOGADA]: Peça [%c %d] removida da frente (dequeue).\n", pecaRemovida.nome, pecaRemovida.id);
+    registrarInfo("\n[JOGADA]: Peça [%c %d] removida da frente (dequeue).\n", pecaRemovida.nome, pecaRemovida.id);
     return pecaRemovida;
 }
 
@@ -139,10 +1152,11 @@ Peca desenfileirar() {
  * @brief Exibe o estado atual da fila de peças.
  */
 void exibirFila() {
+    int contadorPecas = (int)anelTamanho(&filaPecas);
     printf("\n--- ESTADO ATUAL DA FILA DE PEÇAS ---\n");
     printf("Total de Peças: %d / %d\n", contadorPecas, CAPACIDADE_MAXIMA);
     
-    if (filaVazia()) {
+    if (contadorPecas == 0) {
         printf("A fila está vazia.\n");
         return;
     }
@@ -150,12 +1164,10 @@ void exibirFila() {
     printf("Fila de peças: ");
     
     // Percorre a fila a partir da 'frente' até o 'fim'
-    int i = frente;
     for (int count = 0; count < contadorPecas; count++) {
-        printf("[%c %d]", filaPecas[i].nome, filaPecas[i].id);
-        
-        // Avança o índice, mantendo a circularidade
-        i = (i + 1) % CAPACIDADE_MAXIMA;
+        Peca p;
+        anelEspiar(&filaPecas, (size_t)count, &p);
+        printf("[%c %d]", p.nome, p.id);
         
         // Adiciona uma seta se não for o último elemento
         if (count < contadorPecas - 1) {
@@ -179,29 +1191,672 @@ void exibirMenu() {
     printf("Escolha uma opção: ");
 }
 
+/**
+ * @brief Mostra o tabuleiro de cima para baixo ('#' ocupado, '.' vazio).
+ */
+void exibirTabuleiro(const Tabuleiro *t) {
+    printf("\n--- TABULEIRO (%d x %d) ---\n", LARGURA_TABULEIRO, ALTURA_TABULEIRO);
+    for (int r = ALTURA_TABULEIRO - 1; r >= 0; r--) {
+        printf("|");
+        for (int c = 0; c < LARGURA_TABULEIRO; c++) {
+            printf("%c", (t->linhas[r] >> c) & 1u ? '#' : '.');
+        }
+        printf("|\n");
+    }
+    printf("+");
+    for (int c = 0; c < LARGURA_TABULEIRO; c++) {
+        printf("-");
+    }
+    printf("+\n");
+}
+
+// -------------------------------------------------------------------
+// ------------------------ BENCHMARK DA FILA ------------------------
+// -------------------------------------------------------------------
+
+/**
+ * @brief Uma das duas threads do benchmark. Com 'trava', cada operação passa
+ * por um mutex, como faria uma fila protegida por trava (a referência).
+ */
+typedef struct {
+    AnelSPSC *anel;
+    pthread_mutex_t *trava;
+    long long total;        // Peças a produzir ou consumir
+    size_t lote;            // 1 = uma peça por operação
+    long long foraDeOrdem;  // Consumidor: peças que não chegaram na ordem dos IDs
+} TrabalhoFila;
+
+static double segundosAgora() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec + (double)t.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Produz peças (IDs 0, 1, 2...) com o gerador em lote. Quando o anel
+ * enche, cede o processador ao consumidor em vez de girar sem fazer nada.
+ */
+static void *produtorBench(void *arg) {
+    TrabalhoFila *t = arg;
+    GeradorPecas gerador;
+    geradorIniciar(&gerador, 2024);
+    Peca lote[256];
+    long long id = 0;
+    while (id < t->total) {
+        size_t n = t->lote;
+        if ((long long)n > t->total - id) {
+            n = (size_t)(t->total - id);
+        }
+        geradorPreencher(&gerador, lote, n);
+        size_t enviados = 0;
+        while (enviados < n) {
+            size_t k;
+            if (t->trava != NULL) {
+                pthread_mutex_lock(t->trava);
+                k = (size_t)anelEnfileirar(t->anel, lote[enviados]);
+                pthread_mutex_unlock(t->trava);
+            } else if (n == 1) {
+                k = (size_t)anelEnfileirar(t->anel, lote[0]);
+            } else {
+                k = anelEnfileirarLote(t->anel, lote + enviados, n - enviados);
+            }
+            if (k == 0) {
+                sched_yield();
+            }
+            enviados += k;
+        }
+        id += (long long)n;
+    }
+    return NULL;
+}
+
+static void *consumidorBench(void *arg) {
+    TrabalhoFila *t = arg;
+    Peca lote[256];
+    long long esperado = 0;
+    while (esperado < t->total) {
+        size_t k;
+        if (t->trava != NULL) {
+            pthread_mutex_lock(t->trava);
+            k = (size_t)anelDesenfileirar(t->anel, &lote[0]);
+            pthread_mutex_unlock(t->trava);
+        } else if (t->lote == 1) {
+            k = (size_t)anelDesenfileirar(t->anel, &lote[0]);
+        } else {
+            k = anelDesenfileirarLote(t->anel, lote, t->lote);
+        }
+        if (k == 0) {
+            sched_yield();
+        }
+        for (size_t i = 0; i < k; i++, esperado++) {
+            t->foraDeOrdem += lote[i].id != (int)esperado;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Passa 'total' peças de uma thread produtora para uma consumidora.
+ * @return double: Peças por segundo, ou -1 se alguma peça chegou fora de ordem.
+ */
+static double medirFila(long long total, size_t lote, int comTrava) {
+    AnelSPSC *anel = aligned_alloc(LINHA_CACHE, sizeof(AnelSPSC));
+    if (anel == NULL || anelIniciar(anel, 1024) != 0) {
+        free(anel);
+        return -1;
+    }
+    pthread_mutex_t trava = PTHREAD_MUTEX_INITIALIZER;
+    TrabalhoFila produtor = {anel, comTrava ? &trava : NULL, total, lote, 0};
+    TrabalhoFila consumidor = produtor;
+    pthread_t threads[2];
+    double inicio = segundosAgora();
+    pthread_create(&threads[0], NULL, produtorBench, &produtor);
+    pthread_create(&threads[1], NULL, consumidorBench, &consumidor);
+    pthread_join(threads[0], NULL);
+    pthread_join(threads[1], NULL);
+    double tempo = segundosAgora() - inicio;
+    anelLiberar(anel);
+    free(anel);
+    return consumidor.foraDeOrdem == 0 ? (double)total / tempo : -1;
+}
+
+/**
+ * @brief "./TetrisStack --bench-fila [pecas] [lote]": mede peças por segundo
+ * entre uma thread produtora e uma consumidora, com a fila protegida por mutex,
+ * com o anel sem travas peça a peça e com o anel em lotes. O consumidor confere
+ * que todas as peças chegam na ordem em que foram geradas.
+ */
+int executarBenchFila(int argc, char *argv[]) {
+    long long total = argc > 2 ? atoll(argv[2]) : 20000000;
+    long lote = argc > 3 ? atol(argv[3]) : 64;
+    if (total <= 0 || lote <= 0 || lote > 256) {
+        printf("[ERRO]: Uso: ./TetrisStack --bench-fila [pecas] [lote (1 a 256)]\n");
+        return 1;
+    }
+    printf("--- BENCHMARK DA FILA DE PEÇAS (1 produtor, 1 consumidor) ---\n");
+    printf("Peças: %lld | Processadores: %ld | Anel de 1024 posições\n", total, sysconf(_SC_NPROCESSORS_ONLN));
+    double comTrava = medirFila(total, 1, 1);
+    double semTrava = medirFila(total, 1, 0);
+    double emLotes = medirFila(total, (size_t)lote, 0);
+    char rotuloLotes[40];
+    snprintf(rotuloLotes, sizeof(rotuloLotes), "Sem trava, lotes de %ld:", lote);
+    printf("%-28s %12.0f peças/s\n", "Com mutex, uma por vez:", comTrava);
+    printf("%-28s %12.0f peças/s\n", "Sem trava, uma por vez:", semTrava);
+    printf("%-28s %12.0f peças/s\n", rotuloLotes, emLotes);
+    int ok = comTrava > 0 && semTrava > 0 && emLotes > 0;
+    printf("Ordem das peças %s\n", ok ? "confere" : "DIVERGE");
+    return ok ? 0 : 1;
+}
+
+// -------------------------------------------------------------------
+// ----------------------- BENCHMARK DO GERADOR ----------------------
+// -------------------------------------------------------------------
+
+/**
+ * @brief "./TetrisStack --bench-gerador [pecas] [semente]": compara o sorteio
+ * antigo (rand() % tipos, peça a peça) com o gerador de saco de 7 peça a peça e
+ * em lote. Confere que cada saco tem os 7 tipos, que a mesma semente repete a
+ * sequência e que o lote dá as mesmas peças que a geração peça a peça.
+ */
+int executarBenchGerador(int argc, char *argv[]) {
+    long long total = argc > 2 ? atoll(argv[2]) : 50000000;
+    uint64_t semente = argc > 3 ? strtoull(argv[3], NULL, 10) : 2024;
+    if (total <= 0) {
+        printf("[ERRO]: Uso: ./TetrisStack --bench-gerador [pecas] [semente]\n");
+        return 1;
+    }
+    enum { TAMANHO_LOTE = 4096 };
+    Peca *lote = malloc(TAMANHO_LOTE * sizeof(Peca));
+    Peca *conferencia = malloc(TAMANHO_LOTE * sizeof(Peca));
+    if (lote == NULL || conferencia == NULL) {
+        printf("[ERRO]: Falha na alocação de memória.\n");
+        return 1;
+    }
+    // 'volatile' impede que o compilador descarte as peças geradas.
+    volatile char ultima = 0;
+
+    // Referência: o sorteio original, com os tipos antigos.
+    const char tiposAntigos[] = {'I', 'O', 'T', 'L'};
+    srand((unsigned)semente);
+    double inicio = segundosAgora();
+    for (long long i = 0; i < total; i++) {
+        ultima = tiposAntigos[rand() % 4];
+    }
+    double tempoRand = segundosAgora() - inicio;
+
+    GeradorPecas gerador;
+    geradorIniciar(&gerador, semente);
+    inicio = segundosAgora();
+    for (long long i = 0; i < total; i++) {
+        ultima = geradorProxima(&gerador).nome;
+    }
+    double tempoUma = segundosAgora() - inicio;
+
+    geradorIniciar(&gerador, semente);
+    inicio = segundosAgora();
+    for (long long i = 0; i < total; i += TAMANHO_LOTE) {
+        size_t n = total - i < TAMANHO_LOTE ? (size_t)(total - i) : TAMANHO_LOTE;
+        geradorPreencher(&gerador, lote, n);
+        ultima = lote[n - 1].nome;
+    }
+    double tempoLote = segundosAgora() - inicio;
+    (void)ultima;
+
+    // Conferências: sacos completos, lote igual a peça a peça e sementes reproduzíveis.
+    GeradorPecas a, b, c;
+    geradorIniciar(&a, semente);
+    geradorIniciar(&b, semente);
+    geradorIniciar(&c, semente + 1);
+    int sacosOk = 1, loteOk = 1, diferentes = 0;
+    for (int rodada = 0; rodada < 256; rodada++) {
+        geradorPreencher(&a, lote, TAMANHO_LOTE);
+        for (int i = 0; i < TAMANHO_LOTE; i++) {
+            conferencia[i] = geradorProxima(&b);
+            loteOk = loteOk && lote[i].nome == conferencia[i].nome && lote[i].id == conferencia[i].id;
+            diferentes += geradorProxima(&c).nome != lote[i].nome;
+        }
+        // 4096 não é múltiplo de 7: confere só os sacos que começam neste lote.
+        int inicioSaco = (TIPOS_PECAS - (rodada * TAMANHO_LOTE) % TIPOS_PECAS) % TIPOS_PECAS;
+        for (int i = inicioSaco; i + TIPOS_PECAS <= TAMANHO_LOTE; i += TIPOS_PECAS) {
+            int vistos = 0;
+            for (int k = 0; k < TIPOS_PECAS; k++) {
+                vistos |= 1 << indiceTipo(lote[i + k].nome);
+            }
+            sacosOk = sacosOk && vistos == (1 << TIPOS_PECAS) - 1;
+        }
+    }
+
+    geradorIniciar(&gerador, semente);
+    char primeiras[22];
+    for (int i = 0; i < 21; i++) {
+        primeiras[i] = geradorProxima(&gerador).nome;
+    }
+    primeiras[21] = '\0';
+
+    printf("--- BENCHMARK DO GERADOR DE PEÇAS ---\n");
+    printf("Peças: %lld | Semente: %llu | Primeiras: %s\n", total, (unsigned long long)semente, primeiras);
+    printf("%-32s %12.0f peças/s\n", "rand() % tipos, peça a peça:", total / tempoRand);
+    printf("%-32s %12.0f peças/s\n", "Saco de 7 (PCG32), peça a peça:", total / tempoUma);
+    printf("%-32s %12.0f peças/s\n", "Saco de 7 (PCG32), em lote:", total / tempoLote);
+    printf("Sacos com os 7 tipos: %s | Lote igual a peça a peça: %s | Outra semente muda a sequência: %s\n",
+           sacosOk ? "sim" : "NAO", loteOk ? "sim" : "NAO", diferentes > 0 ? "sim" : "NAO");
+    free(lote);
+    free(conferencia);
+    return sacosOk && loteOk && diferentes > 0 ? 0 : 1;
+}
+
+// -------------------------------------------------------------------
+// ---------------------- SIMULAÇÃO SEM INTERFACE --------------------
+// -------------------------------------------------------------------
+
+typedef struct {
+    int jogadas;            // Peças colocadas
+    int perdeu;             // 1 se uma peça não coube (fim de jogo)
+    long long linhas;       // Linhas removidas
+    long long avaliadas;    // Posicionamentos testados pela busca
+    double segundos;
+    uint64_t assinatura;    // Resumo das jogadas, para comparar execuções
+    Tabuleiro tabuleiro;    // Estado final
+} ResultadoSimulacao;
+
+/**
+ * @brief Joga até 'jogadas' peças sem interface: a fila de peças é a mesma do
+ * jogo ('filaPecas', completada pelo gerador a cada jogada) e a busca olha as
+ * 'profundidade' primeiras peças dela para escolher onde colocar a da frente.
+ * @return int: 0 em caso de sucesso, -1 se faltou memória ou thread.
+ */
+static int simularPartida(int jogadas, int profundidade, int numThreads, uint64_t semente, ResultadoSimulacao *r) {
+    BuscaParalela *busca = malloc(sizeof(BuscaParalela));
+    if (busca == NULL || buscaIniciar(busca, numThreads) != 0) {
+        free(busca);
+        return -1;
+    }
+    if (anelIniciar(&filaPecas, CAPACIDADE_MAXIMA) != 0) {
+        buscaEncerrar(busca);
+        free(busca);
+        return -1;
+    }
+    geradorIniciar(&geradorPecas, semente);
+    geradorEncherFila(&geradorPecas, &filaPecas);
+
+    memset(r, 0, sizeof(*r));
+    r->assinatura = 14695981039346656037ULL;
+    double inicio = segundosAgora();
+    while (r->jogadas < jogadas) {
+        int tipos[CAPACIDADE_MAXIMA];
+        Peca peca;
+        for (int k = 0; k < profundidade; k++) {
+            anelEspiar(&filaPecas, (size_t)k, &peca);
+            tipos[k] = indiceTipo(peca.nome);
+        }
+        Jogada jogada;
+        if (!buscaEscolher(busca, &r->tabuleiro, tipos, profundidade, &jogada)) {
+            r->perdeu = 1;
+            break;
+        }
+        anelDesenfileirar(&filaPecas, &peca);
+        const FormaPeca *forma = &formas[tipos[0]][jogada.rotacao];
+        int y = tabuleiroSoltar(&r->tabuleiro, forma, jogada.coluna);
+        r->linhas += tabuleiroFixar(&r->tabuleiro, forma, jogada.coluna, y);
+        r->assinatura = (r->assinatura ^ (uint64_t)(jogada.rotacao * LARGURA_TABULEIRO + jogada.coluna + 1)) *
+                        1099511628211ULL;
+        r->jogadas++;
+        geradorEncherFila(&geradorPecas, &filaPecas);
+    }
+    r->segundos = segundosAgora() - inicio;
+    r->avaliadas = atomic_load(&busca->avaliadas);
+
+    anelLiberar(&filaPecas);
+    buscaEncerrar(busca);
+    free(busca);
+    return 0;
+}
+
+/**
+ * @brief Confere tabuleiroSoltar() com pilhas de todas as alturas, até o
+ * tabuleiro cheio, contra uma queda célula a célula que começa acima do
+ * tabuleiro (onde tudo está vazio). As linhas têm um buraco que muda de coluna,
+ * para que as peças ainda possam descer por entre a pilha.
+ * @return int: Quantas quedas deram resultado diferente.
+ */
+static int conferirQuedas(void) {
+    int diferencas = 0;
+    for (int alturaPilha = 0; alturaPilha <= ALTURA_TABULEIRO; alturaPilha++) {
+        Tabuleiro t = {.topo = alturaPilha};
+        for (int r = 0; r < alturaPilha; r++) {
+            t.linhas[r] = (uint16_t)(LINHA_CHEIA & ~(3u << (r * 3 % (LARGURA_TABULEIRO - 1))));
+        }
+        for (int tipo = 0; tipo < TIPOS_PECAS; tipo++) {
+            for (int rotacao = 0; rotacao < numRotacoes[tipo]; rotacao++) {
+                const FormaPeca *forma = &formas[tipo][rotacao];
+                for (int coluna = 0; coluna + forma->largura <= LARGURA_TABULEIRO; coluna++) {
+                    int y = ALTURA_TABULEIRO, livre = 1;
+                    while (y > 0 && livre) {
+                        for (int k = 0; k < forma->altura; k++) {
+                            int r = y - 1 + k;
+                            livre = livre && (r >= ALTURA_TABULEIRO ||
+                                              !(t.linhas[r] & (uint16_t)(forma->linhas[k] << coluna)));
+                        }
+                        y -= livre;
+                    }
+                    int esperado = y + forma->altura <= ALTURA_TABULEIRO ? y : -1;
+                    diferencas += tabuleiroSoltar(&t, forma, coluna) != esperado;
+                }
+            }
+        }
+    }
+    return diferencas;
+}
+
+/**
+ * @brief "./TetrisStack --simular [jogadas] [pecas olhadas] [threads] [semente]":
+ * joga uma partida sem interface e mede quantos posicionamentos a busca avalia
+ * por segundo. Com mais de uma thread, repete a partida com uma só para mostrar
+ * o ganho e conferir que as jogadas escolhidas são as mesmas.
+ */
+int executarSimulacao(int argc, char *argv[]) {
+    int jogadas = argc > 2 ? atoi(argv[2]) : 1000;
+    int profundidade = argc > 3 ? atoi(argv[3]) : 3;
+    int numThreads = argc > 4 ? atoi(argv[4]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    uint64_t semente = argc > 5 ? strtoull(argv[5], NULL, 10) : 2024;
+    if (jogadas <= 0 || profundidade < 1 || profundidade > CAPACIDADE_MAXIMA || numThreads < 1 || numThreads > 256) {
+        printf("[ERRO]: Uso: ./TetrisStack --simular [jogadas] [peças olhadas (1 a %d)] [threads] [semente]\n",
+               CAPACIDADE_MAXIMA);
+        return 1;
+    }
+    prepararFormas();
+
+    ResultadoSimulacao paralela;
+    if (simularPartida(jogadas, profundidade, numThreads, semente, &paralela) != 0) {
+        printf("[ERRO]: Não foi possível preparar a simulação.\n");
+        return 1;
+    }
+    printf("--- SIMULAÇÃO SEM INTERFACE (busca de jogadas) ---\n");
+    printf("Jogadas: %d | Peças olhadas: %d | Threads: %d | Semente: %llu\n",
+           jogadas, profundidade, numThreads, (unsigned long long)semente);
+    exibirTabuleiro(&paralela.tabuleiro);
+    printf("Peças colocadas: %d%s | Linhas completadas: %lld\n",
+           paralela.jogadas, paralela.perdeu ? " (fim de jogo)" : "", paralela.linhas);
+    printf("Posicionamentos avaliados: %lld em %.3f s -> %.0f posicionamentos/s\n",
+           paralela.avaliadas, paralela.segundos, paralela.avaliadas / paralela.segundos);
+    int quedasErradas = conferirQuedas();
+    printf("Quedas conferidas com a pilha em todas as alturas (até o topo): %s\n",
+           quedasErradas == 0 ? "sim" : "NAO");
+    if (numThreads == 1) {
+        return quedasErradas == 0 ? 0 : 1;
+    }
+
+    ResultadoSimulacao sequencial;
+    if (simularPartida(jogadas, profundidade, 1, semente, &sequencial) != 0) {
+        printf("[ERRO]: Não foi possível preparar a simulação.\n");
+        return 1;
+    }
+    int iguais = sequencial.jogadas == paralela.jogadas && sequencial.assinatura == paralela.assinatura;
+    printf("Com 1 thread: %.0f posicionamentos/s | Ganho: %.2fx | Mesmas jogadas: %s\n",
+           sequencial.avaliadas / sequencial.segundos, sequencial.segundos / paralela.segundos,
+           iguais ? "sim" : "NAO");
+    return iguais && quedasErradas == 0 ? 0 : 1;
+}
+
+// -------------------------------------------------------------------
+// -------------------------- MODOS DE REPLAY ------------------------
+// -------------------------------------------------------------------
+
+typedef struct {
+    uint64_t insercoes;
+    uint64_t recusadas;     // Inserções com a fila cheia
+    uint64_t remocoes;
+    uint64_t vazias;        // Remoções com a fila vazia
+    uint64_t divergencias;  // Eventos que não se repetiram como gravados
+    double segundos;
+} EstatisticasReplay;
+
+/**
+ * @brief Passa os eventos do replay pela lógica da fila, sem nenhuma saída no
+ * console. Cada peça enfileirada tem de ser a próxima do gerador com a semente
+ * gravada, e cada remoção tem de devolver a peça (ou a fila vazia) gravada.
+ * @return int: 0 em caso de sucesso, -1 se o arquivo está corrompido.
+ */
+static int reproduzirReplay(LeitorReplay *l, EstatisticasReplay *e) {
+    AnelSPSC *anel = aligned_alloc(LINHA_CACHE, sizeof(AnelSPSC));
+    if (anel == NULL || anelIniciar(anel, l->cabecalho.capacidade) != 0) {
+        free(anel);
+        return -1;
+    }
+    GeradorPecas gerador;
+    geradorIniciar(&gerador, l->cabecalho.semente);
+    memset(e, 0, sizeof(*e));
+    int corrompido = 0;
+    double inicio = segundosAgora();
+    for (uint64_t i = 0; i < l->cabecalho.eventos; i++) {
+        int tipo;
+        Peca gravada, peca;
+        if (!replayProximoEvento(l, &tipo, &gravada)) {
+            corrompido = 1;
+            break;
+        }
+        if (tipo == EVENTO_ENFILEIRAR) {
+            peca = geradorProxima(&gerador);
+            e->divergencias += peca.nome != gravada.nome || peca.id != gravada.id;
+            e->recusadas += !anelEnfileirar(anel, gravada);
+            e->insercoes++;
+        } else {
+            int removida = anelDesenfileirar(anel, &peca);
+            e->divergencias += removida ? peca.id != gravada.id : gravada.id != -1;
+            e->vazias += !removida;
+            e->remocoes++;
+        }
+    }
+    e->segundos = segundosAgora() - inicio;
+    anelLiberar(anel);
+    free(anel);
+    return corrompido ? -1 : 0;
+}
+
+/**
+ * @brief "./TetrisStack --gerar-replay arquivo [eventos] [semente]": grava uma
+ * sessão sintética como a do jogo (fila cheia no início, depois inserções e
+ * remoções sorteadas) para benchmarks de regressão. A mesma sessão roda antes
+ * sem gravar, para medir o custo da gravação.
+ */
+int executarGerarReplay(int argc, char *argv[]) {
+    long long eventos = argc > 3 ? atoll(argv[3]) : 10000000;
+    uint64_t semente = argc > 4 ? strtoull(argv[4], NULL, 10) : 2024;
+    if (argc < 3 || eventos <= 0) {
+        printf("[ERRO]: Uso: ./TetrisStack --gerar-replay arquivo [eventos] [semente]\n");
+        return 1;
+    }
+    GravadorReplay *gravador = malloc(sizeof(GravadorReplay));
+    AnelSPSC *anel = aligned_alloc(LINHA_CACHE, sizeof(AnelSPSC));
+    if (gravador == NULL || anel == NULL || anelIniciar(anel, CAPACIDADE_MAXIMA) != 0) {
+        printf("[ERRO]: Falha na alocação de memória.\n");
+        free(gravador);
+        free(anel);
+        return 1;
+    }
+    double tempos[2];
+    long long gravados = 0;
+    // Rodada 0: só a lógica da fila. Rodada 1: a mesma sessão, gravada.
+    for (int rodada = 0; rodada < 2; rodada++) {
+        if (rodada == 1 && replayAbrir(gravador, argv[2], semente, CAPACIDADE_MAXIMA) != 0) {
+            printf("[ERRO]: Não foi possível criar '%s'.\n", argv[2]);
+            anelLiberar(anel);
+            free(anel);
+            free(gravador);
+            return 1;
+        }
+        GeradorPecas gerador;
+        GeradorPCG sorteio;
+        geradorIniciar(&gerador, semente);
+        pcgIniciar(&sorteio, semente, 0x5E55A0u);
+        Peca peca;
+        while (anelDesenfileirar(anel, &peca)) {
+        }
+        double inicio = segundosAgora();
+        long long feitos = 0;
+        while (feitos < eventos) {
+            // Primeiro enche a fila, como inicializarFila(); depois sorteia a ação.
+            if (gerador.proximoId < CAPACIDADE_MAXIMA || (pcgProximo(&sorteio) & 1u)) {
+                peca = geradorProxima(&gerador);
+                if (rodada == 1) {
+                    replayGravarInsercao(gravador, peca);
+                }
+                anelEnfileirar(anel, peca);
+            } else {
+                int removida = anelDesenfileirar(anel, &peca);
+                if (rodada == 1) {
+                    replayGravarRemocao(gravador, removida ? peca.id : -1);
+                }
+            }
+            feitos++;
+        }
+        tempos[rodada] = segundosAgora() - inicio;
+        gravados = feitos;
+    }
+    uint64_t bits = 0;
+    int erro = replayFechar(gravador);
+    bits = gravador->cabecalho.bits;
+    anelLiberar(anel);
+    free(anel);
+    free(gravador);
+    if (erro != 0) {
+        printf("[ERRO]: Falha ao gravar '%s'.\n", argv[2]);
+        return 1;
+    }
+    printf("--- GRAVAÇÃO DE REPLAY ---\n");
+    printf("Arquivo: %s | Eventos: %lld | Semente: %llu\n", argv[2], gravados, (unsigned long long)semente);
+    printf("Tamanho: %llu bytes de eventos (%.2f bits por evento)\n",
+           (unsigned long long)(bits + 7) / 8, (double)bits / (double)gravados);
+    printf("%-20s %12.0f eventos/s\n", "Sem gravar:", gravados / tempos[0]);
+    printf("%-20s %12.0f eventos/s\n", "Gravando:", gravados / tempos[1]);
+    return 0;
+}
+
+/**
+ * @brief "./TetrisStack --replay arquivo": reproduz uma sessão gravada com
+ * "--gravar" ou "--gerar-replay" na velocidade máxima e confere que ela se
+ * repete exatamente.
+ */
+int executarReplay(int argc, char *argv[]) {
+    if (argc < 3) {
+        printf("[ERRO]: Uso: ./TetrisStack --replay arquivo\n");
+        return 1;
+    }
+    LeitorReplay leitor;
+    if (replayCarregar(&leitor, argv[2]) != 0) {
+        printf("[ERRO]: '%s' não é um replay válido.\n", argv[2]);
+        return 1;
+    }
+    EstatisticasReplay e;
+    int resultado = reproduzirReplay(&leitor, &e);
+    printf("--- REPLAY DA FILA DE PEÇAS ---\n");
+    printf("Arquivo: %s | Eventos: %llu (%.2f bits por evento) | Semente: %llu | Capacidade: %u\n", argv[2],
+           (unsigned long long)leitor.cabecalho.eventos,
+           leitor.cabecalho.eventos ? (double)leitor.cabecalho.bits / (double)leitor.cabecalho.eventos : 0.0,
+           (unsigned long long)leitor.cabecalho.semente, leitor.cabecalho.capacidade);
+    replayLiberar(&leitor);
+    if (resultado != 0) {
+        printf("[ERRO]: Replay corrompido ou sem memória para reproduzi-lo.\n");
+        return 1;
+    }
+    printf("Inserções: %llu (%llu com a fila cheia) | Remoções: %llu (%llu com a fila vazia)\n",
+           (unsigned long long)e.insercoes, (unsigned long long)e.recusadas,
+           (unsigned long long)e.remocoes, (unsigned long long)e.vazias);
+    printf("Tempo: %.3f s -> %.0f eventos/s\n", e.segundos, (e.insercoes + e.remocoes) / e.segundos);
+    printf("Sessão reproduzida exatamente: %s", e.divergencias == 0 ? "sim\n" : "NAO");
+    if (e.divergencias != 0) {
+        printf(" (%llu eventos divergentes)\n", (unsigned long long)e.divergencias);
+    }
+    return e.divergencias == 0 ? 0 : 1;
+}
+
 // -------------------------------------------------------------------
 // ------------------------- FUNÇÃO PRINCIPAL ------------------------
 // -------------------------------------------------------------------
 
-int main() {
-    // Inicializa a semente para números aleatórios (usado em gerarPeca)
-    srand(time(NULL));
+/**
+ * @brief "./TetrisStack [--semente N]" abre o simulador; com a mesma semente as
+ * peças saem sempre na mesma ordem. "./TetrisStack --bench-fila [pecas] [lote]"
+ * mede a vazão do anel SPSC entre duas threads, "./TetrisStack --bench-gerador
+ * [pecas] [semente]" mede o gerador de peças e "./TetrisStack --simular ..."
+ * joga sem interface no tabuleiro em bits, com a busca de jogadas em paralelo.
+ * "--gravar arquivo" grava a sessão do jogo; "--replay arquivo" a reproduz e
+ * "--gerar-replay arquivo [eventos] [semente]" grava uma sessão sintética.
+ * "--log arquivo" manda as mensagens de cada operação para o arquivo (veja log.h).
+ */
+int main(int argc, char *argv[]) {
+    if (argc > 1 && strcmp(argv[1], "--bench-fila") == 0) {
+        return executarBenchFila(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-gerador") == 0) {
+        return executarBenchGerador(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--simular") == 0) {
+        return executarSimulacao(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--gerar-replay") == 0) {
+        return executarGerarReplay(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--replay") == 0) {
+        return executarReplay(argc, argv);
+    }
+
+    // Sem semente explícita, cada partida usa o relógio.
+    uint64_t semente = (uint64_t)time(NULL);
+    const char *arquivoGravacao = NULL;
+    const char *arquivoLog = NULL;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--semente") == 0) {
+            semente = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--gravar") == 0) {
+            arquivoGravacao = argv[++i];
+        } else if (strcmp(argv[i], "--log") == 0) {
+            arquivoLog = argv[++i];
+        }
+    }
+    // Com "--log", as mensagens de cada operação vão para o arquivo, gravado em
+    // segundo plano, e a saída padrão fica só com o menu e a fila.
+    if (arquivoLog != NULL && logIniciarArquivo(arquivoLog) != 0) {
+        printf("\n[ERRO]: Não foi possível criar o arquivo de log '%s'.\n", arquivoLog);
+        return 1;
+    }
+    geradorIniciar(&geradorPecas, semente);
+    if (arquivoGravacao != NULL) {
+        if (replayAbrir(&gravadorSessao, arquivoGravacao, semente, CAPACIDADE_MAXIMA) != 0) {
+            printf("\n[ERRO]: Não foi possível criar o arquivo de gravação '%s'.\n", arquivoGravacao);
+            return 1;
+        }
+        gravandoSessao = 1;
+    }
     
     int opcao;
     
-    // 1. Inicialização da fila de peças
+    // 1. Inicialização da fila de peças e da thread que gera as peças
+    pthread_t geradora;
+    if (anelIniciar(&filaPecas, CAPACIDADE_MAXIMA) != 0 || anelIniciar(&reservaPecas, RESERVA_PECAS) != 0 ||
+        sem_init(&pedidosGeracao, 0, 0) != 0) {
+        printf("\n[ERRO]: Não foi possível preparar a fila de peças.\n");
+        return 1;
+    }
     inicializarFila();
+    if (pthread_create(&geradora, NULL, threadGeradora, NULL) != 0) {
+        printf("\n[ERRO]: Não foi possível iniciar a geração de peças.\n");
+        return 1;
+    }
     exibirFila();
     
     // 2. Loop principal de interação
     do {
         exibirMenu();
         
-        // Verifica se a leitura da opção foi bem sucedida
-        if (scanf("%d", &opcao) != 1) {
-            printf("\n[AVISO]: Entrada inválida. Tente novamente.\n");
-            // Limpa o buffer de entrada para evitar loop infinito em caso de erro
-            while (getchar() != '\n'); 
+        // Verifica se a leitura da opção foi bem sucedida; o fim da entrada
+        // (uma sessão redirecionada que acabou) encerra o jogo como a opção 0.
+        int lido = entradaInteiro(&entradaPadrao, &opcao);
+        if (lido < 0) {
+            opcao = 0;
+        } else if (lido == 0) {
+            // A leitura já descartou o resto da linha inválida
+            registrarAviso("\n[AVISO]: Entrada inválida. Tente novamente.\n");
             continue;
         }
         
@@ -210,18 +1865,16 @@ int main() {
                 desenfileirar();
                 break;
                 
-            case 2: { // Inserir Nova Peça (Enqueue)
-                Peca nova = gerarPeca();
-                enfileirar(nova);
+            case 2: // Inserir Nova Peça (Enqueue), gerada pela thread geradora
+                solicitarPecas(1);
                 break;
-            }
                 
             case 0: // Sair
                 printf("\n>> 🚪 Saindo do Tetris Stack Simulator. Até mais!\n");
                 break;
                 
             default: // Opção Inválida
-                printf("\n[AVISO]: Opção desconhecida. Por favor, escolha 0, 1 ou 2.\n");
+                registrarAviso("\n[AVISO]: Opção desconhecida. Por favor, escolha 0, 1 ou 2.\n");
         }
         
         // Exibe o estado da fila após cada ação, exceto ao sair
@@ -231,5 +1884,19 @@ int main() {
         
     } while (opcao != 0);
 
+    atomic_store(&encerrarGeracao, 1);
+    sem_post(&pedidosGeracao);
+    pthread_join(geradora, NULL);
+    logEncerrar();
+    anelLiberar(&filaPecas);
+    anelLiberar(&reservaPecas);
+    if (gravandoSessao) {
+        unsigned long long eventos = (unsigned long long)gravadorSessao.cabecalho.eventos;
+        if (replayFechar(&gravadorSessao) != 0) {
+            printf("\n[ERRO]: Falha ao salvar a gravação em '%s'.\n", arquivoGravacao);
+            return 1;
+        }
+        printf(">> 💾 Sessão gravada em '%s' (%llu eventos).\n", arquivoGravacao, eventos);
+    }
     return 0;
 }
\ No newline at end of file
@@ -1,11 +1,34 @@
+// Compilação: gcc -O2 -pthread War.c -o War -lm
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <math.h>
+#include "entrada.h"
+#include "log.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LOTE_SIMD_X86 1
+#endif
 
 // --- Constantes ---
 // Documentação: Usar uma constante torna o código mais fácil de manter.
-// Se quisermos mudar o número de territórios, alteramos em um só lugar.
+// Número de territórios pedidos no cadastro interativo. O mapa em si não tem
+// tamanho fixo: ele cresce conforme os territórios são adicionados.
 #define NUM_TERRITORIOS 5
 
+// Documentação: Limites das regras de batalha. Cada lado rola no máximo 3 dados;
+// o atacante precisa deixar 1 tropa para trás, então só ataca com 2 ou mais.
+#define MAX_DADOS 3
+#define MAX_THREADS 256
+
 // --- Requisito: Criação da struct ---
 // Documentação: A struct 'Territorio' é definida para armazenar os dados de cada
 // território do jogo. Ela agrupa três informações: o nome do território (uma string),
@@ -16,44 +39,3306 @@ struct Territorio {
     int tropas;
 };
 
-// --- Função para limpar o buffer de entrada ---
-// Documentação: Esta função consome todos os caracteres restantes no buffer de entrada
-// até encontrar uma nova linha ('\n') ou o fim do arquivo (EOF). É crucial para
-// evitar que leituras anteriores (como um scanf("%d")) interfiram nas próximas
-// leituras de texto (com fgets).
-void limpar_buffer() {
-    int c;
-    while ((c = getchar()) != '\n' && c != EOF);
+// --- Gerador de números aleatórios por thread ---
+// Documentação: O rand() da libc tem um único estado global, compartilhado por
+// todas as threads. Cada thread do simulador usa seu próprio gerador xoshiro256**,
+// semeado a partir de uma semente explícita; assim os resultados são reproduzíveis
+// e não há disputa de memória entre os núcleos.
+typedef struct {
+    uint64_t s[4];
+} GeradorAleatorio;
+
+// Documentação: splitmix64 espalha uma semente simples (ex: 42) pelos 256 bits do
+// estado do xoshiro, evitando estados iniciais ruins como "tudo zero".
+static uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+void gerador_semear(GeradorAleatorio *g, uint64_t semente) {
+    for (int i = 0; i < 4; i++) {
+        g->s[i] = splitmix64(&semente);
+    }
+}
+
+static inline uint64_t rotl64(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t gerador_proximo(GeradorAleatorio *g) {
+    uint64_t *s = g->s;
+    uint64_t resultado = rotl64(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl64(s[3], 45);
+    return resultado;
+}
+
+// Documentação: Converte 32 bits aleatórios em um dado de 1 a 6 por multiplicação,
+// sem o viés e sem a divisão do operador módulo.
+static inline int rolar_dado(GeradorAleatorio *g) {
+    return (int)(((gerador_proximo(g) >> 32) * 6) >> 32) + 1;
+}
+
+// --- Regras de batalha ---
+// Documentação: Uma rodada segue as regras do nível Aventureiro: o atacante rola
+// até 3 dados (tropas - 1) e o defensor até 3 dados (tropas). Os dados são ordenados
+// do maior para o menor e comparados em pares; cada par vencido pelo atacante tira
+// 1 tropa do defensor, cada par perdido tira 1 tropa do atacante. Empates favorecem
+// o atacante.
+static void ordenar_dados(int *dados, int n) {
+    for (int i = 1; i < n; i++) {
+        int valor = dados[i];
+        int j = i - 1;
+        while (j >= 0 && dados[j] < valor) {
+            dados[j + 1] = dados[j];
+            j--;
+        }
+        dados[j + 1] = valor;
+    }
+}
+
+void resolver_rodada(int *tropas_atacante, int *tropas_defensor, GeradorAleatorio *g) {
+    int dados_atq[MAX_DADOS], dados_def[MAX_DADOS];
+    int n_atq = *tropas_atacante - 1;
+    int n_def = *tropas_defensor;
+    if (n_atq > MAX_DADOS) n_atq = MAX_DADOS;
+    if (n_def > MAX_DADOS) n_def = MAX_DADOS;
+
+    for (int i = 0; i < n_atq; i++) dados_atq[i] = rolar_dado(g);
+    for (int i = 0; i < n_def; i++) dados_def[i] = rolar_dado(g);
+    ordenar_dados(dados_atq, n_atq);
+    ordenar_dados(dados_def, n_def);
+
+    int pares = n_atq < n_def ? n_atq : n_def;
+    for (int i = 0; i < pares; i++) {
+        if (dados_atq[i] >= dados_def[i]) {
+            (*tropas_defensor)--;
+        } else {
+            (*tropas_atacante)--;
+        }
+    }
+}
+
+// Documentação: Resolve um ataque completo, rodada após rodada, até o defensor
+// perder todas as tropas ou o atacante ficar com apenas 1. Em caso de conquista o
+// território defensor passa para a cor do atacante e recebe 1 tropa de ocupação.
+// Retorna 1 se houve conquista e 0 caso contrário.
+int resolver_batalha(struct Territorio *atacante, struct Territorio *defensor, GeradorAleatorio *g) {
+    while (atacante->tropas > 1 && defensor->tropas > 0) {
+        resolver_rodada(&atacante->tropas, &defensor->tropas, g);
+    }
+    if (defensor->tropas > 0) {
+        return 0;
+    }
+    strcpy(defensor->cor, atacante->cor);
+    defensor->tropas = 1;
+    atacante->tropas--;
+    return 1;
+}
+
+// --- Resolução de batalhas em lote (SIMD) ---
+// Documentação: Para simular muitas batalhas, resolver uma de cada vez deixa a CPU
+// ociosa esperando cada comparação de dados. O lote resolve várias batalhas lado a
+// lado, uma por "pista" de um registrador SIMD (4 no SSE2, 8 no AVX2): todas rolam
+// os dados, ordenam e comparam ao mesmo tempo, até todas terminarem.
+//
+// Para que as três versões (escalar, SSE2 e AVX2) deem resultados idênticos bit a
+// bit, cada batalha tem seu próprio gerador xorshift32 e toda rodada consome
+// exatamente 6 números (3 dados de ataque e depois 3 de defesa), mesmo quando
+// algum lado rola menos dados; os dados que sobram são descartados. Batalhas
+// terminadas deixam de avançar o gerador.
+typedef struct {
+    int32_t *tropas_atacante;   // Entrada e saída
+    int32_t *tropas_defensor;   // Entrada e saída
+    uint32_t *estado;           // Gerador de cada batalha (nunca zero)
+    size_t quantidade;
+} LoteBatalhas;
+
+typedef enum {
+    LOTE_AUTOMATICO,
+    LOTE_ESCALAR,
+    LOTE_SSE2,
+    LOTE_AVX2
+} ImplementacaoLote;
+
+static inline uint32_t xorshift32(uint32_t *x) {
+    uint32_t v = *x;
+    v ^= v << 13;
+    v ^= v >> 17;
+    v ^= v << 5;
+    *x = v;
+    return v;
+}
+
+// Documentação: Dado de 1 a 6 a partir dos 16 bits altos, por multiplicação.
+static inline int32_t dado_do_sorteio(uint32_t x) {
+    return (int32_t)(((x >> 16) * 6) >> 16) + 1;
+}
+
+void resolver_lote_escalar(LoteBatalhas *lote, size_t inicio) {
+    for (size_t i = inicio; i < lote->quantidade; i++) {
+        int32_t atq = lote->tropas_atacante[i];
+        int32_t def = lote->tropas_defensor[i];
+        uint32_t estado = lote->estado[i];
+        while (atq > 1 && def > 0) {
+            int32_t a[3], d[3];
+            int n_atq = atq - 1 < 3 ? atq - 1 : 3;
+            int n_def = def < 3 ? def : 3;
+            for (int k = 0; k < 3; k++) a[k] = dado_do_sorteio(xorshift32(&estado));
+            for (int k = 0; k < 3; k++) d[k] = dado_do_sorteio(xorshift32(&estado));
+            for (int k = 0; k < 3; k++) {
+                if (k >= n_atq) a[k] = 0;
+                if (k >= n_def) d[k] = 0;
+            }
+            ordenar_dados(a, 3);
+            ordenar_dados(d, 3);
+            int pares = n_atq < n_def ? n_atq : n_def;
+            for (int k = 0; k < pares; k++) {
+                if (a[k] >= d[k]) {
+                    def--;
+                } else {
+                    atq--;
+                }
+            }
+        }
+        lote->tropas_atacante[i] = atq;
+        lote->tropas_defensor[i] = def;
+        lote->estado[i] = estado;
+    }
+}
+
+#ifdef LOTE_SIMD_X86
+// Os dados valem de 0 a 6, então max/min de 16 bits (SSE2) servem para pistas de 32 bits.
+static inline __m128i sse2_min_epi32(__m128i a, __m128i b) {
+    __m128i a_maior = _mm_cmpgt_epi32(a, b);
+    return _mm_or_si128(_mm_and_si128(a_maior, b), _mm_andnot_si128(a_maior, a));
+}
+
+static inline __m128i sse2_xorshift32(__m128i *x) {
+    __m128i v = *x;
+    v = _mm_xor_si128(v, _mm_slli_epi32(v, 13));
+    v = _mm_xor_si128(v, _mm_srli_epi32(v, 17));
+    v = _mm_xor_si128(v, _mm_slli_epi32(v, 5));
+    *x = v;
+    return v;
+}
+
+static inline __m128i sse2_dado(__m128i sorteio) {
+    // mulhi_epu16 calcula (16 bits * 6) >> 16 em cada metade; a metade alta é o dado.
+    __m128i produto = _mm_mulhi_epu16(sorteio, _mm_set1_epi16(6));
+    return _mm_add_epi32(_mm_srli_epi32(produto, 16), _mm_set1_epi32(1));
+}
+
+static inline void sse2_ordenar3(__m128i *a, __m128i *b, __m128i *c) {
+    __m128i t;
+    t = _mm_max_epi16(*a, *b); *b = _mm_min_epi16(*a, *b); *a = t;
+    t = _mm_max_epi16(*b, *c); *c = _mm_min_epi16(*b, *c); *b = t;
+    t = _mm_max_epi16(*a, *b); *b = _mm_min_epi16(*a, *b); *a = t;
+}
+
+void resolver_lote_sse2(LoteBatalhas *lote) {
+    const __m128i um = _mm_set1_epi32(1), zero = _mm_setzero_si128();
+    const __m128i tres = _mm_set1_epi32(3), dois = _mm_set1_epi32(2);
+    size_t i = 0;
+    for (; i + 4 <= lote->quantidade; i += 4) {
+        __m128i atq = _mm_loadu_si128((const __m128i *)&lote->tropas_atacante[i]);
+        __m128i def = _mm_loadu_si128((const __m128i *)&lote->tropas_defensor[i]);
+        __m128i estado = _mm_loadu_si128((const __m128i *)&lote->estado[i]);
+        for (;;) {
+            __m128i ativa = _mm_and_si128(_mm_cmpgt_epi32(atq, um), _mm_cmpgt_epi32(def, zero));
+            if (_mm_movemask_epi8(ativa) == 0) break;
+
+            __m128i novo = estado;
+            __m128i a0 = sse2_dado(sse2_xorshift32(&novo));
+            __m128i a1 = sse2_dado(sse2_xorshift32(&novo));
+            __m128i a2 = sse2_dado(sse2_xorshift32(&novo));
+            __m128i d0 = sse2_dado(sse2_xorshift32(&novo));
+            __m128i d1 = sse2_dado(sse2_xorshift32(&novo));
+            __m128i d2 = sse2_dado(sse2_xorshift32(&novo));
+            estado = _mm_or_si128(_mm_and_si128(ativa, novo), _mm_andnot_si128(ativa, estado));
+
+            __m128i n_atq = sse2_min_epi32(_mm_sub_epi32(atq, um), tres);
+            __m128i n_def = sse2_min_epi32(def, tres);
+            a1 = _mm_and_si128(a1, _mm_cmpgt_epi32(n_atq, um));
+            a2 = _mm_and_si128(a2, _mm_cmpgt_epi32(n_atq, dois));
+            d1 = _mm_and_si128(d1, _mm_cmpgt_epi32(n_def, um));
+            d2 = _mm_and_si128(d2, _mm_cmpgt_epi32(n_def, dois));
+            sse2_ordenar3(&a0, &a1, &a2);
+            sse2_ordenar3(&d0, &d1, &d2);
+
+            // Máscaras valem -1: somar "defensor venceu o par" tira 1 tropa do atacante.
+            __m128i pares = sse2_min_epi32(n_atq, n_def);
+            __m128i v0 = _mm_and_si128(ativa, _mm_cmpgt_epi32(pares, zero));
+            __m128i v1 = _mm_and_si128(ativa, _mm_cmpgt_epi32(pares, um));
+            __m128i v2 = _mm_and_si128(ativa, _mm_cmpgt_epi32(pares, dois));
+            __m128i p0 = _mm_cmpgt_epi32(d0, a0);
+            __m128i p1 = _mm_cmpgt_epi32(d1, a1);
+            __m128i p2 = _mm_cmpgt_epi32(d2, a2);
+            atq = _mm_add_epi32(atq, _mm_and_si128(v0, p0));
+            atq = _mm_add_epi32(atq, _mm_and_si128(v1, p1));
+            atq = _mm_add_epi32(atq, _mm_and_si128(v2, p2));
+            def = _mm_add_epi32(def, _mm_andnot_si128(p0, v0));
+            def = _mm_add_epi32(def, _mm_andnot_si128(p1, v1));
+            def = _mm_add_epi32(def, _mm_andnot_si128(p2, v2));
+        }
+        _mm_storeu_si128((__m128i *)&lote->tropas_atacante[i], atq);
+        _mm_storeu_si128((__m128i *)&lote->tropas_defensor[i], def);
+        _mm_storeu_si128((__m128i *)&lote->estado[i], estado);
+    }
+    resolver_lote_escalar(lote, i);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i avx2_xorshift32(__m256i *x) {
+    __m256i v = *x;
+    v = _mm256_xor_si256(v, _mm256_slli_epi32(v, 13));
+    v = _mm256_xor_si256(v, _mm256_srli_epi32(v, 17));
+    v = _mm256_xor_si256(v, _mm256_slli_epi32(v, 5));
+    *x = v;
+    return v;
+}
+
+__attribute__((target("avx2")))
+static inline __m256i avx2_dado(__m256i sorteio) {
+    __m256i produto = _mm256_mulhi_epu16(sorteio, _mm256_set1_epi16(6));
+    return _mm256_add_epi32(_mm256_srli_epi32(produto, 16), _mm256_set1_epi32(1));
+}
+
+__attribute__((target("avx2")))
+static inline void avx2_ordenar3(__m256i *a, __m256i *b, __m256i *c) {
+    __m256i t;
+    t = _mm256_max_epi32(*a, *b); *b = _mm256_min_epi32(*a, *b); *a = t;
+    t = _mm256_max_epi32(*b, *c); *c = _mm256_min_epi32(*b, *c); *b = t;
+    t = _mm256_max_epi32(*a, *b); *b = _mm256_min_epi32(*a, *b); *a = t;
+}
+
+__attribute__((target("avx2")))
+void resolver_lote_avx2(LoteBatalhas *lote) {
+    const __m256i um = _mm256_set1_epi32(1), zero = _mm256_setzero_si256();
+    const __m256i tres = _mm256_set1_epi32(3), dois = _mm256_set1_epi32(2);
+    size_t i = 0;
+    for (; i + 8 <= lote->quantidade; i += 8) {
+        __m256i atq = _mm256_loadu_si256((const __m256i *)&lote->tropas_atacante[i]);
+        __m256i def = _mm256_loadu_si256((const __m256i *)&lote->tropas_defensor[i]);
+        __m256i estado = _mm256_loadu_si256((const __m256i *)&lote->estado[i]);
+        for (;;) {
+            __m256i ativa = _mm256_and_si256(_mm256_cmpgt_epi32(atq, um), _mm256_cmpgt_epi32(def, zero));
+            if (_mm256_movemask_epi8(ativa) == 0) break;
+
+            __m256i novo = estado;
+            __m256i a0 = avx2_dado(avx2_xorshift32(&novo));
+            __m256i a1 = avx2_dado(avx2_xorshift32(&novo));
+            __m256i a2 = avx2_dado(avx2_xorshift32(&novo));
+            __m256i d0 = avx2_dado(avx2_xorshift32(&novo));
+            __m256i d1 = avx2_dado(avx2_xorshift32(&novo));
+            __m256i d2 = avx2_dado(avx2_xorshift32(&novo));
+            estado = _mm256_blendv_epi8(estado, novo, ativa);
+
+            __m256i n_atq = _mm256_min_epi32(_mm256_sub_epi32(atq, um), tres);
+            __m256i n_def = _mm256_min_epi32(def, tres);
+            a1 = _mm256_and_si256(a1, _mm256_cmpgt_epi32(n_atq, um));
+            a2 = _mm256_and_si256(a2, _mm256_cmpgt_epi32(n_atq, dois));
+            d1 = _mm256_and_si256(d1, _mm256_cmpgt_epi32(n_def, um));
+            d2 = _mm256_and_si256(d2, _mm256_cmpgt_epi32(n_def, dois));
+            avx2_ordenar3(&a0, &a1, &a2);
+            avx2_ordenar3(&d0, &d1, &d2);
+
+            __m256i pares = _mm256_min_epi32(n_atq, n_def);
+            __m256i v0 = _mm256_and_si256(ativa, _mm256_cmpgt_epi32(pares, zero));
+            __m256i v1 = _mm256_and_si256(ativa, _mm256_cmpgt_epi32(pares, um));
+            __m256i v2 = _mm256_and_si256(ativa, _mm256_cmpgt_epi32(pares, dois));
+            __m256i p0 = _mm256_cmpgt_epi32(d0, a0);
+            __m256i p1 = _mm256_cmpgt_epi32(d1, a1);
+            __m256i p2 = _mm256_cmpgt_epi32(d2, a2);
+            atq = _mm256_add_epi32(atq, _mm256_and_si256(v0, p0));
+            atq = _mm256_add_epi32(atq, _mm256_and_si256(v1, p1));
+            atq = _mm256_add_epi32(atq, _mm256_and_si256(v2, p2));
+            def = _mm256_add_epi32(def, _mm256_andnot_si256(p0, v0));
+            def = _mm256_add_epi32(def, _mm256_andnot_si256(p1, v1));
+            def = _mm256_add_epi32(def, _mm256_andnot_si256(p2, v2));
+        }
+        _mm256_storeu_si256((__m256i *)&lote->tropas_atacante[i], atq);
+        _mm256_storeu_si256((__m256i *)&lote->tropas_defensor[i], def);
+        _mm256_storeu_si256((__m256i *)&lote->estado[i], estado);
+    }
+    resolver_lote_escalar(lote, i);
+}
+#endif
+
+// Documentação: Resolve todas as batalhas do lote com a implementação pedida. No
+// modo automático usa a melhor que a CPU suporta. Retorna a implementação usada.
+ImplementacaoLote resolver_lote(LoteBatalhas *lote, ImplementacaoLote implementacao) {
+#ifdef LOTE_SIMD_X86
+    if (implementacao == LOTE_AUTOMATICO) {
+        implementacao = __builtin_cpu_supports("avx2") ? LOTE_AVX2 : LOTE_SSE2;
+    }
+    if (implementacao == LOTE_AVX2 && __builtin_cpu_supports("avx2")) {
+        resolver_lote_avx2(lote);
+        return LOTE_AVX2;
+    }
+    if (implementacao == LOTE_SSE2) {
+        resolver_lote_sse2(lote);
+        return LOTE_SSE2;
+    }
+#endif
+    resolver_lote_escalar(lote, 0);
+    return LOTE_ESCALAR;
+}
+
+// Documentação: Semeia os geradores do lote a partir de um xoshiro; o xorshift32
+// não pode começar em zero.
+void lote_semear(LoteBatalhas *lote, GeradorAleatorio *g) {
+    for (size_t i = 0; i < lote->quantidade; i++) {
+        uint32_t s = (uint32_t)(gerador_proximo(g) >> 32);
+        lote->estado[i] = s ? s : 1;
+    }
+}
+
+// --- Simulador Monte Carlo (modo não interativo) ---
+// Documentação: Estima, para cada combinação de tropas (atacante x defensor), a
+// probabilidade de conquista e as perdas esperadas de cada lado. Cada thread
+// resolve sua parte das batalhas de todas as células da tabela com o próprio
+// gerador e acumulos privados; o resultado é somado no final, sem locks. As
+// batalhas de cada célula são resolvidas em lotes pelo kernel SIMD.
+#define TAMANHO_LOTE_SIMULACAO 1024
+typedef struct {
+    uint64_t vitorias;
+    uint64_t perdas_atacante;
+    uint64_t perdas_defensor;
+} AcumuloCelula;
+
+typedef struct {
+    int max_atacante;          // Tropas do atacante variam de 2 até este valor
+    int max_defensor;          // Tropas do defensor variam de 1 até este valor
+    uint64_t batalhas;         // Batalhas desta thread em cada célula
+    uint64_t semente;
+    ImplementacaoLote implementacao;
+    AcumuloCelula *celulas;    // (max_atacante - 1) * max_defensor células
+} TarefaSimulacao;
+
+static void *executar_tarefa_simulacao(void *arg) {
+    TarefaSimulacao *tarefa = (TarefaSimulacao *)arg;
+    GeradorAleatorio g;
+    gerador_semear(&g, tarefa->semente);
+
+    int32_t atacantes[TAMANHO_LOTE_SIMULACAO];
+    int32_t defensores[TAMANHO_LOTE_SIMULACAO];
+    uint32_t estados[TAMANHO_LOTE_SIMULACAO];
+
+    for (int a = 2; a <= tarefa->max_atacante; a++) {
+        for (int d = 1; d <= tarefa->max_defensor; d++) {
+            AcumuloCelula acc = {0, 0, 0};
+            for (uint64_t b = 0; b < tarefa->batalhas; b += TAMANHO_LOTE_SIMULACAO) {
+                uint64_t restantes = tarefa->batalhas - b;
+                LoteBatalhas lote = {atacantes, defensores, estados,
+                                     restantes < TAMANHO_LOTE_SIMULACAO ? restantes : TAMANHO_LOTE_SIMULACAO};
+                for (size_t i = 0; i < lote.quantidade; i++) {
+                    atacantes[i] = a;
+                    defensores[i] = d;
+                }
+                lote_semear(&lote, &g);
+                resolver_lote(&lote, tarefa->implementacao);
+                for (size_t i = 0; i < lote.quantidade; i++) {
+                    acc.vitorias += defensores[i] == 0;
+                    acc.perdas_atacante += (uint64_t)(a - atacantes[i]);
+                    acc.perdas_defensor += (uint64_t)(d - defensores[i]);
+                }
+            }
+            tarefa->celulas[(a - 2) * tarefa->max_defensor + (d - 1)] = acc;
+        }
+    }
+    return NULL;
+}
+
+static double segundos_agora() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static int numero_de_nucleos() {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+void imprimir_tabela(const char *titulo, const AcumuloCelula *total, int max_atacante,
+                     int max_defensor, uint64_t batalhas, int campo) {
+    printf("\n%s\n", titulo);
+    printf("ATQ\\DEF");
+    for (int d = 1; d <= max_defensor; d++) {
+        printf(" %7d", d);
+    }
+    printf("\n");
+    for (int a = 2; a <= max_atacante; a++) {
+        printf("%7d", a);
+        for (int d = 1; d <= max_defensor; d++) {
+            const AcumuloCelula *c = &total[(a - 2) * max_defensor + (d - 1)];
+            uint64_t valor = campo == 0 ? c->vitorias
+                           : campo == 1 ? c->perdas_atacante
+                                        : c->perdas_defensor;
+            double media = (double)valor / (double)batalhas;
+            if (campo == 0) {
+                printf(" %6.2f%%", media * 100.0);
+            } else {
+                printf(" %7.3f", media);
+            }
+        }
+        printf("\n");
+    }
+}
+
+int simular_batalhas(int max_atacante, int max_defensor, uint64_t batalhas_por_celula,
+                     int num_threads, uint64_t semente) {
+    int num_celulas = (max_atacante - 1) * max_defensor;
+    pthread_t threads[MAX_THREADS];
+    TarefaSimulacao tarefas[MAX_THREADS];
+
+    AcumuloCelula *acumulos = calloc((size_t)num_threads * num_celulas, sizeof(AcumuloCelula));
+    AcumuloCelula *total = calloc((size_t)num_celulas, sizeof(AcumuloCelula));
+    if (acumulos == NULL || total == NULL) {
+        printf("[ERRO] Falha na alocação de memória para a simulação.\n");
+        free(acumulos);
+        free(total);
+        return 1;
+    }
+
+    printf("--- SIMULAÇÃO MONTE CARLO DE BATALHAS ---\n");
+    printf("Atacante: 2..%d tropas | Defensor: 1..%d tropas\n", max_atacante, max_defensor);
+    printf("Batalhas por célula: %llu | Threads: %d | Semente: %llu\n",
+           (unsigned long long)batalhas_por_celula, num_threads, (unsigned long long)semente);
+
+    // Cada thread recebe uma semente derivada da semente principal.
+    uint64_t gerador_sementes = semente;
+    double inicio = segundos_agora();
+    for (int t = 0; t < num_threads; t++) {
+        tarefas[t].max_atacante = max_atacante;
+        tarefas[t].max_defensor = max_defensor;
+        tarefas[t].batalhas = batalhas_por_celula / num_threads
+                            + ((uint64_t)t < batalhas_por_celula % num_threads ? 1 : 0);
+        tarefas[t].semente = splitmix64(&gerador_sementes);
+        tarefas[t].implementacao = LOTE_AUTOMATICO;
+        tarefas[t].celulas = &acumulos[(size_t)t * num_celulas];
+    }
+    int criadas = 0;
+    while (criadas < num_threads &&
+           pthread_create(&threads[criadas], NULL, executar_tarefa_simulacao, &tarefas[criadas]) == 0) {
+        criadas++;
+    }
+    if (criadas < num_threads) {
+        // As fatias que ficaram sem thread rodam aqui, para a tabela continuar completa.
+        printf("[ALERTA] Só foi possível criar %d de %d threads; o restante roda na thread principal.\n",
+               criadas, num_threads);
+        for (int t = criadas; t < num_threads; t++) {
+            executar_tarefa_simulacao(&tarefas[t]);
+        }
+    }
+    for (int t = 0; t < criadas; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    double duracao = segundos_agora() - inicio;
+
+    for (int t = 0; t < num_threads; t++) {
+        for (int c = 0; c < num_celulas; c++) {
+            total[c].vitorias += acumulos[(size_t)t * num_celulas + c].vitorias;
+            total[c].perdas_atacante += acumulos[(size_t)t * num_celulas + c].perdas_atacante;
+            total[c].perdas_defensor += acumulos[(size_t)t * num_celulas + c].perdas_defensor;
+        }
+    }
+
+    imprimir_tabela("Probabilidade de conquista:", total, max_atacante, max_defensor,
+                    batalhas_por_celula, 0);
+    imprimir_tabela("Perdas esperadas do atacante:", total, max_atacante, max_defensor,
+                    batalhas_por_celula, 1);
+    imprimir_tabela("Perdas esperadas do defensor:", total, max_atacante, max_defensor,
+                    batalhas_por_celula, 2);
+
+    double total_batalhas = (double)batalhas_por_celula * num_celulas;
+    printf("\nTotal: %.0f batalhas em %.3f s (%.0f batalhas/s)\n",
+           total_batalhas, duracao, total_batalhas / duracao);
+
+    free(acumulos);
+    free(total);
+    return 0;
+}
+
+// --- Armazenamento colunar dos territórios ---
+// Documentação: Em vez de um vetor fixo de 'struct Territorio' (44 bytes cada, com
+// nome e cor repetidos dentro de cada elemento), o mapa guarda cada campo em seu
+// próprio vetor contíguo e cresce conforme a necessidade:
+//   - tropas: vetor de int, percorrido sequencialmente nas varreduras do mapa;
+//   - cor: id de 1 byte, indexando a tabela de cores internadas;
+//   - nome: deslocamento de 4 bytes dentro de um pool único de strings.
+// Varreduras como "tropas por cor" tocam só 5 bytes por território.
+#define MAX_CORES 256
+#define TAM_COR 10
+#define TAM_NOME 30
+
+// Documentação: Fronteiras entre territórios em formato CSR (compressed sparse row):
+// os vizinhos do território 'v' ficam em vizinhos[inicio[v] .. inicio[v + 1] - 1].
+// Cada fronteira aparece nas duas direções. Territórios adicionados depois da
+// construção do grafo (v >= num_vertices) ficam sem fronteiras.
+typedef struct {
+    uint32_t num_vertices;
+    uint64_t num_arestas;       // Entradas em 'vizinhos' (2 por fronteira)
+    uint64_t *inicio;           // num_vertices + 1 posições
+    uint32_t *vizinhos;
+} GrafoFronteiras;
+
+typedef struct {
+    size_t quantidade;          // Número de territórios cadastrados
+    size_t capacidade;          // Espaço alocado nos vetores colunares
+    int *tropas;
+    uint8_t *cor;
+    uint32_t *nome;
+    char *pool_nomes;           // Nomes terminados em '\0', um após o outro
+    size_t pool_tamanho;
+    size_t pool_capacidade;
+    char cores[MAX_CORES][TAM_COR];
+    int num_cores;
+    GrafoFronteiras fronteiras;
+    void *mapeamento;           // Snapshot mapeado em memória (NULL se tudo está no heap)
+    size_t tamanho_mapeamento;
+} MapaTerritorios;
+
+void mapa_inicializar(MapaTerritorios *mapa) {
+    memset(mapa, 0, sizeof(*mapa));
+}
+
+void mapa_liberar(MapaTerritorios *mapa) {
+    if (mapa->mapeamento != NULL) {
+        // Os vetores apontam para dentro do arquivo mapeado: basta desfazer o mapeamento.
+        munmap(mapa->mapeamento, mapa->tamanho_mapeamento);
+    } else {
+        free(mapa->tropas);
+        free(mapa->cor);
+        free(mapa->nome);
+        free(mapa->pool_nomes);
+        free(mapa->fronteiras.inicio);
+        free(mapa->fronteiras.vizinhos);
+    }
+    mapa_inicializar(mapa);
+}
+
+static void *duplicar_memoria(const void *origem, size_t tamanho) {
+    void *copia = malloc(tamanho ? tamanho : 1);
+    if (copia != NULL) {
+        memcpy(copia, origem, tamanho);
+    }
+    return copia;
+}
+
+// Documentação: Um mapa carregado de snapshot usa os vetores direto do arquivo
+// mapeado, que não podem ser realocados. Antes de crescer, os vetores são copiados
+// para o heap e o mapeamento é desfeito. Retorna 0 em sucesso.
+static int mapa_materializar(MapaTerritorios *mapa) {
+    if (mapa->mapeamento == NULL) {
+        return 0;
+    }
+    int *tropas = duplicar_memoria(mapa->tropas, mapa->quantidade * sizeof(int));
+    uint8_t *cor = duplicar_memoria(mapa->cor, mapa->quantidade * sizeof(uint8_t));
+    uint32_t *nome = duplicar_memoria(mapa->nome, mapa->quantidade * sizeof(uint32_t));
+    char *pool = duplicar_memoria(mapa->pool_nomes, mapa->pool_tamanho);
+    GrafoFronteiras *g = &mapa->fronteiras;
+    uint64_t *inicio = NULL;
+    uint32_t *vizinhos = NULL;
+    if (g->num_vertices > 0) {
+        inicio = duplicar_memoria(g->inicio, ((size_t)g->num_vertices + 1) * sizeof(uint64_t));
+        vizinhos = duplicar_memoria(g->vizinhos, g->num_arestas * sizeof(uint32_t));
+    }
+    if (tropas == NULL || cor == NULL || nome == NULL || pool == NULL
+        || (g->num_vertices > 0 && (inicio == NULL || vizinhos == NULL))) {
+        free(tropas);
+        free(cor);
+        free(nome);
+        free(pool);
+        free(inicio);
+        free(vizinhos);
+        return -1;
+    }
+    g->inicio = inicio;
+    g->vizinhos = vizinhos;
+    munmap(mapa->mapeamento, mapa->tamanho_mapeamento);
+    mapa->mapeamento = NULL;
+    mapa->tamanho_mapeamento = 0;
+    mapa->tropas = tropas;
+    mapa->cor = cor;
+    mapa->nome = nome;
+    mapa->pool_nomes = pool;
+    return 0;
+}
+
+// Documentação: Garante espaço para pelo menos 'minimo' territórios, dobrando a
+// capacidade para que o custo das realocações seja amortizado. Retorna 0 em sucesso.
+int mapa_reservar(MapaTerritorios *mapa, size_t minimo) {
+    if (minimo <= mapa->capacidade) {
+        return 0;
+    }
+    if (mapa_materializar(mapa) != 0) {
+        return -1;
+    }
+    size_t nova = mapa->capacidade ? mapa->capacidade : 16;
+    while (nova < minimo) {
+        nova *= 2;
+    }
+    int *tropas = realloc(mapa->tropas, nova * sizeof(int));
+    if (tropas == NULL) return -1;
+    mapa->tropas = tropas;
+    uint8_t *cor = realloc(mapa->cor, nova * sizeof(uint8_t));
+    if (cor == NULL) return -1;
+    mapa->cor = cor;
+    uint32_t *nome = realloc(mapa->nome, nova * sizeof(uint32_t));
+    if (nome == NULL) return -1;
+    mapa->nome = nome;
+    mapa->capacidade = nova;
+    return 0;
+}
+
+// Documentação: Devolve o id da cor, cadastrando-a na primeira vez em que aparece.
+// Retorna -1 se a tabela de cores estiver cheia.
+int mapa_internar_cor(MapaTerritorios *mapa, const char *cor) {
+    for (int i = 0; i < mapa->num_cores; i++) {
+        if (strncmp(mapa->cores[i], cor, TAM_COR - 1) == 0) {
+            return i;
+        }
+    }
+    if (mapa->num_cores >= MAX_CORES) {
+        return -1;
+    }
+    strncpy(mapa->cores[mapa->num_cores], cor, TAM_COR - 1);
+    mapa->cores[mapa->num_cores][TAM_COR - 1] = '\0';
+    return mapa->num_cores++;
+}
+
+static int pool_adicionar(MapaTerritorios *mapa, const char *texto, uint32_t *deslocamento) {
+    size_t tamanho = strnlen(texto, TAM_NOME - 1);
+    if (mapa->pool_tamanho + tamanho + 1 > UINT32_MAX) {
+        return -1;
+    }
+    if (mapa->pool_tamanho + tamanho + 1 > mapa->pool_capacidade) {
+        if (mapa_materializar(mapa) != 0) return -1;
+        size_t nova = mapa->pool_capacidade ? mapa->pool_capacidade : 256;
+        while (nova < mapa->pool_tamanho + tamanho + 1) {
+            nova *= 2;
+        }
+        char *pool = realloc(mapa->pool_nomes, nova);
+        if (pool == NULL) return -1;
+        mapa->pool_nomes = pool;
+        mapa->pool_capacidade = nova;
+    }
+    *deslocamento = (uint32_t)mapa->pool_tamanho;
+    memcpy(mapa->pool_nomes + mapa->pool_tamanho, texto, tamanho);
+    mapa->pool_nomes[mapa->pool_tamanho + tamanho] = '\0';
+    mapa->pool_tamanho += tamanho + 1;
+    return 0;
+}
+
+// Documentação: Acrescenta um território ao mapa e devolve seu índice (ou -1 em
+// caso de falha de memória ou excesso de cores).
+long mapa_adicionar(MapaTerritorios *mapa, const char *nome, const char *cor, int tropas) {
+    // Documentação: As alocações vêm antes de cadastrar a cor, e uma cor nova é
+    // desfeita se o nome não couber: uma falha não deixa cor sem território.
+    if (mapa_reservar(mapa, mapa->quantidade + 1) != 0) {
+        return -1;
+    }
+    int cores_antes = mapa->num_cores;
+    int id_cor = mapa_internar_cor(mapa, cor);
+    uint32_t deslocamento;
+    if (id_cor < 0) {
+        return -1;
+    }
+    if (pool_adicionar(mapa, nome, &deslocamento) != 0) {
+        mapa->num_cores = cores_antes;
+        return -1;
+    }
+    size_t i = mapa->quantidade++;
+    mapa->tropas[i] = tropas;
+    mapa->cor[i] = (uint8_t)id_cor;
+    mapa->nome[i] = deslocamento;
+    return (long)i;
+}
+
+static inline const char *mapa_nome(const MapaTerritorios *mapa, size_t i) {
+    return mapa->pool_nomes + mapa->nome[i];
+}
+
+static inline const char *mapa_cor(const MapaTerritorios *mapa, size_t i) {
+    return mapa->cores[mapa->cor[i]];
+}
+
+// Documentação: Monta uma 'struct Territorio' com a cópia dos dados do território
+// 'i', útil para exibir ou para resolver batalhas com as funções acima.
+void mapa_obter(const MapaTerritorios *mapa, size_t i, struct Territorio *t) {
+    strncpy(t->nome, mapa_nome(mapa, i), sizeof(t->nome) - 1);
+    t->nome[sizeof(t->nome) - 1] = '\0';
+    strncpy(t->cor, mapa_cor(mapa, i), sizeof(t->cor) - 1);
+    t->cor[sizeof(t->cor) - 1] = '\0';
+    t->tropas = mapa->tropas[i];
+}
+
+// Documentação: Soma tropas e territórios por cor em uma única passada sequencial.
+// Quatro tabelas parciais são usadas alternadamente para que territórios vizinhos
+// da mesma cor não fiquem esperando um pelo outro na mesma posição de memória.
+void mapa_tropas_por_cor(const MapaTerritorios *mapa, int64_t tropas[MAX_CORES],
+                         uint32_t territorios[MAX_CORES]) {
+    int64_t parcial_tropas[4][MAX_CORES] = {{0}};
+    uint32_t parcial_territorios[4][MAX_CORES] = {{0}};
+    const int *t = mapa->tropas;
+    const uint8_t *c = mapa->cor;
+    size_t n = mapa->quantidade;
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        parcial_tropas[0][c[i]] += t[i];
+        parcial_tropas[1][c[i + 1]] += t[i + 1];
+        parcial_tropas[2][c[i + 2]] += t[i + 2];
+        parcial_tropas[3][c[i + 3]] += t[i + 3];
+        parcial_territorios[0][c[i]]++;
+        parcial_territorios[1][c[i + 1]]++;
+        parcial_territorios[2][c[i + 2]]++;
+        parcial_territorios[3][c[i + 3]]++;
+    }
+    for (; i < n; i++) {
+        parcial_tropas[0][c[i]] += t[i];
+        parcial_territorios[0][c[i]]++;
+    }
+    for (int k = 0; k < MAX_CORES; k++) {
+        tropas[k] = parcial_tropas[0][k] + parcial_tropas[1][k]
+                  + parcial_tropas[2][k] + parcial_tropas[3][k];
+        territorios[k] = parcial_territorios[0][k] + parcial_territorios[1][k]
+                       + parcial_territorios[2][k] + parcial_territorios[3][k];
+    }
+}
+
+// Documentação: Soma total de tropas do mapa; laço simples sobre um vetor contíguo
+// de int, que o compilador vetoriza.
+int64_t mapa_total_tropas(const MapaTerritorios *mapa) {
+    int64_t total = 0;
+    for (size_t i = 0; i < mapa->quantidade; i++) {
+        total += mapa->tropas[i];
+    }
+    return total;
+}
+
+size_t mapa_bytes_usados(const MapaTerritorios *mapa) {
+    return mapa->quantidade * (sizeof(int) + sizeof(uint8_t) + sizeof(uint32_t))
+         + mapa->pool_tamanho + sizeof(mapa->cores);
+}
+
+// Documentação: Preenche o mapa com 'quantidade' territórios gerados a partir de uma
+// semente, para testes de escala sem precisar digitar nada.
+int mapa_gerar_sintetico(MapaTerritorios *mapa, size_t quantidade, int num_cores, uint64_t semente) {
+    static const char *nomes_cores[] = {"Azul", "Verde", "Vermelho", "Amarelo", "Preto", "Branco"};
+    GeradorAleatorio g;
+    gerador_semear(&g, semente);
+    if (mapa_reservar(mapa, mapa->quantidade + quantidade) != 0) {
+        return -1;
+    }
+    for (size_t i = 0; i < quantidade; i++) {
+        char nome[TAM_NOME];
+        char cor[TAM_COR];
+        int c = (int)(gerador_proximo(&g) % (uint64_t)num_cores);
+        snprintf(nome, sizeof(nome), "T%zu", mapa->quantidade + 1);
+        if (c < 6) {
+            snprintf(cor, sizeof(cor), "%s", nomes_cores[c]);
+        } else {
+            snprintf(cor, sizeof(cor), "Cor%u", (unsigned)(uint8_t)c);
+        }
+        if (mapa_adicionar(mapa, nome, cor, 1 + (int)(gerador_proximo(&g) % 20)) < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void imprimir_resumo_cores(const MapaTerritorios *mapa) {
+    int64_t tropas[MAX_CORES];
+    uint32_t territorios[MAX_CORES];
+    mapa_tropas_por_cor(mapa, tropas, territorios);
+    printf("%-10s %12s %14s\n", "COR", "TERRITÓRIOS", "TROPAS");
+    for (int c = 0; c < mapa->num_cores; c++) {
+        printf("%-10s %12u %14lld\n", mapa->cores[c], territorios[c], (long long)tropas[c]);
+    }
+}
+
+// --- Grafo de fronteiras ---
+// Documentação: Monta o CSR a partir de uma lista de fronteiras (pares origem,
+// destino) com duas passadas: conta o grau de cada território, acumula os graus
+// em 'inicio' e então distribui os vizinhos. Substitui o grafo anterior do mapa.
+int grafo_construir(MapaTerritorios *mapa, const uint32_t *origens, const uint32_t *destinos,
+                    size_t num_fronteiras) {
+    if (mapa_materializar(mapa) != 0 || mapa->quantidade > UINT32_MAX) {
+        return -1;
+    }
+    uint32_t n = (uint32_t)mapa->quantidade;
+    uint64_t *inicio = calloc((size_t)n + 1, sizeof(uint64_t));
+    uint32_t *vizinhos = malloc((num_fronteiras * 2 + 1) * sizeof(uint32_t));
+    uint64_t *posicao = malloc(((size_t)n + 1) * sizeof(uint64_t));
+    if (inicio == NULL || vizinhos == NULL || posicao == NULL) {
+        free(inicio);
+        free(vizinhos);
+        free(posicao);
+        return -1;
+    }
+
+    for (size_t e = 0; e < num_fronteiras; e++) {
+        if (origens[e] < n && destinos[e] < n && origens[e] != destinos[e]) {
+            inicio[origens[e] + 1]++;
+            inicio[destinos[e] + 1]++;
+        }
+    }
+    for (uint32_t v = 0; v < n; v++) {
+        inicio[v + 1] += inicio[v];
+    }
+    memcpy(posicao, inicio, ((size_t)n + 1) * sizeof(uint64_t));
+    for (size_t e = 0; e < num_fronteiras; e++) {
+        if (origens[e] < n && destinos[e] < n && origens[e] != destinos[e]) {
+            vizinhos[posicao[origens[e]]++] = destinos[e];
+            vizinhos[posicao[destinos[e]]++] = origens[e];
+        }
+    }
+    free(posicao);
+
+    free(mapa->fronteiras.inicio);
+    free(mapa->fronteiras.vizinhos);
+    mapa->fronteiras.num_vertices = n;
+    mapa->fronteiras.num_arestas = inicio[n];
+    mapa->fronteiras.inicio = inicio;
+    mapa->fronteiras.vizinhos = vizinhos;
+    return 0;
+}
+
+static inline uint64_t grafo_grau(const GrafoFronteiras *g, uint32_t v) {
+    return v < g->num_vertices ? g->inicio[v + 1] - g->inicio[v] : 0;
+}
+
+// Documentação: Gera fronteiras de teste: os territórios são dispostos em uma grade
+// (cada um faz fronteira com o da direita e o de baixo) e recebem algumas
+// fronteiras extras aleatórias, como rotas marítimas no tabuleiro do WAR.
+int grafo_gerar_sintetico(MapaTerritorios *mapa, double fracao_extras, uint64_t semente) {
+    size_t n = mapa->quantidade;
+    size_t largura = 1;
+    while (largura * largura < n) {
+        largura++;
+    }
+    size_t extras = (size_t)(fracao_extras * (double)n);
+    size_t maximo = 2 * n + extras;
+    uint32_t *origens = malloc((maximo + 1) * sizeof(uint32_t));
+    uint32_t *destinos = malloc((maximo + 1) * sizeof(uint32_t));
+    if (origens == NULL || destinos == NULL) {
+        free(origens);
+        free(destinos);
+        return -1;
+    }
+
+    size_t m = 0;
+    for (size_t v = 0; v < n; v++) {
+        if ((v + 1) % largura != 0 && v + 1 < n) {
+            origens[m] = (uint32_t)v;
+            destinos[m++] = (uint32_t)(v + 1);
+        }
+        if (v + largura < n) {
+            origens[m] = (uint32_t)v;
+            destinos[m++] = (uint32_t)(v + largura);
+        }
+    }
+    GeradorAleatorio g;
+    gerador_semear(&g, semente);
+    for (size_t e = 0; e < extras && n > 1; e++) {
+        origens[m] = (uint32_t)(gerador_proximo(&g) % n);
+        destinos[m++] = (uint32_t)(gerador_proximo(&g) % n);
+    }
+
+    int resultado = grafo_construir(mapa, origens, destinos, m);
+    free(origens);
+    free(destinos);
+    return resultado;
+}
+
+// --- Equipe de threads para consultas no grafo ---
+// Documentação: As consultas rodam muitas etapas curtas (um nível de BFS, por
+// exemplo). Criar threads a cada etapa custaria mais que o próprio trabalho, então a
+// equipe é criada uma vez e reutilizada: a thread chamadora participa como
+// membro 0 e as demais esperam na barreira pela próxima tarefa. Se o sistema não
+// criar todas as threads pedidas, a equipe fica só com as que subiram.
+typedef void (*TrabalhoEquipe)(void *arg, int id, int num_threads);
+
+typedef struct {
+    struct EquipeThreads *equipe;
+    int id;
+} MembroEquipe;
+
+typedef struct EquipeThreads {
+    pthread_t threads[MAX_THREADS];
+    MembroEquipe membros[MAX_THREADS];
+    int num_threads;
+    pthread_barrier_t inicio;
+    pthread_barrier_t fim;
+    pthread_mutex_t trava;       // Protege 'montada'
+    pthread_cond_t barreiras_prontas;
+    int montada;                 // 1 quando as barreiras já têm o número final de membros
+    TrabalhoEquipe trabalho;
+    void *arg;
+    int encerrar;
+} EquipeThreads;
+
+static void *executar_membro_equipe(void *arg) {
+    MembroEquipe *membro = (MembroEquipe *)arg;
+    EquipeThreads *equipe = membro->equipe;
+    // Documentação: As barreiras só são montadas depois que se sabe quantas
+    // threads foram criadas; até lá o membro espera aqui.
+    pthread_mutex_lock(&equipe->trava);
+    while (!equipe->montada) {
+        pthread_cond_wait(&equipe->barreiras_prontas, &equipe->trava);
+    }
+    pthread_mutex_unlock(&equipe->trava);
+    for (;;) {
+        pthread_barrier_wait(&equipe->inicio);
+        if (equipe->encerrar) {
+            break;
+        }
+        equipe->trabalho(equipe->arg, membro->id, equipe->num_threads);
+        pthread_barrier_wait(&equipe->fim);
+    }
+    return NULL;
+}
+
+// Documentação: Retorna 0 se todas as threads foram criadas, ou -1 se a equipe
+// ficou menor (equipe->num_threads diz quantas; com 1 o trabalho é sequencial).
+int equipe_criar(EquipeThreads *equipe, int num_threads) {
+    if (num_threads < 1) num_threads = 1;
+    if (num_threads > MAX_THREADS) num_threads = MAX_THREADS;
+    equipe->encerrar = 0;
+    equipe->montada = 0;
+    pthread_mutex_init(&equipe->trava, NULL);
+    pthread_cond_init(&equipe->barreiras_prontas, NULL);
+    int criadas = 1;
+    while (criadas < num_threads) {
+        equipe->membros[criadas].equipe = equipe;
+        equipe->membros[criadas].id = criadas;
+        if (pthread_create(&equipe->threads[criadas], NULL, executar_membro_equipe,
+                           &equipe->membros[criadas]) != 0) {
+            break;
+        }
+        criadas++;
+    }
+    equipe->num_threads = criadas;
+    pthread_barrier_init(&equipe->inicio, NULL, (unsigned)criadas);
+    pthread_barrier_init(&equipe->fim, NULL, (unsigned)criadas);
+    pthread_mutex_lock(&equipe->trava);
+    equipe->montada = 1;
+    pthread_cond_broadcast(&equipe->barreiras_prontas);
+    pthread_mutex_unlock(&equipe->trava);
+    return criadas == num_threads ? 0 : -1;
+}
+
+// Documentação: Executa 'trabalho' em todos os membros e retorna quando todos terminam.
+void equipe_executar(EquipeThreads *equipe, TrabalhoEquipe trabalho, void *arg) {
+    if (equipe->num_threads == 1) {
+        trabalho(arg, 0, 1);
+        return;
+    }
+    equipe->trabalho = trabalho;
+    equipe->arg = arg;
+    pthread_barrier_wait(&equipe->inicio);
+    trabalho(arg, 0, equipe->num_threads);
+    pthread_barrier_wait(&equipe->fim);
+}
+
+void equipe_destruir(EquipeThreads *equipe) {
+    if (equipe->num_threads > 1) {
+        equipe->encerrar = 1;
+        pthread_barrier_wait(&equipe->inicio);
+        for (int t = 1; t < equipe->num_threads; t++) {
+            pthread_join(equipe->threads[t], NULL);
+        }
+    }
+    pthread_barrier_destroy(&equipe->inicio);
+    pthread_barrier_destroy(&equipe->fim);
+    pthread_mutex_destroy(&equipe->trava);
+    pthread_cond_destroy(&equipe->barreiras_prontas);
+}
+
+// --- BFS paralela por níveis ---
+// Documentação: A busca avança um nível por vez. A fronteira atual é dividida em
+// blocos que as threads pegam com um contador atômico; cada vizinho ainda livre é
+// reivindicado com compare-and-swap em 'marca', então cada território entra na
+// próxima fronteira exatamente uma vez. Níveis pequenos são processados só pela
+// thread chamadora, onde acordar a equipe não compensaria.
+//
+// O filtro de cor limita a busca: com 'mesma_cor' ela só atravessa territórios da
+// cor indicada; sem ele, só atravessa territórios de outras cores.
+#define MARCA_LIVRE UINT32_MAX
+#define SEM_PREDECESSOR UINT32_MAX
+#define BLOCO_BFS 256
+#define LIMIAR_BFS_PARALELA 4096
+
+typedef struct {
+    const GrafoFronteiras *grafo;
+    const uint8_t *cor;
+    int cor_filtro;             // -1 para atravessar qualquer território
+    int mesma_cor;
+    uint32_t *marca;            // MARCA_LIVRE ou o valor gravado ao visitar
+    uint32_t *predecessor;      // Opcional (NULL)
+    uint32_t valor_fixo;        // MARCA_LIVRE: grava o nível; senão grava este valor
+    uint32_t nivel;
+    uint32_t *fronteira;
+    size_t tam_fronteira;
+    uint32_t *proxima;
+    size_t tam_proxima;         // Atualizado atomicamente
+    size_t cursor;              // Atualizado atomicamente
+} BuscaLargura;
+
+static inline int bfs_admite(const BuscaLargura *b, uint32_t v) {
+    if (b->cor_filtro < 0) {
+        return 1;
+    }
+    return (b->cor[v] == (uint8_t)b->cor_filtro) == (b->mesma_cor != 0);
+}
+
+static void bfs_processar_nivel(void *arg, int id, int num_threads) {
+    (void)id;
+    (void)num_threads;
+    BuscaLargura *b = (BuscaLargura *)arg;
+    const GrafoFronteiras *g = b->grafo;
+    uint32_t valor = b->valor_fixo != MARCA_LIVRE ? b->valor_fixo : b->nivel + 1;
+    uint32_t local[BLOCO_BFS];
+    size_t tam_local = 0;
+
+    for (;;) {
+        size_t ini = __atomic_fetch_add(&b->cursor, BLOCO_BFS, __ATOMIC_RELAXED);
+        if (ini >= b->tam_fronteira) {
+            break;
+        }
+        size_t fim = ini + BLOCO_BFS < b->tam_fronteira ? ini + BLOCO_BFS : b->tam_fronteira;
+        for (size_t k = ini; k < fim; k++) {
+            uint32_t v = b->fronteira[k];
+            if (v >= g->num_vertices) continue;
+            for (uint64_t e = g->inicio[v]; e < g->inicio[v + 1]; e++) {
+                uint32_t w = g->vizinhos[e];
+                uint32_t livre = MARCA_LIVRE;
+                if (__atomic_load_n(&b->marca[w], __ATOMIC_RELAXED) != MARCA_LIVRE || !bfs_admite(b, w)) {
+                    continue;
+                }
+                if (!__atomic_compare_exchange_n(&b->marca[w], &livre, valor, 0,
+                                                 __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                    continue;
+                }
+                if (b->predecessor != NULL) {
+                    b->predecessor[w] = v;
+                }
+                local[tam_local++] = w;
+                if (tam_local == BLOCO_BFS) {
+                    size_t pos = __atomic_fetch_add(&b->tam_proxima, tam_local, __ATOMIC_RELAXED);
+                    memcpy(&b->proxima[pos], local, tam_local * sizeof(uint32_t));
+                    tam_local = 0;
+                }
+            }
+        }
+    }
+    if (tam_local > 0) {
+        size_t pos = __atomic_fetch_add(&b->tam_proxima, tam_local, __ATOMIC_RELAXED);
+        memcpy(&b->proxima[pos], local, tam_local * sizeof(uint32_t));
+    }
+}
+
+// Documentação: Roda a BFS a partir das fontes já marcadas em 'fronteira' até
+// esgotar o grafo ou, se 'alvo' for válido, até visitá-lo. 'fronteira' e 'proxima'
+// precisam de espaço para todos os territórios. Retorna quantos territórios foram
+// visitados (sem contar as fontes).
+size_t bfs_paralela(EquipeThreads *equipe, BuscaLargura *b, uint32_t alvo) {
+    size_t visitados = 0;
+    b->nivel = 0;
+    while (b->tam_fronteira > 0) {
+        b->tam_proxima = 0;
+        b->cursor = 0;
+        if (b->tam_fronteira >= LIMIAR_BFS_PARALELA && equipe->num_threads > 1) {
+            equipe_executar(equipe, bfs_processar_nivel, b);
+        } else {
+            bfs_processar_nivel(b, 0, 1);
+        }
+        uint32_t *troca = b->fronteira;
+        b->fronteira = b->proxima;
+        b->proxima = troca;
+        b->tam_fronteira = b->tam_proxima;
+        visitados += b->tam_fronteira;
+        b->nivel++;
+        if (alvo != MARCA_LIVRE && b->marca[alvo] != MARCA_LIVRE) {
+            break;
+        }
+    }
+    return visitados;
+}
+
+// --- Consultas de fronteira ---
+// Documentação: Alvos atacáveis por uma cor: territórios de outras cores que fazem
+// fronteira com algum território da cor com pelo menos 2 tropas (quem tem 1 tropa
+// não pode atacar). Cada thread varre uma faixa de territórios; várias threads
+// podem marcar o mesmo alvo, o que é inofensivo porque todas gravam 1.
+typedef struct {
+    const MapaTerritorios *mapa;
+    int cor;
+    uint8_t *alvo;
+} ConsultaAlvos;
+
+static void marcar_alvos_faixa(void *arg, int id, int num_threads) {
+    ConsultaAlvos *c = (ConsultaAlvos *)arg;
+    const GrafoFronteiras *g = &c->mapa->fronteiras;
+    uint32_t n = g->num_vertices;
+    uint32_t ini = (uint32_t)((uint64_t)n * id / num_threads);
+    uint32_t fim = (uint32_t)((uint64_t)n * (id + 1) / num_threads);
+    for (uint32_t v = ini; v < fim; v++) {
+        if (c->mapa->cor[v] != c->cor || c->mapa->tropas[v] < 2) {
+            continue;
+        }
+        for (uint64_t e = g->inicio[v]; e < g->inicio[v + 1]; e++) {
+            uint32_t w = g->vizinhos[e];
+            if (c->mapa->cor[w] != c->cor) {
+                c->alvo[w] = 1;
+            }
+        }
+    }
+}
+
+// Documentação: Preenche 'alvo' (um byte por território) e retorna quantos são atacáveis.
+size_t consultar_alvos(EquipeThreads *equipe, const MapaTerritorios *mapa, int cor, uint8_t *alvo) {
+    ConsultaAlvos consulta = {mapa, cor, alvo};
+    memset(alvo, 0, mapa->quantidade);
+    equipe_executar(equipe, marcar_alvos_faixa, &consulta);
+    size_t total = 0;
+    for (size_t v = 0; v < mapa->quantidade; v++) {
+        total += alvo[v];
+    }
+    return total;
+}
+
+// Documentação: Regiões conexas de uma cor: cada território da cor recebe em
+// 'regiao' o número da sua região (territórios de outras cores ficam com
+// MARCA_LIVRE). Retorna o número de regiões e informa o tamanho da maior.
+uint32_t consultar_regioes(EquipeThreads *equipe, const MapaTerritorios *mapa, int cor,
+                           uint32_t *regiao, uint32_t *fronteira, uint32_t *proxima,
+                           size_t *maior_regiao) {
+    uint32_t num_regioes = 0;
+    *maior_regiao = 0;
+    for (size_t v = 0; v < mapa->quantidade; v++) {
+        regiao[v] = MARCA_LIVRE;
+    }
+    for (size_t v = 0; v < mapa->quantidade; v++) {
+        if (mapa->cor[v] != cor || regiao[v] != MARCA_LIVRE) {
+            continue;
+        }
+        BuscaLargura b = {&mapa->fronteiras, mapa->cor, cor, 1, regiao, NULL,
+                          num_regioes, 0, fronteira, 1, proxima, 0, 0};
+        regiao[v] = num_regioes;
+        fronteira[0] = (uint32_t)v;
+        size_t tamanho = 1 + bfs_paralela(equipe, &b, MARCA_LIVRE);
+        if (tamanho > *maior_regiao) {
+            *maior_regiao = tamanho;
+        }
+        num_regioes++;
+    }
+    return num_regioes;
+}
+
+// Documentação: Rota de conquista mais curta de uma cor até o território 'destino':
+// BFS que parte de todos os territórios da cor ao mesmo tempo e só atravessa
+// territórios inimigos, então a distância é o número de conquistas necessárias.
+// Grava a rota (origem primeiro) em 'rota' e retorna seu tamanho, ou 0 se o
+// destino for inalcançável.
+size_t consultar_rota(EquipeThreads *equipe, const MapaTerritorios *mapa, int cor, uint32_t destino,
+                      uint32_t *distancia, uint32_t *predecessor, uint32_t *fronteira,
+                      uint32_t *proxima, uint32_t *rota) {
+    size_t fontes = 0;
+    for (size_t v = 0; v < mapa->quantidade; v++) {
+        predecessor[v] = SEM_PREDECESSOR;
+        if (mapa->cor[v] == cor) {
+            distancia[v] = 0;
+            fronteira[fontes++] = (uint32_t)v;
+        } else {
+            distancia[v] = MARCA_LIVRE;
+        }
+    }
+    BuscaLargura b = {&mapa->fronteiras, mapa->cor, cor, 0, distancia, predecessor,
+                      MARCA_LIVRE, 0, fronteira, fontes, proxima, 0, 0};
+    bfs_paralela(equipe, &b, destino);
+    if (distancia[destino] == MARCA_LIVRE) {
+        return 0;
+    }
+
+    size_t tamanho = 0;
+    for (uint32_t v = destino; v != SEM_PREDECESSOR; v = predecessor[v]) {
+        rota[tamanho++] = v;
+    }
+    for (size_t i = 0; i < tamanho / 2; i++) {
+        uint32_t troca = rota[i];
+        rota[i] = rota[tamanho - 1 - i];
+        rota[tamanho - 1 - i] = troca;
+    }
+    return tamanho;
+}
+
+// --- Snapshot binário do mapa ---
+// Documentação: O snapshot é uma cópia direta dos vetores colunares em disco,
+// precedida por um cabeçalho com versão e deslocamentos. Cada seção começa alinhada
+// a 64 bytes, então o carregamento só precisa mapear o arquivo e apontar os vetores
+// do mapa para dentro dele; as páginas são lidas sob demanda pelo sistema.
+// O mapeamento é privado: alterar tropas de um mapa carregado não altera o arquivo.
+//
+// Layout: [cabeçalho][cores][tropas][cor][nome][pool de nomes][inicio][vizinhos]
+// A versão 1 não tinha as duas últimas seções (grafo de fronteiras); seus campos
+// no cabeçalho caem no preenchimento de zeros, então ela continua sendo aceita.
+#define SNAPSHOT_MAGICA "WARMAPA"
+#define SNAPSHOT_VERSAO 2
+#define SNAPSHOT_ALINHAMENTO 64
+#define SNAPSHOT_MARCA_ENDIAN 0x01020304u
+
+typedef struct {
+    char magica[8];
+    uint32_t versao;
+    uint32_t marca_endian;      // Detecta arquivos gravados em máquinas de outra ordem de bytes
+    uint64_t quantidade;
+    uint64_t num_cores;
+    uint64_t pool_tamanho;
+    uint64_t desloc_cores;
+    uint64_t desloc_tropas;
+    uint64_t desloc_cor;
+    uint64_t desloc_nome;
+    uint64_t desloc_pool;
+    uint64_t tamanho_total;
+    // Versão 2: grafo de fronteiras (zerados quando o mapa não tem fronteiras).
+    uint64_t num_vertices;
+    uint64_t num_arestas;
+    uint64_t desloc_inicio;
+    uint64_t desloc_vizinhos;
+} CabecalhoSnapshot;
+
+static uint64_t alinhar(uint64_t valor) {
+    return (valor + SNAPSHOT_ALINHAMENTO - 1) & ~(uint64_t)(SNAPSHOT_ALINHAMENTO - 1);
+}
+
+static void snapshot_montar_cabecalho(const MapaTerritorios *mapa, uint32_t versao,
+                                      CabecalhoSnapshot *cab) {
+    memset(cab, 0, sizeof(*cab));
+    memcpy(cab->magica, SNAPSHOT_MAGICA, sizeof(SNAPSHOT_MAGICA));
+    cab->versao = versao;
+    cab->marca_endian = SNAPSHOT_MARCA_ENDIAN;
+    cab->quantidade = mapa->quantidade;
+    cab->num_cores = (uint64_t)mapa->num_cores;
+    cab->pool_tamanho = mapa->pool_tamanho;
+    cab->desloc_cores = alinhar(sizeof(CabecalhoSnapshot));
+    cab->desloc_tropas = alinhar(cab->desloc_cores + cab->num_cores * TAM_COR);
+    cab->desloc_cor = alinhar(cab->desloc_tropas + cab->quantidade * sizeof(int));
+    cab->desloc_nome = alinhar(cab->desloc_cor + cab->quantidade * sizeof(uint8_t));
+    cab->desloc_pool = alinhar(cab->desloc_nome + cab->quantidade * sizeof(uint32_t));
+    cab->tamanho_total = cab->desloc_pool + cab->pool_tamanho;
+    if (versao >= 2 && mapa->fronteiras.num_vertices > 0) {
+        cab->num_vertices = mapa->fronteiras.num_vertices;
+        cab->num_arestas = mapa->fronteiras.num_arestas;
+        cab->desloc_inicio = alinhar(cab->tamanho_total);
+        cab->desloc_vizinhos = alinhar(cab->desloc_inicio + (cab->num_vertices + 1) * sizeof(uint64_t));
+        cab->tamanho_total = cab->desloc_vizinhos + cab->num_arestas * sizeof(uint32_t);
+    }
+}
+
+// Documentação: Escreve todos os blocos com writev(), repetindo a chamada se o
+// sistema aceitar só parte dos dados. Retorna 0 em sucesso.
+static int escrever_blocos(int fd, struct iovec *blocos, int num_blocos) {
+    while (num_blocos > 0) {
+        ssize_t escrito = writev(fd, blocos, num_blocos);
+        if (escrito < 0) {
+            return -1;
+        }
+        while (num_blocos > 0 && (size_t)escrito >= blocos->iov_len) {
+            escrito -= (ssize_t)blocos->iov_len;
+            blocos++;
+            num_blocos--;
+        }
+        if (num_blocos > 0) {
+            blocos->iov_base = (char *)blocos->iov_base + escrito;
+            blocos->iov_len -= (size_t)escrito;
+        }
+    }
+    return 0;
+}
+
+// Documentação: Grava o mapa inteiro em uma única passada sequencial. O arquivo é
+// escrito com nome temporário e renomeado no final, para que uma falha no meio da
+// gravação nunca deixe um snapshot pela metade no lugar do anterior.
+int snapshot_salvar(const MapaTerritorios *mapa, const char *caminho) {
+    static const char zeros[SNAPSHOT_ALINHAMENTO] = {0};
+    CabecalhoSnapshot cab;
+    snapshot_montar_cabecalho(mapa, SNAPSHOT_VERSAO, &cab);
+
+    struct iovec blocos[16];
+    int n = 0;
+    uint64_t posicao = 0;
+    const void *dados[7] = {mapa->cores, mapa->tropas, mapa->cor, mapa->nome, mapa->pool_nomes,
+                            mapa->fronteiras.inicio, mapa->fronteiras.vizinhos};
+    uint64_t inicios[7] = {cab.desloc_cores, cab.desloc_tropas, cab.desloc_cor,
+                           cab.desloc_nome, cab.desloc_pool, cab.desloc_inicio, cab.desloc_vizinhos};
+    uint64_t tamanhos[7] = {cab.num_cores * TAM_COR, cab.quantidade * sizeof(int),
+                            cab.quantidade * sizeof(uint8_t), cab.quantidade * sizeof(uint32_t),
+                            cab.pool_tamanho, 0, cab.num_arestas * sizeof(uint32_t)};
+    int num_secoes = cab.num_vertices > 0 ? 7 : 5;
+    if (cab.num_vertices > 0) {
+        tamanhos[5] = (cab.num_vertices + 1) * sizeof(uint64_t);
+    }
+
+    blocos[n].iov_base = &cab;
+    blocos[n++].iov_len = sizeof(cab);
+    posicao = sizeof(cab);
+    for (int s = 0; s < num_secoes; s++) {
+        if (inicios[s] > posicao) {
+            blocos[n].iov_base = (void *)zeros;
+            blocos[n++].iov_len = (size_t)(inicios[s] - posicao);
+        }
+        if (tamanhos[s] > 0) {
+            blocos[n].iov_base = (void *)dados[s];
+            blocos[n++].iov_len = (size_t)tamanhos[s];
+        }
+        posicao = inicios[s] + tamanhos[s];
+    }
+
+    char temporario[4096];
+    snprintf(temporario, sizeof(temporario), "%s.tmp", caminho);
+    int fd = open(temporario, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    if (escrever_blocos(fd, blocos, n) != 0 || fsync(fd) != 0) {
+        close(fd);
+        unlink(temporario);
+        return -1;
+    }
+    close(fd);
+    return rename(temporario, caminho);
+}
+
+// Documentação: Carrega um snapshot mapeando o arquivo em memória. Só o cabeçalho,
+// os deslocamentos dos nomes e os índices do grafo são conferidos; nenhum
+// território é copiado. Retorna 0
+// em sucesso e -1 se o arquivo não existir, estiver corrompido ou for de outra versão.
+int snapshot_carregar(MapaTerritorios *mapa, const char *caminho) {
+    int fd = open(caminho, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(CabecalhoSnapshot)) {
+        close(fd);
+        return -1;
+    }
+    size_t tamanho = (size_t)info.st_size;
+    void *base = mmap(NULL, tamanho, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd); // O mapeamento continua válido depois de fechar o descritor.
+    if (base == MAP_FAILED) {
+        return -1;
+    }
+
+    const CabecalhoSnapshot *cab = (const CabecalhoSnapshot *)base;
+    CabecalhoSnapshot esperado;
+    MapaTerritorios temporario;
+    mapa_inicializar(&temporario);
+    temporario.quantidade = cab->quantidade;
+    temporario.pool_tamanho = cab->pool_tamanho;
+    temporario.num_cores = (int)cab->num_cores;
+    temporario.fronteiras.num_vertices = (uint32_t)cab->num_vertices;
+    temporario.fronteiras.num_arestas = cab->num_arestas;
+    snapshot_montar_cabecalho(&temporario, cab->versao, &esperado);
+
+    int valido = memcmp(cab->magica, SNAPSHOT_MAGICA, sizeof(SNAPSHOT_MAGICA)) == 0
+              && (cab->versao == 1 || cab->versao == SNAPSHOT_VERSAO)
+              && cab->num_vertices <= cab->quantidade
+              && cab->marca_endian == SNAPSHOT_MARCA_ENDIAN
+              && cab->num_cores <= MAX_CORES
+              && cab->quantidade <= UINT32_MAX
+              && cab->pool_tamanho <= UINT32_MAX
+              && memcmp(cab, &esperado, sizeof(esperado)) == 0
+              && cab->tamanho_total == tamanho;
+    char *bytes = (char *)base;
+    if (valido && cab->pool_tamanho > 0) {
+        valido = bytes[cab->desloc_pool + cab->pool_tamanho - 1] == '\0';
+    }
+    if (valido) {
+        const uint32_t *nomes = (const uint32_t *)(bytes + cab->desloc_nome);
+        uint32_t maior = 0;
+        for (uint64_t i = 0; i < cab->quantidade; i++) {
+            maior = nomes[i] > maior ? nomes[i] : maior;
+        }
+        valido = cab->quantidade == 0 || maior < cab->pool_tamanho;
+    }
+    if (valido && cab->num_vertices > 0) {
+        // O CSR precisa ser monótono e terminar no total de arestas, e todo vizinho
+        // precisa ser um território existente; senão as consultas sairiam do arquivo.
+        const uint64_t *inicio = (const uint64_t *)(bytes + cab->desloc_inicio);
+        const uint32_t *vizinhos = (const uint32_t *)(bytes + cab->desloc_vizinhos);
+        valido = inicio[0] == 0 && inicio[cab->num_vertices] == cab->num_arestas;
+        for (uint64_t v = 0; valido && v < cab->num_vertices; v++) {
+            valido = inicio[v] <= inicio[v + 1];
+        }
+        uint32_t maior = 0;
+        for (uint64_t e = 0; valido && e < cab->num_arestas; e++) {
+            maior = vizinhos[e] > maior ? vizinhos[e] : maior;
+        }
+        valido = valido && (cab->num_arestas == 0 || maior < cab->quantidade);
+    }
+    if (!valido) {
+        munmap(base, tamanho);
+        return -1;
+    }
+
+    mapa_liberar(mapa);
+    mapa->quantidade = cab->quantidade;
+    mapa->capacidade = cab->quantidade;
+    mapa->num_cores = (int)cab->num_cores;
+    memcpy(mapa->cores, bytes + cab->desloc_cores, cab->num_cores * TAM_COR);
+    for (int c = 0; c < mapa->num_cores; c++) {
+        mapa->cores[c][TAM_COR - 1] = '\0';
+    }
+    mapa->tropas = (int *)(bytes + cab->desloc_tropas);
+    mapa->cor = (uint8_t *)(bytes + cab->desloc_cor);
+    mapa->nome = (uint32_t *)(bytes + cab->desloc_nome);
+    mapa->pool_nomes = bytes + cab->desloc_pool;
+    mapa->pool_tamanho = cab->pool_tamanho;
+    mapa->pool_capacidade = cab->pool_tamanho;
+    if (cab->num_vertices > 0) {
+        mapa->fronteiras.num_vertices = (uint32_t)cab->num_vertices;
+        mapa->fronteiras.num_arestas = cab->num_arestas;
+        mapa->fronteiras.inicio = (uint64_t *)(bytes + cab->desloc_inicio);
+        mapa->fronteiras.vizinhos = (uint32_t *)(bytes + cab->desloc_vizinhos);
+    }
+    mapa->mapeamento = base;
+    mapa->tamanho_mapeamento = tamanho;
+    return 0;
+}
+
+// --- Missões com verificação incremental ---
+// Documentação: As missões do nível Mestre ("destruir o exército Verde",
+// "conquistar 3 territórios") dependem só de contadores por cor: quantos
+// territórios e tropas cada cor tem e quantas conquistas cada cor já fez. Esses
+// contadores são montados com uma varredura no início e depois atualizados a cada
+// alteração do mapa, então "Verificar Missão" nunca percorre os territórios.
+//
+// Para atender muitas missões ao mesmo tempo, elas ficam em índices ordenados
+// pelo limiar que as cumpre. Uma conquista muda cada contador em exatamente 1,
+// então só as missões cujo limiar é o valor novo (ou o antigo) mudam de estado:
+// uma busca binária encontra essas missões sem tocar nas demais.
+typedef enum {
+    MISSAO_DESTRUIR_COR,        // A cor alvo não pode ter mais nenhum território
+    MISSAO_CONQUISTAR,          // O jogador precisa fazer 'quantidade' conquistas
+    MISSAO_DOMINAR              // O jogador precisa possuir 'quantidade' territórios
+} TipoMissao;
+
+typedef struct {
+    TipoMissao tipo;
+    uint8_t jogador;            // Cor de quem recebeu a missão
+    uint8_t cor_alvo;           // Usada por MISSAO_DESTRUIR_COR
+    uint32_t quantidade;        // Usada por MISSAO_CONQUISTAR e MISSAO_DOMINAR
+    int cumprida;
+} Missao;
+
+// Documentação: Missões de uma cor ordenadas pelo limiar. Para MISSAO_DESTRUIR_COR o
+// limiar é sempre 1: a missão vira quando a cor alvo passa de 1 para 0 territórios.
+// Novas missões entram no fim e o índice só é reordenado na próxima consulta, para
+// que cadastrar milhões de missões não custe uma inserção ordenada cada.
+typedef struct {
+    uint32_t limiar;
+    uint32_t missao;
+} EntradaLimiar;
+
+typedef struct {
+    EntradaLimiar *entradas;
+    size_t tamanho;
+    size_t capacidade;
+    int ordenado;
+} IndiceLimiar;
+
+typedef struct {
+    uint32_t territorios[MAX_CORES];
+    int64_t tropas[MAX_CORES];
+    uint32_t conquistas[MAX_CORES];
+    IndiceLimiar indices[3][MAX_CORES];     // [tipo][cor observada]
+    Missao *missoes;
+    size_t num_missoes;
+    size_t capacidade;
+    size_t cumpridas;
+} RastreadorMissoes;
+
+void rastreador_iniciar(RastreadorMissoes *r, const MapaTerritorios *mapa) {
+    memset(r, 0, sizeof(*r));
+    mapa_tropas_por_cor(mapa, r->tropas, r->territorios);
+}
+
+void rastreador_liberar(RastreadorMissoes *r) {
+    for (int t = 0; t < 3; t++) {
+        for (int c = 0; c < MAX_CORES; c++) {
+            free(r->indices[t][c].entradas);
+        }
+    }
+    free(r->missoes);
+    memset(r, 0, sizeof(*r));
+}
+
+// Documentação: Verificação de uma missão em tempo constante, lendo os contadores.
+static int missao_avaliar(const RastreadorMissoes *r, const Missao *m) {
+    switch (m->tipo) {
+        case MISSAO_DESTRUIR_COR:
+            return r->territorios[m->cor_alvo] == 0;
+        case MISSAO_CONQUISTAR:
+            return r->conquistas[m->jogador] >= m->quantidade;
+        case MISSAO_DOMINAR:
+            return r->territorios[m->jogador] >= m->quantidade;
+    }
+    return 0;
+}
+
+static int comparar_entradas_limiar(const void *a, const void *b) {
+    const EntradaLimiar *x = (const EntradaLimiar *)a;
+    const EntradaLimiar *y = (const EntradaLimiar *)b;
+    if (x->limiar != y->limiar) return x->limiar < y->limiar ? -1 : 1;
+    return (x->missao > y->missao) - (x->missao < y->missao);
+}
+
+static size_t indice_primeiro_limiar(IndiceLimiar *ind, uint32_t limiar) {
+    if (!ind->ordenado) {
+        qsort(ind->entradas, ind->tamanho, sizeof(EntradaLimiar), comparar_entradas_limiar);
+        ind->ordenado = 1;
+    }
+    size_t baixo = 0, alto = ind->tamanho;
+    while (baixo < alto) {
+        size_t meio = (baixo + alto) / 2;
+        if (ind->entradas[meio].limiar < limiar) {
+            baixo = meio + 1;
+        } else {
+            alto = meio;
+        }
+    }
+    return baixo;
+}
+
+static int indice_inserir(IndiceLimiar *ind, uint32_t limiar, uint32_t missao) {
+    if (ind->tamanho == ind->capacidade) {
+        size_t nova = ind->capacidade ? ind->capacidade * 2 : 8;
+        EntradaLimiar *entradas = realloc(ind->entradas, nova * sizeof(EntradaLimiar));
+        if (entradas == NULL) return -1;
+        ind->entradas = entradas;
+        ind->capacidade = nova;
+    }
+    ind->entradas[ind->tamanho].limiar = limiar;
+    ind->entradas[ind->tamanho].missao = missao;
+    ind->tamanho++;
+    ind->ordenado = 0;
+    return 0;
+}
+
+// Documentação: Cadastra uma missão e devolve seu número (ou -1 sem memória).
+long rastreador_adicionar_missao(RastreadorMissoes *r, TipoMissao tipo, int jogador,
+                                 int cor_alvo, uint32_t quantidade) {
+    if (r->num_missoes == r->capacidade) {
+        size_t nova = r->capacidade ? r->capacidade * 2 : 16;
+        Missao *missoes = realloc(r->missoes, nova * sizeof(Missao));
+        if (missoes == NULL) return -1;
+        r->missoes = missoes;
+        r->capacidade = nova;
+    }
+    Missao *m = &r->missoes[r->num_missoes];
+    m->tipo = tipo;
+    m->jogador = (uint8_t)jogador;
+    m->cor_alvo = (uint8_t)cor_alvo;
+    m->quantidade = quantidade;
+    uint8_t cor = tipo == MISSAO_DESTRUIR_COR ? m->cor_alvo : m->jogador;
+    uint32_t limiar = tipo == MISSAO_DESTRUIR_COR ? 1 : quantidade;
+    if (indice_inserir(&r->indices[tipo][cor], limiar, (uint32_t)r->num_missoes) != 0) {
+        return -1;
+    }
+    m->cumprida = missao_avaliar(r, m);
+    r->cumpridas += (size_t)m->cumprida;
+    return (long)r->num_missoes++;
+}
+
+// Documentação: Reavalia só as missões do índice com exatamente este limiar.
+static void rastreador_reavaliar_limiar(RastreadorMissoes *r, TipoMissao tipo, uint8_t cor,
+                                        uint32_t limiar) {
+    IndiceLimiar *ind = &r->indices[tipo][cor];
+    if (ind->tamanho == 0) {
+        return;
+    }
+    for (size_t k = indice_primeiro_limiar(ind, limiar);
+         k < ind->tamanho && ind->entradas[k].limiar == limiar; k++) {
+        Missao *m = &r->missoes[ind->entradas[k].missao];
+        int cumprida = missao_avaliar(r, m);
+        if (cumprida != m->cumprida) {
+            r->cumpridas += cumprida ? 1 : (size_t)-1;
+            m->cumprida = cumprida;
+        }
+    }
+}
+
+// Documentação: "Verificar Missão": O(1), sem olhar para o mapa.
+static inline int verificar_missao(const RastreadorMissoes *r, size_t missao) {
+    return r->missoes[missao].cumprida;
+}
+
+// --- Placar dos territórios mais fortes ---
+// Documentação: "Quais são os N territórios com mais tropas?" e "qual cor lidera?"
+// são respondidos sem percorrer o mapa. O placar mantém um heap máximo indexado
+// por tropas com todos os territórios e um heap por cor. Cada território guarda
+// sua posição nos dois heaps, então uma mudança de tropas ou de dono só reposiciona
+// aquele território: O(log n) por alteração. O top-k sai do heap sem desmontá-lo,
+// expandindo os filhos dos itens já escolhidos: O(k log k), qualquer que seja n.
+//
+// O placar é criado depois do mapa montado e é mantido pelas funções de alteração
+// do mapa (mapa_alterar_tropas e mapa_conquistar); tropas e cores são lidas do
+// próprio mapa, então o placar guarda só índices de territórios.
+typedef struct {
+    uint32_t *itens;            // Territórios em ordem de heap máximo
+    size_t tamanho;
+    size_t capacidade;
+} HeapPlacar;
+
+typedef struct {
+    const MapaTerritorios *mapa;
+    HeapPlacar geral;
+    HeapPlacar por_cor[MAX_CORES];
+    uint32_t *posicao_geral;    // Posição de cada território em 'geral'
+    uint32_t *posicao_cor;      // Posição de cada território no heap da sua cor
+    int64_t tropas_cor[MAX_CORES];
+} Placar;
+
+// Documentação: Ordem do placar: mais tropas primeiro; em caso de empate, o
+// território cadastrado antes. O desempate torna o top-k determinístico.
+static int placar_antes(const Placar *p, uint32_t a, uint32_t b) {
+    int tropas_a = p->mapa->tropas[a];
+    int tropas_b = p->mapa->tropas[b];
+    return tropas_a > tropas_b || (tropas_a == tropas_b && a < b);
+}
+
+static void heap_placar_colocar(HeapPlacar *h, uint32_t *posicao, size_t i, uint32_t territorio) {
+    h->itens[i] = territorio;
+    posicao[territorio] = (uint32_t)i;
+}
+
+static void heap_placar_subir(const Placar *p, HeapPlacar *h, uint32_t *posicao, size_t i) {
+    uint32_t territorio = h->itens[i];
+    while (i > 0) {
+        size_t pai = (i - 1) / 2;
+        if (!placar_antes(p, territorio, h->itens[pai])) {
+            break;
+        }
+        heap_placar_colocar(h, posicao, i, h->itens[pai]);
+        i = pai;
+    }
+    heap_placar_colocar(h, posicao, i, territorio);
+}
+
+static void heap_placar_descer(const Placar *p, HeapPlacar *h, uint32_t *posicao, size_t i) {
+    uint32_t territorio = h->itens[i];
+    for (;;) {
+        size_t filho = 2 * i + 1;
+        if (filho >= h->tamanho) {
+            break;
+        }
+        if (filho + 1 < h->tamanho && placar_antes(p, h->itens[filho + 1], h->itens[filho])) {
+            filho++;
+        }
+        if (!placar_antes(p, h->itens[filho], territorio)) {
+            break;
+        }
+        heap_placar_colocar(h, posicao, i, h->itens[filho]);
+        i = filho;
+    }
+    heap_placar_colocar(h, posicao, i, territorio);
+}
+
+// Documentação: Reposiciona o item da posição 'i' depois que só as tropas dele mudaram.
+static void heap_placar_corrigir(const Placar *p, HeapPlacar *h, uint32_t *posicao, size_t i) {
+    if (i > 0 && placar_antes(p, h->itens[i], h->itens[(i - 1) / 2])) {
+        heap_placar_subir(p, h, posicao, i);
+    } else {
+        heap_placar_descer(p, h, posicao, i);
+    }
+}
+
+// Documentação: Não precisa crescer: placar_iniciar já reserva espaço para o mapa
+// inteiro em cada heap de cor.
+static void heap_placar_inserir(const Placar *p, HeapPlacar *h, uint32_t *posicao, uint32_t territorio) {
+    h->itens[h->tamanho] = territorio;
+    heap_placar_subir(p, h, posicao, h->tamanho++);
+}
+
+static void heap_placar_remover(const Placar *p, HeapPlacar *h, uint32_t *posicao, size_t i) {
+    uint32_t ultimo = h->itens[--h->tamanho];
+    if (i < h->tamanho) {
+        heap_placar_colocar(h, posicao, i, ultimo);
+        heap_placar_corrigir(p, h, posicao, i);
+    }
+}
+
+// Documentação: Monta os heaps com uma varredura e heapify de baixo para cima (O(n)).
+// Retorna 0 em sucesso ou -1 se faltar memória.
+int placar_iniciar(Placar *p, const MapaTerritorios *mapa) {
+    memset(p, 0, sizeof(*p));
+    p->mapa = mapa;
+    size_t n = mapa->quantidade;
+    uint32_t territorios[MAX_CORES];
+    mapa_tropas_por_cor(mapa, p->tropas_cor, territorios);
+
+    p->posicao_geral = malloc((n ? n : 1) * sizeof(uint32_t));
+    p->posicao_cor = malloc((n ? n : 1) * sizeof(uint32_t));
+    p->geral.itens = malloc((n ? n : 1) * sizeof(uint32_t));
+    int ok = p->posicao_geral != NULL && p->posicao_cor != NULL && p->geral.itens != NULL;
+    // Uma cor nunca tem mais territórios que o mapa, então reservar 'n' por cor
+    // deixa as conquistas sem realocação.
+    for (int c = 0; c < mapa->num_cores && ok; c++) {
+        p->por_cor[c].itens = malloc((n ? n : 1) * sizeof(uint32_t));
+        p->por_cor[c].capacidade = n;
+        ok = p->por_cor[c].itens != NULL;
+    }
+    if (!ok) {
+        return -1;
+    }
+
+    p->geral.capacidade = n;
+    for (size_t t = 0; t < n; t++) {
+        HeapPlacar *h = &p->por_cor[mapa->cor[t]];
+        heap_placar_colocar(&p->geral, p->posicao_geral, p->geral.tamanho++, (uint32_t)t);
+        heap_placar_colocar(h, p->posicao_cor, h->tamanho++, (uint32_t)t);
+    }
+    for (size_t i = n / 2; i-- > 0;) {
+        heap_placar_descer(p, &p->geral, p->posicao_geral, i);
+    }
+    for (int c = 0; c < MAX_CORES; c++) {
+        HeapPlacar *h = &p->por_cor[c];
+        for (size_t i = h->tamanho / 2; i-- > 0;) {
+            heap_placar_descer(p, h, p->posicao_cor, i);
+        }
+    }
+    return 0;
+}
+
+void placar_liberar(Placar *p) {
+    free(p->geral.itens);
+    for (int c = 0; c < MAX_CORES; c++) {
+        free(p->por_cor[c].itens);
+    }
+    free(p->posicao_geral);
+    free(p->posicao_cor);
+    memset(p, 0, sizeof(*p));
+}
+
+// Documentação: Chamada depois que as tropas do território mudaram em 'delta'.
+void placar_tropas_alteradas(Placar *p, uint32_t territorio, int delta) {
+    uint8_t cor = p->mapa->cor[territorio];
+    p->tropas_cor[cor] += delta;
+    heap_placar_corrigir(p, &p->geral, p->posicao_geral, p->posicao_geral[territorio]);
+    heap_placar_corrigir(p, &p->por_cor[cor], p->posicao_cor, p->posicao_cor[territorio]);
+}
+
+// Documentação: Chamada depois que o território passou da cor 'antiga' (com
+// 'tropas_antigas') para a cor e as tropas que estão agora no mapa.
+void placar_territorio_conquistado(Placar *p, uint32_t territorio, uint8_t antiga, int tropas_antigas) {
+    uint8_t nova = p->mapa->cor[territorio];
+    p->tropas_cor[antiga] -= tropas_antigas;
+    p->tropas_cor[nova] += p->mapa->tropas[territorio];
+    heap_placar_remover(p, &p->por_cor[antiga], p->posicao_cor, p->posicao_cor[territorio]);
+    heap_placar_inserir(p, &p->por_cor[nova], p->posicao_cor, territorio);
+    heap_placar_corrigir(p, &p->geral, p->posicao_geral, p->posicao_geral[territorio]);
+}
+
+// Documentação: Fila de candidatos do top-k: heap máximo de posições de 'h',
+// comparadas pela ordem do placar.
+static int candidato_antes(const Placar *p, const HeapPlacar *h, size_t a, size_t b) {
+    return placar_antes(p, h->itens[a], h->itens[b]);
+}
+
+static void candidatos_inserir(const Placar *p, const HeapPlacar *h, size_t *fila,
+                               size_t *tamanho, size_t posicao) {
+    size_t i = (*tamanho)++;
+    while (i > 0 && candidato_antes(p, h, posicao, fila[(i - 1) / 2])) {
+        fila[i] = fila[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    fila[i] = posicao;
+}
+
+static size_t candidatos_retirar(const Placar *p, const HeapPlacar *h, size_t *fila, size_t *tamanho) {
+    size_t melhor = fila[0];
+    size_t ultimo = fila[--(*tamanho)];
+    size_t i = 0;
+    for (;;) {
+        size_t filho = 2 * i + 1;
+        if (filho >= *tamanho) {
+            break;
+        }
+        if (filho + 1 < *tamanho && candidato_antes(p, h, fila[filho + 1], fila[filho])) {
+            filho++;
+        }
+        if (!candidato_antes(p, h, fila[filho], ultimo)) {
+            break;
+        }
+        fila[i] = fila[filho];
+        i = filho;
+    }
+    if (*tamanho > 0) {
+        fila[i] = ultimo;
+    }
+    return melhor;
+}
+
+// Documentação: Top-k sem alterar o heap: a fila de candidatos começa com a raiz;
+// cada item retirado entra no resultado e seus dois filhos viram candidatos, pois
+// só eles podem ser o próximo maior. 'cor' negativa consulta o placar geral.
+// Retorna quantos territórios foram escritos em 'saida' (no máximo k).
+size_t placar_top(const Placar *p, int cor, size_t k, uint32_t *saida) {
+    const HeapPlacar *h = cor < 0 ? &p->geral : &p->por_cor[cor];
+    if (k > h->tamanho) {
+        k = h->tamanho;
+    }
+    if (k == 0) {
+        return 0;
+    }
+    // Cada retirada adiciona no máximo 2 candidatos: k + 2 posições bastam.
+    size_t *fila = malloc((k + 2) * sizeof(size_t));
+    if (fila == NULL) {
+        return 0;
+    }
+    size_t tamanho = 0, escritos = 0;
+    candidatos_inserir(p, h, fila, &tamanho, 0);
+    while (escritos < k) {
+        size_t posicao = candidatos_retirar(p, h, fila, &tamanho);
+        saida[escritos++] = h->itens[posicao];
+        for (size_t filho = 2 * posicao + 1; filho <= 2 * posicao + 2 && filho < h->tamanho; filho++) {
+            candidatos_inserir(p, h, fila, &tamanho, filho);
+        }
+    }
+    free(fila);
+    return escritos;
+}
+
+// Documentação: Cor com mais tropas. Percorre só a tabela de cores (no máximo
+// MAX_CORES entradas), nunca os territórios. Retorna -1 se o mapa está vazio.
+int placar_cor_lider(const Placar *p) {
+    int lider = -1;
+    for (int c = 0; c < p->mapa->num_cores; c++) {
+        if (p->por_cor[c].tamanho > 0 && (lider < 0 || p->tropas_cor[c] > p->tropas_cor[lider])) {
+            lider = c;
+        }
+    }
+    return lider;
+}
+
+// --- Alterações do mapa ---
+// Documentação: Toda mudança de tropas ou de dono passa por estas funções, que
+// atualizam o mapa e, se houver rastreador e placar (ambos podem ser NULL), seus
+// contadores e heaps.
+void mapa_alterar_tropas(MapaTerritorios *mapa, RastreadorMissoes *r, Placar *p,
+                         uint32_t territorio, int delta) {
+    mapa->tropas[territorio] += delta;
+    if (r != NULL) {
+        r->tropas[mapa->cor[territorio]] += delta;
+    }
+    if (p != NULL) {
+        placar_tropas_alteradas(p, territorio, delta);
+    }
+}
+
+void mapa_conquistar(MapaTerritorios *mapa, RastreadorMissoes *r, Placar *p, uint32_t territorio,
+                     int nova_cor, int tropas_ocupacao) {
+    uint8_t antiga = mapa->cor[territorio];
+    int tropas_antigas = mapa->tropas[territorio];
+    if (r != NULL) {
+        r->territorios[antiga]--;
+        r->tropas[antiga] -= mapa->tropas[territorio];
+        r->territorios[nova_cor]++;
+        r->tropas[nova_cor] += tropas_ocupacao;
+        r->conquistas[nova_cor]++;
+    }
+    mapa->cor[territorio] = (uint8_t)nova_cor;
+    mapa->tropas[territorio] = tropas_ocupacao;
+    if (p != NULL) {
+        placar_territorio_conquistado(p, territorio, antiga, tropas_antigas);
+    }
+    if (r != NULL) {
+        // A cor antiga perdeu 1 território e a nova ganhou 1 território e 1 conquista.
+        // Missões de destruição só mudam quando a cor alvo chega a 0 ou sai do 0.
+        rastreador_reavaliar_limiar(r, MISSAO_DOMINAR, antiga, r->territorios[antiga] + 1);
+        rastreador_reavaliar_limiar(r, MISSAO_DOMINAR, (uint8_t)nova_cor, r->territorios[nova_cor]);
+        rastreador_reavaliar_limiar(r, MISSAO_CONQUISTAR, (uint8_t)nova_cor, r->conquistas[nova_cor]);
+        if (r->territorios[antiga] == 0) {
+            rastreador_reavaliar_limiar(r, MISSAO_DESTRUIR_COR, antiga, 1);
+        }
+        if (r->territorios[nova_cor] == 1) {
+            rastreador_reavaliar_limiar(r, MISSAO_DESTRUIR_COR, (uint8_t)nova_cor, 1);
+        }
+    }
+}
+
+// Documentação: Ataque completo entre dois territórios do mapa, com as mesmas
+// regras de resolver_batalha(). As perdas e a conquista passam pelas funções de
+// alteração acima, então os contadores das missões e o placar ficam sempre em dia.
+int mapa_atacar(MapaTerritorios *mapa, RastreadorMissoes *r, Placar *p, uint32_t atacante,
+                uint32_t defensor, GeradorAleatorio *g) {
+    int tropas_atq = mapa->tropas[atacante];
+    int tropas_def = mapa->tropas[defensor];
+    while (tropas_atq > 1 && tropas_def > 0) {
+        resolver_rodada(&tropas_atq, &tropas_def, g);
+    }
+    mapa_alterar_tropas(mapa, r, p, atacante, tropas_atq - mapa->tropas[atacante]);
+    mapa_alterar_tropas(mapa, r, p, defensor, tropas_def - mapa->tropas[defensor]);
+    if (tropas_def > 0) {
+        return 0;
+    }
+    mapa_alterar_tropas(mapa, r, p, atacante, -1);
+    mapa_conquistar(mapa, r, p, defensor, mapa->cor[atacante], 1);
+    return 1;
+}
+
+// Documentação: Verificação ingênua, que reconta o mapa inteiro; usada só para
+// comparação no modo de medição.
+static int missao_verificar_varrendo(const MapaTerritorios *mapa, const Missao *m,
+                                     const uint32_t conquistas[MAX_CORES]) {
+    uint32_t territorios[MAX_CORES] = {0};
+    for (size_t i = 0; i < mapa->quantidade; i++) {
+        territorios[mapa->cor[i]]++;
+    }
+    switch (m->tipo) {
+        case MISSAO_DESTRUIR_COR: return territorios[m->cor_alvo] == 0;
+        case MISSAO_CONQUISTAR: return conquistas[m->jogador] >= m->quantidade;
+        case MISSAO_DOMINAR: return territorios[m->jogador] >= m->quantidade;
+    }
+    return 0;
+}
+
+// --- Estado de jogo para a IA ---
+// Documentação: A IA não mexe no mapa de verdade: ela joga sobre cópias leves do
+// estado (só tropas, cores e a contagem de territórios por cor), que podem ser
+// duplicadas milhares de vezes por jogada. As fronteiras são compartilhadas, pois
+// nunca mudam durante a partida.
+#define PASSAR UINT32_MAX
+#define MAX_ACOES_NO 8          // Ataques considerados em cada nó da árvore (+ passar a vez)
+#define MAX_ATAQUES_TURNO 8     // Ataques que um jogador pode fazer por turno
+#define HORIZONTE_ROLLOUT 4     // Turnos simulados em cada rollout
+#define MAX_PROFUNDIDADE 64     // Ações de árvore reproduzidas por rollout
+#define MAX_TURNOS_PARTIDA 60
+
+typedef struct {
+    uint32_t n;
+    int *tropas;
+    uint8_t *cor;
+    uint32_t territorios[MAX_CORES];
+} EstadoJogo;
+
+int estado_criar(EstadoJogo *e, uint32_t n) {
+    e->n = n;
+    e->tropas = malloc((size_t)n * sizeof(int));
+    e->cor = malloc((size_t)n);
+    memset(e->territorios, 0, sizeof(e->territorios));
+    return e->tropas != NULL && e->cor != NULL ? 0 : -1;
+}
+
+void estado_liberar(EstadoJogo *e) {
+    free(e->tropas);
+    free(e->cor);
+    e->tropas = NULL;
+    e->cor = NULL;
+}
+
+void estado_copiar(EstadoJogo *destino, const EstadoJogo *origem) {
+    memcpy(destino->tropas, origem->tropas, (size_t)origem->n * sizeof(int));
+    memcpy(destino->cor, origem->cor, origem->n);
+    memcpy(destino->territorios, origem->territorios, sizeof(origem->territorios));
+}
+
+void estado_de_mapa(EstadoJogo *e, const MapaTerritorios *mapa) {
+    memcpy(e->tropas, mapa->tropas, (size_t)e->n * sizeof(int));
+    memcpy(e->cor, mapa->cor, e->n);
+    memset(e->territorios, 0, sizeof(e->territorios));
+    for (uint32_t v = 0; v < e->n; v++) {
+        e->territorios[e->cor[v]]++;
+    }
+}
+
+// Documentação: Reforço do início do turno: o jogador recebe 1 tropa para cada 3
+// territórios (no mínimo 3), distribuídas em rodízio entre seus territórios de
+// fronteira com o inimigo.
+void estado_reforcar(EstadoJogo *e, const GrafoFronteiras *g, int jogador) {
+    int bonus = (int)(e->territorios[jogador] / 3);
+    if (bonus < 3) bonus = 3;
+    while (bonus > 0) {
+        int colocou = 0;
+        for (uint32_t v = 0; v < e->n && bonus > 0; v++) {
+            if (e->cor[v] != jogador) continue;
+            for (uint64_t k = g->inicio[v]; k < g->inicio[v + 1]; k++) {
+                if (e->cor[g->vizinhos[k]] != jogador) {
+                    e->tropas[v]++;
+                    bonus--;
+                    colocou = 1;
+                    break;
+                }
+            }
+        }
+        if (!colocou) break;
+    }
+}
+
+static inline int estado_ataque_valido(const EstadoJogo *e, int jogador, uint32_t a, uint32_t d) {
+    return e->cor[a] == jogador && e->cor[d] != jogador && e->tropas[a] > 1;
+}
+
+// Documentação: Mesmas regras de mapa_atacar(), sobre o estado da IA.
+int estado_atacar(EstadoJogo *e, uint32_t atacante, uint32_t defensor, GeradorAleatorio *g) {
+    while (e->tropas[atacante] > 1 && e->tropas[defensor] > 0) {
+        resolver_rodada(&e->tropas[atacante], &e->tropas[defensor], g);
+    }
+    if (e->tropas[defensor] > 0) {
+        return 0;
+    }
+    e->territorios[e->cor[defensor]]--;
+    e->territorios[e->cor[atacante]]++;
+    e->cor[defensor] = e->cor[atacante];
+    e->tropas[defensor] = 1;
+    e->tropas[atacante]--;
+    return 1;
+}
+
+// Documentação: Lista até 'max' ataques possíveis do jogador, preferindo os de maior
+// vantagem de tropas. Os pares ficam em 'atacantes'/'defensores'.
+int estado_listar_ataques(const EstadoJogo *e, const GrafoFronteiras *g, int jogador,
+                          uint32_t *atacantes, uint32_t *defensores, int max) {
+    int vantagens[MAX_ACOES_NO];
+    int total = 0;
+    for (uint32_t v = 0; v < e->n; v++) {
+        if (e->cor[v] != jogador || e->tropas[v] < 2) continue;
+        for (uint64_t k = g->inicio[v]; k < g->inicio[v + 1]; k++) {
+            uint32_t w = g->vizinhos[k];
+            if (e->cor[w] == jogador) continue;
+            int vantagem = e->tropas[v] - e->tropas[w];
+            if (total == max && vantagem <= vantagens[total - 1]) continue;
+            int pos = total < max ? total++ : total - 1;
+            while (pos > 0 && vantagens[pos - 1] < vantagem) {
+                vantagens[pos] = vantagens[pos - 1];
+                atacantes[pos] = atacantes[pos - 1];
+                defensores[pos] = defensores[pos - 1];
+                pos--;
+            }
+            vantagens[pos] = vantagem;
+            atacantes[pos] = v;
+            defensores[pos] = w;
+        }
+    }
+    return total;
+}
+
+// Documentação: Política rápida usada nos rollouts e pelo jogador sem IA: sorteia um
+// território próprio e um vizinho inimigo e só ataca com vantagem de tropas.
+// Retorna 1 se atacou e 0 se decidiu passar a vez.
+int politica_aleatoria(EstadoJogo *e, const GrafoFronteiras *g, int jogador, GeradorAleatorio *rng) {
+    for (int tentativa = 0; tentativa < 32; tentativa++) {
+        uint32_t v = (uint32_t)(gerador_proximo(rng) % e->n);
+        uint64_t grau = g->inicio[v + 1] - g->inicio[v];
+        if (e->cor[v] != jogador || e->tropas[v] < 2 || grau == 0) continue;
+        uint32_t w = g->vizinhos[g->inicio[v] + gerador_proximo(rng) % grau];
+        if (e->cor[w] != jogador && e->tropas[v] > e->tropas[w]) {
+            estado_atacar(e, v, w, rng);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Documentação: Joga a partida até o horizonte com a política rápida e devolve o
+// resultado do ponto de vista de 'jogador_ia': 1 vitória, 0 derrota, ou a média
+// entre a fração de territórios e a fração de tropas que ele controla no fim.
+// Só territórios mudam pouco em poucos turnos; as tropas mostram o custo de
+// ataques ruins.
+double jogar_rollout(EstadoJogo *e, const GrafoFronteiras *g, int jogador_ia, int jogador_da_vez,
+                     int ataques_feitos, GeradorAleatorio *rng) {
+    int oponente = 1 - jogador_ia;
+    for (int turno = 0; turno < HORIZONTE_ROLLOUT; turno++) {
+        for (int k = ataques_feitos; k < MAX_ATAQUES_TURNO; k++) {
+            if (!politica_aleatoria(e, g, jogador_da_vez, rng)) break;
+            if (e->territorios[oponente] == 0 || e->territorios[jogador_ia] == 0) break;
+        }
+        if (e->territorios[oponente] == 0) return 1.0;
+        if (e->territorios[jogador_ia] == 0) return 0.0;
+        jogador_da_vez = 1 - jogador_da_vez;
+        ataques_feitos = 0;
+        estado_reforcar(e, g, jogador_da_vez);
+    }
+    int64_t tropas_ia = 0, tropas_oponente = 0;
+    for (uint32_t v = 0; v < e->n; v++) {
+        if (e->cor[v] == jogador_ia) {
+            tropas_ia += e->tropas[v];
+        } else {
+            tropas_oponente += e->tropas[v];
+        }
+    }
+    return 0.5 * (double)e->territorios[jogador_ia]
+               / (double)(e->territorios[jogador_ia] + e->territorios[oponente])
+         + 0.5 * (double)tropas_ia / (double)(tropas_ia + tropas_oponente);
+}
+
+// --- Pool de threads com roubo de trabalho ---
+// Documentação: Cada trabalhador tem sua própria fila dupla de tarefas. Ele consome
+// pelo fim da sua fila e, quando ela esvazia, rouba do começo da fila de outro
+// trabalhador. Como os rollouts têm durações bem diferentes (partidas que acabam
+// cedo ou vão até o horizonte), o roubo mantém todos os núcleos ocupados até o fim
+// do lote sem uma fila central disputada por todos.
+#define CAPACIDADE_DEQUE 1024
+
+typedef void (*FuncaoTarefa)(void *tarefa, int trabalhador);
+
+typedef struct {
+    void *itens[CAPACIDADE_DEQUE];
+    size_t comeco;              // Próximo item a ser roubado
+    size_t fim;                 // Próxima posição livre (o dono consome em fim - 1)
+    pthread_mutex_t trava;
+} DequeTarefas;
+
+typedef struct PoolRoubo PoolRoubo;
+
+typedef struct {
+    PoolRoubo *pool;
+    int id;
+} TrabalhadorPool;
+
+struct PoolRoubo {
+    int num_trabalhadores;
+    pthread_t threads[MAX_THREADS];
+    TrabalhadorPool trabalhadores[MAX_THREADS];
+    DequeTarefas deques[MAX_THREADS];
+    FuncaoTarefa funcao;
+    pthread_mutex_t trava;
+    pthread_cond_t tem_trabalho;
+    pthread_cond_t lote_concluido;
+    size_t pendentes;           // Tarefas enviadas e ainda não concluídas
+    size_t disponiveis;         // Tarefas nas filas, esperando um trabalhador
+    uint64_t roubos;
+    int encerrar;
+};
+
+static void *pool_tarefa_da_fila(DequeTarefas *d, int do_fim) {
+    void *tarefa = NULL;
+    pthread_mutex_lock(&d->trava);
+    if (d->fim > d->comeco) {
+        tarefa = do_fim ? d->itens[--d->fim % CAPACIDADE_DEQUE]
+                        : d->itens[d->comeco++ % CAPACIDADE_DEQUE];
+    }
+    pthread_mutex_unlock(&d->trava);
+    return tarefa;
+}
+
+static void *executar_trabalhador_pool(void *arg) {
+    TrabalhadorPool *t = (TrabalhadorPool *)arg;
+    PoolRoubo *pool = t->pool;
+    GeradorAleatorio escolha_vitima;
+    gerador_semear(&escolha_vitima, (uint64_t)t->id);
+    // Documentação: pool_criar segura a trava até saber quantos trabalhadores
+    // existem; passar por ela garante que 'num_trabalhadores' já é o final.
+    pthread_mutex_lock(&pool->trava);
+    pthread_mutex_unlock(&pool->trava);
+
+    for (;;) {
+        void *tarefa = pool_tarefa_da_fila(&pool->deques[t->id], 1);
+        for (int tentativa = 0; tarefa == NULL && tentativa < 2 * pool->num_trabalhadores; tentativa++) {
+            int vitima = (int)(gerador_proximo(&escolha_vitima) % (uint64_t)pool->num_trabalhadores);
+            if (vitima != t->id && (tarefa = pool_tarefa_da_fila(&pool->deques[vitima], 0)) != NULL) {
+                __atomic_fetch_add(&pool->roubos, 1, __ATOMIC_RELAXED);
+            }
+        }
+        if (tarefa == NULL) {
+            pthread_mutex_lock(&pool->trava);
+            while (!pool->encerrar && pool->disponiveis == 0) {
+                pthread_cond_wait(&pool->tem_trabalho, &pool->trava);
+            }
+            int encerrar = pool->encerrar;
+            pthread_mutex_unlock(&pool->trava);
+            if (encerrar) break;
+            continue;
+        }
+
+        pthread_mutex_lock(&pool->trava);
+        pool->disponiveis--;
+        pthread_mutex_unlock(&pool->trava);
+        pool->funcao(tarefa, t->id);
+        pthread_mutex_lock(&pool->trava);
+        if (--pool->pendentes == 0) {
+            pthread_cond_signal(&pool->lote_concluido);
+        }
+        pthread_mutex_unlock(&pool->trava);
+    }
+    return NULL;
+}
+
+// Documentação: Retorna 0 se todos os trabalhadores foram criados, ou -1 se o pool
+// ficou menor (pool->num_trabalhadores diz quantos; com 0 ele não pode ser usado).
+int pool_criar(PoolRoubo *pool, int num_trabalhadores, FuncaoTarefa funcao) {
+    if (num_trabalhadores < 1) num_trabalhadores = 1;
+    if (num_trabalhadores > MAX_THREADS) num_trabalhadores = MAX_THREADS;
+    pool->num_trabalhadores = num_trabalhadores;
+    pool->funcao = funcao;
+    pool->pendentes = pool->disponiveis = 0;
+    pool->roubos = 0;
+    pool->encerrar = 0;
+    pthread_mutex_init(&pool->trava, NULL);
+    pthread_cond_init(&pool->tem_trabalho, NULL);
+    pthread_cond_init(&pool->lote_concluido, NULL);
+    for (int i = 0; i < num_trabalhadores; i++) {
+        pool->deques[i].comeco = pool->deques[i].fim = 0;
+        pthread_mutex_init(&pool->deques[i].trava, NULL);
+    }
+    pthread_mutex_lock(&pool->trava);
+    int criados = 0;
+    while (criados < num_trabalhadores) {
+        pool->trabalhadores[criados].pool = pool;
+        pool->trabalhadores[criados].id = criados;
+        if (pthread_create(&pool->threads[criados], NULL, executar_trabalhador_pool,
+                           &pool->trabalhadores[criados]) != 0) {
+            break;
+        }
+        criados++;
+    }
+    // O lote só distribui tarefas e rouba entre os trabalhadores que existem.
+    for (int i = criados; i < num_trabalhadores; i++) {
+        pthread_mutex_destroy(&pool->deques[i].trava);
+    }
+    pool->num_trabalhadores = criados;
+    pthread_mutex_unlock(&pool->trava);
+    return criados == num_trabalhadores ? 0 : -1;
+}
+
+// Documentação: Distribui as tarefas entre as filas em rodízio e espera todas
+// terminarem. 'num_tarefas' não pode passar de CAPACIDADE_DEQUE por trabalhador.
+void pool_executar_lote(PoolRoubo *pool, void **tarefas, size_t num_tarefas) {
+    pthread_mutex_lock(&pool->trava);
+    pool->pendentes += num_tarefas;
+    pool->disponiveis += num_tarefas;
+    pthread_mutex_unlock(&pool->trava);
+    for (size_t i = 0; i < num_tarefas; i++) {
+        DequeTarefas *d = &pool->deques[i % (size_t)pool->num_trabalhadores];
+        pthread_mutex_lock(&d->trava);
+        d->itens[d->fim++ % CAPACIDADE_DEQUE] = tarefas[i];
+        pthread_mutex_unlock(&d->trava);
+    }
+    pthread_mutex_lock(&pool->trava);
+    pthread_cond_broadcast(&pool->tem_trabalho);
+    while (pool->pendentes > 0) {
+        pthread_cond_wait(&pool->lote_concluido, &pool->trava);
+    }
+    pthread_mutex_unlock(&pool->trava);
+}
+
+void pool_destruir(PoolRoubo *pool) {
+    pthread_mutex_lock(&pool->trava);
+    pool->encerrar = 1;
+    pthread_cond_broadcast(&pool->tem_trabalho);
+    pthread_mutex_unlock(&pool->trava);
+    // Um trabalhador ainda pode tentar roubar das filas dos outros antes de ver
+    // 'encerrar', então as travas das filas só são destruídas depois de todos.
+    for (int i = 0; i < pool->num_trabalhadores; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    for (int i = 0; i < pool->num_trabalhadores; i++) {
+        pthread_mutex_destroy(&pool->deques[i].trava);
+    }
+    pthread_mutex_destroy(&pool->trava);
+    pthread_cond_destroy(&pool->tem_trabalho);
+    pthread_cond_destroy(&pool->lote_concluido);
+}
+
+// --- IA por busca em árvore Monte Carlo (MCTS) ---
+// Documentação: Cada nó da árvore é uma sequência de ações (ataques ou "passar a
+// vez") a partir do estado atual. Como o resultado das batalhas é aleatório, a
+// árvore é de "laço aberto": cada rollout reproduz as ações do caminho sobre uma
+// cópia nova do estado, com dados novos, e pula ataques que deixaram de ser
+// possíveis. A thread principal escolhe um lote de folhas por UCT (com perda
+// virtual, para espalhar o lote por caminhos diferentes); os rollouts do lote
+// rodam no pool com roubo de trabalho e o resultado volta para a árvore.
+#define SEM_NO UINT32_MAX
+#define CONSTANTE_UCT 0.25   // Baixa: os resultados variam pouco entre ataques parecidos
+#define ROLLOUTS_POR_THREAD_LOTE 8
+
+typedef struct {
+    uint32_t atacante;          // Ação que levou a este nó (PASSAR encerra o turno)
+    uint32_t defensor;
+    uint32_t pai;
+    uint32_t primeiro_filho;    // Os filhos ocupam posições consecutivas
+    uint16_t num_filhos;
+    uint8_t jogador;            // Jogador da vez neste nó
+    uint8_t ataques_feitos;     // Ataques já feitos no turno deste jogador
+    uint8_t expandido;
+    uint32_t visitas;
+    uint32_t perdas_virtuais;
+    double valor;               // Soma dos resultados para quem fez a ação do nó
+} NoMCTS;
+
+typedef struct {
+    const GrafoFronteiras *grafo;
+    const EstadoJogo *raiz;
+    const NoMCTS *nos;
+    int jogador_ia;
+    EstadoJogo rascunho[MAX_THREADS];   // Cópia de trabalho de cada trabalhador do pool
+    GeradorAleatorio rng[MAX_THREADS];
+} ContextoMCTS;
+
+typedef struct {
+    ContextoMCTS *ctx;
+    uint32_t folha;
+    uint32_t caminho[MAX_PROFUNDIDADE];
+    int profundidade;
+    double resultado;
+    int num_acoes;              // Ataques possíveis na folha, para expandi-la
+    uint32_t atacantes[MAX_ACOES_NO];
+    uint32_t defensores[MAX_ACOES_NO];
+} TarefaRollout;
+
+// Documentação: Função de tarefa do pool: um rollout a partir da folha da tarefa.
+void executar_rollout(void *arg, int trabalhador) {
+    TarefaRollout *t = (TarefaRollout *)arg;
+    ContextoMCTS *ctx = t->ctx;
+    EstadoJogo *e = &ctx->rascunho[trabalhador];
+    GeradorAleatorio *rng = &ctx->rng[trabalhador];
+    estado_copiar(e, ctx->raiz);
+
+    // Reproduz as ações da raiz até a folha (caminho[0] é a raiz).
+    for (int i = 1; i < t->profundidade; i++) {
+        const NoMCTS *no = &ctx->nos[t->caminho[i]];
+        int jogador = ctx->nos[no->pai].jogador;
+        if (no->atacante == PASSAR) {
+            estado_reforcar(e, ctx->grafo, 1 - jogador);
+        } else if (estado_ataque_valido(e, jogador, no->atacante, no->defensor)) {
+            estado_atacar(e, no->atacante, no->defensor, rng);
+        }
+    }
+    const NoMCTS *folha = &ctx->nos[t->folha];
+    t->num_acoes = folha->ataques_feitos < MAX_ATAQUES_TURNO
+                 ? estado_listar_ataques(e, ctx->grafo, folha->jogador, t->atacantes,
+                                         t->defensores, MAX_ACOES_NO)
+                 : 0;
+    t->resultado = jogar_rollout(e, ctx->grafo, ctx->jogador_ia, folha->jogador,
+                                 folha->ataques_feitos, rng);
+}
+
+typedef struct {
+    NoMCTS *nos;
+    size_t num_nos;
+    size_t capacidade;
+} ArvoreMCTS;
+
+static uint32_t arvore_novo_no(ArvoreMCTS *a, uint32_t pai, uint32_t atacante, uint32_t defensor,
+                               int jogador, int ataques_feitos) {
+    if (a->num_nos == a->capacidade) {
+        size_t nova = a->capacidade ? a->capacidade * 2 : 4096;
+        NoMCTS *nos = realloc(a->nos, nova * sizeof(NoMCTS));
+        if (nos == NULL) return SEM_NO;
+        a->nos = nos;
+        a->capacidade = nova;
+    }
+    NoMCTS *no = &a->nos[a->num_nos];
+    memset(no, 0, sizeof(*no));
+    no->atacante = atacante;
+    no->defensor = defensor;
+    no->pai = pai;
+    no->primeiro_filho = SEM_NO;
+    no->jogador = (uint8_t)jogador;
+    no->ataques_feitos = (uint8_t)ataques_feitos;
+    return (uint32_t)a->num_nos++;
+}
+
+// Documentação: Cria os filhos de um nó: um por ataque listado e um para passar a vez.
+static void arvore_expandir(ArvoreMCTS *a, uint32_t no, const uint32_t *atacantes,
+                            const uint32_t *defensores, int num_acoes) {
+    if (a->nos[no].expandido) return;
+    int jogador = a->nos[no].jogador;
+    int feitos = a->nos[no].ataques_feitos;
+    uint32_t primeiro = arvore_novo_no(a, no, PASSAR, PASSAR, 1 - jogador, 0);
+    if (primeiro == SEM_NO) return;
+    for (int i = 0; i < num_acoes; i++) {
+        if (arvore_novo_no(a, no, atacantes[i], defensores[i], jogador, feitos + 1) == SEM_NO) {
+            num_acoes = i;
+            break;
+        }
+    }
+    a->nos[no].primeiro_filho = primeiro;
+    a->nos[no].num_filhos = (uint16_t)(num_acoes + 1);
+    a->nos[no].expandido = 1;
+}
+
+static uint32_t arvore_selecionar_filho(const ArvoreMCTS *a, uint32_t no) {
+    const NoMCTS *pai = &a->nos[no];
+    double log_pai = log((double)(pai->visitas + pai->perdas_virtuais) + 1.0);
+    uint32_t melhor = SEM_NO;
+    double melhor_valor = -1.0;
+    for (uint32_t f = pai->primeiro_filho; f < pai->primeiro_filho + pai->num_filhos; f++) {
+        const NoMCTS *filho = &a->nos[f];
+        double n = (double)(filho->visitas + filho->perdas_virtuais);
+        // Filhos nunca visitados são explorados primeiro.
+        double valor = n == 0 ? 1e9 : filho->valor / n + CONSTANTE_UCT * sqrt(log_pai / n);
+        if (valor > melhor_valor) {
+            melhor_valor = valor;
+            melhor = f;
+        }
+    }
+    return melhor;
+}
+
+typedef struct {
+    uint32_t atacante;          // PASSAR quando a IA decide encerrar o turno
+    uint32_t defensor;
+    uint64_t rollouts;
+    double segundos;
+} DecisaoIA;
+
+// Documentação: Escolhe a próxima ação do 'jogador' no estado 'raiz' usando até
+// 'orcamento_ms' milissegundos. Retorna a ação do filho da raiz mais visitado.
+DecisaoIA mcts_escolher(PoolRoubo *pool, ContextoMCTS *ctx, const EstadoJogo *raiz,
+                        const GrafoFronteiras *grafo, int jogador, int ataques_feitos,
+                        double orcamento_ms) {
+    DecisaoIA decisao = {PASSAR, PASSAR, 0, 0.0};
+    ArvoreMCTS arvore = {NULL, 0, 0};
+    size_t tamanho_lote = (size_t)pool->num_trabalhadores * ROLLOUTS_POR_THREAD_LOTE;
+    TarefaRollout *tarefas = malloc(tamanho_lote * sizeof(TarefaRollout));
+    void **ponteiros = malloc(tamanho_lote * sizeof(void *));
+    if (tarefas == NULL || ponteiros == NULL
+        || arvore_novo_no(&arvore, SEM_NO, PASSAR, PASSAR, jogador, ataques_feitos) == SEM_NO) {
+        free(tarefas);
+        free(ponteiros);
+        free(arvore.nos);
+        return decisao;
+    }
+
+    uint32_t atacantes[MAX_ACOES_NO], defensores[MAX_ACOES_NO];
+    int num_acoes = ataques_feitos < MAX_ATAQUES_TURNO
+                  ? estado_listar_ataques(raiz, grafo, jogador, atacantes, defensores, MAX_ACOES_NO)
+                  : 0;
+    if (num_acoes == 0) {
+        free(tarefas);
+        free(ponteiros);
+        free(arvore.nos);
+        return decisao;
+    }
+    arvore_expandir(&arvore, 0, atacantes, defensores, num_acoes);
+
+    ctx->grafo = grafo;
+    ctx->raiz = raiz;
+    ctx->jogador_ia = jogador;
+    double inicio = segundos_agora();
+    do {
+        // 1. Seleção: desce por UCT até uma folha, aplicando perda virtual.
+        for (size_t i = 0; i < tamanho_lote; i++) {
+            TarefaRollout *t = &tarefas[i];
+            uint32_t no = 0;
+            t->ctx = ctx;
+            t->profundidade = 0;
+            t->caminho[t->profundidade++] = no;
+            arvore.nos[no].perdas_virtuais++;
+            while (arvore.nos[no].expandido && t->profundidade < MAX_PROFUNDIDADE) {
+                no = arvore_selecionar_filho(&arvore, no);
+                t->caminho[t->profundidade++] = no;
+                arvore.nos[no].perdas_virtuais++;
+            }
+            t->folha = no;
+            ponteiros[i] = t;
+        }
+        // 2. Simulação em paralelo.
+        ctx->nos = arvore.nos;
+        pool_executar_lote(pool, ponteiros, tamanho_lote);
+        // 3. Expansão e retropropagação.
+        for (size_t i = 0; i < tamanho_lote; i++) {
+            TarefaRollout *t = &tarefas[i];
+            for (int k = 0; k < t->profundidade; k++) {
+                NoMCTS *no = &arvore.nos[t->caminho[k]];
+                int quem_agiu = no->pai == SEM_NO ? jogador : arvore.nos[no->pai].jogador;
+                no->perdas_virtuais--;
+                no->visitas++;
+                no->valor += quem_agiu == jogador ? t->resultado : 1.0 - t->resultado;
+            }
+            if (t->profundidade < MAX_PROFUNDIDADE) {
+                arvore_expandir(&arvore, t->folha, t->atacantes, t->defensores, t->num_acoes);
+            }
+        }
+        decisao.rollouts += tamanho_lote;
+    } while ((segundos_agora() - inicio) * 1e3 < orcamento_ms);
+    decisao.segundos = segundos_agora() - inicio;
+
+    uint32_t melhor = SEM_NO;
+    for (uint32_t f = arvore.nos[0].primeiro_filho;
+         f < arvore.nos[0].primeiro_filho + arvore.nos[0].num_filhos; f++) {
+        if (melhor == SEM_NO || arvore.nos[f].visitas > arvore.nos[melhor].visitas) {
+            melhor = f;
+        }
+    }
+    decisao.atacante = arvore.nos[melhor].atacante;
+    decisao.defensor = arvore.nos[melhor].defensor;
+    free(tarefas);
+    free(ponteiros);
+    free(arvore.nos);
+    return decisao;
+}
+
+// --- Entrada do jogador ---
+// Documentação: O cadastro lê a entrada padrão pelo leitor de entrada.h, em blocos
+// grandes e linha a linha. Cada leitura consome a linha inteira, então não é mais
+// preciso limpar o buffer entre um número e o próximo texto.
+Entrada entrada_padrao;
+
+// --- Modo de simulação pela linha de comando ---
+// Documentação: "./War --simular [max_atacante] [max_defensor] [batalhas] [threads] [semente]"
+// roda o simulador sem nenhuma pergunta ao usuário. Parâmetros omitidos usam os padrões.
+int executar_modo_simulacao(int argc, char *argv[]) {
+    int max_atacante = argc > 2 ? atoi(argv[2]) : 10;
+    int max_defensor = argc > 3 ? atoi(argv[3]) : 10;
+    uint64_t batalhas = argc > 4 ? strtoull(argv[4], NULL, 10) : 100000;
+    int num_threads = argc > 5 ? atoi(argv[5]) : numero_de_nucleos();
+    uint64_t semente = argc > 6 ? strtoull(argv[6], NULL, 10) : (uint64_t)time(NULL);
+
+    if (max_atacante < 2 || max_defensor < 1 || batalhas == 0) {
+        printf("[ERRO] Parâmetros inválidos: atacante >= 2, defensor >= 1, batalhas > 0.\n");
+        return 1;
+    }
+    if (num_threads < 1) num_threads = 1;
+    if (num_threads > MAX_THREADS) num_threads = MAX_THREADS;
+
+    return simular_batalhas(max_atacante, max_defensor, batalhas, num_threads, semente);
+}
+
+// --- Modo de mapa sintético ---
+// Documentação: "./War --mapa-sintetico [territorios] [cores] [semente]" gera um mapa
+// grande no armazenamento colunar e mede a varredura de tropas por cor, comparando
+// a memória usada com a de um vetor de 'struct Territorio'.
+int executar_modo_mapa_sintetico(int argc, char *argv[]) {
+    size_t quantidade = argc > 2 ? strtoull(argv[2], NULL, 10) : 1000000;
+    int num_cores = argc > 3 ? atoi(argv[3]) : 6;
+    uint64_t semente = argc > 4 ? strtoull(argv[4], NULL, 10) : 42;
+    if (quantidade == 0 || num_cores < 1 || num_cores > MAX_CORES) {
+        printf("[ERRO] Parâmetros inválidos: territorios > 0 e 1 <= cores <= %d.\n", MAX_CORES);
+        return 1;
+    }
+
+    MapaTerritorios mapa;
+    mapa_inicializar(&mapa);
+    double inicio = segundos_agora();
+    if (mapa_gerar_sintetico(&mapa, quantidade, num_cores, semente) != 0) {
+        printf("[ERRO] Falha na alocação de memória para o mapa.\n");
+        mapa_liberar(&mapa);
+        return 1;
+    }
+    double geracao = segundos_agora() - inicio;
+
+    int64_t tropas[MAX_CORES];
+    uint32_t territorios[MAX_CORES];
+    const int repeticoes = 20;
+    inicio = segundos_agora();
+    for (int r = 0; r < repeticoes; r++) {
+        mapa_tropas_por_cor(&mapa, tropas, territorios);
+    }
+    double varredura = (segundos_agora() - inicio) / repeticoes;
+
+    printf("--- MAPA SINTÉTICO ---\n");
+    printf("Territórios: %zu | Cores: %d | Geração: %.3f s\n", mapa.quantidade, mapa.num_cores, geracao);
+    imprimir_resumo_cores(&mapa);
+    printf("\nVarredura de tropas por cor: %.3f ms (%.0f territórios/s)\n",
+           varredura * 1e3, (double)mapa.quantidade / varredura);
+    printf("Memória: %.1f bytes/território (vetor de struct Territorio: %zu bytes/território)\n",
+           (double)mapa_bytes_usados(&mapa) / (double)mapa.quantidade, sizeof(struct Territorio));
+
+    mapa_liberar(&mapa);
+    return 0;
+}
+
+// --- Modos de snapshot ---
+// Documentação: "./War --salvar-sintetico arquivo [territorios] [cores] [semente]" gera
+// um mapa e o grava em snapshot; "./War --carregar arquivo" abre um snapshot e mostra
+// o resumo do mapa, medindo o tempo de cada operação.
+int executar_modo_salvar_sintetico(int argc, char *argv[]) {
+    if (argc < 3) {
+        printf("[ERRO] Informe o arquivo: ./War --salvar-sintetico arquivo [territorios] [cores] [semente]\n");
+        return 1;
+    }
+    size_t quantidade = argc > 3 ? strtoull(argv[3], NULL, 10) : 1000000;
+    int num_cores = argc > 4 ? atoi(argv[4]) : 6;
+    uint64_t semente = argc > 5 ? strtoull(argv[5], NULL, 10) : 42;
+    if (num_cores < 1 || num_cores > MAX_CORES) {
+        printf("[ERRO] O número de cores deve ficar entre 1 e %d.\n", MAX_CORES);
+        return 1;
+    }
+
+    MapaTerritorios mapa;
+    mapa_inicializar(&mapa);
+    if (mapa_gerar_sintetico(&mapa, quantidade, num_cores, semente) != 0
+        || grafo_gerar_sintetico(&mapa, 0.05, semente + 1) != 0) {
+        printf("[ERRO] Falha na alocação de memória para o mapa.\n");
+        mapa_liberar(&mapa);
+        return 1;
+    }
+    double inicio = segundos_agora();
+    int resultado = snapshot_salvar(&mapa, argv[2]);
+    double duracao = segundos_agora() - inicio;
+    if (resultado != 0) {
+        printf("[ERRO] Não foi possível gravar o snapshot '%s'.\n", argv[2]);
+    } else {
+        CabecalhoSnapshot cab;
+        snapshot_montar_cabecalho(&mapa, SNAPSHOT_VERSAO, &cab);
+        printf("Snapshot '%s' gravado: %zu territórios, %llu fronteiras, %.1f MB em %.3f s (%.0f MB/s)\n",
+               argv[2], mapa.quantidade, (unsigned long long)(mapa.fronteiras.num_arestas / 2),
+               cab.tamanho_total / 1e6, duracao,
+               cab.tamanho_total / 1e6 / duracao);
+    }
+    mapa_liberar(&mapa);
+    return resultado != 0;
+}
+
+void exibir_mapa(const MapaTerritorios *mapa, size_t limite) {
+    for (size_t i = 0; i < mapa->quantidade && i < limite; i++) {
+        printf("\nTerritório %zu:\n", i + 1);
+        printf("  Nome: %s\n", mapa_nome(mapa, i));
+        printf("  Cor do Exército: %s\n", mapa_cor(mapa, i));
+        printf("  Quantidade de Tropas: %d\n", mapa->tropas[i]);
+    }
+    if (mapa->quantidade > limite) {
+        printf("\n... e mais %zu territórios.\n", mapa->quantidade - limite);
+    }
+}
+
+int executar_modo_carregar(int argc, char *argv[]) {
+    if (argc < 3) {
+        printf("[ERRO] Informe o arquivo: ./War --carregar arquivo\n");
+        return 1;
+    }
+    MapaTerritorios mapa;
+    mapa_inicializar(&mapa);
+    double inicio = segundos_agora();
+    if (snapshot_carregar(&mapa, argv[2]) != 0) {
+        printf("[ERRO] Snapshot '%s' ausente, corrompido ou de versão incompatível.\n", argv[2]);
+        return 1;
+    }
+    double duracao = segundos_agora() - inicio;
+
+    printf("--- MAPA CARREGADO DE '%s' ---\n", argv[2]);
+    printf("Territórios: %zu | Cores: %d | Carregamento: %.3f ms\n",
+           mapa.quantidade, mapa.num_cores, duracao * 1e3);
+    exibir_mapa(&mapa, 10);
+    printf("\n");
+    imprimir_resumo_cores(&mapa);
+    mapa_liberar(&mapa);
+    return 0;
+}
+
+// --- Modo de consultas de fronteira ---
+// Documentação: "./War --fronteiras arquivo cor [destino] [threads]" carrega um snapshot
+// com fronteiras e, para a cor informada, lista os alvos atacáveis, as regiões
+// conexas e a rota de conquista mais curta até o território 'destino' (1..N).
+int executar_modo_fronteiras(int argc, char *argv[]) {
+    if (argc < 4) {
+        printf("[ERRO] Uso: ./War --fronteiras arquivo cor [destino] [threads]\n");
+        return 1;
+    }
+    MapaTerritorios mapa;
+    mapa_inicializar(&mapa);
+    if (snapshot_carregar(&mapa, argv[2]) != 0) {
+        printf("[ERRO] Snapshot '%s' ausente, corrompido ou de versão incompatível.\n", argv[2]);
+        return 1;
+    }
+    if (mapa.fronteiras.num_vertices == 0) {
+        printf("[ERRO] O mapa '%s' não tem fronteiras cadastradas.\n", argv[2]);
+        mapa_liberar(&mapa);
+        return 1;
+    }
+    int cor = -1;
+    for (int c = 0; c < mapa.num_cores; c++) {
+        if (strcmp(mapa.cores[c], argv[3]) == 0) cor = c;
+    }
+    if (cor < 0) {
+        printf("[ERRO] Cor '%s' não existe no mapa.\n", argv[3]);
+        mapa_liberar(&mapa);
+        return 1;
+    }
+    size_t n = mapa.quantidade;
+    uint32_t destino = argc > 4 ? (uint32_t)(strtoul(argv[4], NULL, 10) - 1) : (uint32_t)(n - 1);
+    int num_threads = argc > 5 ? atoi(argv[5]) : numero_de_nucleos();
+    if (destino >= n) {
+        printf("[ERRO] Território de destino deve estar entre 1 e %zu.\n", n);
+        mapa_liberar(&mapa);
+        return 1;
+    }
+
+    uint8_t *alvo = malloc(n);
+    uint32_t *marca = malloc(n * sizeof(uint32_t));
+    uint32_t *predecessor = malloc(n * sizeof(uint32_t));
+    uint32_t *fronteira = malloc(n * sizeof(uint32_t));
+    uint32_t *proxima = malloc(n * sizeof(uint32_t));
+    uint32_t *rota = malloc(n * sizeof(uint32_t));
+    if (!alvo || !marca || !predecessor || !fronteira || !proxima || !rota) {
+        printf("[ERRO] Falha na alocação de memória para as consultas.\n");
+        free(alvo); free(marca); free(predecessor); free(fronteira); free(proxima); free(rota);
+        mapa_liberar(&mapa);
+        return 1;
+    }
+    EquipeThreads equipe;
+    if (equipe_criar(&equipe, num_threads) != 0) {
+        printf("[ALERTA] Só foi possível criar %d de %d threads; as consultas seguem com elas.\n",
+               equipe.num_threads, num_threads);
+    }
+
+    printf("--- CONSULTAS DE FRONTEIRA (%s) ---\n", mapa.cores[cor]);
+    printf("Territórios: %zu | Fronteiras: %llu | Threads: %d\n", n,
+           (unsigned long long)(mapa.fronteiras.num_arestas / 2), equipe.num_threads);
+
+    double inicio = segundos_agora();
+    size_t num_alvos = consultar_alvos(&equipe, &mapa, cor, alvo);
+    printf("Alvos atacáveis: %zu (%.3f ms)\n", num_alvos, (segundos_agora() - inicio) * 1e3);
+
+    size_t maior_regiao;
+    inicio = segundos_agora();
+    uint32_t regioes = consultar_regioes(&equipe, &mapa, cor, marca, fronteira, proxima, &maior_regiao);
+    printf("Regiões conexas: %u, a maior com %zu territórios (%.3f ms)\n",
+           regioes, maior_regiao, (segundos_agora() - inicio) * 1e3);
+
+    inicio = segundos_agora();
+    size_t tamanho = consultar_rota(&equipe, &mapa, cor, destino, marca, predecessor,
+                                    fronteira, proxima, rota);
+    double duracao = segundos_agora() - inicio;
+    if (tamanho == 0) {
+        printf("Rota até '%s': inalcançável (%.3f ms)\n", mapa_nome(&mapa, destino), duracao * 1e3);
+    } else {
+        printf("Rota até '%s': %zu conquista(s) (%.3f ms)\n  ",
+               mapa_nome(&mapa, destino), tamanho - 1, duracao * 1e3);
+        for (size_t i = 0; i < tamanho; i++) {
+            printf("%s%s", i ? " -> " : "", mapa_nome(&mapa, rota[i]));
+        }
+        printf("\n");
+    }
+
+    equipe_destruir(&equipe);
+    free(alvo); free(marca); free(predecessor); free(fronteira); free(proxima); free(rota);
+    mapa_liberar(&mapa);
+    return 0;
+}
+
+// --- Modo de campanha com missões ---
+// Documentação: "./War --missoes arquivo [ataques] [missoes] [semente]" carrega um mapa
+// com fronteiras, sorteia missões para todas as cores e joga ataques aleatórios
+// entre territórios vizinhos, verificando a missão do atacante depois de cada
+// ataque. No final compara o custo da verificação incremental com o da varredura.
+int executar_modo_missoes(int argc, char *argv[]) {
+    uint64_t ataques = argc > 3 ? strtoull(argv[3], NULL, 10) : 1000000;
+    size_t num_missoes = argc > 4 ? strtoull(argv[4], NULL, 10) : 10000;
+    uint64_t semente = argc > 5 ? strtoull(argv[5], NULL, 10) : 42;
+    // As comparações do final sorteiam entre as missões: é preciso ao menos uma.
+    if (argc < 3 || num_missoes == 0) {
+        printf("[ERRO] Uso: ./War --missoes arquivo [ataques] [missoes >= 1] [semente]\n");
+        return 1;
+    }
+
+    MapaTerritorios mapa;
+    mapa_inicializar(&mapa);
+    if (snapshot_carregar(&mapa, argv[2]) != 0 || mapa.fronteiras.num_vertices == 0) {
+        printf("[ERRO] O snapshot '%s' não existe ou não tem fronteiras.\n", argv[2]);
+        mapa_liberar(&mapa);
+        return 1;
+    }
+
+    GeradorAleatorio g;
+    gerador_semear(&g, semente);
+    RastreadorMissoes r;
+    rastreador_iniciar(&r, &mapa);
+    long missao_da_cor[MAX_CORES];
+    for (size_t i = 0; i < num_missoes; i++) {
+        int jogador = (int)(i % (size_t)mapa.num_cores);
+        int tipo = (int)(gerador_proximo(&g) % 3);
+        int alvo = (int)(gerador_proximo(&g) % (uint64_t)mapa.num_cores);
+        uint32_t quantidade = tipo == MISSAO_CONQUISTAR
+                            ? 3 + (uint32_t)(gerador_proximo(&g) % 1000)
+                            : r.territorios[jogador] + 1 + (uint32_t)(gerador_proximo(&g) % 1000);
+        long id = rastreador_adicionar_missao(&r, (TipoMissao)tipo, jogador, alvo, quantidade);
+        if (id < 0) {
+            printf("[ERRO] Falha na alocação de memória para as missões.\n");
+            rastreador_liberar(&r);
+            mapa_liberar(&mapa);
+            return 1;
+        }
+        if (i < (size_t)mapa.num_cores) {
+            missao_da_cor[jogador] = id;
+        }
+    }
+
+    const GrafoFronteiras *fr = &mapa.fronteiras;
+    uint64_t conquistas = 0, verificacoes_cumpridas = 0;
+    double inicio = segundos_agora();
+    for (uint64_t a = 0; a < ataques; a++) {
+        uint32_t v = (uint32_t)(gerador_proximo(&g) % fr->num_vertices);
+        uint64_t grau = grafo_grau(fr, v);
+        if (mapa.tropas[v] < 2 || grau == 0) {
+            // Fase de reforço simplificada: o território recebe tropas novas.
+            mapa_alterar_tropas(&mapa, &r, NULL, v, 3);
+            continue;
+        }
+        uint32_t w = fr->vizinhos[fr->inicio[v] + gerador_proximo(&g) % grau];
+        if (mapa.cor[w] == mapa.cor[v]) {
+            continue;
+        }
+        int cor_atacante = mapa.cor[v];
+        conquistas += (uint64_t)mapa_atacar(&mapa, &r, NULL, v, w, &g);
+        if (cor_atacante < (int)num_missoes) {
+            verificacoes_cumpridas += (uint64_t)verificar_missao(&r, (size_t)missao_da_cor[cor_atacante]);
+        }
+    }
+    double duracao = segundos_agora() - inicio;
+
+    printf("--- CAMPANHA COM MISSÕES ---\n");
+    printf("Territórios: %zu | Missões: %zu | Ataques: %llu | Conquistas: %llu\n",
+           mapa.quantidade, r.num_missoes, (unsigned long long)ataques,
+           (unsigned long long)conquistas);
+    printf("Missões cumpridas no final: %zu | Verificações com missão cumprida: %llu\n",
+           r.cumpridas, (unsigned long long)verificacoes_cumpridas);
+    printf("Turnos (ataque + verificação): %.0f/s\n", (double)ataques / duracao);
+
+    // Comparação: mesmas verificações feitas com varredura do mapa inteiro.
+    const int amostras = 20;
+    int iguais = 1;
+    inicio = segundos_agora();
+    for (int k = 0; k < amostras; k++) {
+        size_t m = (size_t)k % r.num_missoes;
+        iguais &= missao_verificar_varrendo(&mapa, &r.missoes[m], r.conquistas) == verificar_missao(&r, m);
+    }
+    double varredura = (segundos_agora() - inicio) / amostras;
+    inicio = segundos_agora();
+    uint64_t soma = 0;
+    for (uint64_t k = 0; k < 10000000; k++) {
+        soma += (uint64_t)verificar_missao(&r, (size_t)(k % r.num_missoes));
+    }
+    double incremental = (segundos_agora() - inicio) / 1e7;
+    printf("Verificação incremental: %.1f ns | Varredura do mapa: %.3f ms | Resultados %s (%llu)\n",
+           incremental * 1e9, varredura * 1e3, iguais ? "conferem" : "DIVERGEM",
+           (unsigned long long)soma);
+
+    rastreador_liberar(&r);
+    mapa_liberar(&mapa);
+    return iguais ? 0 : 1;
+}
+
+// --- Modo placar ---
+// Documentação: Top-k por varredura completa do mapa, mantendo os k melhores em
+// ordem por inserção. Usado só para conferir o placar e comparar o custo.
+static size_t placar_top_varrendo(const MapaTerritorios *mapa, int cor, size_t k, uint32_t *saida) {
+    size_t escritos = 0;
+    for (size_t t = 0; t < mapa->quantidade; t++) {
+        if (cor >= 0 && mapa->cor[t] != cor) {
+            continue;
+        }
+        int tropas = mapa->tropas[t];
+        size_t i = escritos < k ? escritos++ : k;
+        // Empates mantêm o território de menor índice, como no placar.
+        while (i > 0 && tropas > mapa->tropas[saida[i - 1]]) {
+            if (i < k) {
+                saida[i] = saida[i - 1];
+            }
+            i--;
+        }
+        if (i < k) {
+            saida[i] = (uint32_t)t;
+        }
+    }
+    return escritos;
 }
 
-int main() {
-    // Declaração do vetor de structs
-    struct Territorio territorios[NUM_TERRITORIOS];
-    int i; // Variável de controle para os laços
+// Documentação: "./War --placar arquivo [k] [ataques] [semente]" carrega um mapa com
+// fronteiras, monta o placar e joga ataques aleatórios entre vizinhos mantendo o
+// placar atualizado. No final mostra o top-k geral e o da cor líder, conferindo
+// com uma varredura do mapa e comparando o tempo das duas consultas.
+int executar_modo_placar(int argc, char *argv[]) {
+    if (argc < 3) {
+        printf("[ERRO] Uso: ./War --placar arquivo [k] [ataques] [semente]\n");
+        return 1;
+    }
+    size_t k = argc > 3 ? strtoull(argv[3], NULL, 10) : 10;
+    uint64_t ataques = argc > 4 ? strtoull(argv[4], NULL, 10) : 1000000;
+    uint64_t semente = argc > 5 ? strtoull(argv[5], NULL, 10) : 42;
+    if (k == 0) {
+        k = 1;
+    }
+
+    MapaTerritorios mapa;
+    mapa_inicializar(&mapa);
+    if (snapshot_carregar(&mapa, argv[2]) != 0 || mapa.fronteiras.num_vertices == 0) {
+        printf("[ERRO] O snapshot '%s' não existe ou não tem fronteiras.\n", argv[2]);
+        mapa_liberar(&mapa);
+        return 1;
+    }
+
+    Placar placar;
+    double inicio = segundos_agora();
+    int falhou = placar_iniciar(&placar, &mapa) != 0;
+    double montagem = segundos_agora() - inicio;
+    uint32_t *top = malloc(k * sizeof(uint32_t));
+    uint32_t *conferencia = malloc(k * sizeof(uint32_t));
+    if (falhou || top == NULL || conferencia == NULL) {
+        printf("[ERRO] Falha na alocação de memória para o placar.\n");
+        free(top); free(conferencia);
+        placar_liberar(&placar);
+        mapa_liberar(&mapa);
+        return 1;
+    }
+
+    GeradorAleatorio g;
+    gerador_semear(&g, semente);
+    const GrafoFronteiras *fr = &mapa.fronteiras;
+    uint64_t conquistas = 0;
+    inicio = segundos_agora();
+    for (uint64_t a = 0; a < ataques; a++) {
+        uint32_t v = (uint32_t)(gerador_proximo(&g) % fr->num_vertices);
+        uint64_t grau = grafo_grau(fr, v);
+        if (mapa.tropas[v] < 2 || grau == 0) {
+            mapa_alterar_tropas(&mapa, NULL, &placar, v, 3);
+            continue;
+        }
+        uint32_t w = fr->vizinhos[fr->inicio[v] + gerador_proximo(&g) % grau];
+        if (mapa.cor[w] != mapa.cor[v]) {
+            conquistas += (uint64_t)mapa_atacar(&mapa, NULL, &placar, v, w, &g);
+        }
+    }
+    double duracao = segundos_agora() - inicio;
+
+    printf("--- PLACAR DOS TERRITÓRIOS ---\n");
+    printf("Territórios: %zu | Montagem: %.1f ms | Ataques: %llu | Conquistas: %llu | %.0f ataques/s\n",
+           mapa.quantidade, montagem * 1e3, (unsigned long long)ataques,
+           (unsigned long long)conquistas, (double)ataques / duracao);
+
+    int lider = placar_cor_lider(&placar);
+    int iguais = 1;
+    for (int consulta = 0; consulta < 2; consulta++) {
+        int cor = consulta == 0 ? -1 : lider;
+        const int repeticoes = 1000;
+        inicio = segundos_agora();
+        size_t obtidos = 0;
+        for (int i = 0; i < repeticoes; i++) {
+            obtidos = placar_top(&placar, cor, k, top);
+        }
+        double tempo_placar = (segundos_agora() - inicio) / repeticoes;
+        inicio = segundos_agora();
+        size_t esperados = placar_top_varrendo(&mapa, cor, k, conferencia);
+        double tempo_varredura = segundos_agora() - inicio;
+        iguais &= obtidos == esperados && memcmp(top, conferencia, obtidos * sizeof(uint32_t)) == 0;
+
+        if (cor < 0) {
+            printf("\nTop %zu geral:\n", obtidos);
+        } else {
+            printf("\nCor líder: %s (%lld tropas) | Top %zu da cor:\n", mapa.cores[cor],
+                   (long long)placar.tropas_cor[cor], obtidos);
+        }
+        for (size_t i = 0; i < obtidos; i++) {
+            printf("  %2zu. %-12s %-10s %d tropas\n", i + 1, mapa_nome(&mapa, top[i]),
+                   mapa_cor(&mapa, top[i]), mapa.tropas[top[i]]);
+        }
+        printf("Consulta no placar: %.2f us | Varredura do mapa: %.3f ms\n",
+               tempo_placar * 1e6, tempo_varredura * 1e3);
+    }
+    int64_t tropas_recontadas[MAX_CORES];
+    uint32_t territorios_recontados[MAX_CORES];
+    mapa_tropas_por_cor(&mapa, tropas_recontadas, territorios_recontados);
+    for (int c = 0; c < mapa.num_cores; c++) {
+        iguais &= tropas_recontadas[c] == placar.tropas_cor[c] &&
+                  territorios_recontados[c] == placar.por_cor[c].tamanho;
+    }
+    printf("\nResultados %s com a varredura.\n", iguais ? "conferem" : "DIVERGEM");
+
+    free(top); free(conferencia);
+    placar_liberar(&placar);
+    mapa_liberar(&mapa);
+    return iguais ? 0 : 1;
+}
+
+// --- Modo torneio entre IAs ---
+// Documentação: "./War --torneio [territorios] [partidas] [ms_azul] [ms_verde] [threads] [semente]"
+// joga partidas entre dois exércitos em um mapa sintético com fronteiras. Cada
+// jogador usa a MCTS com o orçamento de tempo indicado por jogada; orçamento 0
+// usa a política aleatória dos rollouts, servindo de adversário de referência.
+
+// Documentação: Libera tudo o que o torneio aloca; serve tanto para o fim normal
+// quanto para uma alocação que falhou no meio (ponteiros nulos são ignorados).
+static void torneio_liberar(ContextoMCTS *ctx, int num_threads, EstadoJogo *inicial, EstadoJogo *estado,
+                            MapaTerritorios *mapa) {
+    for (int t = 0; ctx != NULL && t < num_threads; t++) {
+        estado_liberar(&ctx->rascunho[t]);
+    }
+    free(ctx);
+    estado_liberar(inicial);
+    estado_liberar(estado);
+    mapa_liberar(mapa);
+}
+
+int executar_modo_torneio(int argc, char *argv[]) {
+    uint32_t territorios = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 42;
+    int partidas = argc > 3 ? atoi(argv[3]) : 4;
+    double orcamento[2];
+    orcamento[0] = argc > 4 ? atof(argv[4]) : 20.0;
+    orcamento[1] = argc > 5 ? atof(argv[5]) : 0.0;
+    int num_threads = argc > 6 ? atoi(argv[6]) : numero_de_nucleos();
+    uint64_t semente = argc > 7 ? strtoull(argv[7], NULL, 10) : 42;
+    if (territorios < 4 || partidas < 1) {
+        printf("[ERRO] São necessários pelo menos 4 territórios e 1 partida.\n");
+        return 1;
+    }
+    if (num_threads < 1) num_threads = 1;
+    if (num_threads > MAX_THREADS) num_threads = MAX_THREADS;
+
+    MapaTerritorios mapa;
+    mapa_inicializar(&mapa);
+    if (mapa_gerar_sintetico(&mapa, territorios, 2, semente) != 0
+        || grafo_gerar_sintetico(&mapa, 0.05, semente + 1) != 0 || mapa.num_cores != 2) {
+        printf("[ERRO] Não foi possível gerar o mapa do torneio.\n");
+        mapa_liberar(&mapa);
+        return 1;
+    }
+
+    // Estados zerados: estado_liberar() aceita os que não chegaram a ser criados.
+    ContextoMCTS *ctx = calloc(1, sizeof(ContextoMCTS));
+    EstadoJogo inicial = {0}, estado = {0};
+    int ok = ctx != NULL && estado_criar(&inicial, territorios) == 0
+          && estado_criar(&estado, territorios) == 0;
+    for (int t = 0; ok && t < num_threads; t++) {
+        ok = estado_criar(&ctx->rascunho[t], territorios) == 0;
+        gerador_semear(&ctx->rng[t], semente * 1000 + (uint64_t)t);
+    }
+    PoolRoubo *pool = ok ? malloc(sizeof(PoolRoubo)) : NULL;
+    if (pool == NULL) {
+        printf("[ERRO] Falha na alocação de memória para o torneio.\n");
+        torneio_liberar(ctx, num_threads, &inicial, &estado, &mapa);
+        return 1;
+    }
+    estado_de_mapa(&inicial, &mapa);
+    if (pool_criar(pool, num_threads, executar_rollout) != 0) {
+        if (pool->num_trabalhadores == 0) {
+            printf("[ERRO] Não foi possível criar as threads do torneio.\n");
+            pool_destruir(pool);
+            free(pool);
+            torneio_liberar(ctx, num_threads, &inicial, &estado, &mapa);
+            return 1;
+        }
+        printf("[ALERTA] Só foi possível criar %d de %d threads; o torneio segue com elas.\n",
+               pool->num_trabalhadores, num_threads);
+    }
+
+    printf("--- TORNEIO DE IA (MCTS) ---\n");
+    printf("Territórios: %u | Partidas: %d | Orçamento: %s %.0f ms, %s %.0f ms | Threads: %d\n",
+           territorios, partidas, mapa.cores[0], orcamento[0], mapa.cores[1], orcamento[1],
+           pool->num_trabalhadores);
+
+    GeradorAleatorio rng;
+    gerador_semear(&rng, semente);
+    int vitorias[2] = {0, 0}, empates = 0;
+    uint64_t total_rollouts = 0;
+    double total_segundos = 0.0;
+    for (int p = 0; p < partidas; p++) {
+        estado_copiar(&estado, &inicial);
+        int jogador = p % 2; // Os exércitos se alternam no primeiro turno
+        int turno;
+        for (turno = 0; turno < MAX_TURNOS_PARTIDA; turno++) {
+            estado_reforcar(&estado, &mapa.fronteiras, jogador);
+            for (int k = 0; k < MAX_ATAQUES_TURNO; k++) {
+                if (orcamento[jogador] <= 0.0) {
+                    if (!politica_aleatoria(&estado, &mapa.fronteiras, jogador, &rng)) break;
+                } else {
+                    DecisaoIA d = mcts_escolher(pool, ctx, &estado, &mapa.fronteiras, jogador, k,
+                                                orcamento[jogador]);
+                    total_rollouts += d.rollouts;
+                    total_segundos += d.segundos;
+                    if (d.atacante == PASSAR) break;
+                    estado_atacar(&estado, d.atacante, d.defensor, &rng);
+                }
+                if (estado.territorios[1 - jogador] == 0) break;
+            }
+            if (estado.territorios[1 - jogador] == 0) break;
+            jogador = 1 - jogador;
+        }
+        // Documentação: Sem eliminação até MAX_TURNOS_PARTIDA vence quem tem mais
+        // territórios; com o mapa dividido ao meio a partida é um empate.
+        int vencedor = estado.territorios[0] > estado.territorios[1] ? 0
+                     : estado.territorios[1] > estado.territorios[0] ? 1 : -1;
+        if (vencedor < 0) {
+            empates++;
+        } else {
+            vitorias[vencedor]++;
+        }
+        // Documentação: Uma linha por partida é mensagem informativa (log.h); some
+        // da compilação com NIVEL_LOG abaixo de LOG_INFO, e o placar final fica.
+        registrarInfo("Partida %d: %s%s em %d turnos (%u x %u territórios)\n", p + 1,
+                      vencedor < 0 ? "empate" : "vence ", vencedor < 0 ? "" : mapa.cores[vencedor],
+                      turno + (turno < MAX_TURNOS_PARTIDA), estado.territorios[0], estado.territorios[1]);
+    }
+
+    printf("\nPlacar: %s %d x %d %s | Empates: %d\n", mapa.cores[0], vitorias[0], vitorias[1], mapa.cores[1],
+           empates);
+    if (total_segundos > 0.0) {
+        printf("Rollouts: %llu em %.2f s de busca (%.0f rollouts/s, %llu roubos de tarefa)\n",
+               (unsigned long long)total_rollouts, total_segundos,
+               (double)total_rollouts / total_segundos, (unsigned long long)pool->roubos);
+    }
+
+    pool_destruir(pool);
+    free(pool);
+    torneio_liberar(ctx, num_threads, &inicial, &estado, &mapa);
+    return 0;
+}
+
+// --- Micro-benchmark do kernel de dados ---
+// Documentação: Libera os vetores do benchmark; serve tanto para o fim normal
+// quanto para uma alocação que falhou no meio (ponteiros nulos são ignorados).
+static void bench_dados_liberar(int32_t *atq_inicial, int32_t *def_inicial, uint32_t *est_inicial,
+                                int32_t *atq[3], int32_t *def[3], uint32_t *est[3]) {
+    free(atq_inicial);
+    free(def_inicial);
+    free(est_inicial);
+    for (int k = 0; k < 3; k++) {
+        free(atq[k]);
+        free(def[k]);
+        free(est[k]);
+    }
+}
+
+// Documentação: "./War --bench-dados [batalhas] [semente]" resolve o mesmo lote de
+// batalhas (tropas sorteadas entre 2..20 e 1..20) com cada implementação, confere
+// que os resultados são idênticos bit a bit e compara as velocidades.
+int executar_modo_bench_dados(int argc, char *argv[]) {
+    size_t quantidade = argc > 2 ? strtoull(argv[2], NULL, 10) : 4000000;
+    uint64_t semente = argc > 3 ? strtoull(argv[3], NULL, 10) : 42;
+    static const char *nomes[] = {"automático", "escalar", "SSE2", "AVX2"};
+
+    int32_t *atq_inicial = malloc(quantidade * sizeof(int32_t));
+    int32_t *def_inicial = malloc(quantidade * sizeof(int32_t));
+    uint32_t *est_inicial = malloc(quantidade * sizeof(uint32_t));
+    int32_t *atq[3], *def[3];
+    uint32_t *est[3];
+    int ok = atq_inicial && def_inicial && est_inicial;
+    for (int k = 0; k < 3; k++) {
+        atq[k] = malloc(quantidade * sizeof(int32_t));
+        def[k] = malloc(quantidade * sizeof(int32_t));
+        est[k] = malloc(quantidade * sizeof(uint32_t));
+        ok = ok && atq[k] && def[k] && est[k];
+    }
+    if (!ok || quantidade == 0) {
+        printf("[ERRO] Falha na alocação de memória para o benchmark.\n");
+        bench_dados_liberar(atq_inicial, def_inicial, est_inicial, atq, def, est);
+        return 1;
+    }
+
+    GeradorAleatorio g;
+    gerador_semear(&g, semente);
+    LoteBatalhas inicial = {atq_inicial, def_inicial, est_inicial, quantidade};
+    for (size_t i = 0; i < quantidade; i++) {
+        atq_inicial[i] = 2 + (int32_t)(gerador_proximo(&g) % 19);
+        def_inicial[i] = 1 + (int32_t)(gerador_proximo(&g) % 20);
+    }
+    lote_semear(&inicial, &g);
+
+    printf("--- BENCHMARK DO KERNEL DE DADOS (%zu batalhas) ---\n", quantidade);
+    double tempo_escalar = 0.0;
+    int identicos = 1;
+    ImplementacaoLote implementacoes[3] = {LOTE_ESCALAR, LOTE_SSE2, LOTE_AVX2};
+    for (int k = 0; k < 3; k++) {
+        memcpy(atq[k], atq_inicial, quantidade * sizeof(int32_t));
+        memcpy(def[k], def_inicial, quantidade * sizeof(int32_t));
+        memcpy(est[k], est_inicial, quantidade * sizeof(uint32_t));
+        LoteBatalhas lote = {atq[k], def[k], est[k], quantidade};
+        double inicio = segundos_agora();
+        ImplementacaoLote usada = resolver_lote(&lote, implementacoes[k]);
+        double duracao = segundos_agora() - inicio;
+        if (usada != implementacoes[k]) {
+            printf("%-8s não suportado nesta CPU\n", nomes[implementacoes[k]]);
+            continue;
+        }
+        if (k == 0) {
+            tempo_escalar = duracao;
+        }
+        int igual = memcmp(atq[k], atq[0], quantidade * sizeof(int32_t)) == 0
+                 && memcmp(def[k], def[0], quantidade * sizeof(int32_t)) == 0
+                 && memcmp(est[k], est[0], quantidade * sizeof(uint32_t)) == 0;
+        identicos &= igual;
+        printf("%-8s %8.3f ms  %12.0f batalhas/s  %5.2fx  %s\n", nomes[implementacoes[k]],
+               duracao * 1e3, (double)quantidade / duracao, tempo_escalar / duracao,
+               igual ? "idêntico ao escalar" : "DIVERGE do escalar");
+    }
+
+    bench_dados_liberar(atq_inicial, def_inicial, est_inicial, atq, def, est);
+    return identicos ? 0 : 1;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1 && strcmp(argv[1], "--simular") == 0) {
+        return executar_modo_simulacao(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--mapa-sintetico") == 0) {
+        return executar_modo_mapa_sintetico(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--salvar-sintetico") == 0) {
+        return executar_modo_salvar_sintetico(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--carregar") == 0) {
+        return executar_modo_carregar(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--fronteiras") == 0) {
+        return executar_modo_fronteiras(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--missoes") == 0) {
+        return executar_modo_missoes(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--placar") == 0) {
+        return executar_modo_placar(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--torneio") == 0) {
+        return executar_modo_torneio(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-dados") == 0) {
+        return executar_modo_bench_dados(argc, argv);
+    }
+    // "./War --salvar arquivo" faz o cadastro normal e grava o mapa no final.
+    const char *arquivo_saida = NULL;
+    if (argc > 2 && strcmp(argv[1], "--salvar") == 0) {
+        arquivo_saida = argv[2];
+    }
+
+    // O mapa cresce conforme os territórios são cadastrados.
+    MapaTerritorios mapa;
+    mapa_inicializar(&mapa);
+    struct Territorio novo; // Área de leitura de um território antes de ir para o mapa
+    size_t i; // Variável de controle para os laços
 
     // --- Requisito: Cadastro dos territórios ---
     printf("--- SISTEMA DE CADASTRO DE TERRITÓRIOS ---\n");
     for (i = 0; i < NUM_TERRITORIOS; i++) {
-        printf("\n--- Cadastro do Território %d ---\n", i + 1);
+        printf("\n--- Cadastro do Território %zu ---\n", i + 1);
 
         // Usabilidade: Agora permite nomes com espaços.
         printf("Digite o nome do território: ");
-        // Segurança: fgets() é usado para evitar buffer overflow.
-        // Ele lê a linha inteira, incluindo o '\n' no final.
-        fgets(territorios[i].nome, sizeof(territorios[i].nome), stdin);
-        // Remove o '\n' que o fgets() deixa no final da string.
-        territorios[i].nome[strcspn(territorios[i].nome, "\n")] = '\0';
+        // Segurança: entradaLinha() nunca escreve além do tamanho do campo; o
+        // excesso da linha é descartado e o '\n' não entra na string.
+        if (entradaLinha(&entrada_padrao, novo.nome, sizeof(novo.nome)) < 0) {
+            novo.nome[0] = '\0';
+        }
 
         printf("Digite a cor do exército (ex: Azul, Verde): ");
-        fgets(territorios[i].cor, sizeof(territorios[i].cor), stdin);
-        territorios[i].cor[strcspn(territorios[i].cor, "\n")] = '\0';
+        if (entradaLinha(&entrada_padrao, novo.cor, sizeof(novo.cor)) < 0) {
+            novo.cor[0] = '\0';
+        }
 
         printf("Digite a quantidade de tropas: ");
-        scanf("%d", &territorios[i].tropas);
-        
-        // Limpeza: Essencial após um scanf() para limpar o '\n' que ficou no buffer,
-        // evitando problemas na próxima leitura com fgets().
-        limpar_buffer();
+        // Lê o número e consome o resto da linha dele, como o scanf() seguido da
+        // limpeza do buffer.
+        if (entradaInteiroLinha(&entrada_padrao, &novo.tropas) != 1) {
+            novo.tropas = 0;
+        }
+
+        if (mapa_adicionar(&mapa, novo.nome, novo.cor, novo.tropas) < 0) {
+            registrarErro("[ERRO] Não foi possível cadastrar o território.\n");
+            mapa_liberar(&mapa);
+            return 1;
+        }
     }
 
     // --- Requisito: Exibição dos dados ---
@@ -61,12 +3346,16 @@ int main() {
     printf("--- DADOS DOS TERRITÓRIOS CADASTRADOS ---\n");
     printf("=========================================\n");
 
-    for (i = 0; i < NUM_TERRITORIOS; i++) {
-        printf("\nTerritório %d:\n", i + 1);
-        printf("  Nome: %s\n", territorios[i].nome);
-        printf("  Cor do Exército: %s\n", territorios[i].cor);
-        printf("  Quantidade de Tropas: %d\n", territorios[i].tropas);
+    exibir_mapa(&mapa, mapa.quantidade);
+
+    if (arquivo_saida != NULL) {
+        if (snapshot_salvar(&mapa, arquivo_saida) == 0) {
+            registrarInfo("\nMapa salvo em '%s'.\n", arquivo_saida);
+        } else {
+            registrarErro("\n[ERRO] Não foi possível salvar o mapa em '%s'.\n", arquivo_saida);
+        }
     }
 
+    mapa_liberar(&mapa);
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,241 @@
+// Leitura da entrada padrão com buffer próprio, usada pelos quatro programas.
+// Só cabeçalho: basta "#include "entrada.h"" no .c, sem mudar a compilação.
+#ifndef ENTRADA_H
+#define ENTRADA_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#define ENTRADA_BLOCO (1 << 16) // Bytes pedidos ao sistema por leitura (a capacidade de um pipe)
+
+/**
+ * @brief Leitor de um descritor com buffer de ENTRADA_BLOCO bytes. Em vez de
+ * scanf/fgets/getchar (uma chamada da libc por campo ou por caractere), os
+ * dados chegam em blocos grandes com read() e as linhas são achadas com
+ * memchr(). Uma Entrada zerada lê da entrada padrão (descritor 0), então uma
+ * variável global não precisa de inicialização.
+ *
+ * Antes de cada read() a saída padrão é descarregada, para que um prompt sem
+ * '\n' apareça no terminal antes de o programa esperar a resposta; com a
+ * entrada vindo de um pipe isso só acontece uma vez a cada bloco.
+ */
+typedef struct {
+    int descritor;  // Descritor lido; 0 = entrada padrão
+    int acabou;     // 1 depois que read() indicou fim do arquivo (ou erro)
+    size_t inicio;  // Próximo byte ainda não consumido em 'dados'
+    size_t fim;     // Bytes válidos em 'dados'
+    char dados[ENTRADA_BLOCO];
+} Entrada;
+
+/**
+ * @brief Separadores entre palavras: espaço, tabulação e quebras de linha.
+ */
+static inline int entradaSeparador(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/**
+ * @brief Garante bytes não consumidos no buffer, lendo o próximo bloco se
+ * preciso.
+ * @return int: 1 se há bytes, 0 no fim da entrada.
+ */
+static inline int entradaEncher(Entrada *e) {
+    if (e->inicio < e->fim) {
+        return 1;
+    }
+    e->inicio = e->fim = 0;
+    while (!e->acabou) {
+        fflush(stdout);
+        ssize_t lidos = read(e->descritor, e->dados, sizeof(e->dados));
+        if (lidos > 0) {
+            e->fim = (size_t)lidos;
+            return 1;
+        }
+        if (lidos < 0 && errno == EINTR) {
+            continue;
+        }
+        e->acabou = 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Pula espaços, tabulações e quebras de linha.
+ * @return int: O próximo caractere (sem consumi-lo), ou -1 no fim da entrada.
+ */
+static inline int entradaPular(Entrada *e) {
+    while (entradaEncher(e)) {
+        while (e->inicio < e->fim) {
+            unsigned char c = (unsigned char)e->dados[e->inicio];
+            if (!entradaSeparador((char)c)) {
+                return c;
+            }
+            e->inicio++;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Copia o resto da linha atual para 'destino' e consome o '\n'. O '\r'
+ * de arquivos do Windows é removido e o que não cabe em 'capacidade' é
+ * descartado (como o fgets seguido da limpeza do buffer).
+ * @return int: Tamanho do texto copiado, ou -1 se a entrada já tinha acabado.
+ */
+static inline int entradaLinha(Entrada *e, char *destino, size_t capacidade) {
+    size_t copiados = 0;
+    int leuAlgo = 0;
+    while (entradaEncher(e)) {
+        leuAlgo = 1;
+        char *inicio = e->dados + e->inicio;
+        size_t disponiveis = e->fim - e->inicio;
+        char *quebra = memchr(inicio, '\n', disponiveis);
+        size_t tamanho = quebra != NULL ? (size_t)(quebra - inicio) : disponiveis;
+        size_t cabe = capacidade - 1 - copiados;
+        memcpy(destino + copiados, inicio, tamanho < cabe ? tamanho : cabe);
+        copiados += tamanho < cabe ? tamanho : cabe;
+        e->inicio += tamanho;
+        if (quebra != NULL) {
+            e->inicio++;
+            break;
+        }
+    }
+    if (!leuAlgo) {
+        return -1;
+    }
+    if (copiados > 0 && destino[copiados - 1] == '\r') {
+        copiados--;
+    }
+    destino[copiados] = '\0';
+    return (int)copiados;
+}
+
+/**
+ * @brief Descarta o resto da linha atual, inclusive o '\n'.
+ */
+static inline void entradaDescartarLinha(Entrada *e) {
+    while (entradaEncher(e)) {
+        char *quebra = memchr(e->dados + e->inicio, '\n', e->fim - e->inicio);
+        if (quebra != NULL) {
+            e->inicio = (size_t)(quebra - e->dados) + 1;
+            return;
+        }
+        e->inicio = e->fim;
+    }
+}
+
+/**
+ * @brief Lê a próxima palavra (sequência sem espaços), pulando espaços e
+ * quebras de linha antes dela, como o "%s" do scanf. O separador depois da
+ * palavra não é consumido; o que não cabe em 'capacidade' é descartado.
+ * @return int: Tamanho da palavra, ou -1 no fim da entrada.
+ */
+static inline int entradaPalavra(Entrada *e, char *destino, size_t capacidade) {
+    if (entradaPular(e) < 0) {
+        return -1;
+    }
+    size_t copiados = 0;
+    while (entradaEncher(e)) {
+        while (e->inicio < e->fim) {
+            char c = e->dados[e->inicio];
+            if (entradaSeparador(c)) {
+                destino[copiados] = '\0';
+                return (int)copiados;
+            }
+            if (copiados + 1 < capacidade) {
+                destino[copiados++] = c;
+            }
+            e->inicio++;
+        }
+    }
+    destino[copiados] = '\0';
+    return (int)copiados;
+}
+
+/**
+ * @brief Converte o início de 'texto' (até 'fim') num int, como o "%d" do
+ * scanf: espaços antes do número são ignorados, e o que vem depois dele também.
+ * @return int: 1 se havia um número que cabe num int, 0 caso contrário.
+ */
+static inline int entradaConverterInteiro(const char *texto, const char *fim, int *valor) {
+    while (texto < fim && entradaSeparador(*texto)) {
+        texto++;
+    }
+    int negativo = texto < fim && *texto == '-';
+    if (texto < fim && (*texto == '-' || *texto == '+')) {
+        texto++;
+    }
+    const char *digitos = texto;
+    long long numero = 0;
+    while (texto < fim && *texto >= '0' && *texto <= '9' && numero <= 2147483648LL) {
+        numero = numero * 10 + (*texto++ - '0');
+    }
+    if (texto == digitos || numero > 2147483647LL + negativo) {
+        return 0;
+    }
+    *valor = (int)(negativo ? -numero : numero);
+    return 1;
+}
+
+/**
+ * @brief Lê um inteiro da próxima palavra. Quando a palavra já está inteira no
+ * buffer (o caso comum), ela é convertida ali mesmo, sem cópia. Se ela não é
+ * um número, o resto da linha é descartado, para que a próxima leitura comece
+ * numa linha nova.
+ * @return int: 1 se leu um número, 0 se a palavra era inválida, -1 no fim da entrada.
+ */
+static inline int entradaInteiro(Entrada *e, int *valor) {
+    if (entradaPular(e) < 0) {
+        return -1;
+    }
+    const char *inicio = e->dados + e->inicio, *fim = e->dados + e->fim;
+    const char *p = inicio;
+    while (p < fim && !entradaSeparador(*p)) {
+        p++;
+    }
+    int valido;
+    if (p < fim) {
+        valido = entradaConverterInteiro(inicio, p, valor);
+        e->inicio = (size_t)(p - e->dados);
+    } else {
+        // A palavra continua no próximo bloco.
+        char palavra[32];
+        int tamanho = entradaPalavra(e, palavra, sizeof(palavra));
+        valido = entradaConverterInteiro(palavra, palavra + tamanho, valor);
+    }
+    if (!valido) {
+        entradaDescartarLinha(e);
+    }
+    return valido;
+}
+
+/**
+ * @brief Lê um inteiro e descarta o resto da linha dele, como um scanf("%d")
+ * seguido da limpeza do buffer. Linhas em branco antes do número são puladas.
+ * @return int: 1 se leu um número, 0 se a linha não começava com um, -1 no fim da entrada.
+ */
+static inline int entradaInteiroLinha(Entrada *e, int *valor) {
+    int lido = entradaInteiro(e, valor);
+    if (lido == 1) {
+        entradaDescartarLinha(e);
+    }
+    return lido;
+}
+
+/**
+ * @brief Lê o próximo caractere que não é espaço nem quebra de linha, como o
+ * " %c" do scanf.
+ * @return int: O caractere, ou -1 no fim da entrada.
+ */
+static inline int entradaCaractere(Entrada *e) {
+    int c = entradaPular(e);
+    if (c >= 0) {
+        e->inicio++;
+    }
+    return c;
+}
+
+#endif // ENTRADA_H
@@ -0,0 +1,300 @@
+// Mensagens de registro (log) com níveis, usadas pelos quatro programas.
+// Só cabeçalho: basta "#include "log.h"" no .c (que já compila com -pthread).
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+
+// --- Níveis ---
+// Uma mensagem só existe no programa se o seu nível for <= NIVEL_LOG, escolhido
+// na compilação: "gcc -DNIVEL_LOG=LOG_AVISO ..." tira todas as mensagens
+// informativas (a chamada, a formatação e os argumentos somem do binário).
+#define LOG_NADA 0
+#define LOG_ERRO 1  // Falha do próprio programa (memória, disco)
+#define LOG_AVISO 2 // Pedido recusado ou entrada inválida (fila cheia, opção desconhecida...)
+#define LOG_INFO 3  // Confirmação de cada operação ([GERADO], [JOGADA], [SUCESSO]...)
+
+#ifndef NIVEL_LOG
+#define NIVEL_LOG LOG_INFO
+#endif
+
+#define LOG_HABILITADO(nivel) ((nivel) <= NIVEL_LOG)
+
+// A condição é constante: com o nível desligado o compilador descarta o bloco
+// inteiro, mas ainda confere os argumentos contra o formato.
+#define registrarLog(nivel, ...)                     \
+    do {                                             \
+        if (LOG_HABILITADO(nivel)) {                 \
+            logEscreverNivel((nivel), __VA_ARGS__);  \
+        }                                            \
+    } while (0)
+#define registrarErro(...) registrarLog(LOG_ERRO, __VA_ARGS__)
+#define registrarAviso(...) registrarLog(LOG_AVISO, __VA_ARGS__)
+#define registrarInfo(...) registrarLog(LOG_INFO, __VA_ARGS__)
+
+#define LOG_TAM_BUFFER (1 << 16) // Bytes de mensagens acumulados por thread antes de ir para o escritor
+#define LOG_MAX_BUFFERS 16       // Buffers em uso; acima disso quem registra espera o escritor devolver um
+
+/**
+ * @brief Bloco de mensagens já formatadas. Cada thread enche o seu sem trava
+ * nenhuma e só o entrega ao escritor quando ele não comporta a próxima
+ * mensagem (ou em logDescarregar()).
+ */
+typedef struct BufferLog {
+    struct BufferLog *proximo;
+    size_t usado;
+    char dados[LOG_TAM_BUFFER];
+} BufferLog;
+
+/**
+ * @brief Estado do registro. Sem logIniciarArquivo() (o modo interativo), as
+ * mensagens saem na hora pela saída padrão, na mesma ordem dos outros printf.
+ * Com um arquivo, cada thread formata no seu buffer e uma thread escritora grava
+ * os buffers cheios com write(), fora do caminho de quem registra. As mensagens
+ * de uma thread ficam na ordem; as de threads diferentes saem agrupadas por buffer.
+ * Mensagens de LOG_ERRO vão para o arquivo e também para a saída padrão.
+ */
+typedef struct {
+    int descritor;           // Arquivo do registro, ou -1 para a saída padrão
+    pthread_t escritor;
+    pthread_mutex_t trava;
+    pthread_cond_t temTrabalho; // Há buffer entregue ou pedido de encerramento
+    pthread_cond_t temLivre;    // Um buffer voltou para 'livres'
+    BufferLog *fila;            // Buffers entregues, na ordem de entrega
+    BufferLog *ultimo;
+    BufferLog *livres;
+    int alocados;
+    int entregues;              // Buffers na fila ou sendo gravados: vão voltar para 'livres'
+    int encerrar;
+} RegistroLog;
+
+static RegistroLog registroLog = {.descritor = -1};
+static _Thread_local BufferLog *bufferLogThread; // Buffer sendo enchido por esta thread
+
+/**
+ * @brief Laço da thread escritora: grava os buffers entregues e os devolve
+ * para a lista de livres.
+ */
+static inline void *logEscritor(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&registroLog.trava);
+    for (;;) {
+        while (registroLog.fila == NULL && !registroLog.encerrar) {
+            pthread_cond_wait(&registroLog.temTrabalho, &registroLog.trava);
+        }
+        BufferLog *lote = registroLog.fila;
+        if (lote == NULL) {
+            break; // Encerramento sem nada pendente
+        }
+        registroLog.fila = registroLog.ultimo = NULL;
+        pthread_mutex_unlock(&registroLog.trava);
+
+        BufferLog *fimLote = lote;
+        int buffersLote = 0;
+        for (BufferLog *b = lote; b != NULL; b = b->proximo) {
+            size_t gravados = 0;
+            while (gravados < b->usado) {
+                ssize_t n = write(registroLog.descritor, b->dados + gravados, b->usado - gravados);
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n <= 0) {
+                    break; // Disco cheio ou arquivo fechado: o resto do buffer se perde
+                }
+                gravados += (size_t)n;
+            }
+            b->usado = 0;
+            fimLote = b;
+            buffersLote++;
+        }
+
+        pthread_mutex_lock(&registroLog.trava);
+        registroLog.entregues -= buffersLote;
+        fimLote->proximo = registroLog.livres;
+        registroLog.livres = lote;
+        pthread_cond_broadcast(&registroLog.temLivre);
+    }
+    pthread_mutex_unlock(&registroLog.trava);
+    return NULL;
+}
+
+/**
+ * @brief Pega um buffer vazio, esperando o escritor se LOG_MAX_BUFFERS já estão
+ * em uso. Só vale esperar se algum buffer foi entregue e vai voltar: se todos
+ * estão sendo enchidos por threads (mais de LOG_MAX_BUFFERS threads
+ * registrando), nenhum volta até elas registrarem de novo, então aloca mais um.
+ * @return BufferLog*: O buffer, ou NULL se faltou memória.
+ */
+static inline BufferLog *logObterBuffer(void) {
+    pthread_mutex_lock(&registroLog.trava);
+    BufferLog *b = NULL;
+    for (;;) {
+        if (registroLog.livres != NULL) {
+            b = registroLog.livres;
+            registroLog.livres = b->proximo;
+            break;
+        }
+        if (registroLog.alocados < LOG_MAX_BUFFERS || registroLog.entregues == 0) {
+            b = malloc(sizeof(BufferLog));
+            registroLog.alocados += b != NULL;
+            break;
+        }
+        pthread_cond_wait(&registroLog.temLivre, &registroLog.trava);
+    }
+    pthread_mutex_unlock(&registroLog.trava);
+    if (b != NULL) {
+        b->proximo = NULL;
+        b->usado = 0;
+    }
+    return b;
+}
+
+/**
+ * @brief Entrega o buffer desta thread ao escritor (ou o devolve, se vazio).
+ * Toda thread que registra mensagens num arquivo chama isto antes de terminar.
+ */
+static inline void logDescarregar(void) {
+    BufferLog *b = bufferLogThread;
+    if (b == NULL) {
+        return;
+    }
+    bufferLogThread = NULL;
+    pthread_mutex_lock(&registroLog.trava);
+    if (b->usado == 0) {
+        b->proximo = registroLog.livres;
+        registroLog.livres = b;
+    } else {
+        b->proximo = NULL;
+        if (registroLog.ultimo != NULL) {
+            registroLog.ultimo->proximo = b;
+        } else {
+            registroLog.fila = b;
+        }
+        registroLog.ultimo = b;
+        registroLog.entregues++;
+        pthread_cond_signal(&registroLog.temTrabalho);
+    }
+    pthread_mutex_unlock(&registroLog.trava);
+}
+
+/**
+ * @brief Corpo de logEscrever(), com os argumentos já numa va_list.
+ */
+static inline void logEscreverLista(const char *formato, va_list args) {
+    if (registroLog.descritor < 0) {
+        vprintf(formato, args);
+        return;
+    }
+    for (int tentativa = 0; tentativa < 2; tentativa++) {
+        if (bufferLogThread == NULL && (bufferLogThread = logObterBuffer()) == NULL) {
+            break; // Sem memória: a mensagem se perde
+        }
+        BufferLog *b = bufferLogThread;
+        size_t espaco = LOG_TAM_BUFFER - b->usado;
+        va_list copia;
+        va_copy(copia, args);
+        int n = vsnprintf(b->dados + b->usado, espaco, formato, copia);
+        va_end(copia);
+        if (n < 0) {
+            break;
+        }
+        if ((size_t)n < espaco) {
+            b->usado += (size_t)n;
+            break;
+        }
+        if (b->usado == 0) {
+            b->usado = LOG_TAM_BUFFER - 1; // Maior que um buffer inteiro: vai cortada
+            break;
+        }
+        logDescarregar(); // Não coube: entrega o buffer cheio e tenta num vazio
+    }
+}
+
+/**
+ * @brief Escreve uma mensagem no formato do printf, na tela ou no arquivo do
+ * registro. Para mensagens com nível, use os macros registrarErro/
+ * registrarAviso/registrarInfo, que respeitam NIVEL_LOG.
+ */
+__attribute__((format(printf, 1, 2))) static inline void logEscrever(const char *formato, ...) {
+    va_list args;
+    va_start(args, formato);
+    logEscreverLista(formato, args);
+    va_end(args);
+}
+
+/**
+ * @brief Escreve uma mensagem de um nível (pelos macros registrar*). Um erro
+ * sempre aparece também na tela: com um arquivo de registro ativo, o jogador
+ * ainda precisa saber que, por exemplo, a mochila não foi salva.
+ */
+__attribute__((format(printf, 2, 3))) static inline void logEscreverNivel(int nivel, const char *formato, ...) {
+    va_list args;
+    va_start(args, formato);
+    if (nivel == LOG_ERRO && registroLog.descritor >= 0) {
+        va_list copia;
+        va_copy(copia, args);
+        vprintf(formato, copia);
+        va_end(copia);
+    }
+    logEscreverLista(formato, args);
+    va_end(args);
+}
+
+/**
+ * @brief Passa a gravar as mensagens em 'caminho' (criado ou truncado) por uma
+ * thread escritora. Deve ser chamada antes de criar as threads que registram.
+ * @return int: 0 em caso de sucesso, -1 se o arquivo ou a thread não puderam ser criados.
+ */
+static inline int logIniciarArquivo(const char *caminho) {
+    int descritor = open(caminho, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (descritor < 0) {
+        return -1;
+    }
+    pthread_mutex_init(&registroLog.trava, NULL);
+    pthread_cond_init(&registroLog.temTrabalho, NULL);
+    pthread_cond_init(&registroLog.temLivre, NULL);
+    registroLog.fila = registroLog.ultimo = registroLog.livres = NULL;
+    registroLog.alocados = 0;
+    registroLog.entregues = 0;
+    registroLog.encerrar = 0;
+    registroLog.descritor = descritor;
+    if (pthread_create(&registroLog.escritor, NULL, logEscritor, NULL) != 0) {
+        registroLog.descritor = -1;
+        close(descritor);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Entrega o buffer da thread que chama, espera o escritor gravar tudo e
+ * fecha o arquivo; as mensagens voltam para a saída padrão. Deve ser chamada
+ * depois que as outras threads que registram terminaram. Sem arquivo, não faz nada.
+ */
+static inline void logEncerrar(void) {
+    if (registroLog.descritor < 0) {
+        return;
+    }
+    logDescarregar();
+    pthread_mutex_lock(&registroLog.trava);
+    registroLog.encerrar = 1;
+    pthread_cond_signal(&registroLog.temTrabalho);
+    pthread_mutex_unlock(&registroLog.trava);
+    pthread_join(registroLog.escritor, NULL);
+    while (registroLog.livres != NULL) {
+        BufferLog *b = registroLog.livres;
+        registroLog.livres = b->proximo;
+        free(b);
+    }
+    close(registroLog.descritor);
+    registroLog.descritor = -1;
+}
+
+#endif // LOG_H